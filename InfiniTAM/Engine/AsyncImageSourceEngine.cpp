@@ -0,0 +1,155 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "AsyncImageSourceEngine.h"
+
+using namespace InfiniTAM::Engine;
+
+AsyncImageSourceEngine::AsyncImageSourceEngine(ImageSourceEngine* source,
+                                               Policy policy, int noFrames)
+    : ImageSourceEngine(""), source(source), policy(policy) {
+  calib = source->calib;
+  imageSize_rgb = source->getRGBImageSize();
+  imageSize_d = source->getDepthImageSize();
+
+  // one pair is being captured and one read, the rest queue up
+  if (noFrames < 3) noFrames = 3;
+  for (int i = 0; i < noFrames; i++) {
+    Frame frame;
+    frame.rgb = new ITMUChar4Image(imageSize_rgb, true, false);
+    frame.rawDepth = new ITMShortImage(imageSize_d, true, false);
+    frames.push_back(frame);
+    freeFrames.push_back(i);
+  }
+
+  capturingFrame = -1;
+  stopRequested = false;
+  sourceFinished = false;
+  noCapturedFrames = 0;
+  noDroppedFrames = 0;
+  hasRequest = false;
+
+  thread = std::thread(&AsyncImageSourceEngine::Run, this);
+}
+
+AsyncImageSourceEngine::~AsyncImageSourceEngine() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopRequested = true;
+  }
+  frameAvailable.notify_all();
+  thread.join();
+
+  for (size_t i = 0; i < frames.size(); i++) {
+    delete frames[i].rgb;
+    delete frames[i].rawDepth;
+  }
+  delete source;
+}
+
+void AsyncImageSourceEngine::Run(void) {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    if (policy == POLICY_EVERY_FRAME)
+      frameAvailable.wait(
+          lock, [this] { return stopRequested || !freeFrames.empty(); });
+    if (stopRequested) break;
+
+    // without a free pair, the oldest one not yet read is overwritten
+    if (freeFrames.empty()) {
+      freeFrames.push_back(capturedFrames.front());
+      capturedFrames.pop_front();
+      noDroppedFrames++;
+    }
+    capturingFrame = freeFrames.back();
+    freeFrames.pop_back();
+    Frame& frame = frames[capturingFrame];
+
+    lock.unlock();
+    bool hasImage = source->hasMoreImages();
+    if (hasImage) source->getImages(frame.rgb, frame.rawDepth);
+    Clock::time_point captureTime = Clock::now();
+    lock.lock();
+
+    if (hasImage) {
+      frame.captureTime = captureTime;
+      capturedFrames.push_back(capturingFrame);
+      noCapturedFrames++;
+    } else {
+      freeFrames.push_back(capturingFrame);
+      sourceFinished = true;
+    }
+    capturingFrame = -1;
+    frameAvailable.notify_all();
+
+    if (sourceFinished) break;
+  }
+}
+
+bool AsyncImageSourceEngine::IsFrameReady(void) const {
+  if (capturedFrames.empty()) return false;
+  if (policy != POLICY_NEXT_FRAME) return true;
+  return frames[capturedFrames.back()].captureTime >= requestTime;
+}
+
+bool AsyncImageSourceEngine::hasMoreImages(void) {
+  std::unique_lock<std::mutex> lock(mutex);
+  if (!hasRequest) {
+    requestTime = Clock::now();
+    hasRequest = true;
+  }
+  frameAvailable.wait(lock,
+                      [this] { return sourceFinished || IsFrameReady(); });
+  return !capturedFrames.empty();
+}
+
+void AsyncImageSourceEngine::getImages(ITMUChar4Image* rgb,
+                                       ITMShortImage* rawDepth) {
+  std::unique_lock<std::mutex> lock(mutex);
+  if (!hasRequest) requestTime = Clock::now();
+  hasRequest = false;
+
+  frameAvailable.wait(lock,
+                      [this] { return sourceFinished || IsFrameReady(); });
+  if (capturedFrames.empty()) return;
+
+  int readFrame;
+  if (policy == POLICY_EVERY_FRAME) {
+    readFrame = capturedFrames.front();
+    capturedFrames.pop_front();
+  } else {
+    readFrame = capturedFrames.back();
+    capturedFrames.pop_back();
+    noDroppedFrames += (int)capturedFrames.size();
+    freeFrames.insert(freeFrames.end(), capturedFrames.begin(),
+                      capturedFrames.end());
+    capturedFrames.clear();
+  }
+
+  // the capture thread does not touch a pair that is neither free nor queued
+  lock.unlock();
+  rgb->SetFrom(frames[readFrame].rgb,
+               ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU);
+  rawDepth->SetFrom(frames[readFrame].rawDepth,
+                    ORUtils::MemoryBlock<short>::CPU_TO_CPU);
+  lock.lock();
+
+  lastCaptureTime = frames[readFrame].captureTime;
+  freeFrames.push_back(readFrame);
+  frameAvailable.notify_all();
+}
+
+AsyncImageSourceEngine::Clock::time_point
+AsyncImageSourceEngine::GetLastCaptureTime(void) {
+  std::lock_guard<std::mutex> lock(mutex);
+  return lastCaptureTime;
+}
+
+int AsyncImageSourceEngine::GetNoCapturedFrames(void) {
+  std::lock_guard<std::mutex> lock(mutex);
+  return noCapturedFrames;
+}
+
+int AsyncImageSourceEngine::GetNoDroppedFrames(void) {
+  std::lock_guard<std::mutex> lock(mutex);
+  return noDroppedFrames;
+}
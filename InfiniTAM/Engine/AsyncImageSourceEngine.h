@@ -0,0 +1,96 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ImageSourceEngine.h"
+
+namespace InfiniTAM {
+namespace Engine {
+/** \brief
+    Captures images from another image source on a background thread,
+    so that waiting for the sensor and converting its images does not
+    add to the frame time of the thread that processes them.
+
+    The capture thread fills a small ring of preallocated image pairs
+    and stamps every pair with the time it was captured. How
+    getImages() picks from the captured pairs is set by the Policy;
+    pairs that are skipped are counted as dropped.
+*/
+class AsyncImageSourceEngine : public ImageSourceEngine {
+ public:
+  enum Policy {
+    /// Waits for a pair captured after the call to hasMoreImages() or, without
+    /// one, getImages(); older pairs are dropped
+    POLICY_NEXT_FRAME,
+    /// Takes the newest pair, older pairs are dropped; waits only if there is
+    /// no pair yet
+    POLICY_LATEST_FRAME,
+    /// Takes every pair in order; capture waits while the ring is full
+    POLICY_EVERY_FRAME
+  };
+
+  typedef std::chrono::steady_clock Clock;
+
+ private:
+  struct Frame {
+    ITMUChar4Image* rgb;
+    ITMShortImage* rawDepth;
+    Clock::time_point captureTime;
+  };
+
+  ImageSourceEngine* source;
+  Policy policy;
+  Vector2i imageSize_rgb, imageSize_d;
+
+  std::vector<Frame> frames;
+  std::vector<int> freeFrames;
+  std::deque<int> capturedFrames;
+  /// Frame the capture thread is filling, -1 if none
+  int capturingFrame;
+
+  std::mutex mutex;
+  std::condition_variable frameAvailable;
+  bool stopRequested, sourceFinished;
+  int noCapturedFrames, noDroppedFrames;
+  Clock::time_point lastCaptureTime;
+  /// Time the consumer asked for the pair it is waiting for
+  Clock::time_point requestTime;
+  bool hasRequest;
+
+  std::thread thread;
+
+  void Run(void);
+  /// Whether a pair getImages() may return is queued, mutex held
+  bool IsFrameReady(void) const;
+
+ public:
+  /** Starts capturing from @p source, which is deleted with this engine and
+      must not be used otherwise in the meantime. @p noFrames pairs are
+      allocated for the ring.
+  */
+  AsyncImageSourceEngine(ImageSourceEngine* source, Policy policy,
+                         int noFrames = 3);
+  ~AsyncImageSourceEngine();
+
+  /// Waits until a pair is captured or the source has no more images
+  bool hasMoreImages(void);
+  void getImages(ITMUChar4Image* rgb, ITMShortImage* rawDepth);
+  Vector2i getDepthImageSize(void) { return imageSize_d; }
+  Vector2i getRGBImageSize(void) { return imageSize_rgb; }
+
+  /// Capture time of the pair returned by the last getImages()
+  Clock::time_point GetLastCaptureTime(void);
+
+  int GetNoCapturedFrames(void);
+  /// Pairs captured but never returned by getImages()
+  int GetNoDroppedFrames(void);
+};
+}
+}
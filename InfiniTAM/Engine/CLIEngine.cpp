@@ -12,6 +12,43 @@
 using namespace InfiniTAM::Engine;
 CLIEngine* CLIEngine::instance;
 
+// frames of rendered images that can wait for the writer before images are
+// dropped
+static const int noQueuedRenderFrames = 4;
+
+static const struct {
+  const char* name;
+  ITMMainEngine::GetImageType type;
+} imageTypeNames[] = {
+    {"rgb", ITMMainEngine::InfiniTAM_IMAGE_ORIGINAL_RGB},
+    {"depth", ITMMainEngine::InfiniTAM_IMAGE_ORIGINAL_DEPTH},
+    {"raycast", ITMMainEngine::InfiniTAM_IMAGE_SCENERAYCAST},
+    {"shaded", ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_SHADED},
+    {"colour", ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_VOLUME},
+    {"normals", ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_NORMAL}};
+
+bool CLIEngine::ParseImageType(const char* name,
+                               ITMMainEngine::GetImageType& type) {
+  for (size_t i = 0; i < sizeof(imageTypeNames) / sizeof(imageTypeNames[0]);
+       i++) {
+    if (strcmp(name, imageTypeNames[i].name) == 0) {
+      type = imageTypeNames[i].type;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* CLIEngine::GetImageTypeName(ITMMainEngine::GetImageType type) {
+  for (size_t i = 0; i < sizeof(imageTypeNames) / sizeof(imageTypeNames[0]);
+       i++) {
+    if (imageTypeNames[i].type == type) {
+      return imageTypeNames[i].name;
+    }
+  }
+  return "unknown";
+}
+
 void CLIEngine::Initialise(ImageSourceEngine* imageSource,
                            IMUSourceEngine* imuSource,
                            ITMMainEngine* mainEngine,
@@ -26,6 +63,9 @@ void CLIEngine::Initialise(ImageSourceEngine* imageSource,
 
   this->currentFrameNo = 0;
 
+  this->renderEveryNthFrame = 0;
+  this->imageWriter = NULL;
+
   bool allocateGPU = false;
   if (deviceType == ITMLibSettings::DEVICE_CUDA) {
     allocateGPU = true;
@@ -85,11 +125,54 @@ bool CLIEngine::ProcessFrame() {
   printf("frame %i: time %.2f, avg %.2f\n", currentFrameNo, processedTime_inst,
          processedTime_avg);
 
+  if (imageWriter != NULL && currentFrameNo % renderEveryNthFrame == 0) {
+    RenderImages();
+  }
+
   currentFrameNo++;
 
   return true;
 }
 
+void CLIEngine::SetRenderOutput(
+    const std::vector<ITMMainEngine::GetImageType>& types, int everyNthFrame,
+    const char* outFolder) {
+  delete imageWriter;
+  imageWriter = NULL;
+
+  renderTypes = types;
+  renderEveryNthFrame = everyNthFrame;
+  renderFolder = outFolder;
+
+  if (!renderTypes.empty() && renderEveryNthFrame > 0) {
+    imageWriter =
+        new AsyncImageWriter(mainEngine->GetImageSize(),
+                             noQueuedRenderFrames * (int)renderTypes.size());
+  }
+}
+
+void CLIEngine::RenderImages() {
+  // the free camera looks from the tracked pose
+  ITMPose pose(*mainEngine->GetTrackingState()->pose_d);
+  ITMIntrinsics intrinsics = imageSource->calib.intrinsics_d;
+
+  for (size_t i = 0; i < renderTypes.size(); i++) {
+    ITMUChar4Image* image = imageWriter->GetImage();
+    if (image == NULL) {
+      continue;
+    }
+
+    image->ChangeDims(mainEngine->GetImageSize());
+    mainEngine->GetImage(image, renderTypes[i], &pose, &intrinsics);
+
+    char fileName[2048];
+    snprintf(fileName, sizeof(fileName), "%s/%s_%05d.ppm",
+             renderFolder.c_str(), GetImageTypeName(renderTypes[i]),
+             currentFrameNo);
+    imageWriter->Write(image, fileName);
+  }
+}
+
 void CLIEngine::Run() {
   while (true) {
     if (!ProcessFrame()) {
@@ -99,6 +182,15 @@ void CLIEngine::Run() {
 }
 
 void CLIEngine::Shutdown() {
+  if (imageWriter != NULL) {
+    imageWriter->Flush();
+    if (imageWriter->GetNoDroppedImages() > 0) {
+      printf("%d rendered images were dropped, the writer could not keep up\n",
+             imageWriter->GetNoDroppedImages());
+    }
+    delete imageWriter;
+  }
+
   sdkDeleteTimer(&timer_instant);
   sdkDeleteTimer(&timer_average);
 
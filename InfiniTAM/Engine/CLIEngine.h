@@ -4,9 +4,13 @@
 
 #include "../ITMLib/Engine/ITMMainEngine.h"
 #include "../ITMLib/Utils/ITMLibSettings.h"
+#include "../Utils/AsyncImageWriter.h"
 #include "../Utils/FileUtils.h"
 #include "../Utils/NVTimer.h"
 
+#include <string>
+#include <vector>
+
 #include "ImageSourceEngine.h"
 #include "IMUSourceEngine.h"
 
@@ -31,6 +35,13 @@ namespace InfiniTAM
 			ITMIMUMeasurement *inputIMUMeasurement;
 
 			int currentFrameNo;
+
+			std::vector<ITMMainEngine::GetImageType> renderTypes;
+			int renderEveryNthFrame;
+			std::string renderFolder;
+			AsyncImageWriter *imageWriter;
+
+			void RenderImages(void);
 		public:
 			static CLIEngine* Instance(void) {
 				if (instance == NULL) instance = new CLIEngine();
@@ -43,6 +54,17 @@ namespace InfiniTAM
 				ITMLibSettings::DeviceType deviceType);
 			void Shutdown();
 
+			/** Renders the given images of every Nth frame and writes them
+			    to outFolder as <name>_<frame>.ppm on a background thread.
+			    The free camera images are rendered from the tracked pose.
+			    Call after Initialise().
+			*/
+			void SetRenderOutput(const std::vector<ITMMainEngine::GetImageType> & types, int everyNthFrame, const char *outFolder);
+
+			/// Names of the image types for SetRenderOutput(), e.g. "raycast" or "depth"
+			static bool ParseImageType(const char *name, ITMMainEngine::GetImageType & type);
+			static const char* GetImageTypeName(ITMMainEngine::GetImageType type);
+
 			void Run();
 			bool ProcessFrame();
 		};
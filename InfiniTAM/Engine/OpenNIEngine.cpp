@@ -10,6 +10,10 @@
 #ifndef COMPILE_WITHOUT_OpenNI
 #include <OpenNI.h>
 
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
 using namespace InfiniTAM::Engine;
 
 class OpenNIEngine::PrivateData {
@@ -23,6 +27,26 @@ class OpenNIEngine::PrivateData {
 	openni::VideoStream **streams;
 };
 
+/// Expands @p noPixels packed RGB888 pixels to RGBA with alpha 255
+static void convertRGB888ToRGBA(const unsigned char *src, unsigned char *dst, int noPixels)
+{
+	int i = 0;
+#ifdef __SSSE3__
+	// four pixels per step, the 16 byte load reads 4 bytes past them
+	const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+	for (; i + 6 <= noPixels; i += 4)
+	{
+		__m128i pix = _mm_loadu_si128((const __m128i*)(src + 3 * i));
+		_mm_storeu_si128((__m128i*)(dst + 4 * i), _mm_or_si128(_mm_shuffle_epi8(pix, shuffle), alpha));
+	}
+#endif
+	for (; i < noPixels; i++)
+	{
+		dst[4 * i] = src[3 * i]; dst[4 * i + 1] = src[3 * i + 1]; dst[4 * i + 2] = src[3 * i + 2]; dst[4 * i + 3] = 255;
+	}
+}
+
 static openni::VideoMode findBestMode(const openni::SensorInfo *sensorInfo, int requiredResolutionX = -1, int requiredResolutionY = -1, openni::PixelFormat requiredPixelFormat = (openni::PixelFormat)-1)
 {
 	const openni::Array<openni::VideoMode> & modes = sensorInfo->getSupportedVideoModes();
@@ -248,13 +272,8 @@ void OpenNIEngine::getImages(ITMUChar4Image *rgbImage, ITMShortImage *rawDepthIm
 	Vector4u *rgb = rgbImage->GetData(MEMORYDEVICE_CPU);
 	if (colorAvailable)
 	{
-		const openni::RGB888Pixel* colorImagePix = (const openni::RGB888Pixel*)data->colorFrame.getData();
-		for (int i = 0; i < rgbImage->noDims.x * rgbImage->noDims.y; i++)
-		{
-			Vector4u newPix; openni::RGB888Pixel oldPix = colorImagePix[i];
-			newPix.x = oldPix.r; newPix.y = oldPix.g; newPix.z = oldPix.b; newPix.w = 255;
-			rgb[i] = newPix;
-		}
+		const unsigned char *colorImagePix = (const unsigned char*)data->colorFrame.getData();
+		convertRGB888ToRGBA(colorImagePix, (unsigned char*)rgb, rgbImage->noDims.x * rgbImage->noDims.y);
 	}
 	else memset(rgb, 0, rgbImage->dataSize * sizeof(Vector4u));
 
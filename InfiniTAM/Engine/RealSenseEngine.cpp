@@ -93,8 +93,6 @@ void RealSenseEngine::getImages(ITMUChar4Image* rgbImage,
   Vector4u* rgb = rgbImage->GetData(MEMORYDEVICE_CPU);
 
   Vector2i noDims = rawDepthImage->noDims;
-  rawDepthImage->Clear();
-  rgbImage->Clear();
 
   for (int y = 0; y < noDims.y; y++)
     for (int x = 0; x < noDims.x; x++)
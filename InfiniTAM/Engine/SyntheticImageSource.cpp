@@ -0,0 +1,180 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "SyntheticImageSource.h"
+
+#include <math.h>
+
+using namespace InfiniTAM::Engine;
+
+/// Depth beyond the range of the sensor is invalid
+static const float maxSensorDepth = 5.0f;
+
+/// Distance along the ray to the nearest face of an axis aligned box, if the
+/// ray enters it closer than @p best
+static float IntersectBox(const Vector3f& origin, const Vector3f& direction,
+                          const Vector3f& boxMin, const Vector3f& boxMax,
+                          float best) {
+  float t0 = 0.0f, t1 = best;
+  for (int a = 0; a < 3; a++) {
+    if (fabsf(direction[a]) < 1e-6f) {
+      if (origin[a] < boxMin[a] || origin[a] > boxMax[a]) return best;
+      continue;
+    }
+    float ta = (boxMin[a] - origin[a]) / direction[a];
+    float tb = (boxMax[a] - origin[a]) / direction[a];
+    if (ta > tb) {
+      float t = ta;
+      ta = tb;
+      tb = t;
+    }
+    if (ta > t0) t0 = ta;
+    if (tb < t1) t1 = tb;
+  }
+  return (t0 < t1 && t0 > 0.0f) ? t0 : best;
+}
+
+/// Distance along the ray to the walls of a box seen from the inside
+static float IntersectWalls(const Vector3f& origin, const Vector3f& direction,
+                            const Vector3f& boxMin, const Vector3f& boxMax,
+                            int noAxes, float best) {
+  for (int a = 0; a < noAxes; a++) {
+    if (fabsf(direction[a]) < 1e-6f) continue;
+    float t0 = (boxMin[a] - origin[a]) / direction[a];
+    float t1 = (boxMax[a] - origin[a]) / direction[a];
+    if (t0 > 0.0f && t0 < best) best = t0;
+    if (t1 > 0.0f && t1 < best) best = t1;
+  }
+  return best;
+}
+
+SyntheticImageSource::SyntheticImageSource(const char* calibFilename,
+                                           SceneType sceneType, int noFrames,
+                                           Vector2i setImageSize, float ratio,
+                                           int noReturnFrames)
+    : ImageSourceEngine(calibFilename),
+      sceneType(sceneType),
+      noFrames(noFrames),
+      noReturnFrames(noReturnFrames),
+      currentFrameNo(0),
+      imgSize(setImageSize) {
+  ITMIntrinsics* intrinsics[2] = {&calib.intrinsics_d, &calib.intrinsics_rgb};
+  for (int i = 0; i < 2; i++) {
+    intrinsics[i]->projectionParamsSimple.fx *= ratio;
+    intrinsics[i]->projectionParamsSimple.fy *= ratio;
+    intrinsics[i]->projectionParamsSimple.px *= ratio;
+    intrinsics[i]->projectionParamsSimple.py *= ratio;
+    intrinsics[i]->projectionParamsSimple.all *= ratio;
+  }
+
+  calib.disparityCalib.SetFrom(1.0f / 1000.0f, 0.0f,
+                               ITMDisparityCalib::TRAFO_AFFINE);
+}
+
+ITMPose SyntheticImageSource::getPose(int frameNo) const {
+  ITMPose pose;
+
+  if (sceneType == SCENE_ROOM) {
+    pose.SetFrom(0.01f * frameNo, 0.003f * frameNo, 0.0f, 0.0f, 0.01f * frameNo,
+                 0.0f);
+    return pose;
+  }
+
+  int noForwardFrames = noFrames - noReturnFrames;
+  bool isReturning = frameNo >= noForwardFrames;
+  float z = 0.2f * (isReturning ? 2 * noForwardFrames - frameNo - 1 : frameNo);
+
+  Matrix4f cameraToWorld;
+  cameraToWorld.setIdentity();
+  if (isReturning) cameraToWorld.m00 = cameraToWorld.m22 = -1.0f;
+  cameraToWorld.m30 = 0.1f;
+  cameraToWorld.m32 = z;
+  pose.SetInvM(cameraToWorld);
+  return pose;
+}
+
+float SyntheticImageSource::CastRay(const Vector3f& origin,
+                                    const Vector3f& direction) const {
+  float best = 1e9f;
+
+  if (sceneType == SCENE_ROOM) {
+    Vector3f centre(0.2f, 0.1f, 2.0f), oc = origin - centre;
+    float radius = 0.5f;
+    float b = dot(oc, direction), c = dot(oc, oc) - radius * radius;
+    if (b * b - c > 0.0f) {
+      float t = -b - sqrtf(b * b - c);
+      if (t > 0.0f) best = t;
+    }
+
+    best = IntersectWalls(origin, direction, Vector3f(-2.0f, -1.5f, -1.0f),
+                          Vector3f(2.0f, 1.5f, 3.5f), 3, best);
+    return IntersectBox(origin, direction, Vector3f(-1.0f, 0.6f, 1.8f),
+                        Vector3f(-0.4f, 1.5f, 2.6f), best);
+  }
+
+  // the corridor is open along z
+  best = IntersectWalls(origin, direction, Vector3f(-1.0f, -1.2f, 0.0f),
+                        Vector3f(1.0f, 1.2f, 0.0f), 2, best);
+
+  int firstPillar = (int)floorf((origin.z - maxSensorDepth) / 4.0f);
+  int lastPillar = (int)floorf((origin.z + maxSensorDepth) / 4.0f);
+  for (int k = firstPillar; k <= lastPillar; k++)
+    best = IntersectBox(origin, direction, Vector3f(-1.0f, -1.2f, 4.0f * k),
+                        Vector3f(-0.7f, 1.2f, 4.0f * k + 0.4f), best);
+
+  return best;
+}
+
+void SyntheticImageSource::Render(ITMShortImage* rawDepth, ITMUChar4Image* rgb,
+                                  const ITMIntrinsics& intrinsics,
+                                  const Matrix4f& cameraToWorld) {
+  const Vector4f& proj = intrinsics.projectionParamsSimple.all;
+  Vector3f origin(cameraToWorld.m30, cameraToWorld.m31, cameraToWorld.m32);
+
+  short* depth = rawDepth != NULL ? rawDepth->GetData(MEMORYDEVICE_CPU) : NULL;
+  Vector4u* colour = rgb != NULL ? rgb->GetData(MEMORYDEVICE_CPU) : NULL;
+
+#ifdef WITH_OPENMP
+#pragma omp parallel for
+#endif
+  for (int y = 0; y < imgSize.y; y++)
+    for (int x = 0; x < imgSize.x; x++) {
+      Vector4f ray = cameraToWorld * Vector4f((x - proj.z) / proj.x,
+                                              (y - proj.w) / proj.y, 1.0f,
+                                              0.0f);
+      Vector3f direction(ray.x, ray.y, ray.z);
+      float norm = sqrtf(dot(direction, direction));
+      direction /= norm;
+
+      float t = CastRay(origin, direction);
+      float z = t / norm;
+
+      int idx = x + y * imgSize.x;
+      if (depth != NULL)
+        depth[idx] =
+            z > maxSensorDepth ? 0 : (short)(z * 1000.0f + 0.5f);
+
+      if (colour != NULL) {
+        // a 10 cm checkerboard, so that the colour trackers find gradients
+        Vector3f hit = origin + direction * t;
+        int cell = ((int)floorf(hit.x * 10.0f) + (int)floorf(hit.y * 10.0f) +
+                    (int)floorf(hit.z * 10.0f)) & 1;
+        colour[idx] = Vector4u((uchar)(cell ? 200 : 50),
+                               (uchar)(cell ? 150 : 100), (uchar)128, 255);
+      }
+    }
+}
+
+void SyntheticImageSource::getImages(ITMUChar4Image* rgb,
+                                     ITMShortImage* rawDepth) {
+  currentPose = getPose(currentFrameNo);
+
+  Matrix4f cameraToWorld = currentPose.GetInvM();
+  rgb->ChangeDims(imgSize);
+  rawDepth->ChangeDims(imgSize);
+
+  Render(rawDepth, NULL, calib.intrinsics_d, cameraToWorld);
+  Render(NULL, rgb, calib.intrinsics_rgb,
+         cameraToWorld * calib.trafo_rgb_to_depth.calib);
+
+  ++currentFrameNo;
+}
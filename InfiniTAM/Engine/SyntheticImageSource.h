@@ -0,0 +1,59 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "ImageSourceEngine.h"
+
+namespace InfiniTAM {
+namespace Engine {
+/** Renders the depth and colour images of an analytic scene along a
+    scripted camera path, for the test programs that must run without a
+    recorded sequence. The intrinsics and extrinsics are taken from the
+    calibration file, the depth is written in millimetres.
+*/
+class SyntheticImageSource : public ImageSourceEngine {
+ public:
+  enum SceneType {
+    /// A 4 x 3 x 4.5 m box with a sphere and a cuboid in it, the camera
+    /// sweeps sideways while it turns slowly
+    SCENE_ROOM,
+    /// A 2 m wide corridor along z with a pillar every 4 m, the camera walks
+    /// it forward 0.2 m per frame and turns around for the last
+    /// noReturnFrames frames
+    SCENE_CORRIDOR
+  };
+
+ private:
+  SceneType sceneType;
+  int noFrames, noReturnFrames;
+  int currentFrameNo;
+  Vector2i imgSize;
+  ITMPose currentPose;
+
+  float CastRay(const Vector3f& origin, const Vector3f& direction) const;
+  void Render(ITMShortImage* rawDepth, ITMUChar4Image* rgb,
+              const ITMIntrinsics& intrinsics, const Matrix4f& cameraToWorld);
+
+ public:
+  /** Renders @p noFrames images of @p setImageSize. As with CalibSource,
+      @p ratio scales the intrinsics of the calibration file.
+  */
+  SyntheticImageSource(const char* calibFilename, SceneType sceneType,
+                       int noFrames,
+                       Vector2i setImageSize = Vector2i(640, 480),
+                       float ratio = 1.0f, int noReturnFrames = 0);
+  ~SyntheticImageSource() {}
+
+  /// Ground truth pose of a frame, as in ITMTrackingState::pose_d
+  ITMPose getPose(int frameNo) const;
+
+  /// Ground truth pose of the frame last returned by getImages()
+  const ITMPose& getCurrentPose(void) const { return currentPose; }
+
+  bool hasMoreImages(void) { return currentFrameNo < noFrames; }
+  void getImages(ITMUChar4Image* rgb, ITMShortImage* rawDepth);
+  Vector2i getDepthImageSize(void) { return imgSize; }
+  Vector2i getRGBImageSize(void) { return imgSize; }
+};
+}
+}
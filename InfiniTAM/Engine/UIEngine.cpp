@@ -19,6 +19,8 @@
 #endif
 #endif
 
+#include <chrono>
+
 #include "../Utils/FileUtils.h"
 
 using namespace InfiniTAM::Engine;
@@ -34,21 +36,43 @@ static void safe_glutBitmapString(void* font, const char* str) {
 void UIEngine::glutDisplayFunction() {
   UIEngine* uiEngine = UIEngine::Instance();
 
-  // get updated images from processing thread
-  uiEngine->mainEngine->GetImage(
-      uiEngine->outImage[0], uiEngine->outImageType[0], &uiEngine->freeviewPose,
-      &uiEngine->freeviewIntrinsics);
+  // upload the images last rendered by the processing thread, the textures
+  // are only reallocated when the size of an image changes
+  float processedTime;
+  {
+    std::lock_guard<std::mutex> lock(uiEngine->viewMutex);
+    if (uiEngine->newImagesAvailable) {
+      for (int w = 0; w < NUM_WIN; ++w) {
+        const ITMUChar4Image* image = uiEngine->outImage[w];
+        if (uiEngine->outImageType[w] ==
+                ITMMainEngine::InfiniTAM_IMAGE_UNKNOWN ||
+            image->noDims.x * image->noDims.y == 0)
+          continue;
 
-  for (int w = 1; w < NUM_WIN; ++w)
-    uiEngine->mainEngine->GetImage(uiEngine->outImage[w],
-                                   uiEngine->outImageType[w]);
+        glBindTexture(GL_TEXTURE_2D, uiEngine->textureId[w]);
+        if (uiEngine->textureSize[w] != image->noDims) {
+          glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image->noDims.x,
+                       image->noDims.y, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                       image->GetData(MEMORYDEVICE_CPU));
+          glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+          glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+          uiEngine->textureSize[w] = image->noDims;
+        } else {
+          glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image->noDims.x,
+                          image->noDims.y, GL_RGBA, GL_UNSIGNED_BYTE,
+                          image->GetData(MEMORYDEVICE_CPU));
+        }
+      }
+      uiEngine->newImagesAvailable = false;
+    }
+    processedTime = uiEngine->renderedTime;
+  }
 
   // do the actual drawing
   glClear(GL_COLOR_BUFFER_BIT);
   glColor3f(1.0f, 1.0f, 1.0f);
   glEnable(GL_TEXTURE_2D);
 
-  ITMUChar4Image** showImgs = uiEngine->outImage;
   Vector4f* winReg = uiEngine->winReg;
   glMatrixMode(GL_PROJECTION);
   glPushMatrix();
@@ -61,14 +85,8 @@ void UIEngine::glutDisplayFunction() {
     {
       glEnable(GL_TEXTURE_2D);
       for (int w = 0; w < NUM_WIN; ++w) {  // Draw each sub window
-        if (uiEngine->outImageType[w] == ITMMainEngine::InfiniTAM_IMAGE_UNKNOWN)
-          continue;
+        if (uiEngine->textureSize[w] == Vector2i(0, 0)) continue;
         glBindTexture(GL_TEXTURE_2D, uiEngine->textureId[w]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, showImgs[w]->noDims.x,
-                     showImgs[w]->noDims.y, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-                     showImgs[w]->GetData(MEMORYDEVICE_CPU));
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glBegin(GL_QUADS);
         {
           glTexCoord2f(0, 1);
@@ -93,7 +111,7 @@ void UIEngine::glutDisplayFunction() {
   glRasterPos2f(0.85f, -0.962f);
 
   char str[200];
-  sprintf(str, "%04.2lf", uiEngine->processedTime);
+  sprintf(str, "%04.2lf", processedTime);
   safe_glutBitmapString(GLUT_BITMAP_HELVETICA_18, (const char*)str);
 
   glRasterPos2f(-0.95f, -0.95f);
@@ -113,44 +131,44 @@ void UIEngine::glutDisplayFunction() {
   safe_glutBitmapString(GLUT_BITMAP_HELVETICA_12, (const char*)str);
 
   glutSwapBuffers();
-  uiEngine->needsRefresh = false;
 }
 
 void UIEngine::glutIdleFunction() {
   UIEngine* uiEngine = UIEngine::Instance();
 
-  switch (uiEngine->mainLoopAction) {
-    case PROCESS_FRAME:
-      uiEngine->ProcessFrame();
-      ++uiEngine->processedFrameNo;
-      uiEngine->mainLoopAction = PROCESS_PAUSED;
-      uiEngine->needsRefresh = true;
-      break;
-    case PROCESS_VIDEO:
-      uiEngine->ProcessFrame();
-      ++uiEngine->processedFrameNo;
-      uiEngine->needsRefresh = true;
-      break;
-    case EXIT:
+  if (uiEngine->mainLoopAction == EXIT) {
+    uiEngine->StopProcessing();
 #ifdef FREEGLUT
-      glutLeaveMainLoop();
+    glutLeaveMainLoop();
 #else
-      exit(0);
+    exit(0);
 #endif
-      break;
-    case PROCESS_PAUSED:
-    default:
-      break;
+    return;
   }
 
-  if (uiEngine->needsRefresh) {
+  bool newImagesAvailable;
+  {
+    std::lock_guard<std::mutex> lock(uiEngine->viewMutex);
+    newImagesAvailable = uiEngine->newImagesAvailable;
+  }
+
+  if (newImagesAvailable) {
     glutPostRedisplay();
+  } else {
+    // leave the cores to the processing thread until there is something new
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
   }
 }
 
 void UIEngine::glutKeyUpFunction(unsigned char key, int x, int y) {
   UIEngine* uiEngine = UIEngine::Instance();
 
+  // some keys change the engine, so wait for the frame being processed
+  std::unique_lock<std::mutex> engineLock(uiEngine->engineMutex,
+                                          std::defer_lock);
+  std::unique_lock<std::mutex> viewLock(uiEngine->viewMutex, std::defer_lock);
+  std::lock(engineLock, viewLock);
+
   switch (key) {
     case 'n':
       printf("processing one frame ...\n");
@@ -192,8 +210,6 @@ void UIEngine::glutKeyUpFunction(unsigned char key, int x, int y) {
         if (uiEngine->mainEngine->GetView() != NULL) {
           uiEngine->freeviewIntrinsics =
               uiEngine->mainEngine->GetView()->calib->intrinsics_d;
-          uiEngine->outImage[0]->ChangeDims(
-              uiEngine->mainEngine->GetView()->depth->noDims);
         }
         uiEngine->freeviewActive = true;
       }
@@ -217,7 +233,7 @@ void UIEngine::glutKeyUpFunction(unsigned char key, int x, int y) {
       break;
     case 'w':
       printf("saving mesh to disk ...");
-      uiEngine->SaveSceneToMesh("mesh.stl");
+      uiEngine->mainEngine->SaveSceneToMesh("mesh.stl");
       printf(" done\n");
       break;
     default:
@@ -228,6 +244,10 @@ void UIEngine::glutKeyUpFunction(unsigned char key, int x, int y) {
     uiEngine->outImageType[0] =
         uiEngine->colourModes[uiEngine->currentColourMode].type;
   }
+
+  viewLock.unlock();
+  engineLock.unlock();
+  uiEngine->processingSignal.notify_all();
 }
 
 void UIEngine::glutMouseButtonFunction(int button, int state, int x, int y) {
@@ -300,6 +320,7 @@ void UIEngine::glutMouseMoveFunction(int x, int y) {
   static const float scale_rotation = 0.005f;
   static const float scale_translation = 0.0025f;
 
+  std::unique_lock<std::mutex> lock(uiEngine->viewMutex);
   switch (uiEngine->mouseState) {
     case 1: {
       // left button: rotation
@@ -334,6 +355,8 @@ void UIEngine::glutMouseMoveFunction(int x, int y) {
     default:
       break;
   }
+  lock.unlock();
+  uiEngine->processingSignal.notify_all();
 }
 
 void UIEngine::glutMouseWheelFunction(int button, int dir, int x, int y) {
@@ -341,10 +364,14 @@ void UIEngine::glutMouseWheelFunction(int button, int dir, int x, int y) {
 
   static const float scale_translation = 0.05f;
 
-  uiEngine->freeviewPose.SetT(
-      uiEngine->freeviewPose.GetT() +
-      scale_translation * Vector3f(0.0f, 0.0f, (dir > 0) ? -1.0f : 1.0f));
-  uiEngine->needsRefresh = true;
+  {
+    std::lock_guard<std::mutex> lock(uiEngine->viewMutex);
+    uiEngine->freeviewPose.SetT(
+        uiEngine->freeviewPose.GetT() +
+        scale_translation * Vector3f(0.0f, 0.0f, (dir > 0) ? -1.0f : 1.0f));
+    uiEngine->needsRefresh = true;
+  }
+  uiEngine->processingSignal.notify_all();
 }
 
 void UIEngine::Initialise(int& argc, char** argv,
@@ -360,7 +387,7 @@ void UIEngine::Initialise(int& argc, char** argv,
   this->currentColourMode = 0;
   this->colourModes.push_back(UIColourMode(
       "shaded greyscale", ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_SHADED));
-  if (ITMVoxel::hasColorInformation) {
+  if (mainEngine->GetSettings()->VoxelHasColourInformation()) {
     this->colourModes.push_back(UIColourMode(
         "integrated colours",
         ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_VOLUME));
@@ -426,9 +453,13 @@ void UIEngine::Initialise(int& argc, char** argv,
   bool allocateGPU = false;
   if (deviceType == ITMLibSettings::DEVICE_CUDA) allocateGPU = true;
 
-  for (int w = 0; w < NUM_WIN; ++w)
+  for (int w = 0; w < NUM_WIN; ++w) {
     outImage[w] =
         new ITMUChar4Image(imageSource->getDepthImageSize(), true, allocateGPU);
+    renderImage[w] =
+        new ITMUChar4Image(imageSource->getDepthImageSize(), true, allocateGPU);
+    textureSize[w] = Vector2i(0, 0);
+  }
 
   inputRGBImage =
       new ITMUChar4Image(imageSource->getRGBImageSize(), true, allocateGPU);
@@ -449,9 +480,12 @@ void UIEngine::Initialise(int& argc, char** argv,
 
   mainLoopAction = PROCESS_PAUSED;
   mouseState = 0;
-  needsRefresh = false;
+  needsRefresh = true;  // shows the first images before any processing
   processedFrameNo = 0;
   processedTime = 0.0f;
+  renderedTime = 0.0f;
+  newImagesAvailable = false;
+  stopProcessing = false;
 
 #ifndef COMPILE_WITHOUT_CUDA
   ITMSafeCall(cudaThreadSynchronize());
@@ -471,7 +505,8 @@ void UIEngine::SaveScreenshot(const char* filename) const {
   SaveImageToFile(&screenshot, filename, true);
 }
 
-void UIEngine::SaveSceneToMesh(const char* filename) const {
+void UIEngine::SaveSceneToMesh(const char* filename) {
+  std::lock_guard<std::mutex> lock(engineMutex);
   mainEngine->SaveSceneToMesh(filename);
 }
 
@@ -480,16 +515,16 @@ void UIEngine::GetScreenshot(ITMUChar4Image* dest) const {
                dest->GetData(MEMORYDEVICE_CPU));
 }
 
-void UIEngine::ProcessFrame() {
+bool UIEngine::ProcessFrame() {
   if (!imageSource->hasMoreImages()) {
-    return;
+    return false;
   }
   // std::cout << "gettingImages" << std::endl;
   imageSource->getImages(inputRGBImage, inputRawDepthImage);
 
   if (imuSource != NULL) {
     if (!imuSource->hasMoreMeasurements()) {
-      return;
+      return false;
     } else {
       imuSource->getMeasurement(inputIMUMeasurement);
     }
@@ -498,11 +533,11 @@ void UIEngine::ProcessFrame() {
   if (isRecording) {
     char str[250];
 
-    sprintf(str, "%s/%04d.pgm", outFolder, currentFrameNo);
+    sprintf(str, "%s/%04d.pgm", outFolder, currentFrameNo.load());
     SaveImageToFile(inputRawDepthImage, str);
 
     if (inputRGBImage->noDims != Vector2i(0, 0)) {
-      sprintf(str, "%s/%04d.ppm", outFolder, currentFrameNo);
+      sprintf(str, "%s/%04d.ppm", outFolder, currentFrameNo.load());
       SaveImageToFile(inputRGBImage, str);
     }
   }
@@ -529,15 +564,95 @@ void UIEngine::ProcessFrame() {
   processedTime = sdkGetAverageTimerValue(&timer_average);
 
   ++currentFrameNo;
+  return true;
+}
+
+void UIEngine::RenderImages() {
+  ITMMainEngine::GetImageType imageType[NUM_WIN];
+  ITMPose pose;
+  ITMIntrinsics intrinsics;
+  {
+    std::lock_guard<std::mutex> lock(viewMutex);
+    for (int w = 0; w < NUM_WIN; ++w) imageType[w] = outImageType[w];
+    pose.SetFrom(&freeviewPose);
+    intrinsics = freeviewIntrinsics;
+  }
+
+  for (int w = 0; w < NUM_WIN; ++w) {
+    if (imageType[w] == ITMMainEngine::InfiniTAM_IMAGE_UNKNOWN) continue;
+
+    // the free viewpoint is rendered at the size of the depth images
+    renderImage[w]->ChangeDims(imageSource->getDepthImageSize());
+    mainEngine->GetImage(renderImage[w], imageType[w], &pose, &intrinsics);
+  }
+
+  std::lock_guard<std::mutex> lock(viewMutex);
+  for (int w = 0; w < NUM_WIN; ++w) std::swap(outImage[w], renderImage[w]);
+  renderedTime = processedTime;
+  newImagesAvailable = true;
+}
+
+void UIEngine::ProcessingLoop() {
+  while (true) {
+    MainLoopAction action;
+    {
+      // the action can also be changed from other threads without notifying
+      std::unique_lock<std::mutex> lock(viewMutex);
+      processingSignal.wait_for(lock, std::chrono::milliseconds(10), [this] {
+        return stopProcessing || needsRefresh ||
+               mainLoopAction == PROCESS_FRAME ||
+               mainLoopAction == PROCESS_VIDEO;
+      });
+      if (stopProcessing) break;
+
+      action = mainLoopAction;
+      if (action == PROCESS_FRAME) {
+        mainLoopAction.compare_exchange_strong(action, PROCESS_PAUSED);
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(engineMutex);
+    bool processed = false;
+    if (action == PROCESS_FRAME || action == PROCESS_VIDEO) {
+      processed = ProcessFrame();
+      if (processed) ++processedFrameNo;
+    }
+
+    if (processed || needsRefresh.exchange(false)) {
+      RenderImages();
+    } else if (action == PROCESS_VIDEO) {
+      // the sources are exhausted, wait for the view to change
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+}
+
+void UIEngine::StopProcessing() {
+  if (!processingThread.joinable()) return;
+
+  {
+    std::lock_guard<std::mutex> lock(viewMutex);
+    stopProcessing = true;
+  }
+  processingSignal.notify_all();
+  processingThread.join();
+}
+
+void UIEngine::Run() {
+  processingThread = std::thread(&UIEngine::ProcessingLoop, this);
+  glutMainLoop();
+  StopProcessing();
 }
 
-void UIEngine::Run() { glutMainLoop(); }
 void UIEngine::Shutdown() {
+  StopProcessing();
+
   sdkDeleteTimer(&timer_instant);
   sdkDeleteTimer(&timer_average);
 
   for (int w = 0; w < NUM_WIN; ++w) {
     delete outImage[w];
+    delete renderImage[w];
   }
 
   delete inputRGBImage;
@@ -10,10 +10,22 @@
 #include "IMUSourceEngine.h"
 #include "ImageSourceEngine.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 namespace InfiniTAM {
 namespace Engine {
+/** \brief
+    Shows the images of the main engine in a GLUT window.
+
+    The frames are processed on a separate thread, which also renders the
+    images of the windows after each frame or when the free viewpoint
+    changes. The GLUT thread only uploads the last rendered images, so the
+    display never holds up processing.
+*/
 class UIEngine {
   static UIEngine* instance;
 
@@ -39,9 +51,29 @@ class UIEngine {
   Vector4f winReg[NUM_WIN];  // (x1, y1, x2, y2)
   Vector2i winSize;
   uint textureId[NUM_WIN];
-  ITMUChar4Image* outImage[NUM_WIN];
+  Vector2i textureSize[NUM_WIN];
   ITMMainEngine::GetImageType outImageType[NUM_WIN];
 
+  // Double buffered images of the windows: the processing thread renders
+  // into renderImage and swaps it with outImage, which the display uploads.
+  ITMUChar4Image* outImage[NUM_WIN];
+  ITMUChar4Image* renderImage[NUM_WIN];
+  bool newImagesAvailable;
+  float renderedTime;
+
+  // viewMutex guards the images and the view settings shared with the
+  // processing thread (outImageType, freeviewPose, freeviewIntrinsics),
+  // engineMutex the main engine while a frame is processed or rendered.
+  std::mutex viewMutex;
+  std::mutex engineMutex;
+  std::condition_variable processingSignal;
+  std::thread processingThread;
+  bool stopProcessing;
+
+  void ProcessingLoop();
+  void RenderImages();
+  void StopProcessing();
+
   ITMUChar4Image* inputRGBImage;
   ITMShortImage* inputRawDepthImage;
   ITMIMUMeasurement* inputIMUMeasurement;
@@ -54,8 +86,8 @@ class UIEngine {
   int mouseState;
   Vector2i mouseLastClick;
 
-  int currentFrameNo;
-  bool isRecording;
+  std::atomic<int> currentFrameNo;
+  std::atomic<bool> isRecording;
 
  public:
   static UIEngine* Instance(void) {
@@ -68,7 +100,9 @@ class UIEngine {
     PROCESS_VIDEO,
     EXIT,
     SAVE_TO_DISK
-  } mainLoopAction;
+  };
+  /// Read by the processing thread, can be changed from any thread
+  std::atomic<MainLoopAction> mainLoopAction;
 
   static void glutDisplayFunction();
   static void glutIdleFunction();
@@ -82,7 +116,9 @@ class UIEngine {
   float processedTime;
   int processedFrameNo;
   char* outFolder;
-  bool needsRefresh;
+  /// Requests the images to be rendered again, e.g. after moving the free
+  /// viewpoint
+  std::atomic<bool> needsRefresh;
   ITMUChar4Image* saveImage;
 
   void Initialise(int& argc, char** argv, ImageSourceEngine* imageSource,
@@ -90,12 +126,14 @@ class UIEngine {
                   const char* outFolder, ITMLibSettings::DeviceType deviceType);
   void Shutdown();
 
+  /// Starts the processing thread and runs the GLUT main loop
   void Run();
-  void ProcessFrame();
+  /// Processes the next frame, false if the sources have no more data
+  bool ProcessFrame();
 
   void GetScreenshot(ITMUChar4Image* dest) const;
   void SaveScreenshot(const char* filename) const;
-  void SaveSceneToMesh(const char* filename) const;
+  void SaveSceneToMesh(const char* filename);
 };
 }
 }
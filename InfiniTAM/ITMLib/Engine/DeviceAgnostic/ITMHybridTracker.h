@@ -0,0 +1,160 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "../../Utils/ITMLibDefines.h"
+#include "ITMPixelUtils.h"
+#include "ITMDepthTracker.h"
+
+/// Residuals of the photometric term above this value (in intensities between 0 and 1) are down-weighted (Huber).
+#define HYBRID_PHOTOMETRIC_HUBER 0.1f
+
+_CPU_AND_GPU_CODE_ inline float hybridIntensity(const THREADPTR(Vector4f) & colour)
+{
+	return (colour.x + colour.y + colour.z) * (1.0f / (3.0f * 255.0f));
+}
+
+/** Derivatives of a point in world coordinates with respect to the
+    parameters of the pose update, in the same order as the rows of
+    computePerPointGH_Depth_Ab.
+*/
+template<bool shortIteration, bool rotationOnly>
+_CPU_AND_GPU_CODE_ inline void computeHybridPointDerivatives(THREADPTR(Vector3f) *d_pt, const THREADPTR(Vector4f) & pt)
+{
+	Vector3f d_rot[3], d_trans[3];
+
+	d_rot[0].x = 0.0f;   d_rot[0].y = pt.z;   d_rot[0].z = -pt.y;
+	d_rot[1].x = -pt.z;  d_rot[1].y = 0.0f;   d_rot[1].z = pt.x;
+	d_rot[2].x = pt.y;   d_rot[2].y = -pt.x;  d_rot[2].z = 0.0f;
+
+	d_trans[0].x = 1.0f; d_trans[0].y = 0.0f; d_trans[0].z = 0.0f;
+	d_trans[1].x = 0.0f; d_trans[1].y = 1.0f; d_trans[1].z = 0.0f;
+	d_trans[2].x = 0.0f; d_trans[2].y = 0.0f; d_trans[2].z = 1.0f;
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (shortIteration) d_pt[i] = rotationOnly ? d_rot[i] : d_trans[i];
+		else { d_pt[i] = d_rot[i]; d_pt[i + 3] = d_trans[i]; }
+	}
+}
+
+/** Photometric term of the hybrid tracker. The depth pixel (x, y) of
+    the current frame is looked up in the current colour image and,
+    after transforming it with @p approxInvPose, in the colour image of
+    the reference frame, whose camera pose is @p refPose. The row of
+    the linearised system is returned in A and b, scaled by the square
+    root of the robust weight.
+*/
+template<bool shortIteration, bool rotationOnly>
+_CPU_AND_GPU_CODE_ inline bool computePerPointGH_Hybrid_Photometric_Ab(THREADPTR(float) *A, THREADPTR(float) &b,
+	const THREADPTR(int) & x, const THREADPTR(int) & y, const CONSTPTR(float) &depth, const CONSTPTR(Vector4f) & viewIntrinsics,
+	const CONSTPTR(Matrix4f) & approxInvPose, const CONSTPTR(Matrix4f) & depthToRGB, const CONSTPTR(Vector4f) & rgbIntrinsics,
+	const CONSTPTR(Vector2i) & rgbImageSize, const CONSTPTR(Vector4u) *rgb, const CONSTPTR(Vector2i) & refImageSize,
+	const CONSTPTR(Matrix4f) & refPose, const CONSTPTR(Vector4u) *refRGB, const CONSTPTR(Vector4s) *refGradX, const CONSTPTR(Vector4s) *refGradY)
+{
+	if (depth <= 1e-8f) return false;
+
+	const int noPara = shortIteration ? 3 : 6;
+	Vector4f pt_camera, pt_world, pt_rgb, pt_ref;
+	Vector2f pt_image;
+
+	pt_camera.x = depth * ((float(x) - viewIntrinsics.z) / viewIntrinsics.x);
+	pt_camera.y = depth * ((float(y) - viewIntrinsics.w) / viewIntrinsics.y);
+	pt_camera.z = depth;
+	pt_camera.w = 1.0f;
+
+	// intensity observed in the current frame
+	pt_rgb = depthToRGB * pt_camera;
+	if (pt_rgb.z <= 0.0f) return false;
+	pt_image.x = rgbIntrinsics.x * pt_rgb.x / pt_rgb.z + rgbIntrinsics.z;
+	pt_image.y = rgbIntrinsics.y * pt_rgb.y / pt_rgb.z + rgbIntrinsics.w;
+	if (pt_image.x < 0.0f || pt_image.x > rgbImageSize.x - 2 || pt_image.y < 0.0f || pt_image.y > rgbImageSize.y - 2) return false;
+
+	float intensity = hybridIntensity(interpolateBilinear(rgb, pt_image, rgbImageSize));
+
+	// intensity and its gradient in the reference frame, the border has no gradients
+	pt_world = approxInvPose * pt_camera;
+	pt_world.w = 1.0f;
+
+	pt_ref = refPose * pt_world;
+	if (pt_ref.z <= 0.0f) return false;
+	pt_image.x = rgbIntrinsics.x * pt_ref.x / pt_ref.z + rgbIntrinsics.z;
+	pt_image.y = rgbIntrinsics.y * pt_ref.y / pt_ref.z + rgbIntrinsics.w;
+	if (pt_image.x < 1.0f || pt_image.x > refImageSize.x - 3 || pt_image.y < 1.0f || pt_image.y > refImageSize.y - 3) return false;
+
+	float refIntensity = hybridIntensity(interpolateBilinear(refRGB, pt_image, refImageSize));
+	float gx = hybridIntensity(interpolateBilinear(refGradX, pt_image, refImageSize));
+	float gy = hybridIntensity(interpolateBilinear(refGradY, pt_image, refImageSize));
+
+	// chain rule: image gradient, projection, rotation into the reference camera
+	Vector3f d_ref, d_world;
+	float invZ = 1.0f / pt_ref.z;
+	d_ref.x = gx * rgbIntrinsics.x * invZ;
+	d_ref.y = gy * rgbIntrinsics.y * invZ;
+	d_ref.z = -(d_ref.x * pt_ref.x + d_ref.y * pt_ref.y) * invZ;
+
+	d_world.x = refPose.m00 * d_ref.x + refPose.m01 * d_ref.y + refPose.m02 * d_ref.z;
+	d_world.y = refPose.m10 * d_ref.x + refPose.m11 * d_ref.y + refPose.m12 * d_ref.z;
+	d_world.z = refPose.m20 * d_ref.x + refPose.m21 * d_ref.y + refPose.m22 * d_ref.z;
+
+	Vector3f d_pt[6];
+	computeHybridPointDerivatives<shortIteration, rotationOnly>(d_pt, pt_world);
+
+	b = intensity - refIntensity;
+
+	float absB = fabs(b), weight = absB > HYBRID_PHOTOMETRIC_HUBER ? sqrtf(HYBRID_PHOTOMETRIC_HUBER / absB) : 1.0f;
+
+	b *= weight;
+	for (int i = 0; i < noPara; i++) A[i] = weight * (d_world.x * d_pt[i].x + d_world.y * d_pt[i].y + d_world.z * d_pt[i].z);
+
+	return true;
+}
+
+/** Adds the point-to-plane and the photometric row of a depth pixel to
+    the Gauss-Newton system, each scaled by its weight. Returns whether
+    either term was valid.
+*/
+template<bool shortIteration, bool rotationOnly>
+_CPU_AND_GPU_CODE_ inline bool computePerPointGH_Hybrid(THREADPTR(float) *localNabla, THREADPTR(float) *localHessian, THREADPTR(float) &localF,
+	const THREADPTR(int) & x, const THREADPTR(int) & y, const CONSTPTR(float) &depth, const CONSTPTR(Vector2i) & viewImageSize,
+	const CONSTPTR(Vector4f) & viewIntrinsics, const CONSTPTR(Vector2i) & sceneImageSize, const CONSTPTR(Vector4f) & sceneIntrinsics,
+	const CONSTPTR(Matrix4f) & approxInvPose, const CONSTPTR(Matrix4f) & scenePose, const CONSTPTR(Vector4f) *pointsMap,
+	const CONSTPTR(Vector4f) *normalsMap, float distThresh, float icpWeight,
+	const CONSTPTR(Matrix4f) & depthToRGB, const CONSTPTR(Vector4f) & rgbIntrinsics, const CONSTPTR(Vector2i) & rgbImageSize,
+	const CONSTPTR(Vector4u) *rgb, const CONSTPTR(Vector2i) & refImageSize, const CONSTPTR(Matrix4f) & refPose, const CONSTPTR(Vector4u) *refRGB,
+	const CONSTPTR(Vector4s) *refGradX, const CONSTPTR(Vector4s) *refGradY, float photometricWeight)
+{
+	const int noPara = shortIteration ? 3 : 6;
+	float A[noPara], b;
+	bool isValidPoint = false;
+
+	localF = 0.0f;
+	for (int i = 0; i < noPara; i++) localNabla[i] = 0.0f;
+	for (int i = 0, counter = 0; i < noPara; i++) for (int j = 0; j <= i; j++) localHessian[counter++] = 0.0f;
+
+	if (icpWeight > 0.0f && computePerPointGH_Depth_Ab<shortIteration, rotationOnly>(A, b, x, y, depth, viewImageSize, viewIntrinsics,
+		sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh))
+	{
+		localF += icpWeight * b * b;
+		for (int r = 0, counter = 0; r < noPara; r++)
+		{
+			localNabla[r] += icpWeight * b * A[r];
+			for (int c = 0; c <= r; c++, counter++) localHessian[counter] += icpWeight * A[r] * A[c];
+		}
+		isValidPoint = true;
+	}
+
+	if (photometricWeight > 0.0f && computePerPointGH_Hybrid_Photometric_Ab<shortIteration, rotationOnly>(A, b, x, y, depth, viewIntrinsics,
+		approxInvPose, depthToRGB, rgbIntrinsics, rgbImageSize, rgb, refImageSize, refPose, refRGB, refGradX, refGradY))
+	{
+		localF += photometricWeight * b * b;
+		for (int r = 0, counter = 0; r < noPara; r++)
+		{
+			localNabla[r] += photometricWeight * b * A[r];
+			for (int c = 0; c <= r; c++, counter++) localHessian[counter] += photometricWeight * A[r] * A[c];
+		}
+		isValidPoint = true;
+	}
+
+	return isValidPoint;
+}
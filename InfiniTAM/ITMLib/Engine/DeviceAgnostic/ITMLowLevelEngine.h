@@ -46,6 +46,13 @@ _CPU_AND_GPU_CODE_ inline void filterSubsampleWithHoles(DEVICEPTR(float) *imageD
 	imageData_out[x + y * newDims.x] = pixel_out;
 }
 
+_CPU_AND_GPU_CODE_ inline void filterSubsampleWithHoles(DEVICEPTR(float) *depth_out, DEVICEPTR(float) *uncertainty_out, int x, int y, Vector2i newDims,
+	const CONSTPTR(float) *depth_in, const CONSTPTR(float) *uncertainty_in, Vector2i oldDims)
+{
+	filterSubsampleWithHoles(depth_out, x, y, newDims, depth_in, oldDims);
+	filterSubsampleWithHoles(uncertainty_out, x, y, newDims, uncertainty_in, oldDims);
+}
+
 _CPU_AND_GPU_CODE_ inline void filterSubsampleWithHoles(DEVICEPTR(Vector4f) *imageData_out, int x, int y, Vector2i newDims, 
 	const CONSTPTR(Vector4f) *imageData_in, Vector2i oldDims)
 {
@@ -19,13 +19,13 @@ _CPU_AND_GPU_CODE_ inline void unprojectPtWithIntrinsic(const THREADPTR(Vector4f
 
 template<class TVoxel, class TIndex>
 _CPU_AND_GPU_CODE_ inline float computePerPixelEnergy(const THREADPTR(Vector4f) &inpt, const CONSTPTR(TVoxel) *voxelBlocks,
-	const CONSTPTR(typename TIndex::IndexData) *index, float oneOverVoxelSize, Matrix4f invM)
+	const CONSTPTR(typename TIndex::IndexData) *index, float oneOverVoxelSize, Matrix4f invM, THREADPTR(typename TIndex::IndexCache) &cache)
 {
 	Vector3f pt; bool dtIsFound;
 	pt = TO_VECTOR3(invM * inpt) * oneOverVoxelSize;
 
 	// faster but theoretically worse
-	float dt = readFromSDF_float_uninterpolated(voxelBlocks, index, pt, dtIsFound);
+	float dt = readFromSDF_float_uninterpolated(voxelBlocks, index, pt, dtIsFound, cache);
 
 	//typename TIndex::IndexCache cache;
 	//float dt = readFromSDF_float_interpolated(voxelBlocks, index, pt, dtIsFound, cache);
@@ -36,9 +36,18 @@ _CPU_AND_GPU_CODE_ inline float computePerPixelEnergy(const THREADPTR(Vector4f)
 	return 4.0f * expdt / ((expdt + 1.0f)*(expdt + 1.0f));
 }
 
+template<class TVoxel, class TIndex>
+_CPU_AND_GPU_CODE_ inline float computePerPixelEnergy(const THREADPTR(Vector4f) &inpt, const CONSTPTR(TVoxel) *voxelBlocks,
+	const CONSTPTR(typename TIndex::IndexData) *index, float oneOverVoxelSize, Matrix4f invM)
+{
+	typename TIndex::IndexCache cache;
+	return computePerPixelEnergy<TVoxel, TIndex>(inpt, voxelBlocks, index, oneOverVoxelSize, invM, cache);
+}
+
 template<class TVoxel, class TIndex>
 _CPU_AND_GPU_CODE_ inline Vector3f computeDDT(const CONSTPTR(Vector3f) &pt_f, const THREADPTR(TVoxel) *voxelBlocks,
-	const THREADPTR(typename TIndex::IndexData) *index, float oneOverVoxelSize, DEVICEPTR(bool) &ddtFound)
+	const THREADPTR(typename TIndex::IndexData) *index, float oneOverVoxelSize, DEVICEPTR(bool) &ddtFound,
+	THREADPTR(typename TIndex::IndexCache) &cache)
 {
 	
 	Vector3f ddt;
@@ -47,30 +56,48 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeDDT(const CONSTPTR(Vector3f) &pt_f, co
 
 	bool isFound; float dt1, dt2;
 
-	dt1 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(1, 0, 0), isFound).sdf);
+	dt1 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(1, 0, 0), isFound, cache).sdf);
 	if (!isFound || dt1 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
-	dt2 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(-1, 0, 0), isFound).sdf);
+	dt2 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(-1, 0, 0), isFound, cache).sdf);
 	if (!isFound || dt2 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
 	ddt.x = (dt1 - dt2) * 0.5f;
 
-	dt1 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, 1, 0), isFound).sdf);
+	dt1 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, 1, 0), isFound, cache).sdf);
 	if (!isFound || dt1 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
-	dt2 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, -1, 0), isFound).sdf);
+	dt2 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, -1, 0), isFound, cache).sdf);
 	if (!isFound || dt2 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
 	ddt.y = (dt1 - dt2) * 0.5f;
 
-	dt1 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, 0, 1), isFound).sdf);
+	dt1 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, 0, 1), isFound, cache).sdf);
 	if (!isFound || dt1 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
-	dt2 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, 0, -1), isFound).sdf);
+	dt2 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, 0, -1), isFound, cache).sdf);
 	if (!isFound || dt2 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
 	ddt.z = (dt1 - dt2) * 0.5f;
 
 	ddtFound = true; return ddt;
 }
 
+/// Jacobian of the energy of a point at @p cPt in world coordinates, with SDF value @p dt and SDF gradient @p dDt
+_CPU_AND_GPU_CODE_ inline void computeJacobianFromDDT(THREADPTR(float) *jacobian, const THREADPTR(Vector3f) &cPt, float dt, Vector3f dDt)
+{
+	float expdt = exp(-dt * DTUNE);
+	float deto = expdt + 1;
+
+	float prefix = 4.0f * DTUNE * (2.0f * exp(-dt * 2.0f * DTUNE) / (deto * deto * deto) - expdt / (deto * deto));
+
+	dDt *= prefix;
+
+	jacobian[0] = dDt.x; jacobian[1] = dDt.y; jacobian[2] = dDt.z;
+
+	jacobian[3] = 4.0f * (dDt.z * cPt.y - dDt.y * cPt.z);
+	jacobian[4] = 4.0f * (dDt.x * cPt.z - dDt.z * cPt.x);
+	jacobian[5] = 4.0f * (dDt.y * cPt.x - dDt.x * cPt.y);
+}
+
 template<class TVoxel, class TIndex>
 _CPU_AND_GPU_CODE_ inline bool computePerPixelJacobian(THREADPTR(float) *jacobian, const THREADPTR(Vector4f) &inpt, 
-	const CONSTPTR(TVoxel) *voxelBlocks, const CONSTPTR(typename TIndex::IndexData) *index, float oneOverVoxelSize, Matrix4f invM)
+	const CONSTPTR(TVoxel) *voxelBlocks, const CONSTPTR(typename TIndex::IndexData) *index, float oneOverVoxelSize, Matrix4f invM,
+	THREADPTR(typename TIndex::IndexCache) &cache)
 {
 
 	bool isFound;
@@ -84,26 +111,23 @@ _CPU_AND_GPU_CODE_ inline bool computePerPixelJacobian(THREADPTR(float) *jacobia
 	//typename TIndex::IndexCache cache;
 	//float dt = readFromSDF_float_interpolated(voxelBlocks, index, pt, isFound, cache);
 
-	float dt = readFromSDF_float_uninterpolated(voxelBlocks, index, pt, isFound);
+	float dt = readFromSDF_float_uninterpolated(voxelBlocks, index, pt, isFound, cache);
 
 	if (dt == 1.0f || !isFound) return false;
 
 
-	dDt = computeDDT<TVoxel, TIndex>(pt, voxelBlocks, index, oneOverVoxelSize, isFound);
+	dDt = computeDDT<TVoxel, TIndex>(pt, voxelBlocks, index, oneOverVoxelSize, isFound, cache);
 	if (!isFound) return false;
 
-	float expdt = exp(-dt * DTUNE);
-	float deto = expdt + 1;
-
-	float prefix = 4.0f * DTUNE * (2.0f * exp(-dt * 2.0f * DTUNE) / (deto * deto * deto) - expdt / (deto * deto));
-
-	dDt *= prefix;
-
-	jacobian[0] = dDt.x; jacobian[1] = dDt.y; jacobian[2] = dDt.z;
-
-	jacobian[3] = 4.0f * (dDt.z * cPt.y - dDt.y * cPt.z);
-	jacobian[4] = 4.0f * (dDt.x * cPt.z - dDt.z * cPt.x);
-	jacobian[5] = 4.0f * (dDt.y * cPt.x - dDt.x * cPt.y);
+	computeJacobianFromDDT(jacobian, cPt, dt, dDt);
 
 	return true;
 }
+
+template<class TVoxel, class TIndex>
+_CPU_AND_GPU_CODE_ inline bool computePerPixelJacobian(THREADPTR(float) *jacobian, const THREADPTR(Vector4f) &inpt,
+	const CONSTPTR(TVoxel) *voxelBlocks, const CONSTPTR(typename TIndex::IndexData) *index, float oneOverVoxelSize, Matrix4f invM)
+{
+	typename TIndex::IndexCache cache;
+	return computePerPixelJacobian<TVoxel, TIndex>(jacobian, inpt, voxelBlocks, index, oneOverVoxelSize, invM, cache);
+}
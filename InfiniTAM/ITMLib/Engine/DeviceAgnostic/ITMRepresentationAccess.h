@@ -141,6 +141,50 @@ _CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, co
 	return readVoxel(voxelData, voxelIndex, point_orig, isFound);
 }
 
+/** Reads the 8 voxels of the cell with lower corner @p pos, in the order
+    x, then y, then z. If the cell lies inside one voxel block, which is
+    the case for 7 in 8 cells per axis, the block is looked up only once.
+*/
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline void readVoxelCell(THREADPTR(TVoxel) *cell, const CONSTPTR(TVoxel) *voxelData,
+	const CONSTPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexData) *voxelIndex, const THREADPTR(Vector3i) & pos,
+	THREADPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexCache) & cache)
+{
+	bool isFound;
+	Vector3i blockPos;
+	int linearIdx = pointToVoxelBlockPos(pos, blockPos);
+	Vector3i locPos = pos - blockPos * SDF_BLOCK_SIZE;
+
+	if ((locPos.x < SDF_BLOCK_SIZE - 1) && (locPos.y < SDF_BLOCK_SIZE - 1) && (locPos.z < SDF_BLOCK_SIZE - 1))
+	{
+		cell[0] = readVoxel(voxelData, voxelIndex, pos, isFound, cache);
+		if (!isFound) { for (int i = 1; i < 8; i++) cell[i] = TVoxel(); return; }
+
+		const CONSTPTR(TVoxel) *base = voxelData + cache.blockPtr + linearIdx;
+		cell[1] = base[1];
+		cell[2] = base[SDF_BLOCK_SIZE];
+		cell[3] = base[SDF_BLOCK_SIZE + 1];
+		cell[4] = base[SDF_BLOCK_SIZE * SDF_BLOCK_SIZE];
+		cell[5] = base[SDF_BLOCK_SIZE * SDF_BLOCK_SIZE + 1];
+		cell[6] = base[SDF_BLOCK_SIZE * SDF_BLOCK_SIZE + SDF_BLOCK_SIZE];
+		cell[7] = base[SDF_BLOCK_SIZE * SDF_BLOCK_SIZE + SDF_BLOCK_SIZE + 1];
+		return;
+	}
+
+	for (int i = 0; i < 8; i++)
+		cell[i] = readVoxel(voxelData, voxelIndex, pos + Vector3i(i & 1, (i >> 1) & 1, (i >> 2) & 1), isFound, cache);
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline void readVoxelCell(THREADPTR(TVoxel) *cell, const CONSTPTR(TVoxel) *voxelData,
+	const CONSTPTR(ITMLib::Objects::ITMPlainVoxelArray::IndexData) *voxelIndex, const THREADPTR(Vector3i) & pos,
+	THREADPTR(ITMLib::Objects::ITMPlainVoxelArray::IndexCache) & cache)
+{
+	bool isFound;
+	for (int i = 0; i < 8; i++)
+		cell[i] = readVoxel(voxelData, voxelIndex, pos + Vector3i(i & 1, (i >> 1) & 1, (i >> 2) & 1), isFound);
+}
+
 template<class TVoxel, class TIndex>
 _CPU_AND_GPU_CODE_ inline float readFromSDF_float_uninterpolated(const CONSTPTR(TVoxel) *voxelData,
 	const CONSTPTR(TIndex) *voxelIndex, Vector3f point, THREADPTR(bool) &isFound)
@@ -189,32 +233,19 @@ _CPU_AND_GPU_CODE_ inline Vector4f readFromSDF_color4u_interpolated(const CONSTP
 	const CONSTPTR(typename TIndex::IndexData) *voxelIndex, const THREADPTR(Vector3f) & point, 
 	THREADPTR(typename TIndex::IndexCache) & cache)
 {
-	TVoxel resn; Vector3f ret = 0.0f; Vector4f ret4; bool isFound;
+	TVoxel cell[8]; Vector3f ret = 0.0f; Vector4f ret4;
 	Vector3f coeff; Vector3i pos; TO_INT_FLOOR3(pos, coeff, point);
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 0), isFound, cache);
-	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
+	readVoxelCell(cell, voxelData, voxelIndex, pos, cache);
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 0), isFound, cache);
-	ret += (coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 0), isFound, cache);
-	ret += (1.0f - coeff.x) * (coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 0), isFound, cache);
-	ret += (coeff.x) * (coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 1), isFound, cache);
-	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * coeff.z * resn.clr.toFloat();
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 1), isFound, cache);
-	ret += (coeff.x) * (1.0f - coeff.y) * coeff.z * resn.clr.toFloat();;
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 1), isFound, cache);
-	ret += (1.0f - coeff.x) * (coeff.y) * coeff.z * resn.clr.toFloat();
-
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 1), isFound, cache);
-	ret += (coeff.x) * (coeff.y) * coeff.z * resn.clr.toFloat();
+	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * cell[0].clr.toFloat();
+	ret += (coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * cell[1].clr.toFloat();
+	ret += (1.0f - coeff.x) * (coeff.y) * (1.0f - coeff.z) * cell[2].clr.toFloat();
+	ret += (coeff.x) * (coeff.y) * (1.0f - coeff.z) * cell[3].clr.toFloat();
+	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * coeff.z * cell[4].clr.toFloat();
+	ret += (coeff.x) * (1.0f - coeff.y) * coeff.z * cell[5].clr.toFloat();
+	ret += (1.0f - coeff.x) * (coeff.y) * coeff.z * cell[6].clr.toFloat();
+	ret += (coeff.x) * (coeff.y) * coeff.z * cell[7].clr.toFloat();
 
 	ret4.x = ret.x; ret4.y = ret.y; ret4.z = ret.z; ret4.w = 255.0f;
 
@@ -343,6 +374,10 @@ struct VoxelColorReader<false,TVoxel,TIndex> {
 	_CPU_AND_GPU_CODE_ static Vector4f interpolate(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(typename TIndex::IndexData) *voxelIndex,
 		const THREADPTR(Vector3f) & point)
 	{ return Vector4f(0.0f,0.0f,0.0f,0.0f); }
+
+	_CPU_AND_GPU_CODE_ static Vector4f interpolate(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(typename TIndex::IndexData) *voxelIndex,
+		const THREADPTR(Vector3f) & point, THREADPTR(typename TIndex::IndexCache) & cache)
+	{ return Vector4f(0.0f,0.0f,0.0f,0.0f); }
 };
 
 template<class TVoxel, class TIndex>
@@ -353,4 +388,11 @@ struct VoxelColorReader<true,TVoxel,TIndex> {
 		typename TIndex::IndexCache cache;
 		return readFromSDF_color4u_interpolated<TVoxel,TIndex>(voxelData, voxelIndex, point, cache);
 	}
+
+	/// Keeps @p cache between calls, for points that are likely to share voxel blocks
+	_CPU_AND_GPU_CODE_ static Vector4f interpolate(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(typename TIndex::IndexData) *voxelIndex,
+		const THREADPTR(Vector3f) & point, THREADPTR(typename TIndex::IndexCache) & cache)
+	{
+		return readFromSDF_color4u_interpolated<TVoxel,TIndex>(voxelData, voxelIndex, point, cache);
+	}
 };
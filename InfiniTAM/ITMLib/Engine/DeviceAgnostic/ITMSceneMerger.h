@@ -0,0 +1,157 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "../../Utils/ITMLibDefines.h"
+#include "ITMRepresentationAccess.h"
+
+/** Reads the 8 voxels around @p point, in voxel units, and the
+    trilinear coefficients of @p point inside that cell. Returns false
+    unless all 8 voxels have been observed, so that unobserved voxels
+    (sdf = 1, w_depth = 0) do not bleed into the interpolation.
+*/
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline bool readObservedCell(THREADPTR(TVoxel) *cell, THREADPTR(Vector3f) &coeff, const CONSTPTR(TVoxel) *voxelData,
+	const CONSTPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexData) *voxelIndex, const THREADPTR(Vector3f) &point,
+	THREADPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexCache) &cache)
+{
+	Vector3i pos; TO_INT_FLOOR3(pos, coeff, point);
+
+	readVoxelCell(cell, voxelData, voxelIndex, pos, cache);
+	for (int i = 0; i < 8; i++) if (cell[i].w_depth == 0) return false;
+
+	return true;
+}
+
+/// Trilinear weights of the 8 voxels of a cell, in the order of readVoxelCell()
+_CPU_AND_GPU_CODE_ inline void computeCellWeights(THREADPTR(float) *weights, const THREADPTR(Vector3f) &coeff)
+{
+	for (int i = 0; i < 8; i++)
+	{
+		weights[i] = ((i & 1) ? coeff.x : 1.0f - coeff.x) *
+			(((i >> 1) & 1) ? coeff.y : 1.0f - coeff.y) *
+			(((i >> 2) & 1) ? coeff.z : 1.0f - coeff.z);
+	}
+}
+
+/** Trilinearly interpolated SDF value of a cell, as
+    readFromSDF_float_interpolated() computes it, together with its
+    analytic gradient in voxel units.
+*/
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline float interpolateCellSDF(THREADPTR(Vector3f) &gradient, const THREADPTR(TVoxel) *cell, const THREADPTR(Vector3f) &coeff)
+{
+	float sdf[8];
+	for (int i = 0; i < 8; i++) sdf[i] = TVoxel::SDF_valueToFloat(cell[i].sdf);
+
+	// interpolate along x first, then y, then z
+	float x00 = (1.0f - coeff.x) * sdf[0] + coeff.x * sdf[1], x10 = (1.0f - coeff.x) * sdf[2] + coeff.x * sdf[3];
+	float x01 = (1.0f - coeff.x) * sdf[4] + coeff.x * sdf[5], x11 = (1.0f - coeff.x) * sdf[6] + coeff.x * sdf[7];
+	float y0 = (1.0f - coeff.y) * x00 + coeff.y * x10, y1 = (1.0f - coeff.y) * x01 + coeff.y * x11;
+
+	float dx00 = sdf[1] - sdf[0], dx10 = sdf[3] - sdf[2], dx01 = sdf[5] - sdf[4], dx11 = sdf[7] - sdf[6];
+	float dx0 = (1.0f - coeff.y) * dx00 + coeff.y * dx10, dx1 = (1.0f - coeff.y) * dx01 + coeff.y * dx11;
+
+	gradient.x = (1.0f - coeff.z) * dx0 + coeff.z * dx1;
+	gradient.y = (1.0f - coeff.z) * (x10 - x00) + coeff.z * (x11 - x01);
+	gradient.z = y1 - y0;
+
+	return (1.0f - coeff.z) * y0 + coeff.z * y1;
+}
+
+/** Residual and Jacobian of the alignment of point @p point_A, a
+    surface point of scene B moved into scene A, against the SDF of
+    scene A. The residual is the SDF of A at the point in metres, the
+    Jacobian is taken with respect to a small motion
+    (rotation, translation) applied on the left of the current
+    transform. Returns false if the point is not inside the observed
+    truncation band of A.
+*/
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline bool computeSDFAlignmentTerm(THREADPTR(float) &residual, THREADPTR(float) *jacobian, const THREADPTR(Vector3f) &point_A,
+	const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexData) *voxelIndex,
+	float oneOverVoxelSize, float mu, THREADPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexCache) &cache)
+{
+	TVoxel cell[8]; Vector3f coeff, gradient;
+	if (!readObservedCell(cell, coeff, voxelData, voxelIndex, point_A * oneOverVoxelSize, cache)) return false;
+
+	float sdf = interpolateCellSDF(gradient, cell, coeff);
+	if (fabs(sdf) >= 1.0f) return false;
+
+	residual = sdf * mu;
+	gradient *= mu * oneOverVoxelSize;
+
+	Vector3f rotationPart = cross(point_A, gradient);
+	jacobian[0] = rotationPart.x; jacobian[1] = rotationPart.y; jacobian[2] = rotationPart.z;
+	jacobian[3] = gradient.x; jacobian[4] = gradient.y; jacobian[5] = gradient.z;
+
+	return true;
+}
+
+/** Fuses a sample of scene B, interpolated from the observed @p cell
+    at @p coeff, into @p voxel of scene A by weight averaging, like the
+    integration of a depth frame does. @p sdfScale converts SDF values
+    from the truncation band of B to that of A.
+*/
+template<bool hasColor, class TVoxel> struct FuseResampledVoxel;
+
+template<class TVoxel>
+struct FuseResampledVoxel<false, TVoxel> {
+	_CPU_AND_GPU_CODE_ static void compute(DEVICEPTR(TVoxel) &voxel, const THREADPTR(TVoxel) *cell, const THREADPTR(Vector3f) &coeff,
+		float sdfScale, int maxW)
+	{
+		float weights[8]; computeCellWeights(weights, coeff);
+
+		float newF = 0.0f, newWf = 0.0f;
+		for (int i = 0; i < 8; i++)
+		{
+			newF += weights[i] * TVoxel::SDF_valueToFloat(cell[i].sdf);
+			newWf += weights[i] * cell[i].w_depth;
+		}
+
+		newF = CLAMP(newF * sdfScale, -1.0f, 1.0f);
+		int newW = MAX((int)(newWf + 0.5f), 1);
+
+		float oldF = TVoxel::SDF_valueToFloat(voxel.sdf);
+		int oldW = voxel.w_depth;
+
+		newF = (oldW * oldF + newW * newF) / (oldW + newW);
+		newW = MIN(oldW + newW, maxW);
+
+		voxel.sdf = TVoxel::SDF_floatToValue(newF);
+		voxel.w_depth = newW;
+	}
+};
+
+template<class TVoxel>
+struct FuseResampledVoxel<true, TVoxel> {
+	_CPU_AND_GPU_CODE_ static void compute(DEVICEPTR(TVoxel) &voxel, const THREADPTR(TVoxel) *cell, const THREADPTR(Vector3f) &coeff,
+		float sdfScale, int maxW)
+	{
+		float weights[8]; computeCellWeights(weights, coeff);
+
+		Vector3f newC(0.0f); float newWf = 0.0f;
+		for (int i = 0; i < 8; i++)
+		{
+			newC += weights[i] * cell[i].w_color * cell[i].clr.toFloat();
+			newWf += weights[i] * cell[i].w_color;
+		}
+
+		FuseResampledVoxel<false, TVoxel>::compute(voxel, cell, coeff, sdfScale, maxW);
+
+		// voxels of B that were never seen in colour do not change the colour of A
+		if (newWf < 0.5f) return;
+
+		newC /= newWf;
+		int newW = (int)(newWf + 0.5f);
+
+		Vector3f oldC = voxel.clr.toFloat();
+		int oldW = voxel.w_color;
+
+		newC = (oldC * (float)oldW + newC * (float)newW) / (float)(oldW + newW);
+		newW = MIN(oldW + newW, maxW);
+
+		voxel.clr = TO_UCHAR3(newC);
+		voxel.w_color = (uchar)newW;
+	}
+};
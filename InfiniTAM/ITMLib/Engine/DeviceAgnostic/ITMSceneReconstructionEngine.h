@@ -6,17 +6,40 @@
 #include "ITMPixelUtils.h"
 #include "ITMRepresentationAccess.h"
 
+/// Standard deviation of the sensor noise model for a fronto-parallel
+/// measurement at 1m, see computeNormalAndWeight.
+#define SENSOR_NOISE_SIGMA_REF 0.0019f
+/// Largest weight a single low-noise depth observation is fused with.
+#define SDF_MAX_OBSERVATION_WEIGHT 4
+
+/** Maps the modelled depth uncertainty of a pixel to the integer weight its
+    observation is fused with. The weight falls off inversely with the
+    uncertainty: close, fronto-parallel measurements count as
+    @ref SDF_MAX_OBSERVATION_WEIGHT observations, far and oblique ones (or
+    pixels without a valid noise estimate) as a single one.
+*/
+_CPU_AND_GPU_CODE_ inline int computeObservationWeight(float sigmaZ) {
+  if (sigmaZ <= 0.0f) return 1;
+
+  float w = SDF_MAX_OBSERVATION_WEIGHT * SENSOR_NOISE_SIGMA_REF / sigmaZ;
+
+  return CLAMP((int)(w + 0.5f), 1, SDF_MAX_OBSERVATION_WEIGHT);
+}
+
 template <class TVoxel>
 _CPU_AND_GPU_CODE_ inline float computeUpdatedVoxelDepthInfo(
     DEVICEPTR(TVoxel) & voxel, const THREADPTR(Vector4f) & pt_model,
     const CONSTPTR(Matrix4f) & M_d, const CONSTPTR(Vector4f) & projParams_d,
     float mu, int maxW, const CONSTPTR(float) * depth,
-    const CONSTPTR(Vector2i) & imgSize) {
+    const CONSTPTR(float) * depthUncertainty,
+    const CONSTPTR(Vector2i) & imgSize, THREADPTR(int) & locId) {
   Vector4f pt_camera;
   Vector2f pt_image;
   float depth_measure, eta, oldF, newF;
   int oldW, newW;
 
+  locId = -1;
+
   // project point into image
   pt_camera = M_d * pt_model;
   if (pt_camera.z <= 0) return -1;
@@ -28,8 +51,8 @@ _CPU_AND_GPU_CODE_ inline float computeUpdatedVoxelDepthInfo(
     return -1;
 
   // get measured depth from image
-  depth_measure =
-      depth[(int)(pt_image.x + 0.5f) + (int)(pt_image.y + 0.5f) * imgSize.x];
+  locId = (int)(pt_image.x + 0.5f) + (int)(pt_image.y + 0.5f) * imgSize.x;
+  depth_measure = depth[locId];
   if (depth_measure <= 0.0) return -1;
 
   // check whether voxel needs updating
@@ -41,7 +64,9 @@ _CPU_AND_GPU_CODE_ inline float computeUpdatedVoxelDepthInfo(
   oldW = voxel.w_depth;
 
   newF = MIN(1.0f, eta / mu);
-  newW = 1;
+  newW = (depthUncertainty == NULL)
+             ? 1
+             : computeObservationWeight(depthUncertainty[locId]);
 
   newF = oldW * oldF + newW * newF;
   newW = oldW + newW;
@@ -55,6 +80,42 @@ _CPU_AND_GPU_CODE_ inline float computeUpdatedVoxelDepthInfo(
   return eta;
 }
 
+template <class TVoxel>
+_CPU_AND_GPU_CODE_ inline float computeUpdatedVoxelDepthInfo(
+    DEVICEPTR(TVoxel) & voxel, const THREADPTR(Vector4f) & pt_model,
+    const CONSTPTR(Matrix4f) & M_d, const CONSTPTR(Vector4f) & projParams_d,
+    float mu, int maxW, const CONSTPTR(float) * depth,
+    const CONSTPTR(Vector2i) & imgSize) {
+  int locId;
+  return computeUpdatedVoxelDepthInfo(voxel, pt_model, M_d, projParams_d, mu,
+                                      maxW, depth, NULL, imgSize, locId);
+}
+
+template <class TVoxel>
+_CPU_AND_GPU_CODE_ inline void fuseVoxelColor(
+    DEVICEPTR(TVoxel) & voxel, const THREADPTR(Vector3f) & rgb_measure,
+    uchar maxW) {
+  Vector3f oldC, newC;
+  Vector3u buffV3u;
+  float newW, oldW;
+  buffV3u = voxel.clr;
+  oldW = (float)voxel.w_color;
+
+  oldC = TO_FLOAT3(buffV3u) / 255.0f;
+
+  newW = 1;
+
+  newC = oldC * oldW + rgb_measure * newW;
+  newW = oldW + newW;
+  newC /= newW;
+  newW = MIN(newW, maxW);
+
+  buffV3u = TO_UCHAR3(newC * 255.0f);
+
+  voxel.clr = buffV3u;
+  voxel.w_color = (uchar)newW;
+}
+
 template <class TVoxel>
 _CPU_AND_GPU_CODE_ inline void computeUpdatedVoxelColorInfo(
     /* clang-format off */
@@ -64,14 +125,7 @@ _CPU_AND_GPU_CODE_ inline void computeUpdatedVoxelColorInfo(
     const CONSTPTR(Vector2i)& imgSize /* clang-format on */) {
   Vector4f pt_camera;
   Vector2f pt_image;
-  Vector3f rgb_measure, oldC, newC;
-  Vector3u buffV3u;
-  float newW, oldW;
-  buffV3u = voxel.clr;
-  oldW = (float)voxel.w_color;
-
-  oldC = TO_FLOAT3(buffV3u) / 255.0f;
-  newC = oldC;
+  Vector3f rgb_measure;
 
   pt_camera = M_rgb * pt_model;
 
@@ -86,17 +140,26 @@ _CPU_AND_GPU_CODE_ inline void computeUpdatedVoxelColorInfo(
       TO_VECTOR3(interpolateBilinear(rgb, pt_image, imgSize)) / 255.0f;
   // rgb_measure = rgb[(int)(pt_image.x + 0.5f) + (int)(pt_image.y + 0.5f) *
   // imgSize.x].toVector3().toFloat() / 255.0f;
-  newW = 1;
 
-  newC = oldC * oldW + rgb_measure * newW;
-  newW = oldW + newW;
-  newC /= newW;
-  newW = MIN(newW, maxW);
+  fuseVoxelColor(voxel, rgb_measure, maxW);
+}
 
-  buffV3u = TO_UCHAR3(newC * 255.0f);
+/** Colour update from an image that is pixel-aligned with the depth image
+    (ITMView::GetRGBAlignedWithDepth). This reuses the depth pixel @p locId_d
+    the voxel has already been projected to, instead of projecting it again
+    into the RGB camera. Pixels that are 0 in @p rgbMask_d, if given, have
+    no colour.
+*/
+template <class TVoxel>
+_CPU_AND_GPU_CODE_ inline void computeUpdatedVoxelColorInfo(
+    DEVICEPTR(TVoxel) & voxel, uchar maxW, const CONSTPTR(Vector4u) * rgb_d,
+    const CONSTPTR(uchar) * rgbMask_d, int locId_d) {
+  if (rgbMask_d != NULL && rgbMask_d[locId_d] == 0) return;
+  Vector4u rgb_sample = rgb_d[locId_d];
 
-  voxel.clr = buffV3u;
-  voxel.w_color = (uchar)newW;
+  Vector3f rgb_measure = TO_FLOAT3(TO_VECTOR3(rgb_sample)) / 255.0f;
+
+  fuseVoxelColor(voxel, rgb_measure, maxW);
 }
 
 template <bool hasColor, class TVoxel>
@@ -104,6 +167,21 @@ struct ComputeUpdatedVoxelInfo;
 
 template <class TVoxel>
 struct ComputeUpdatedVoxelInfo<false, TVoxel> {
+  _CPU_AND_GPU_CODE_ static void
+  compute(/* clang-format off */
+      DEVICEPTR(TVoxel)& voxel, const THREADPTR(Vector4f)& pt_model,
+      const CONSTPTR(Matrix4f)& M_d, const CONSTPTR(Vector4f)& projParams_d,
+      const CONSTPTR(Matrix4f)& M_rgb,
+      const CONSTPTR(Vector4f)& projParams_rgb, float mu, int maxW,
+      const CONSTPTR(float)* depth, const CONSTPTR(float)* depthUncertainty,
+      const CONSTPTR(Vector2i)& imgSize_d, const CONSTPTR(Vector4u)* rgb,
+      const CONSTPTR(Vector2i)& imgSize_rgb, const CONSTPTR(Vector4u)* rgb_d,
+      const CONSTPTR(uchar)* rgbMask_d /* clang-format on */) {
+    int locId_d;
+    computeUpdatedVoxelDepthInfo(voxel, pt_model, M_d, projParams_d, mu, maxW,
+                                 depth, depthUncertainty, imgSize_d, locId_d);
+  }
+
   _CPU_AND_GPU_CODE_ static void
   compute(/* clang-format off */
       DEVICEPTR(TVoxel)& voxel, const THREADPTR(Vector4f)& pt_model,
@@ -113,13 +191,37 @@ struct ComputeUpdatedVoxelInfo<false, TVoxel> {
       const CONSTPTR(float)* depth, const CONSTPTR(Vector2i)& imgSize_d,
       const CONSTPTR(Vector4u)* rgb, const CONSTPTR(Vector2i)& imgSize_rgb
           /* clang-format on */) {
-    computeUpdatedVoxelDepthInfo(voxel, pt_model, M_d, projParams_d, mu, maxW,
-                                 depth, imgSize_d);
+    compute(voxel, pt_model, M_d, projParams_d, M_rgb, projParams_rgb, mu,
+            maxW, depth, NULL, imgSize_d, rgb, imgSize_rgb, NULL, NULL);
   }
 };
 
 template <class TVoxel>
 struct ComputeUpdatedVoxelInfo<true, TVoxel> {
+  _CPU_AND_GPU_CODE_ static void
+  compute(/* clang-format off */
+      DEVICEPTR(TVoxel) & voxel, const THREADPTR(Vector4f) & pt_model,
+      const THREADPTR(Matrix4f)& M_d, const THREADPTR(Vector4f)& projParams_d,
+      const THREADPTR(Matrix4f)& M_rgb,
+      const THREADPTR(Vector4f)& projParams_rgb, float mu, int maxW,
+      const CONSTPTR(float)* depth, const CONSTPTR(float)* depthUncertainty,
+      const CONSTPTR(Vector2i)& imgSize_d, const CONSTPTR(Vector4u)* rgb,
+      const THREADPTR(Vector2i)& imgSize_rgb, const CONSTPTR(Vector4u)* rgb_d,
+      const CONSTPTR(uchar)* rgbMask_d /* clang-format on */) {
+    int locId_d;
+    float eta = computeUpdatedVoxelDepthInfo(voxel, pt_model, M_d,
+                                             projParams_d, mu, maxW, depth,
+                                             depthUncertainty, imgSize_d,
+                                             locId_d);
+    // TOOD(ff): Check what the purpose of this is.
+    if ((eta > mu) || (fabs(eta / mu) > 0.25f)) return;
+    if (rgb_d != NULL)
+      computeUpdatedVoxelColorInfo(voxel, maxW, rgb_d, rgbMask_d, locId_d);
+    else
+      computeUpdatedVoxelColorInfo(voxel, pt_model, M_rgb, projParams_rgb, mu,
+                                   maxW, eta, rgb, imgSize_rgb);
+  }
+
   _CPU_AND_GPU_CODE_ static void
   compute(/* clang-format off */
       DEVICEPTR(TVoxel) & voxel, const THREADPTR(Vector4f) & pt_model,
@@ -129,34 +231,31 @@ struct ComputeUpdatedVoxelInfo<true, TVoxel> {
       const CONSTPTR(float)* depth, const CONSTPTR(Vector2i)& imgSize_d,
       const CONSTPTR(Vector4u)* rgb, const THREADPTR(Vector2i)& imgSize_rgb
           /* clang-format on */) {
-    float eta = computeUpdatedVoxelDepthInfo(voxel, pt_model, M_d, projParams_d,
-                                             mu, maxW, depth, imgSize_d);
-    // TOOD(ff): Check what the purpose of this is.
-    if ((eta > mu) || (fabs(eta / mu) > 0.25f)) return;
-    computeUpdatedVoxelColorInfo(voxel, pt_model, M_rgb, projParams_rgb, mu,
-                                 maxW, eta, rgb, imgSize_rgb);
+    compute(voxel, pt_model, M_d, projParams_d, M_rgb, projParams_rgb, mu,
+            maxW, depth, NULL, imgSize_d, rgb, imgSize_rgb, NULL, NULL);
   }
 };
 
-_CPU_AND_GPU_CODE_ inline void buildHashAllocAndVisibleTypePP(
+/** Computes the segment [depth - mu, depth + mu] along the ray through pixel
+    (x, y), in block coordinates. Returns the number of block-sized steps to
+    take from @p point along @p direction, or 0 if the pixel has no usable
+    depth.
+*/
+_CPU_AND_GPU_CODE_ inline int computeBlockRaySegment(
     /* clang-format off */
-    DEVICEPTR(uchar)* entriesAllocType, DEVICEPTR(uchar)* entriesVisibleType,
-    int x, int y, DEVICEPTR(Vector4s)* blockCoords,
+    THREADPTR(Vector3f)& point, THREADPTR(Vector3f)& direction, int x, int y,
     const CONSTPTR(float)* depth, Matrix4f invM_d, Vector4f projParams_d,
-    float mu, Vector2i imgSize, float oneOverVoxelSize,
-    const CONSTPTR(ITMHashEntry)* hashTable, float viewFrustum_min,
+    float mu, Vector2i imgSize, float oneOverVoxelSize, float viewFrustum_min,
     float viewFrustum_max /* clang-format on */) {
   float depth_measure;
-  unsigned int hashIdx;
   int noSteps;
-  Vector3f pt_camera_f, point_e, point, direction;
-  Vector3s blockPos;
+  Vector3f pt_camera_f, point_e;
 
   depth_measure = depth[x + y * imgSize.x];
   if (depth_measure <= 0 || (depth_measure - mu) < 0 ||
       (depth_measure - mu) < viewFrustum_min ||
       (depth_measure + mu) > viewFrustum_max)
-    return;
+    return 0;
 
   pt_camera_f.z = depth_measure;
   pt_camera_f.x =
@@ -186,54 +285,84 @@ _CPU_AND_GPU_CODE_ inline void buildHashAllocAndVisibleTypePP(
 
   direction /= (float)(noSteps - 1);
 
-  // add neighbouring blocks
-  for (int i = 0; i < noSteps; i++) {
-    blockPos = TO_SHORT_FLOOR3(point);
+  return noSteps;
+}
 
-    // compute index in hash table
-    hashIdx = hashIndex(blockPos);
+/** Looks up @p blockPos in the hash table. If the block exists it is marked
+    visible and -1 is returned. Otherwise the index of the hash entry that
+    has to be allocated for it is returned, with @p isExcess telling whether
+    it goes into the excess list.
+*/
+_CPU_AND_GPU_CODE_ inline int findHashEntryOrAllocationSlot(
+    /* clang-format off */
+    DEVICEPTR(uchar)* entriesVisibleType,
+    const CONSTPTR(ITMHashEntry)* hashTable,
+    const THREADPTR(Vector3s)& blockPos,
+    THREADPTR(bool)& isExcess /* clang-format on */) {
+  // compute index in hash table
+  int hashIdx = hashIndex(blockPos);
+
+  ITMHashEntry hashEntry = hashTable[hashIdx];
+  isExcess = false;
+
+  // check if hash table contains entry
+  if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= -1) {
+    // entry has been streamed out but is visible or in memory and visible
+    entriesVisibleType[hashIdx] = (hashEntry.ptr == -1) ? 2 : 1;
+    return -1;
+  }
 
-    // check if hash table contains entry
-    bool isFound = false;
+  if (hashEntry.ptr >=
+      -1)  // seach excess list only if there is no room in ordered part
+  {
+    while (hashEntry.offset >= 1) {
+      hashIdx = SDF_BUCKET_NUM + hashEntry.offset - 1;
+      hashEntry = hashTable[hashIdx];
+
+      if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= -1) {
+        // entry has been streamed out but is visible or in memory and
+        // visible
+        entriesVisibleType[hashIdx] = (hashEntry.ptr == -1) ? 2 : 1;
+        return -1;
+      }
+    }
 
-    ITMHashEntry hashEntry = hashTable[hashIdx];
+    isExcess = true;
+  }
 
-    if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= -1) {
-      // entry has been streamed out but is visible or in memory and visible
-      entriesVisibleType[hashIdx] = (hashEntry.ptr == -1) ? 2 : 1;
+  return hashIdx;
+}
 
-      isFound = true;
-    }
+_CPU_AND_GPU_CODE_ inline void buildHashAllocAndVisibleTypePP(
+    /* clang-format off */
+    DEVICEPTR(uchar)* entriesAllocType, DEVICEPTR(uchar)* entriesVisibleType,
+    int x, int y, DEVICEPTR(Vector4s)* blockCoords,
+    const CONSTPTR(float)* depth, Matrix4f invM_d, Vector4f projParams_d,
+    float mu, Vector2i imgSize, float oneOverVoxelSize,
+    const CONSTPTR(ITMHashEntry)* hashTable, float viewFrustum_min,
+    float viewFrustum_max /* clang-format on */) {
+  Vector3f point, direction;
+  Vector3s blockPos;
 
-    if (!isFound) {
-      bool isExcess = false;
-      if (hashEntry.ptr >=
-          -1)  // seach excess list only if there is no room in ordered part
-      {
-        while (hashEntry.offset >= 1) {
-          hashIdx = SDF_BUCKET_NUM + hashEntry.offset - 1;
-          hashEntry = hashTable[hashIdx];
-
-          if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= -1) {
-            // entry has been streamed out but is visible or in memory and
-            // visible
-            entriesVisibleType[hashIdx] = (hashEntry.ptr == -1) ? 2 : 1;
-
-            isFound = true;
-            break;
-          }
-        }
-
-        isExcess = true;
-      }
+  int noSteps = computeBlockRaySegment(point, direction, x, y, depth, invM_d,
+                                       projParams_d, mu, imgSize,
+                                       oneOverVoxelSize, viewFrustum_min,
+                                       viewFrustum_max);
 
-      if (!isFound)  // still not found
-      {
-        entriesAllocType[hashIdx] = isExcess ? 2 : 1;    // needs allocation
-        if (!isExcess) entriesVisibleType[hashIdx] = 1;  // new entry is visible
+  // add neighbouring blocks
+  for (int i = 0; i < noSteps; i++) {
+    blockPos = TO_SHORT_FLOOR3(point);
 
-        blockCoords[hashIdx] = Vector4s(blockPos.x, blockPos.y, blockPos.z, 1);
-      }
+    bool isExcess;
+    int hashIdx = findHashEntryOrAllocationSlot(entriesVisibleType, hashTable,
+                                                blockPos, isExcess);
+
+    if (hashIdx >= 0)  // not found
+    {
+      entriesAllocType[hashIdx] = isExcess ? 2 : 1;    // needs allocation
+      if (!isExcess) entriesVisibleType[hashIdx] = 1;  // new entry is visible
+
+      blockCoords[hashIdx] = Vector4s(blockPos.x, blockPos.y, blockPos.z, 1);
     }
 
     point += direction;
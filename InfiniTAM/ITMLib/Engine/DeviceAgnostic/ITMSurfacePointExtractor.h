@@ -0,0 +1,55 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "../../Utils/ITMLibDefines.h"
+#include "ITMRepresentationAccess.h"
+#include "ITMMeshingEngine.h"
+
+/** Finds the zero crossings on the three edges leaving voxel @p pos in
+    positive x, y and z direction, so that every edge of the volume is
+    visited once. Like in the meshing engine, voxels that were never
+    observed (sdf = 1) do not take part. Returns the number of crossings,
+    their positions in voxel units and the smaller weight of each edge.
+*/
+template<class TVoxel, class TIndex>
+_CPU_AND_GPU_CODE_ inline int findSurfaceCrossings(THREADPTR(Vector3f) *crossings, THREADPTR(int) *weights, const THREADPTR(Vector3i) &pos,
+	const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(typename TIndex::IndexData) *voxelIndex, int minWeight, THREADPTR(typename TIndex::IndexCache) &cache)
+{
+	bool isFound;
+
+	TVoxel voxel = readVoxel(voxelData, voxelIndex, pos, isFound, cache);
+	float sdf = TVoxel::SDF_valueToFloat(voxel.sdf);
+	if (!isFound || sdf == 1.0f || voxel.w_depth < minWeight) return 0;
+
+	int noCrossings = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		Vector3i neighbourPos = pos;
+		neighbourPos[axis]++;
+
+		TVoxel neighbour = readVoxel(voxelData, voxelIndex, neighbourPos, isFound, cache);
+		float neighbourSdf = TVoxel::SDF_valueToFloat(neighbour.sdf);
+		if (!isFound || neighbourSdf == 1.0f || neighbour.w_depth < minWeight) continue;
+		if ((sdf < 0) == (neighbourSdf < 0)) continue;
+
+		crossings[noCrossings] = sdfInterp(pos.toFloat(), neighbourPos.toFloat(), sdf, neighbourSdf);
+		weights[noCrossings] = MIN(voxel.w_depth, neighbour.w_depth);
+		noCrossings++;
+	}
+
+	return noCrossings;
+}
+
+/// Unit normal of the surface at @p point, in voxel units, from the central differences of the SDF
+template<class TVoxel, class TIndex>
+_CPU_AND_GPU_CODE_ inline Vector3f computeSurfaceNormal(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(typename TIndex::IndexData) *voxelIndex,
+	const THREADPTR(Vector3f) &point)
+{
+	Vector3f normal = computeSingleNormalFromSDF(voxelData, voxelIndex, point);
+
+	float length = sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+	if (length > 0.0f) normal *= 1.0f / length;
+
+	return normal;
+}
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "../../Utils/ITMLibDefines.h"
+#include "ITMPixelUtils.h"
 
 _CPU_AND_GPU_CODE_ inline void convertDisparityToDepth(DEVICEPTR(float) *d_out, int x, int y, const CONSTPTR(short) *d_in,
 	Vector2f disparityCalibParams, float fx_depth, Vector2i imgSize)
@@ -81,10 +82,10 @@ _CPU_AND_GPU_CODE_ inline void computeNormalAndWeight(const CONSTPTR(float) *dep
 	}
 
 	// unprojected
-	xp1_y.x = xp1_y.z * ((x + 1.0f) - intrinparam.z) * intrinparam.x; xp1_y.y = xp1_y.z * (y - intrinparam.w) * intrinparam.y;
-	xm1_y.x = xm1_y.z * ((x - 1.0f) - intrinparam.z) * intrinparam.x; xm1_y.y = xm1_y.z * (y - intrinparam.w) * intrinparam.y;
-	x_yp1.x = x_yp1.z * (x - intrinparam.z) * intrinparam.x; x_yp1.y = x_yp1.z * ((y + 1.0f) - intrinparam.w) * intrinparam.y;
-	x_ym1.x = x_ym1.z * (x - intrinparam.z) * intrinparam.x; x_ym1.y = x_ym1.z * ((y - 1.0f) - intrinparam.w) * intrinparam.y;
+	xp1_y.x = xp1_y.z * ((x + 1.0f) - intrinparam.z) / intrinparam.x; xp1_y.y = xp1_y.z * (y - intrinparam.w) / intrinparam.y;
+	xm1_y.x = xm1_y.z * ((x - 1.0f) - intrinparam.z) / intrinparam.x; xm1_y.y = xm1_y.z * (y - intrinparam.w) / intrinparam.y;
+	x_yp1.x = x_yp1.z * (x - intrinparam.z) / intrinparam.x; x_yp1.y = x_yp1.z * ((y + 1.0f) - intrinparam.w) / intrinparam.y;
+	x_ym1.x = x_ym1.z * (x - intrinparam.z) / intrinparam.x; x_ym1.y = x_ym1.z * ((y - 1.0f) - intrinparam.w) / intrinparam.y;
 
 	// gradients x and y
 	diff_x = xp1_y - xm1_y, diff_y = x_yp1 - x_ym1;
@@ -112,3 +113,35 @@ _CPU_AND_GPU_CODE_ inline void computeNormalAndWeight(const CONSTPTR(float) *dep
 
 	sigmaZ_out[idx] = (0.0012f + 0.0019f * (z - 0.4f) * (z - 0.4f) + 0.0001f / sqrt(z) * theta_diff * theta_diff);
 }
+
+_CPU_AND_GPU_CODE_ inline void registerColourToDepth(DEVICEPTR(Vector4u) *rgb_out, DEVICEPTR(uchar) *mask_out, const CONSTPTR(Vector4u) *rgb_in,
+	const CONSTPTR(float) *depth_in, int x, int y, Vector2i imgSize_d, Vector2i imgSize_rgb, const CONSTPTR(Matrix4f) & depthToRGB, Vector4f projParams_d,
+	Vector4f projParams_rgb)
+{
+	int locId = x + y * imgSize_d.x;
+
+	Vector4f pt_camera; Vector2f pt_image;
+
+	// invalid pixels are black and marked in the mask, the colour itself may be anything
+	rgb_out[locId] = Vector4u((uchar)0);
+	mask_out[locId] = 0;
+
+	float z = depth_in[locId];
+	if (z <= 0.0f) return;
+
+	pt_camera.x = z * ((float)x - projParams_d.z) / projParams_d.x;
+	pt_camera.y = z * ((float)y - projParams_d.w) / projParams_d.y;
+	pt_camera.z = z; pt_camera.w = 1.0f;
+
+	pt_camera = depthToRGB * pt_camera;
+	if (pt_camera.z <= 0.0f) return;
+
+	pt_image.x = projParams_rgb.x * pt_camera.x / pt_camera.z + projParams_rgb.z;
+	pt_image.y = projParams_rgb.y * pt_camera.y / pt_camera.z + projParams_rgb.w;
+
+	if ((pt_image.x < 1) || (pt_image.x > imgSize_rgb.x - 2) || (pt_image.y < 1) || (pt_image.y > imgSize_rgb.y - 2)) return;
+
+	Vector4f rgb_measure = interpolateBilinear(rgb_in, pt_image, imgSize_rgb);
+	rgb_out[locId] = Vector4u((uchar)(rgb_measure.x + 0.5f), (uchar)(rgb_measure.y + 0.5f), (uchar)(rgb_measure.z + 0.5f), (uchar)255);
+	mask_out[locId] = 1;
+}
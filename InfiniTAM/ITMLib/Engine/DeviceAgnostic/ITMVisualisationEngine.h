@@ -157,11 +157,13 @@ _CPU_AND_GPU_CODE_ inline bool castRay(DEVICEPTR(Vector4f) &pt_out, int x, int y
 	return pt_found;
 }
 
+/// Projects a point into the image, @p depth is its depth in the camera frame
 _CPU_AND_GPU_CODE_ inline int forwardProjectPixel(Vector4f pixel, const CONSTPTR(Matrix4f) &M, const CONSTPTR(Vector4f) &projParams,
-	const THREADPTR(Vector2i) &imgSize)
+	const THREADPTR(Vector2i) &imgSize, THREADPTR(float) &depth)
 {
 	pixel.w = 1;
 	pixel = M * pixel;
+	depth = pixel.z;
 
 	Vector2f pt_image;
 	pt_image.x = projParams.x * pixel.x / pixel.z + projParams.z;
@@ -172,6 +174,13 @@ _CPU_AND_GPU_CODE_ inline int forwardProjectPixel(Vector4f pixel, const CONSTPTR
 	return (int)(pt_image.x + 0.5f) + (int)(pt_image.y + 0.5f) * imgSize.x;
 }
 
+_CPU_AND_GPU_CODE_ inline int forwardProjectPixel(Vector4f pixel, const CONSTPTR(Matrix4f) &M, const CONSTPTR(Vector4f) &projParams,
+	const THREADPTR(Vector2i) &imgSize)
+{
+	float depth;
+	return forwardProjectPixel(pixel, M, projParams, imgSize, depth);
+}
+
 template<class TVoxel, class TIndex>
 _CPU_AND_GPU_CODE_ inline void computeNormalAndAngle(THREADPTR(bool) & foundPoint, const THREADPTR(Vector3f) & point,
                                                      const CONSTPTR(TVoxel) *voxelBlockData, const CONSTPTR(typename TIndex::IndexData) *indexData,
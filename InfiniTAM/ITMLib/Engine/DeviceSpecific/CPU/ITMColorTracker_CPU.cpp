@@ -3,9 +3,16 @@
 #include "ITMColorTracker_CPU.h"
 #include "../../DeviceAgnostic/ITMColorTracker.h"
 #include "../../DeviceAgnostic/ITMPixelUtils.h"
+#include "../../ITMTaskScheduler.h"
 
 using namespace ITMLib::Engine;
 
+// points per chunk of the reductions below, fixed so that the sums do not depend on the number of threads
+static const int noPointsPerChunk = 1024;
+
+struct ColorTrackerF { float f; int noValidPoints; };
+struct ColorTrackerGH { float g[6]; float h[21]; };
+
 ITMColorTracker_CPU::ITMColorTracker_CPU(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, const ITMLowLevelEngine *lowLevelEngine)
 	: ITMColorTracker(imgSize, trackingRegime, noHierarchyLevels, lowLevelEngine, MEMORYDEVICE_CPU) {  }
 
@@ -29,12 +36,19 @@ void ITMColorTracker_CPU::F_oneLevel(float *f, ITMPose *pose)
 	Vector4f *colours = trackingState->pointCloud->colours->GetData(MEMORYDEVICE_CPU);
 	Vector4u *rgb = viewHierarchy->levels[levelId]->rgb->GetData(MEMORYDEVICE_CPU);
 
-	final_f = 0; countedPoints_valid = 0;
-	for (int locId = 0; locId < noTotalPoints; locId++)
-	{
-		float colorDiffSq = getColorDifferenceSq(locations, colours, rgb, imgSize, locId, projParams, M);
-		if (colorDiffSq >= 0) { final_f += colorDiffSq; countedPoints_valid++; }
-	}
+	ColorTrackerF zero = { 0.0f, 0 };
+	ColorTrackerF sum = ITMTaskScheduler::GetDefault().ParallelReduce(0, noTotalPoints, noPointsPerChunk, zero,
+		[&](int begin, int end, ColorTrackerF &partial)
+		{
+			for (int locId = begin; locId < end; locId++)
+			{
+				float colorDiffSq = getColorDifferenceSq(locations, colours, rgb, imgSize, locId, projParams, M);
+				if (colorDiffSq >= 0) { partial.f += colorDiffSq; partial.noValidPoints++; }
+			}
+		},
+		[](ColorTrackerF &result, const ColorTrackerF &partial) { result.f += partial.f; result.noValidPoints += partial.noValidPoints; });
+
+	final_f = sum.f; countedPoints_valid = sum.noValidPoints;
 
 	if (countedPoints_valid == 0) { final_f = MY_INF; scaleForOcclusions = 1.0; }
 	else { scaleForOcclusions = (float)noTotalPoints / countedPoints_valid; }
@@ -59,9 +73,6 @@ void ITMColorTracker_CPU::G_oneLevel(float *gradient, float *hessian, ITMPose *p
 	bool rotationOnly = iterationType == TRACKER_ITERATION_ROTATION;
 	int numPara = rotationOnly ? 3 : 6, startPara = rotationOnly ? 3 : 0, numParaSQ = rotationOnly ? 3 + 2 + 1 : 6 + 5 + 4 + 3 + 2 + 1;
 
-	float globalGradient[6], globalHessian[21];
-	for (int i = 0; i < numPara; i++) globalGradient[i] = 0.0f;
-	for (int i = 0; i < numParaSQ; i++) globalHessian[i] = 0.0f;
 
 	Vector4f *locations = trackingState->pointCloud->locations->GetData(MEMORYDEVICE_CPU);
 	Vector4f *colours = trackingState->pointCloud->colours->GetData(MEMORYDEVICE_CPU);
@@ -69,19 +80,34 @@ void ITMColorTracker_CPU::G_oneLevel(float *gradient, float *hessian, ITMPose *p
 	Vector4s *gx = viewHierarchy->levels[levelId]->gradientX_rgb->GetData(MEMORYDEVICE_CPU);
 	Vector4s *gy = viewHierarchy->levels[levelId]->gradientY_rgb->GetData(MEMORYDEVICE_CPU);
 
-	for (int locId = 0; locId < noTotalPoints; locId++)
-	{
-		float localGradient[6], localHessian[21];
-
-		bool isValidPoint = computePerPointGH_rt_Color(localGradient, localHessian, locations, colours, rgb, imgSize, locId,
-			projParams, M, gx, gy, numPara, startPara);
+	ColorTrackerGH zero;
+	for (int i = 0; i < 6; i++) zero.g[i] = 0.0f;
+	for (int i = 0; i < 21; i++) zero.h[i] = 0.0f;
 
-		if (isValidPoint)
+	ColorTrackerGH sum = ITMTaskScheduler::GetDefault().ParallelReduce(0, noTotalPoints, noPointsPerChunk, zero,
+		[&](int begin, int end, ColorTrackerGH &partial)
 		{
-			for (int i = 0; i < numPara; i++) globalGradient[i] += localGradient[i];
-			for (int i = 0; i < numParaSQ; i++) globalHessian[i] += localHessian[i];
-		}
-	}
+			for (int locId = begin; locId < end; locId++)
+			{
+				float localGradient[6], localHessian[21];
+
+				bool isValidPoint = computePerPointGH_rt_Color(localGradient, localHessian, locations, colours, rgb, imgSize, locId,
+					projParams, M, gx, gy, numPara, startPara);
+
+				if (isValidPoint)
+				{
+					for (int i = 0; i < numPara; i++) partial.g[i] += localGradient[i];
+					for (int i = 0; i < numParaSQ; i++) partial.h[i] += localHessian[i];
+				}
+			}
+		},
+		[&](ColorTrackerGH &result, const ColorTrackerGH &partial)
+		{
+			for (int i = 0; i < numPara; i++) result.g[i] += partial.g[i];
+			for (int i = 0; i < numParaSQ; i++) result.h[i] += partial.h[i];
+		});
+
+	const float *globalGradient = sum.g, *globalHessian = sum.h;
 
 	scaleForOcclusions = (float)noTotalPoints / countedPoints_valid;
 	if (countedPoints_valid == 0) { scaleForOcclusions = 1.0f; }
@@ -10,6 +10,13 @@ namespace ITMLib
 	{
 		class ITMDepthTracker_CPU : public ITMDepthTracker
 		{
+		public:
+			struct AccuCell;
+
+		private:
+			/// Partial sums of each image row, added up in row order so the result does not depend on the number of threads.
+			AccuCell *rowAccu;
+
 		protected:
 			int ComputeGandH(float &f, float *nabla, float *hessian, Matrix4f approxInvPose);
 
@@ -0,0 +1,133 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "../../../Objects/ITMScene.h"
+#include "../../DeviceAgnostic/ITMRepresentationAccess.h"
+
+namespace ITMLib
+{
+	namespace Engine
+	{
+		/** Index of the hash entry of the block at @p blockPos, including
+		    blocks that are swapped out, or -1 if there is none.
+		*/
+		inline int findHashEntry_CPU(const ITMHashEntry *hashTable, const Vector3s &blockPos)
+		{
+			int hashIdx = hashIndex(blockPos);
+
+			while (true)
+			{
+				const ITMHashEntry &hashEntry = hashTable[hashIdx];
+				if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= -1) return hashIdx;
+
+				if (hashEntry.offset < 1) return -1;
+				hashIdx = SDF_BUCKET_NUM + hashEntry.offset - 1;
+			}
+		}
+
+		/** Allocates the block at @p blockPos, which must not be in the
+		    hash table yet, as the reconstruction engine does: into its
+		    bucket if that is free, otherwise into an entry of the excess
+		    list appended to the chain of the bucket. The voxels of the
+		    block are reset. Returns the index of the hash entry, or -1 if
+		    the scene is out of voxel blocks or excess entries. Single
+		    threaded.
+		*/
+		template<class TVoxel>
+		inline int allocateVoxelBlock_CPU(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, const Vector3s &blockPos)
+		{
+			ITMHashEntry *hashTable = scene->index.GetEntries();
+			int *allocationList = scene->localVBA.GetAllocationList();
+			int *excessAllocationList = scene->index.GetExcessAllocationList();
+
+			if (scene->localVBA.lastFreeBlockId < 0) return -1;
+
+			int hashIdx = hashIndex(blockPos);
+
+			// the bucket is taken, append an entry from the excess list to its chain
+			if (hashTable[hashIdx].ptr >= -1)
+			{
+				int lastFreeExcessListId = scene->index.GetLastFreeExcessListId();
+				if (lastFreeExcessListId < 0) return -1;
+
+				while (hashTable[hashIdx].offset >= 1) hashIdx = SDF_BUCKET_NUM + hashTable[hashIdx].offset - 1;
+
+				int exlOffset = excessAllocationList[lastFreeExcessListId];
+				scene->index.SetLastFreeExcessListId(lastFreeExcessListId - 1);
+
+				hashTable[hashIdx].offset = exlOffset + 1;
+				hashIdx = SDF_BUCKET_NUM + exlOffset;
+			}
+
+			ITMHashEntry &hashEntry = hashTable[hashIdx];
+			hashEntry.pos = blockPos;
+			hashEntry.ptr = allocationList[scene->localVBA.lastFreeBlockId--];
+			hashEntry.offset = 0;
+
+			TVoxel *voxelBlock = scene->localVBA.GetVoxelBlocks() + hashEntry.ptr * SDF_BLOCK_SIZE3;
+			for (int i = 0; i < SDF_BLOCK_SIZE3; i++) voxelBlock[i] = TVoxel();
+
+			return hashIdx;
+		}
+
+		/** Removes the block at @p blockPos from the scene, undoing
+		    allocateVoxelBlock_CPU(). The voxel block goes back to the
+		    allocation list, or is retired if read views are published
+		    (see ITMSceneEpochs). An entry of the excess list goes back to
+		    the excess allocation list; if the bucket itself is removed,
+		    the next entry of its chain moves into it. Hash entry indices
+		    of the chain change therefore. Returns false if the block is
+		    not allocated. Single threaded.
+		*/
+		template<class TVoxel>
+		inline bool removeVoxelBlock_CPU(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, const Vector3s &blockPos)
+		{
+			ITMHashEntry *hashTable = scene->index.GetEntries();
+			int *allocationList = scene->localVBA.GetAllocationList();
+			int *excessAllocationList = scene->index.GetExcessAllocationList();
+
+			int hashIdx = findHashEntry_CPU(hashTable, blockPos);
+			if (hashIdx < 0 || hashTable[hashIdx].ptr < 0) return false;
+
+			int ptr = hashTable[hashIdx].ptr;
+			if (scene->epochs.IsPublishing()) scene->epochs.RetireBlock(ptr);
+			else
+			{
+				TVoxel *voxelBlock = scene->localVBA.GetVoxelBlocks() + ptr * SDF_BLOCK_SIZE3;
+				for (int i = 0; i < SDF_BLOCK_SIZE3; i++) voxelBlock[i] = TVoxel();
+				allocationList[++scene->localVBA.lastFreeBlockId] = ptr;
+			}
+
+			ITMHashEntry emptyEntry;
+			emptyEntry.pos = Vector3s((short)0); emptyEntry.offset = 0; emptyEntry.ptr = -2;
+
+			int excessId;
+			if (hashIdx < SDF_BUCKET_NUM)
+			{
+				int offset = hashTable[hashIdx].offset;
+				if (offset < 1) { hashTable[hashIdx] = emptyEntry; return true; }
+
+				// the bucket takes over the next entry of its chain, which frees that one
+				excessId = offset - 1;
+				hashTable[hashIdx] = hashTable[SDF_BUCKET_NUM + excessId];
+			}
+			else
+			{
+				excessId = hashIdx - SDF_BUCKET_NUM;
+
+				int prevIdx = hashIndex(blockPos);
+				while (hashTable[prevIdx].offset - 1 != excessId) prevIdx = SDF_BUCKET_NUM + hashTable[prevIdx].offset - 1;
+				hashTable[prevIdx].offset = hashTable[hashIdx].offset;
+			}
+
+			hashTable[SDF_BUCKET_NUM + excessId] = emptyEntry;
+
+			int lastFreeExcessListId = scene->index.GetLastFreeExcessListId() + 1;
+			excessAllocationList[lastFreeExcessListId] = excessId;
+			scene->index.SetLastFreeExcessListId(lastFreeExcessListId);
+
+			return true;
+		}
+	}
+}
@@ -0,0 +1,128 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMHybridTracker_CPU.h"
+#include "../../DeviceAgnostic/ITMHybridTracker.h"
+#include "../../ITMTaskScheduler.h"
+
+using namespace ITMLib::Engine;
+
+struct ITMHybridTracker_CPU::AccuCell {
+	int numPoints;
+	float f;
+	float g[6];
+	float h[6+5+4+3+2+1];
+};
+
+ITMHybridTracker_CPU::ITMHybridTracker_CPU(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, float distThresh,
+	float terminationThreshold, float icpWeight, float photometricWeight, const ITMLowLevelEngine *lowLevelEngine)
+	:ITMHybridTracker(imgSize, trackingRegime, noHierarchyLevels, distThresh, terminationThreshold, icpWeight, photometricWeight,
+	lowLevelEngine, MEMORYDEVICE_CPU)
+{
+	rowAccu = new AccuCell[imgSize.y];
+}
+
+ITMHybridTracker_CPU::~ITMHybridTracker_CPU(void)
+{
+	delete[] rowAccu;
+}
+
+int ITMHybridTracker_CPU::ComputeGandH(float &f, float *nabla, float *hessian, Matrix4f approxInvPose)
+{
+	Vector4f *pointsMap = sceneHierarchyLevel->pointsMap->GetData(MEMORYDEVICE_CPU);
+	Vector4f *normalsMap = sceneHierarchyLevel->normalsMap->GetData(MEMORYDEVICE_CPU);
+	Vector4f sceneIntrinsics = sceneHierarchyLevel->intrinsics;
+	Vector2i sceneImageSize = sceneHierarchyLevel->pointsMap->noDims;
+
+	float *depth = viewHierarchyLevel->depth->GetData(MEMORYDEVICE_CPU);
+	Vector4f viewIntrinsics = viewHierarchyLevel->intrinsics;
+	Vector2i viewImageSize = viewHierarchyLevel->depth->noDims;
+
+	Vector4u *rgb = viewHierarchyLevel->rgb->GetData(MEMORYDEVICE_CPU);
+	Vector2i rgbImageSize = viewHierarchyLevel->rgb->noDims;
+
+	// without a reference frame only the ICP term is evaluated
+	float photometricWeight = referenceHierarchyLevel != NULL ? this->photometricWeight : 0.0f;
+	Vector4u *refRGB = NULL; Vector4s *refGradX = NULL, *refGradY = NULL;
+	Vector2i refImageSize(0, 0);
+	if (referenceHierarchyLevel != NULL)
+	{
+		refRGB = referenceHierarchyLevel->rgb->GetData(MEMORYDEVICE_CPU);
+		refGradX = referenceHierarchyLevel->gradientX_rgb->GetData(MEMORYDEVICE_CPU);
+		refGradY = referenceHierarchyLevel->gradientY_rgb->GetData(MEMORYDEVICE_CPU);
+		refImageSize = referenceHierarchyLevel->rgb->noDims;
+	}
+
+	if (iterationType == TRACKER_ITERATION_NONE) return 0;
+
+	bool shortIteration = (iterationType == TRACKER_ITERATION_ROTATION) || (iterationType == TRACKER_ITERATION_TRANSLATION);
+
+	float sumHessian[6 * 6], sumNabla[6], sumF; int noValidPoints;
+	int noPara = shortIteration ? 3 : 6, noParaSQ = shortIteration ? 3 + 2 + 1 : 6 + 5 + 4 + 3 + 2 + 1;
+
+	ITMTaskScheduler::GetDefault().ParallelFor(0, viewImageSize.y, [&](int y)
+	{
+		AccuCell &accu = rowAccu[y];
+
+		accu.numPoints = 0; accu.f = 0.0f;
+		for (int i = 0; i < noPara; i++) accu.g[i] = 0.0f;
+		for (int i = 0; i < noParaSQ; i++) accu.h[i] = 0.0f;
+
+		for (int x = 0; x < viewImageSize.x; x++)
+		{
+			float localHessian[6 + 5 + 4 + 3 + 2 + 1], localNabla[6], localF = 0;
+
+			bool isValidPoint;
+
+			switch (iterationType)
+			{
+			case TRACKER_ITERATION_ROTATION:
+				isValidPoint = computePerPointGH_Hybrid<true, true>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], viewImageSize, viewIntrinsics,
+					sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId], icpWeight,
+					depthToRGB, rgbIntrinsics, rgbImageSize, rgb, refImageSize, referencePose, refRGB, refGradX, refGradY, photometricWeight);
+				break;
+			case TRACKER_ITERATION_TRANSLATION:
+				isValidPoint = computePerPointGH_Hybrid<true, false>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], viewImageSize, viewIntrinsics,
+					sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId], icpWeight,
+					depthToRGB, rgbIntrinsics, rgbImageSize, rgb, refImageSize, referencePose, refRGB, refGradX, refGradY, photometricWeight);
+				break;
+			case TRACKER_ITERATION_BOTH:
+				isValidPoint = computePerPointGH_Hybrid<false, false>(localNabla, localHessian, localF, x, y, depth[x + y * viewImageSize.x], viewImageSize, viewIntrinsics,
+					sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId], icpWeight,
+					depthToRGB, rgbIntrinsics, rgbImageSize, rgb, refImageSize, referencePose, refRGB, refGradX, refGradY, photometricWeight);
+				break;
+			default:
+				isValidPoint = false;
+				break;
+			}
+
+			if (isValidPoint)
+			{
+				accu.numPoints++; accu.f += localF;
+				for (int i = 0; i < noPara; i++) accu.g[i] += localNabla[i];
+				for (int i = 0; i < noParaSQ; i++) accu.h[i] += localHessian[i];
+			}
+		}
+	});
+
+	// reduce the rows in a fixed order
+	noValidPoints = 0; sumF = 0.0f;
+	memset(sumHessian, 0, sizeof(float) * noParaSQ);
+	memset(sumNabla, 0, sizeof(float) * noPara);
+
+	for (int y = 0; y < viewImageSize.y; y++)
+	{
+		const AccuCell &accu = rowAccu[y];
+
+		noValidPoints += accu.numPoints; sumF += accu.f;
+		for (int i = 0; i < noPara; i++) sumNabla[i] += accu.g[i];
+		for (int i = 0; i < noParaSQ; i++) sumHessian[i] += accu.h[i];
+	}
+
+	for (int r = 0, counter = 0; r < noPara; r++) for (int c = 0; c <= r; c++, counter++) hessian[r + c * 6] = sumHessian[counter];
+	for (int r = 0; r < noPara; ++r) for (int c = r + 1; c < noPara; c++) hessian[r + c * 6] = hessian[c + r * 6];
+
+	memcpy(nabla, sumNabla, noPara * sizeof(float));
+	f = (noValidPoints > 100) ? sqrt(sumF) / noValidPoints : 1e5f;
+
+	return noValidPoints;
+}
@@ -0,0 +1,29 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "../../ITMHybridTracker.h"
+
+namespace ITMLib
+{
+	namespace Engine
+	{
+		class ITMHybridTracker_CPU : public ITMHybridTracker
+		{
+		public:
+			struct AccuCell;
+
+		private:
+			/// Partial sums of each image row, added up in row order so the result does not depend on the number of threads.
+			AccuCell *rowAccu;
+
+		protected:
+			int ComputeGandH(float &f, float *nabla, float *hessian, Matrix4f approxInvPose);
+
+		public:
+			ITMHybridTracker_CPU(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, float distThresh,
+				float terminationThreshold, float icpWeight, float photometricWeight, const ITMLowLevelEngine *lowLevelEngine);
+			~ITMHybridTracker_CPU(void);
+		};
+	}
+}
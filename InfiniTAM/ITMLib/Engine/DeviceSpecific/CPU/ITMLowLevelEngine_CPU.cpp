@@ -3,6 +3,7 @@
 #include "ITMLowLevelEngine_CPU.h"
 
 #include "../../DeviceAgnostic/ITMLowLevelEngine.h"
+#include "../../ITMTaskScheduler.h"
 
 using namespace ITMLib::Engine;
 
@@ -43,8 +44,11 @@ void ITMLowLevelEngine_CPU::FilterSubsample(ITMUChar4Image *image_out, const ITM
 	const Vector4u *imageData_in = image_in->GetData(MEMORYDEVICE_CPU);
 	Vector4u *imageData_out = image_out->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 0; y < newDims.y; y++) for (int x = 0; x < newDims.x; x++)
-		filterSubsample(imageData_out, x, y, newDims, imageData_in, oldDims);
+	ITMTaskScheduler::GetDefault().ParallelFor(0, newDims.y, [&](int y)
+	{
+		for (int x = 0; x < newDims.x; x++)
+			filterSubsample(imageData_out, x, y, newDims, imageData_in, oldDims);
+	});
 }
 
 void ITMLowLevelEngine_CPU::FilterSubsampleWithHoles(ITMFloatImage *image_out, const ITMFloatImage *image_in) const
@@ -57,8 +61,11 @@ void ITMLowLevelEngine_CPU::FilterSubsampleWithHoles(ITMFloatImage *image_out, c
 	const float *imageData_in = image_in->GetData(MEMORYDEVICE_CPU);
 	float *imageData_out = image_out->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 0; y < newDims.y; y++) for (int x = 0; x < newDims.x; x++)
-		filterSubsampleWithHoles(imageData_out, x, y, newDims, imageData_in, oldDims);
+	ITMTaskScheduler::GetDefault().ParallelFor(0, newDims.y, [&](int y)
+	{
+		for (int x = 0; x < newDims.x; x++)
+			filterSubsampleWithHoles(imageData_out, x, y, newDims, imageData_in, oldDims);
+	});
 }
 
 void ITMLowLevelEngine_CPU::FilterSubsampleWithHoles(ITMFloat4Image *image_out, const ITMFloat4Image *image_in) const
@@ -71,8 +78,32 @@ void ITMLowLevelEngine_CPU::FilterSubsampleWithHoles(ITMFloat4Image *image_out,
 	const Vector4f *imageData_in = image_in->GetData(MEMORYDEVICE_CPU);
 	Vector4f *imageData_out = image_out->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 0; y < newDims.y; y++) for (int x = 0; x < newDims.x; x++)
-		filterSubsampleWithHoles(imageData_out, x, y, newDims, imageData_in, oldDims);
+	ITMTaskScheduler::GetDefault().ParallelFor(0, newDims.y, [&](int y)
+	{
+		for (int x = 0; x < newDims.x; x++)
+			filterSubsampleWithHoles(imageData_out, x, y, newDims, imageData_in, oldDims);
+	});
+}
+
+void ITMLowLevelEngine_CPU::FilterSubsampleWithHoles(ITMFloatImage *depth_out, ITMFloatImage *uncertainty_out, const ITMFloatImage *depth_in,
+	const ITMFloatImage *uncertainty_in) const
+{
+	Vector2i oldDims = depth_in->noDims;
+	Vector2i newDims; newDims.x = depth_in->noDims.x / 2; newDims.y = depth_in->noDims.y / 2;
+
+	depth_out->ChangeDims(newDims);
+	uncertainty_out->ChangeDims(newDims);
+
+	const float *depthData_in = depth_in->GetData(MEMORYDEVICE_CPU);
+	const float *uncertaintyData_in = uncertainty_in->GetData(MEMORYDEVICE_CPU);
+	float *depthData_out = depth_out->GetData(MEMORYDEVICE_CPU);
+	float *uncertaintyData_out = uncertainty_out->GetData(MEMORYDEVICE_CPU);
+
+	ITMTaskScheduler::GetDefault().ParallelFor(0, newDims.y, [&](int y)
+	{
+		for (int x = 0; x < newDims.x; x++)
+			filterSubsampleWithHoles(depthData_out, uncertaintyData_out, x, y, newDims, depthData_in, uncertaintyData_in, oldDims);
+	});
 }
 
 void ITMLowLevelEngine_CPU::GradientX(ITMShort4Image *grad_out, const ITMUChar4Image *image_in) const
@@ -85,8 +116,11 @@ void ITMLowLevelEngine_CPU::GradientX(ITMShort4Image *grad_out, const ITMUChar4I
 
 	memset(grad, 0, imgSize.x * imgSize.y * sizeof(Vector3s));
 
-	for (int y = 1; y < imgSize.y - 1; y++) for (int x = 1; x < imgSize.x - 1; x++)
-		gradientX(grad, x, y, image, imgSize);
+	ITMTaskScheduler::GetDefault().ParallelFor(1, imgSize.y - 1, [&](int y)
+	{
+		for (int x = 1; x < imgSize.x - 1; x++)
+			gradientX(grad, x, y, image, imgSize);
+	});
 }
 
 void ITMLowLevelEngine_CPU::GradientY(ITMShort4Image *grad_out, const ITMUChar4Image *image_in) const
@@ -99,6 +133,9 @@ void ITMLowLevelEngine_CPU::GradientY(ITMShort4Image *grad_out, const ITMUChar4I
 
 	memset(grad, 0, imgSize.x * imgSize.y * sizeof(Vector3s));
 
-	for (int y = 1; y < imgSize.y - 1; y++) for (int x = 1; x < imgSize.x - 1; x++)
-		gradientY(grad, x, y, image, imgSize);
+	ITMTaskScheduler::GetDefault().ParallelFor(1, imgSize.y - 1, [&](int y)
+	{
+		for (int x = 1; x < imgSize.x - 1; x++)
+			gradientY(grad, x, y, image, imgSize);
+	});
 }
\ No newline at end of file
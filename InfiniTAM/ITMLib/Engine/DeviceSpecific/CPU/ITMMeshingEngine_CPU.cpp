@@ -69,4 +69,4 @@ template<class TVoxel>
 void ITMMeshingEngine_CPU<TVoxel, ITMPlainVoxelArray>::MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMPlainVoxelArray> *scene)
 {}
 
-template class ITMLib::Engine::ITMMeshingEngine_CPU<ITMVoxel, ITMVoxelIndex>;
+ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(ITMLib::Engine::ITMMeshingEngine_CPU)
@@ -3,74 +3,234 @@
 #include "ITMRenTracker_CPU.h"
 #include "../../DeviceAgnostic/ITMRenTracker.h"
 #include "../../DeviceAgnostic/ITMRepresentationAccess.h" 
+#include "../../ITMTaskScheduler.h"
+
+#include <atomic>
+#include <memory>
 
 using namespace ITMLib::Engine;
 
 
+// points per task of the parallel reductions; fixed, so that the sums do not depend on the number of threads
+static const int noPointsPerChunk = 4096;
+
+struct RenTrackerGH
+{
+	float gradient[6], hessian[21];
+
+	RenTrackerGH(void)
+	{
+		for (int i = 0; i < 6; i++) gradient[i] = 0.0f;
+		for (int i = 0; i < 21; i++) hessian[i] = 0.0f;
+	}
+};
+
+// the gradient cache is organised by voxel block
+template<class TIndex> struct SupportsSDFGradientCache { static const bool value = false; };
+template<> struct SupportsSDFGradientCache<ITMVoxelBlockHash> { static const bool value = true; };
+
 template<class TVoxel, class TIndex>
-ITMLib::Engine::ITMRenTracker_CPU<TVoxel, TIndex>::ITMRenTracker_CPU(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, const ITMLowLevelEngine *lowLevelEngine, const ITMScene<TVoxel, TIndex> *scene)
-	: ITMRenTracker<TVoxel, TIndex>(imgSize, trackingRegime, noHierarchyLevels, lowLevelEngine, scene, MEMORYDEVICE_CPU){}
+struct ITMRenTracker_CPU<TVoxel, TIndex>::SDFGradientCache
+{
+	int epoch;
+
+	/// Per voxel block: epoch in which its gradients were computed, or minus the current epoch while they are.
+	std::unique_ptr<std::atomic<int>[]> blockEpochs;
+
+	/// SDF gradient of each voxel, laid out like the voxel block array, w is 0 where it could not be computed
+	std::vector<Vector4f> gradients;
+
+	SDFGradientCache(int noBlocks) : epoch(1), blockEpochs(new std::atomic<int>[noBlocks]), gradients((size_t)noBlocks * SDF_BLOCK_SIZE3)
+	{
+		for (int blockId = 0; blockId < noBlocks; blockId++) blockEpochs[blockId] = 0;
+	}
+};
 
 template<class TVoxel, class TIndex>
-ITMRenTracker_CPU<TVoxel,TIndex>::~ITMRenTracker_CPU(void) { }
+ITMLib::Engine::ITMRenTracker_CPU<TVoxel, TIndex>::ITMRenTracker_CPU(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, const ITMLowLevelEngine *lowLevelEngine, const ITMScene<TVoxel, TIndex> *scene, bool useGradientCache)
+	: ITMRenTracker<TVoxel, TIndex>(imgSize, trackingRegime, noHierarchyLevels, lowLevelEngine, scene, MEMORYDEVICE_CPU)
+{
+	sortedPoints.resize(this->viewHierarchy->noLevels);
+	sortedPointsAreValid.assign(this->viewHierarchy->noLevels, false);
+
+	gradientCache = NULL;
+	if (useGradientCache && SupportsSDFGradientCache<TIndex>::value)
+		gradientCache = new SDFGradientCache(scene->localVBA.allocatedSize / SDF_BLOCK_SIZE3);
+}
 
 template<class TVoxel, class TIndex>
-void ITMRenTracker_CPU<TVoxel,TIndex>::F_oneLevel(float *f, Matrix4f invM)
+ITMRenTracker_CPU<TVoxel,TIndex>::~ITMRenTracker_CPU(void)
 {
-	int count = static_cast<int>(this->viewHierarchy->levels[this->levelId]->depth->dataSize);
-	Vector4f *ptList = this->viewHierarchy->levels[this->levelId]->depth->GetData(MEMORYDEVICE_CPU);
+	delete gradientCache;
+}
+
+template<class TVoxel, class TIndex>
+const Vector4f *ITMRenTracker_CPU<TVoxel,TIndex>::GetBlockGradients(int blockId, const Vector3i &voxelPos) const
+{
+	std::atomic<int> &blockEpoch = gradientCache->blockEpochs[blockId];
+	int epoch = gradientCache->epoch;
+
+	// if another thread is filling the block, the caller computes its gradient directly rather than waiting
+	int cachedEpoch = blockEpoch.load();
+	Vector4f *gradients = &gradientCache->gradients[(size_t)blockId * SDF_BLOCK_SIZE3];
+	if (cachedEpoch == epoch) return gradients;
+	if (cachedEpoch == -epoch || !blockEpoch.compare_exchange_strong(cachedEpoch, -epoch)) return NULL;
 
 	const TVoxel *voxelBlocks = this->scene->localVBA.GetVoxelBlocks();
 	const typename TIndex::IndexData *index = this->scene->index.getIndexData();
 	float oneOverVoxelSize = 1.0f / (float)this->scene->sceneParams->voxelSize;
 
-	float energy = 0;
+	Vector3i blockPos;
+	pointToVoxelBlockPos(voxelPos, blockPos);
+	blockPos *= SDF_BLOCK_SIZE;
+
+	typename TIndex::IndexCache cache;
+	for (int z = 0; z < SDF_BLOCK_SIZE; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+	{
+		bool isFound;
+		Vector3f pt((float)(blockPos.x + x), (float)(blockPos.y + y), (float)(blockPos.z + z));
+		Vector3f dDt = computeDDT<TVoxel, TIndex>(pt, voxelBlocks, index, oneOverVoxelSize, isFound, cache);
+
+		gradients[x + y * SDF_BLOCK_SIZE + z * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE] = Vector4f(dDt, isFound ? 1.0f : 0.0f);
+	}
+
+	blockEpoch.store(epoch);
+	return gradients;
+}
+
+template<class TVoxel, class TIndex>
+void ITMRenTracker_CPU<TVoxel,TIndex>::SortPointsByBlock(int levelId, const Matrix4f &invM)
+{
+	int count = static_cast<int>(this->viewHierarchy->levels[levelId]->depth->dataSize);
+	const Vector4f *ptList = this->viewHierarchy->levels[levelId]->depth->GetData(MEMORYDEVICE_CPU);
+	float oneOverVoxelSize = 1.0f / (float)this->scene->sceneParams->voxelSize;
+
+	const typename TIndex::IndexData *index = this->scene->index.getIndexData();
+	int noBuckets = this->scene->localVBA.allocatedSize / SDF_BLOCK_SIZE3 + 1;
+
+	// counting sort on the position of the voxel block of each point in the voxel block array, so that the points are
+	// visited in memory order of the voxels they read; points outside the allocated blocks go last
+	pointBuckets.resize(count);
+	bucketStarts.assign(noBuckets + 1, 0);
 
+	typename TIndex::IndexCache cache;
 	for (int i = 0; i < count; i++)
 	{
-		Vector4f inpt = ptList[i];
-		if (inpt.w > -1.0f) energy += computePerPixelEnergy<TVoxel,TIndex>(inpt, voxelBlocks, index, oneOverVoxelSize, invM);
+		if (ptList[i].w == -1.0f) { pointBuckets[i] = -1; continue; }
+
+		Vector3f pt = TO_VECTOR3(invM * ptList[i]) * oneOverVoxelSize;
+		bool isFound;
+		int voxelAddress = findVoxel(index, Vector3i((int)ROUND(pt.x), (int)ROUND(pt.y), (int)ROUND(pt.z)), isFound, cache);
+
+		pointBuckets[i] = isFound ? voxelAddress / SDF_BLOCK_SIZE3 : noBuckets - 1;
+		bucketStarts[pointBuckets[i] + 1]++;
 	}
 
-	f[0] = -energy;
+	for (int bucket = 0; bucket < noBuckets; bucket++) bucketStarts[bucket + 1] += bucketStarts[bucket];
+
+	std::vector<Vector4f> &points = sortedPoints[levelId];
+	points.resize(bucketStarts[noBuckets]);
+	for (int i = 0; i < count; i++)
+		if (pointBuckets[i] >= 0) points[bucketStarts[pointBuckets[i]]++] = ptList[i];
+
+	sortedPointsAreValid[levelId] = true;
 }
 
 template<class TVoxel, class TIndex>
-void ITMRenTracker_CPU<TVoxel,TIndex>::G_oneLevel(float *gradient, float *hessian, Matrix4f invM) const
+void ITMRenTracker_CPU<TVoxel,TIndex>::F_oneLevel(float *f, Matrix4f invM)
 {
-	int count = static_cast<int>(this->viewHierarchy->levels[this->levelId]->depth->dataSize);
-	Vector4f *ptList = this->viewHierarchy->levels[this->levelId]->depth->GetData(MEMORYDEVICE_CPU);
+	// the pose changes little during the optimisation, so the order found at the first evaluation stays coherent
+	if (!sortedPointsAreValid[this->levelId]) SortPointsByBlock(this->levelId, invM);
+
+	const std::vector<Vector4f> &points = sortedPoints[this->levelId];
 
 	const TVoxel *voxelBlocks = this->scene->localVBA.GetVoxelBlocks();
 	const typename TIndex::IndexData *index = this->scene->index.getIndexData();
 	float oneOverVoxelSize = 1.0f / (float)this->scene->sceneParams->voxelSize;
 
-	int noPara = 6, noParaSQ = 21;
+	float energy = ITMTaskScheduler::GetDefault().ParallelReduce(0, (int)points.size(), noPointsPerChunk, 0.0f,
+		[&](int chunkBegin, int chunkEnd, float &partial)
+		{
+			typename TIndex::IndexCache cache;
+			float energy = 0.0f;
+			for (int i = chunkBegin; i < chunkEnd; i++)
+				energy += computePerPixelEnergy<TVoxel,TIndex>(points[i], voxelBlocks, index, oneOverVoxelSize, invM, cache);
+			partial = energy;
+		},
+		[](float &result, const float &partial) { result += partial; });
 
-	float globalGradient[6], globalHessian[21];
-	for (int i = 0; i < noPara; i++) globalGradient[i] = 0.0f;
-	for (int i = 0; i < noParaSQ; i++) globalHessian[i] = 0.0f;
+	f[0] = -energy;
+}
 
-	for (int i = 0; i < count; i++)
-	{
-		Vector4f cPt = ptList[i];
-		if (cPt.w == -1.0f) continue;
+template<class TVoxel, class TIndex>
+void ITMRenTracker_CPU<TVoxel,TIndex>::G_oneLevel(float *gradient, float *hessian, Matrix4f invM) const
+{
+	// F_oneLevel is always evaluated first and has sorted the points
+	const std::vector<Vector4f> &points = sortedPoints[this->levelId];
+
+	const TVoxel *voxelBlocks = this->scene->localVBA.GetVoxelBlocks();
+	const typename TIndex::IndexData *index = this->scene->index.getIndexData();
+	float oneOverVoxelSize = 1.0f / (float)this->scene->sceneParams->voxelSize;
 
-		float jacobian[6];
+	int noPara = 6;
 
-		if (computePerPixelJacobian<TVoxel,TIndex>(jacobian, cPt, voxelBlocks, index, oneOverVoxelSize, invM))
+	RenTrackerGH sum = ITMTaskScheduler::GetDefault().ParallelReduce(0, (int)points.size(), noPointsPerChunk, RenTrackerGH(),
+		[&](int chunkBegin, int chunkEnd, RenTrackerGH &partial)
 		{
-			for (int r = 0, counter = 0; r < noPara; r++)
+			RenTrackerGH local;
+			typename TIndex::IndexCache cache;
+			for (int i = chunkBegin; i < chunkEnd; i++)
 			{
-				globalGradient[r] -= jacobian[r];
-				for (int c = 0; c <= r; c++, counter++) globalHessian[counter] += jacobian[r] * jacobian[c];
+				float jacobian[6];
+
+				if (gradientCache != NULL)
+				{
+					// same voxel lookups as computePerPixelJacobian, with the gradient taken from the cache
+					Vector3f cPt = TO_VECTOR3(invM * points[i]), pt = cPt * oneOverVoxelSize;
+					Vector3i voxelPos((int)ROUND(pt.x), (int)ROUND(pt.y), (int)ROUND(pt.z));
+
+					bool isFound;
+					int voxelAddress = findVoxel(index, voxelPos, isFound, cache);
+					if (!isFound) continue;
+
+					float dt = TVoxel::SDF_valueToFloat(voxelBlocks[voxelAddress].sdf);
+					if (dt == 1.0f) continue;
+
+					Vector3f dDt;
+					const Vector4f *gradients = GetBlockGradients(voxelAddress / SDF_BLOCK_SIZE3, voxelPos);
+					if (gradients != NULL)
+					{
+						const Vector4f &gradient = gradients[voxelAddress % SDF_BLOCK_SIZE3];
+						if (gradient.w == 0.0f) continue;
+						dDt = TO_VECTOR3(gradient);
+					}
+					else
+					{
+						dDt = computeDDT<TVoxel, TIndex>(pt, voxelBlocks, index, oneOverVoxelSize, isFound, cache);
+						if (!isFound) continue;
+					}
+
+					computeJacobianFromDDT(jacobian, cPt, dt, dDt);
+				}
+				else if (!computePerPixelJacobian<TVoxel,TIndex>(jacobian, points[i], voxelBlocks, index, oneOverVoxelSize, invM, cache)) continue;
+
+				for (int r = 0, counter = 0; r < noPara; r++)
+				{
+					local.gradient[r] -= jacobian[r];
+					for (int c = 0; c <= r; c++, counter++) local.hessian[counter] += jacobian[r] * jacobian[c];
+				}
 			}
-		}
-	}
+			partial = local;
+		},
+		[](RenTrackerGH &result, const RenTrackerGH &partial)
+		{
+			for (int i = 0; i < 6; i++) result.gradient[i] += partial.gradient[i];
+			for (int i = 0; i < 21; i++) result.hessian[i] += partial.hessian[i];
+		});
 
-	for (int r = 0, counter = 0; r < noPara; r++) for (int c = 0; c <= r; c++, counter++) hessian[r + c * 6] = globalHessian[counter];
+	for (int r = 0, counter = 0; r < noPara; r++) for (int c = 0; c <= r; c++, counter++) hessian[r + c * 6] = sum.hessian[counter];
 	for (int r = 0; r < noPara; ++r) for (int c = r + 1; c < noPara; c++) hessian[r + c * 6] = hessian[c + r * 6];
-	for (int r = 0; r < noPara; ++r) gradient[r] = globalGradient[r];
+	for (int r = 0; r < noPara; ++r) gradient[r] = sum.gradient[r];
 }
 
 template<class TVoxel, class TIndex>
@@ -86,19 +246,26 @@ void ITMRenTracker_CPU<TVoxel,TIndex>::UnprojectDepthToCam(ITMFloatImage *depth,
 	Vector2i imgSize = depth->noDims;
 	upPtCloud->noDims = imgSize; upPtCloud->dataSize = depth->dataSize;
 
-	for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
+	// a new frame is being prepared, the scene may have changed since the last one
+	sortedPointsAreValid.assign(sortedPointsAreValid.size(), false);
+	if (gradientCache != NULL && upPtCloud == this->viewHierarchy->levels[0]->depth) gradientCache->epoch++;
+
+	ITMTaskScheduler::GetDefault().ParallelFor(0, imgSize.y, [&](int y)
 	{
-		Vector3f inpt; int locId = x + y * imgSize.x;
+		for (int x = 0; x < imgSize.x; x++)
+		{
+			Vector3f inpt; int locId = x + y * imgSize.x;
 
-		inpt.z = depthMap[locId];
+			inpt.z = depthMap[locId];
 
-		if (inpt.z > 0.0f)
-		{
-			inpt.x = x * inpt.z; inpt.y = y * inpt.z;
-			unprojectPtWithIntrinsic(ooIntrinsics, inpt, camPoints[locId]);
+			if (inpt.z > 0.0f)
+			{
+				inpt.x = x * inpt.z; inpt.y = y * inpt.z;
+				unprojectPtWithIntrinsic(ooIntrinsics, inpt, camPoints[locId]);
+			}
+			else camPoints[locId] = Vector4f(0.0f, 0.0f, 0.0f, -1.0f);
 		}
-		else camPoints[locId] = Vector4f(0.0f, 0.0f, 0.0f, -1.0f);
-	}
+	});
 }
 
-template class ITMLib::Engine::ITMRenTracker_CPU<ITMVoxel, ITMVoxelIndex>;
+ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(ITMLib::Engine::ITMRenTracker_CPU)
@@ -4,6 +4,8 @@
 
 #include "../../ITMRenTracker.h"
 
+#include <vector>
+
 namespace ITMLib
 {
 	namespace Engine
@@ -11,6 +13,34 @@ namespace ITMLib
 		template<class TVoxel, class TIndex>
 		class ITMRenTracker_CPU : public ITMRenTracker<TVoxel,TIndex>
 		{
+		private:
+			/** Valid points of each hierarchy level, sorted by the voxel
+			    block they fall into under the pose of the first energy
+			    evaluation, in the order of the blocks in the voxel block
+			    array. Consecutive points then share hash lookups and
+			    cache lines, and chunks of the list touch few blocks.
+			*/
+			std::vector<std::vector<Vector4f> > sortedPoints;
+			std::vector<bool> sortedPointsAreValid;
+			std::vector<int> pointBuckets, bucketStarts;
+
+			void SortPointsByBlock(int levelId, const Matrix4f &invM);
+
+			/** Optional cache of the SDF gradient of every voxel in the
+			    blocks read by G_oneLevel, replacing the six extra voxel
+			    reads per point. A block is filled the first time a point
+			    falls into it and stays valid for the rest of the frame;
+			    the next frame may have been integrated, so it starts
+			    over. The gradients of all blocks are allocated up front,
+			    16 bytes per voxel of the voxel block array, so that
+			    freed and retired blocks do not hold memory of their own.
+			    Only used with ITMVoxelBlockHash.
+			*/
+			struct SDFGradientCache;
+			SDFGradientCache *gradientCache;
+
+			const Vector4f *GetBlockGradients(int blockId, const Vector3i &voxelPos) const;
+
 		protected:
 			void F_oneLevel(float *f, Matrix4f invM);
 			void G_oneLevel(float *gradient, float *hessian, Matrix4f invM) const;
@@ -20,7 +50,7 @@ namespace ITMLib
 		public:
 			
 			ITMRenTracker_CPU(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, const ITMLowLevelEngine *lowLevelEngine,
-				const ITMScene<TVoxel, TIndex> *scene);
+				const ITMScene<TVoxel, TIndex> *scene, bool useGradientCache = false);
 
 			~ITMRenTracker_CPU(void);
 		};
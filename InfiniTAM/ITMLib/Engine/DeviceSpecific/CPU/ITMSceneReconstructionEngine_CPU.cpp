@@ -2,6 +2,7 @@
 
 #include "ITMSceneReconstructionEngine_CPU.h"
 #include "../../DeviceAgnostic/ITMSceneReconstructionEngine.h"
+#include "../../ITMTaskScheduler.h"
 #include "../../../Objects/ITMRenderState_VH.h"
 
 using namespace ITMLib::Engine;
@@ -28,7 +29,26 @@ void ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::ResetScene(ITMS
 	int blockSize = scene->index.getVoxelBlockSize();
 
 	TVoxel *voxelBlocks_ptr = scene->localVBA.GetVoxelBlocks();
-	for (int i = 0; i < numBlocks * blockSize; ++i) voxelBlocks_ptr[i] = TVoxel();
+	ITMTaskScheduler &scheduler = ITMTaskScheduler::GetDefault();
+	if (scheduler.GetNumNodes() > 1)
+	{
+		// let the owning node touch each stripe first, so that its pages get placed there
+		int noNodes = scheduler.GetNumNodes();
+		int noBlocksPerStripe = scene->localVBA.noBlocksPerNUMAStripe;
+
+		ITMTaskScheduler::DiscardPages(voxelBlocks_ptr, (size_t)numBlocks * blockSize * sizeof(TVoxel));
+
+		ITMTaskScheduler::TaskGroup group;
+		for (int stripeBegin = 0; stripeBegin < numBlocks; stripeBegin += noBlocksPerStripe)
+		{
+			int stripeEnd = stripeBegin + noBlocksPerStripe < numBlocks ? stripeBegin + noBlocksPerStripe : numBlocks;
+			scheduler.SpawnOnNode(group, scene->localVBA.GetNUMANodeOfBlock(stripeBegin, noNodes), [=]() {
+				for (int i = stripeBegin * blockSize; i < stripeEnd * blockSize; ++i) voxelBlocks_ptr[i] = TVoxel();
+			});
+		}
+		scheduler.Wait(group);
+	}
+	else for (int i = 0; i < numBlocks * blockSize; ++i) voxelBlocks_ptr[i] = TVoxel();
 	int *vbaAllocationList_ptr = scene->localVBA.GetAllocationList();
 	for (int i = 0; i < numBlocks; ++i) vbaAllocationList_ptr[i] = i;
 	scene->localVBA.lastFreeBlockId = numBlocks - 1;
@@ -42,6 +62,44 @@ void ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::ResetScene(ITMS
 	for (int i = 0; i < SDF_EXCESS_LIST_SIZE; ++i) excessList_ptr[i] = i;
 
 	scene->index.SetLastFreeExcessListId(SDF_EXCESS_LIST_SIZE - 1);
+
+	scene->epochs.Reset();
+}
+
+template<class TVoxel>
+bool ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::CopySharedBlocks(ITMScene<TVoxel, ITMVoxelBlockHash> *scene,
+	const int *visibleEntryIds, int noVisibleEntries)
+{
+	if (scene->epochs.GetPublishedEntries() == NULL) return false;
+
+	ITMHashEntry *hashTable = scene->index.GetEntries();
+	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
+	int *allocationList = scene->localVBA.GetAllocationList();
+
+	entriesNotIntegrated.assign(noVisibleEntries, 0);
+
+	// pairs of source and destination block
+	std::vector<Vector2i> copies;
+	for (int entryId = 0; entryId < noVisibleEntries; entryId++)
+	{
+		int hashIdx = visibleEntryIds[entryId];
+		int ptr = hashTable[hashIdx].ptr;
+		if (ptr < 0 || !scene->epochs.IsShared(ptr)) continue;
+
+		if (scene->localVBA.lastFreeBlockId < 0) { entriesNotIntegrated[entryId] = 1; continue; }
+
+		int copyPtr = allocationList[scene->localVBA.lastFreeBlockId--];
+		copies.push_back(Vector2i(ptr, copyPtr));
+		hashTable[hashIdx].ptr = copyPtr;
+		scene->epochs.RetireBlock(ptr);
+	}
+
+	ITMTaskScheduler::GetDefault().ParallelFor(0, (int)copies.size(), [&](int i)
+	{
+		memcpy(&localVBA[copies[i].y * SDF_BLOCK_SIZE3], &localVBA[copies[i].x * SDF_BLOCK_SIZE3], SDF_BLOCK_SIZE3 * sizeof(TVoxel));
+	});
+
+	return true;
 }
 
 template<class TVoxel>
@@ -66,7 +124,13 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateIntoS
 	float mu = scene->sceneParams->mu; int maxW = scene->sceneParams->maxW;
 
 	float *depth = view->depth->GetData(MEMORYDEVICE_CPU);
+	float *depthUncertainty = (scene->sceneParams->useSensorNoiseWeighting && view->depthUncertainty != NULL) ?
+		view->depthUncertainty->GetData(MEMORYDEVICE_CPU) : NULL;
 	Vector4u *rgb = view->rgb->GetData(MEMORYDEVICE_CPU);
+	const ITMUChar4Image *rgbAligned = TVoxel::hasColorInformation ? view->GetRGBAlignedWithDepth() : NULL;
+	const Vector4u *rgb_d = (rgbAligned != NULL) ? rgbAligned->GetData(MEMORYDEVICE_CPU) : NULL;
+	const ITMUCharImage *rgbAlignedMask = (rgbAligned != NULL) ? view->GetRGBAlignedWithDepthMask() : NULL;
+	const uchar *rgbMask_d = (rgbAlignedMask != NULL) ? rgbAlignedMask->GetData(MEMORYDEVICE_CPU) : NULL;
 	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
 	ITMHashEntry *hashTable = scene->index.GetEntries();
 
@@ -76,15 +140,18 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateIntoS
 	bool stopIntegratingAtMaxW = scene->sceneParams->stopIntegratingAtMaxW;
 	//bool approximateIntegration = !trackingState->requiresFullRendering;
 
-#ifdef WITH_OPENMP
-	#pragma omp parallel for
-#endif
-	for (int entryId = 0; entryId < noVisibleEntries; entryId++)
+	// with swapping, blocks are written and freed outside of this function, so no snapshots are published
+	bool publishScene = scene->epochs.IsPublishing() && !scene->useSwapping;
+	const unsigned char *notIntegrated = NULL;
+	if (publishScene && CopySharedBlocks(scene, visibleEntryIds, noVisibleEntries)) notIntegrated = &entriesNotIntegrated[0];
+
+	auto integrateBlock = [&](int entryId)
 	{
 		Vector3i globalPos;
 		const ITMHashEntry &currentHashEntry = hashTable[visibleEntryIds[entryId]];
 
-		if (currentHashEntry.ptr < 0) continue;
+		if (currentHashEntry.ptr < 0) return;
+		if (notIntegrated != NULL && notIntegrated[entryId]) return;
 
 		globalPos.x = currentHashEntry.pos.x;
 		globalPos.y = currentHashEntry.pos.y;
@@ -108,9 +175,43 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateIntoS
 			pt_model.w = 1.0f;
 
 			ComputeUpdatedVoxelInfo<TVoxel::hasColorInformation,TVoxel>::compute(localVoxelBlock[locId], pt_model, M_d, 
-				projParams_d, M_rgb, projParams_rgb, mu, maxW, depth, depthImgSize, rgb, rgbImgSize);
+				projParams_d, M_rgb, projParams_rgb, mu, maxW, depth, depthUncertainty, depthImgSize, rgb, rgbImgSize, rgb_d, rgbMask_d);
+		}
+	};
+
+	ITMTaskScheduler &scheduler = ITMTaskScheduler::GetDefault();
+	if (scheduler.GetNumNodes() == 1) scheduler.ParallelFor(0, noVisibleEntries, integrateBlock);
+	else
+	{
+		// on NUMA systems each block is integrated by a worker of the node that holds its voxels
+		int noNodes = scheduler.GetNumNodes();
+		entriesOfNode.resize(noNodes);
+		for (int node = 0; node < noNodes; node++) entriesOfNode[node].clear();
+
+		for (int entryId = 0; entryId < noVisibleEntries; entryId++)
+		{
+			int ptr = hashTable[visibleEntryIds[entryId]].ptr;
+			if (ptr >= 0) entriesOfNode[scene->localVBA.GetNUMANodeOfBlock(ptr, noNodes)].push_back(entryId);
 		}
+
+		static const int noEntriesPerTask = 64;
+
+		ITMTaskScheduler::TaskGroup group;
+		for (int node = 0; node < noNodes; node++)
+		{
+			const std::vector<int> &entries = entriesOfNode[node];
+			for (int taskBegin = 0; taskBegin < (int)entries.size(); taskBegin += noEntriesPerTask)
+			{
+				int taskEnd = taskBegin + noEntriesPerTask < (int)entries.size() ? taskBegin + noEntriesPerTask : (int)entries.size();
+				scheduler.SpawnOnNode(group, node, [&integrateBlock, &entries, taskBegin, taskEnd]() {
+					for (int i = taskBegin; i < taskEnd; i++) integrateBlock(entries[i]);
+				});
+			}
+		}
+		scheduler.Wait(group);
 	}
+
+	if (publishScene) scene->epochs.Publish(hashTable, scene->index.noTotalEntries, scene->localVBA, SDF_BLOCK_SIZE3);
 }
 
 template<class TVoxel>
@@ -160,16 +261,49 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneF
 		entriesVisibleType[visibleEntryIDs[i]] = 3; // visible at previous frame and unstreamed
 
 	//build hashVisibility
-#ifdef WITH_OPENMP
-	#pragma omp parallel for
-#endif
-	for (int locId = 0; locId < depthImgSize.x*depthImgSize.y; locId++)
+	if ((int)allocationRequests.size() != depthImgSize.y) allocationRequests.resize(depthImgSize.y);
+
+	ITMTaskScheduler::GetDefault().ParallelFor(0, depthImgSize.y, [&](int y)
 	{
-		int y = locId / depthImgSize.x;
-		int x = locId - y * depthImgSize.x;
-		buildHashAllocAndVisibleTypePP(entriesAllocType, entriesVisibleType, x, y, blockCoords, depth, invM_d,
-			invProjParams_d, mu, depthImgSize, oneOverVoxelSize, hashTable, scene->sceneParams->viewFrustum_min,
-			scene->sceneParams->viewFrustum_max);
+		std::vector<AllocationRequest> &rowRequests = allocationRequests[y];
+		rowRequests.clear();
+
+		for (int x = 0; x < depthImgSize.x; x++)
+		{
+			Vector3f point, direction;
+			int noSteps = computeBlockRaySegment(point, direction, x, y, depth, invM_d, invProjParams_d, mu, depthImgSize,
+				oneOverVoxelSize, scene->sceneParams->viewFrustum_min, scene->sceneParams->viewFrustum_max);
+
+			for (int i = 0; i < noSteps; i++, point += direction)
+			{
+				Vector3s blockPos = TO_SHORT_FLOOR3(point);
+
+				bool isExcess;
+				int hashIdx = findHashEntryOrAllocationSlot(entriesVisibleType, hashTable, blockPos, isExcess);
+				if (hashIdx < 0) continue;
+
+				AllocationRequest request;
+				request.hashIdx = hashIdx;
+				request.blockCoords = Vector4s(blockPos.x, blockPos.y, blockPos.z, isExcess ? 2 : 1);
+				rowRequests.push_back(request);
+			}
+		}
+	});
+
+	// apply the requests in pixel order, the last one for each entry wins as in a serial pass
+	for (int y = 0; y < depthImgSize.y; y++)
+	{
+		const std::vector<AllocationRequest> &rowRequests = allocationRequests[y];
+		for (size_t i = 0; i < rowRequests.size(); i++)
+		{
+			int hashIdx = rowRequests[i].hashIdx;
+			Vector4s pt_block_all = rowRequests[i].blockCoords;
+
+			entriesAllocType[hashIdx] = (uchar)pt_block_all.w; // needs allocation
+			if (pt_block_all.w == 1) entriesVisibleType[hashIdx] = 1; // new entry is visible
+
+			blockCoords[hashIdx] = Vector4s(pt_block_all.x, pt_block_all.y, pt_block_all.z, 1);
+		}
 	}
 
 	if (onlyUpdateVisibleList) useSwapping = false;
@@ -336,7 +470,13 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::IntegrateInto
 	float mu = scene->sceneParams->mu; int maxW = scene->sceneParams->maxW;
 
 	float *depth = view->depth->GetData(MEMORYDEVICE_CPU);
+	float *depthUncertainty = (scene->sceneParams->useSensorNoiseWeighting && view->depthUncertainty != NULL) ?
+		view->depthUncertainty->GetData(MEMORYDEVICE_CPU) : NULL;
 	Vector4u *rgb = view->rgb->GetData(MEMORYDEVICE_CPU);
+	const ITMUChar4Image *rgbAligned = TVoxel::hasColorInformation ? view->GetRGBAlignedWithDepth() : NULL;
+	const Vector4u *rgb_d = (rgbAligned != NULL) ? rgbAligned->GetData(MEMORYDEVICE_CPU) : NULL;
+	const ITMUCharImage *rgbAlignedMask = (rgbAligned != NULL) ? view->GetRGBAlignedWithDepthMask() : NULL;
+	const uchar *rgbMask_d = (rgbAlignedMask != NULL) ? rgbAlignedMask->GetData(MEMORYDEVICE_CPU) : NULL;
 	TVoxel *voxelArray = scene->localVBA.GetVoxelBlocks();
 
 	const ITMPlainVoxelArray::IndexData *arrayInfo = scene->index.getIndexData();
@@ -344,10 +484,7 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::IntegrateInto
 	bool stopIntegratingAtMaxW = scene->sceneParams->stopIntegratingAtMaxW;
 	//bool approximateIntegration = !trackingState->requiresFullRendering;
 
-#ifdef WITH_OPENMP
-	#pragma omp parallel for
-#endif
-	for (int locId = 0; locId < scene->index.getVolumeSize().x*scene->index.getVolumeSize().y*scene->index.getVolumeSize().z; ++locId)
+	ITMTaskScheduler::GetDefault().ParallelFor(0, scene->index.getVolumeSize().x*scene->index.getVolumeSize().y*scene->index.getVolumeSize().z, [&](int locId)
 	{
 		int z = locId / (scene->index.getVolumeSize().x*scene->index.getVolumeSize().y);
 		int tmp = locId - z * scene->index.getVolumeSize().x*scene->index.getVolumeSize().y;
@@ -355,8 +492,8 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::IntegrateInto
 		int x = tmp - y * scene->index.getVolumeSize().x;
 		Vector4f pt_model;
 
-		if (stopIntegratingAtMaxW) if (voxelArray[locId].w_depth == maxW) continue;
-		//if (approximateIntegration) if (voxelArray[locId].w_depth != 0) continue;
+		if (stopIntegratingAtMaxW) if (voxelArray[locId].w_depth == maxW) return;
+		//if (approximateIntegration) if (voxelArray[locId].w_depth != 0) return;
 
 		pt_model.x = (float)(x + arrayInfo->offset.x) * voxelSize;
 		pt_model.y = (float)(y + arrayInfo->offset.y) * voxelSize;
@@ -364,8 +501,8 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::IntegrateInto
 		pt_model.w = 1.0f;
 
 		ComputeUpdatedVoxelInfo<TVoxel::hasColorInformation,TVoxel>::compute(voxelArray[locId], pt_model, M_d, projParams_d, M_rgb, projParams_rgb, mu, maxW, 
-			depth, depthImgSize, rgb, rgbImgSize);
-	}
+			depth, depthUncertainty, depthImgSize, rgb, rgbImgSize, rgb_d, rgbMask_d);
+	});
 }
 
-template class ITMLib::Engine::ITMSceneReconstructionEngine_CPU<ITMVoxel, ITMVoxelIndex>;
+ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(ITMLib::Engine::ITMSceneReconstructionEngine_CPU)
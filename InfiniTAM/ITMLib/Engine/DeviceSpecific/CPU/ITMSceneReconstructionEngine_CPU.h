@@ -4,6 +4,8 @@
 
 #include "../../ITMSceneReconstructionEngine.h"
 
+#include <vector>
+
 namespace ITMLib
 {
 	namespace Engine
@@ -19,6 +21,24 @@ namespace ITMLib
 			ORUtils::MemoryBlock<unsigned char> *entriesAllocType;
 			ORUtils::MemoryBlock<Vector4s> *blockCoords;
 
+			struct AllocationRequest { int hashIdx; Vector4s blockCoords; };
+
+			/** Hash entries requested for allocation by each row of the depth image. They are applied in row order after
+			    the parallel pass, so that colliding requests are resolved the same way for any number of threads.
+			*/
+			std::vector<std::vector<AllocationRequest> > allocationRequests;
+
+			/// Visible entries grouped by the NUMA node that holds their voxel block.
+			std::vector<std::vector<int> > entriesOfNode;
+
+			/// Visible entries whose shared block could not be copied for lack of free blocks, see CopySharedBlocks().
+			std::vector<unsigned char> entriesNotIntegrated;
+
+			/** Gives each visible entry that still references a block of the last published snapshot a private copy of
+			    the block, so that readers of the snapshot never see it change. Returns false if nothing is shared.
+			*/
+			bool CopySharedBlocks(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, const int *visibleEntryIds, int noVisibleEntries);
+
 		public:
 			void ResetScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene);
 
@@ -0,0 +1,160 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMSurfacePointExtractor_CPU.h"
+#include "../../DeviceAgnostic/ITMSurfacePointExtractor.h"
+#include "../../ITMTaskScheduler.h"
+
+#include <vector>
+
+using namespace ITMLib::Engine;
+
+namespace
+{
+	struct SurfacePoint
+	{
+		Vector4f point, normal, colour;
+	};
+
+	struct ExtractionParams
+	{
+		int minWeight;
+		bool useROI;
+		Vector3f roiMin, roiMax;
+		float voxelSize;
+	};
+}
+
+static bool isInsideROI(const Vector3f &point, const ExtractionParams &params)
+{
+	return (point.x >= params.roiMin.x) && (point.x <= params.roiMax.x) &&
+		(point.y >= params.roiMin.y) && (point.y <= params.roiMax.y) &&
+		(point.z >= params.roiMin.z) && (point.z <= params.roiMax.z);
+}
+
+template<class TVoxel, class TIndex>
+static void appendSurfacePoints(std::vector<SurfacePoint> &dest, const Vector3i &pos, const TVoxel *voxelData,
+	const typename TIndex::IndexData *voxelIndex, typename TIndex::IndexCache &cache, const ExtractionParams &params)
+{
+	Vector3f crossings[3]; int weights[3];
+	int noCrossings = findSurfaceCrossings<TVoxel, TIndex>(crossings, weights, pos, voxelData, voxelIndex, params.minWeight, cache);
+
+	for (int i = 0; i < noCrossings; i++)
+	{
+		Vector3f point = crossings[i] * params.voxelSize;
+		if (params.useROI && !isInsideROI(point, params)) continue;
+
+		SurfacePoint surfacePoint;
+		surfacePoint.point = Vector4f(point, (float)weights[i]);
+		surfacePoint.normal = Vector4f(computeSurfaceNormal<TVoxel, TIndex>(voxelData, voxelIndex, crossings[i]), 0.0f);
+		surfacePoint.colour = VoxelColorReader<TVoxel::hasColorInformation, TVoxel, TIndex>::interpolate(voxelData, voxelIndex, crossings[i], cache);
+
+		dest.push_back(surfacePoint);
+	}
+}
+
+/// Concatenates the points found by the chunks, in chunk order
+static void gatherSurfacePoints(ITMSurfacePoints *points, const std::vector<std::vector<SurfacePoint> > &chunkPoints, bool hasColours)
+{
+	std::vector<uint> offsets(chunkPoints.size() + 1, 0);
+	for (size_t chunkId = 0; chunkId < chunkPoints.size(); chunkId++)
+		offsets[chunkId + 1] = offsets[chunkId] + (uint)chunkPoints[chunkId].size();
+
+	uint noTotalPoints = offsets[chunkPoints.size()];
+	points->Reserve(noTotalPoints);
+
+	Vector4f *pointData = points->points->GetData(MEMORYDEVICE_CPU);
+	Vector4f *normalData = points->normals->GetData(MEMORYDEVICE_CPU);
+	Vector4f *colourData = points->colours->GetData(MEMORYDEVICE_CPU);
+
+	ITMTaskScheduler::GetDefault().ParallelFor(0, (int)chunkPoints.size(), [&](int chunkId)
+	{
+		const std::vector<SurfacePoint> &src = chunkPoints[chunkId];
+		for (size_t i = 0, pointId = offsets[chunkId]; i < src.size(); i++, pointId++)
+		{
+			pointData[pointId] = src[i].point;
+			normalData[pointId] = src[i].normal;
+			colourData[pointId] = src[i].colour;
+		}
+	});
+
+	points->noTotalPoints = noTotalPoints;
+	points->hasColours = hasColours;
+}
+
+template<class TVoxel>
+void ITMSurfacePointExtractor_CPU<TVoxel, ITMVoxelBlockHash>::ExtractPoints(ITMSurfacePoints *points, const ITMScene<TVoxel, ITMVoxelBlockHash> *scene)
+{
+	const TVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+	const ITMHashEntry *hashTable = scene->index.GetEntries();
+	int noTotalEntries = scene->index.noTotalEntries;
+
+	ExtractionParams params;
+	params.minWeight = this->minWeight;
+	params.useROI = this->useROI;
+	params.roiMin = this->roiMin; params.roiMax = this->roiMax;
+	params.voxelSize = scene->sceneParams->voxelSize;
+
+	// each chunk of hash entries collects its points in its own buffer
+	const int noEntriesPerChunk = 4096;
+	int noChunks = (noTotalEntries + noEntriesPerChunk - 1) / noEntriesPerChunk;
+	std::vector<std::vector<SurfacePoint> > chunkPoints(noChunks);
+
+	ITMTaskScheduler::GetDefault().ParallelFor(0, noChunks, [&](int chunkId)
+	{
+		std::vector<SurfacePoint> &dest = chunkPoints[chunkId];
+		ITMVoxelBlockHash::IndexCache cache;
+
+		int entryEnd = MIN((chunkId + 1) * noEntriesPerChunk, noTotalEntries);
+		for (int entryId = chunkId * noEntriesPerChunk; entryId < entryEnd; entryId++)
+		{
+			const ITMHashEntry &currentHashEntry = hashTable[entryId];
+			if (currentHashEntry.ptr < 0) continue;
+
+			Vector3i globalPos = currentHashEntry.pos.toInt() * SDF_BLOCK_SIZE;
+
+			if (params.useROI)
+			{
+				// the edges of a block reach one voxel into its neighbours
+				Vector3f blockMin = globalPos.toFloat() * params.voxelSize;
+				Vector3f blockMax = (globalPos + Vector3i(SDF_BLOCK_SIZE)).toFloat() * params.voxelSize;
+				if ((blockMax.x < params.roiMin.x) || (blockMin.x > params.roiMax.x) ||
+					(blockMax.y < params.roiMin.y) || (blockMin.y > params.roiMax.y) ||
+					(blockMax.z < params.roiMin.z) || (blockMin.z > params.roiMax.z)) continue;
+			}
+
+			for (int z = 0; z < SDF_BLOCK_SIZE; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+				appendSurfacePoints<TVoxel, ITMVoxelBlockHash>(dest, globalPos + Vector3i(x, y, z), voxelData, hashTable, cache, params);
+		}
+	}, 1);
+
+	gatherSurfacePoints(points, chunkPoints, TVoxel::hasColorInformation);
+}
+
+template<class TVoxel>
+void ITMSurfacePointExtractor_CPU<TVoxel, ITMPlainVoxelArray>::ExtractPoints(ITMSurfacePoints *points, const ITMScene<TVoxel, ITMPlainVoxelArray> *scene)
+{
+	const TVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+	const ITMPlainVoxelArray::IndexData *arrayInfo = scene->index.getIndexData();
+
+	ExtractionParams params;
+	params.minWeight = this->minWeight;
+	params.useROI = this->useROI;
+	params.roiMin = this->roiMin; params.roiMax = this->roiMax;
+	params.voxelSize = scene->sceneParams->voxelSize;
+
+	// one chunk per slice of the volume
+	std::vector<std::vector<SurfacePoint> > chunkPoints(arrayInfo->size.z);
+
+	ITMTaskScheduler::GetDefault().ParallelFor(0, arrayInfo->size.z, [&](int z)
+	{
+		std::vector<SurfacePoint> &dest = chunkPoints[z];
+		ITMPlainVoxelArray::IndexCache cache;
+
+		for (int y = 0; y < arrayInfo->size.y; y++) for (int x = 0; x < arrayInfo->size.x; x++)
+			appendSurfacePoints<TVoxel, ITMPlainVoxelArray>(dest, arrayInfo->offset + Vector3i(x, y, z), voxelData, arrayInfo, cache, params);
+	}, 1);
+
+	gatherSurfacePoints(points, chunkPoints, TVoxel::hasColorInformation);
+}
+
+ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(ITMLib::Engine::ITMSurfacePointExtractor_CPU)
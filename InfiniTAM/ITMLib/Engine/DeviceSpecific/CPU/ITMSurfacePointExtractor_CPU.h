@@ -0,0 +1,35 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "../../ITMSurfacePointExtractor.h"
+
+namespace ITMLib
+{
+	namespace Engine
+	{
+		template<class TVoxel, class TIndex>
+		class ITMSurfacePointExtractor_CPU : public ITMSurfacePointExtractor < TVoxel, TIndex >
+		{};
+
+		template<class TVoxel>
+		class ITMSurfacePointExtractor_CPU<TVoxel, ITMVoxelBlockHash> : public ITMSurfacePointExtractor < TVoxel, ITMVoxelBlockHash >
+		{
+		public:
+			void ExtractPoints(ITMSurfacePoints *points, const ITMScene<TVoxel, ITMVoxelBlockHash> *scene);
+
+			ITMSurfacePointExtractor_CPU(void) { }
+			~ITMSurfacePointExtractor_CPU(void) { }
+		};
+
+		template<class TVoxel>
+		class ITMSurfacePointExtractor_CPU<TVoxel, ITMPlainVoxelArray> : public ITMSurfacePointExtractor < TVoxel, ITMPlainVoxelArray >
+		{
+		public:
+			void ExtractPoints(ITMSurfacePoints *points, const ITMScene<TVoxel, ITMPlainVoxelArray> *scene);
+
+			ITMSurfacePointExtractor_CPU(void) { }
+			~ITMSurfacePointExtractor_CPU(void) { }
+		};
+	}
+}
@@ -128,6 +128,7 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMSce
 	
 	int noNeededEntries = 0;
 	int noAllocatedVoxelEntries = scene->localVBA.lastFreeBlockId;
+	int noVoxelBlocks = scene->index.getNumAllocatedVoxelBlocks();
 
 	for (int entryDestId = 0; entryDestId < noTotalEntries; entryDestId++)
 	{
@@ -148,7 +149,7 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMSce
 			swapStates[entryDestId].state = 0;
 
 			int vbaIdx = noAllocatedVoxelEntries;
-			if (vbaIdx < SDF_BUCKET_NUM - 1)
+			if (vbaIdx < noVoxelBlocks - 1)
 			{
 				noAllocatedVoxelEntries++;
 				voxelAllocationList[vbaIdx + 1] = localPtr;
@@ -175,4 +176,4 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMSce
 	}
 }
 
-template class ITMLib::Engine::ITMSwappingEngine_CPU<ITMVoxel, ITMVoxelIndex>;
+ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(ITMLib::Engine::ITMSwappingEngine_CPU)
@@ -3,12 +3,13 @@
 #include "ITMViewBuilder_CPU.h"
 
 #include "../../DeviceAgnostic/ITMViewBuilder.h"
+#include "../../ITMTaskScheduler.h"
 #include "../../../../ORUtils/MetalContext.h"
 
 using namespace ITMLib::Engine;
 using namespace ORUtils;
 
-ITMViewBuilder_CPU::ITMViewBuilder_CPU(const ITMRGBDCalib *calib):ITMViewBuilder(calib) { }
+ITMViewBuilder_CPU::ITMViewBuilder_CPU(const ITMRGBDCalib *calib, bool alignColourWithDepth):ITMViewBuilder(calib, alignColourWithDepth) { }
 ITMViewBuilder_CPU::~ITMViewBuilder_CPU(void) { }
 
 void ITMViewBuilder_CPU::UpdateView(ITMView **view_ptr, ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, bool useBilateralFilter, bool modelSensorNoise)
@@ -30,6 +31,7 @@ void ITMViewBuilder_CPU::UpdateView(ITMView **view_ptr, ITMUChar4Image *rgbImage
 
 	}
 	ITMView *view = *view_ptr;
+	view->frameNo++;
 
 	view->rgb->SetFrom(rgbImage, MemoryBlock<Vector4u>::CPU_TO_CPU);
 	this->shortImage->SetFrom(rawDepthImage, MemoryBlock<short>::CPU_TO_CPU);
@@ -61,6 +63,8 @@ void ITMViewBuilder_CPU::UpdateView(ITMView **view_ptr, ITMUChar4Image *rgbImage
 	{
 		this->ComputeNormalAndWeights(view->depthNormal, view->depthUncertainty, view->depth, view->calib->intrinsics_d.projectionParamsSimple.all);
 	}
+
+	UpdateRegisteredColour(view);
 }
 
 void ITMViewBuilder_CPU::UpdateView(ITMView **view_ptr, ITMUChar4Image *rgbImage, ITMFloatImage *depthImage)
@@ -69,9 +73,26 @@ void ITMViewBuilder_CPU::UpdateView(ITMView **view_ptr, ITMUChar4Image *rgbImage
 		*view_ptr = new ITMView(calib, rgbImage->noDims, depthImage->noDims, false);
 
 	ITMView *view = *view_ptr;
+	view->frameNo++;
 
 	view->rgb->UpdateDeviceFromHost();
 	view->depth->UpdateDeviceFromHost();
+
+	UpdateRegisteredColour(view);
+}
+
+void ITMViewBuilder_CPU::UpdateRegisteredColour(ITMView *view)
+{
+	if (!alignColourWithDepth || view->IsColourAlignedWithDepth()) return;
+
+	if (view->rgbRegistered == NULL)
+	{
+		view->rgbRegistered = new ITMUChar4Image(view->depth->noDims, true, false);
+		view->rgbRegisteredMask = new ITMUCharImage(view->depth->noDims, true, false);
+	}
+
+	this->RegisterColourToDepth(view->rgbRegistered, view->rgbRegisteredMask, view->rgb, view->depth, view->calib->trafo_rgb_to_depth.calib_inv,
+		view->calib->intrinsics_d.projectionParamsSimple.all, view->calib->intrinsics_rgb.projectionParamsSimple.all);
 }
 
 void ITMViewBuilder_CPU::UpdateView(ITMView **view_ptr, ITMUChar4Image *rgbImage, ITMShortImage *depthImage, bool useBilateralFilter, ITMIMUMeasurement *imuMeasurement)
@@ -101,8 +122,11 @@ void ITMViewBuilder_CPU::ConvertDisparityToDepth(ITMFloatImage *depth_out, const
 
 	float fx_depth = depthIntrinsics->projectionParamsSimple.fx;
 
-	for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
-		convertDisparityToDepth(d_out, x, y, d_in, disparityCalibParams, fx_depth, imgSize);
+	ITMTaskScheduler::GetDefault().ParallelFor(0, imgSize.y, [&](int y)
+	{
+		for (int x = 0; x < imgSize.x; x++)
+			convertDisparityToDepth(d_out, x, y, d_in, disparityCalibParams, fx_depth, imgSize);
+	});
 }
 
 void ITMViewBuilder_CPU::ConvertDepthAffineToFloat(ITMFloatImage *depth_out, const ITMShortImage *depth_in, const Vector2f depthCalibParams)
@@ -112,8 +136,11 @@ void ITMViewBuilder_CPU::ConvertDepthAffineToFloat(ITMFloatImage *depth_out, con
 	const short *d_in = depth_in->GetData(MEMORYDEVICE_CPU);
 	float *d_out = depth_out->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
-		convertDepthAffineToFloat(d_out, x, y, d_in, imgSize, depthCalibParams);
+	ITMTaskScheduler::GetDefault().ParallelFor(0, imgSize.y, [&](int y)
+	{
+		for (int x = 0; x < imgSize.x; x++)
+			convertDepthAffineToFloat(d_out, x, y, d_in, imgSize, depthCalibParams);
+	});
 }
 
 void ITMViewBuilder_CPU::DepthFiltering(ITMFloatImage *image_out, const ITMFloatImage *image_in)
@@ -125,8 +152,11 @@ void ITMViewBuilder_CPU::DepthFiltering(ITMFloatImage *image_out, const ITMFloat
 	float *imout = image_out->GetData(MEMORYDEVICE_CPU);
 	const float *imin = image_in->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 2; y < imgSize.y - 2; y++) for (int x = 2; x < imgSize.x - 2; x++)
-		filterDepth(imout, imin, x, y, imgSize);
+	ITMTaskScheduler::GetDefault().ParallelFor(2, imgSize.y - 2, [&](int y)
+	{
+		for (int x = 2; x < imgSize.x - 2; x++)
+			filterDepth(imout, imin, x, y, imgSize);
+	});
 }
 
 void ITMLib::Engine::ITMViewBuilder_CPU::ComputeNormalAndWeights(ITMFloat4Image *normal_out, ITMFloatImage *sigmaZ_out, const ITMFloatImage *depth_in, Vector4f intrinsic)
@@ -138,6 +168,26 @@ void ITMLib::Engine::ITMViewBuilder_CPU::ComputeNormalAndWeights(ITMFloat4Image
 	float *sigmaZData_out = sigmaZ_out->GetData(MEMORYDEVICE_CPU);
 	Vector4f *normalData_out = normal_out->GetData(MEMORYDEVICE_CPU);
 
-	for (int y = 2; y < imgDims.y - 2; y++) for (int x = 2; x < imgDims.x - 2; x++)
-		computeNormalAndWeight(depthData_in, normalData_out, sigmaZData_out, x, y, imgDims, intrinsic);
+	ITMTaskScheduler::GetDefault().ParallelFor(2, imgDims.y - 2, [&](int y)
+	{
+		for (int x = 2; x < imgDims.x - 2; x++)
+			computeNormalAndWeight(depthData_in, normalData_out, sigmaZData_out, x, y, imgDims, intrinsic);
+	});
+}
+
+void ITMViewBuilder_CPU::RegisterColourToDepth(ITMUChar4Image *rgb_out, ITMUCharImage *mask_out, const ITMUChar4Image *rgb_in, const ITMFloatImage *depth_in,
+	const Matrix4f & depthToRGB, Vector4f intrinsics_d, Vector4f intrinsics_rgb)
+{
+	Vector2i imgSize_d = depth_in->noDims, imgSize_rgb = rgb_in->noDims;
+
+	const float *depthData_in = depth_in->GetData(MEMORYDEVICE_CPU);
+	const Vector4u *rgbData_in = rgb_in->GetData(MEMORYDEVICE_CPU);
+	Vector4u *rgbData_out = rgb_out->GetData(MEMORYDEVICE_CPU);
+	uchar *maskData_out = mask_out->GetData(MEMORYDEVICE_CPU);
+
+	ITMTaskScheduler::GetDefault().ParallelFor(0, imgSize_d.y, [&](int y)
+	{
+		for (int x = 0; x < imgSize_d.x; x++)
+			registerColourToDepth(rgbData_out, maskData_out, rgbData_in, depthData_in, x, y, imgSize_d, imgSize_rgb, depthToRGB, intrinsics_d, intrinsics_rgb);
+	});
 }
@@ -4,8 +4,11 @@
 #include "../../DeviceAgnostic/ITMRepresentationAccess.h"
 #include "../../DeviceAgnostic/ITMVisualisationEngine.h"
 #include "../../DeviceAgnostic/ITMSceneReconstructionEngine.h"
+#include "../../ITMTaskScheduler.h"
 #include "../../../Objects/ITMRenderState_VH.h"
 
+#include <atomic>
+#include <string.h>
 #include <vector>
 
 using namespace ITMLib::Engine;
@@ -164,10 +167,7 @@ static void GenericRaycast(const ITMScene<TVoxel,TIndex> *scene, const Vector2i&
 	const TVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
 	const typename TIndex::IndexData *voxelIndex = scene->index.getIndexData();
 
-#ifdef WITH_OPENMP
-	#pragma omp parallel for
-#endif
-	for (int locId = 0; locId < imgSize.x*imgSize.y; ++locId)
+	ITMTaskScheduler::GetDefault().ParallelFor(0, imgSize.x*imgSize.y, [&](int locId)
 	{
 		int y = locId/imgSize.x;
 		int x = locId - y*imgSize.x;
@@ -184,7 +184,7 @@ static void GenericRaycast(const ITMScene<TVoxel,TIndex> *scene, const Vector2i&
 			mu,
 			minmaximg[locId2]
 		);
-	}
+	});
 }
 
 template<class TVoxel, class TIndex>
@@ -207,35 +207,26 @@ static void RenderImage_common(const ITMScene<TVoxel,TIndex> *scene, const ITMPo
 
 	switch (type) {
 	case IITMVisualisationEngine::RENDER_COLOUR_FROM_VOLUME:
-#ifdef WITH_OPENMP
-		#pragma omp parallel for
-#endif
-		for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
+		ITMTaskScheduler::GetDefault().ParallelFor(0, imgSize.x * imgSize.y, [&](int locId)
 		{
 			Vector4f ptRay = pointsRay[locId];
 			processPixelColour<TVoxel, TIndex>(outRendering[locId], ptRay.toVector3(), ptRay.w > 0, voxelData, voxelIndex, lightSource);
-		}
+		});
 		break;
 	case IITMVisualisationEngine::RENDER_COLOUR_FROM_NORMAL:
-#ifdef WITH_OPENMP
-		#pragma omp parallel for
-#endif
-		for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
+		ITMTaskScheduler::GetDefault().ParallelFor(0, imgSize.x * imgSize.y, [&](int locId)
 		{
 			Vector4f ptRay = pointsRay[locId];
 			processPixelNormal<TVoxel, TIndex>(outRendering[locId], ptRay.toVector3(), ptRay.w > 0, voxelData, voxelIndex, lightSource);
-		}
+		});
 		break;
 	case IITMVisualisationEngine::RENDER_SHADED_GREYSCALE:
 	default:
-#ifdef WITH_OPENMP
-		#pragma omp parallel for
-#endif
-		for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
+		ITMTaskScheduler::GetDefault().ParallelFor(0, imgSize.x * imgSize.y, [&](int locId)
 		{
 			Vector4f ptRay = pointsRay[locId];
 			processPixelGrey<TVoxel, TIndex>(outRendering[locId], ptRay.toVector3(), ptRay.w > 0, voxelData, voxelIndex, lightSource);
-		}
+		});
 	}
 }
 
@@ -279,11 +270,11 @@ static void CreateICPMaps_common(const ITMScene<TVoxel,TIndex> *scene, const ITM
 	Vector4f *pointsRay = renderState->raycastResult->GetData(MEMORYDEVICE_CPU);
 	float voxelSize = scene->sceneParams->voxelSize;
 
-#ifdef WITH_OPENMP
-	#pragma omp parallel for
-#endif
-	for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
-		processPixelICP<true>(outRendering, pointsMap, normalsMap, pointsRay, imgSize, x, y, voxelSize, lightSource);
+	ITMTaskScheduler::GetDefault().ParallelFor(0, imgSize.y, [&](int y)
+	{
+		for (int x = 0; x < imgSize.x; x++)
+			processPixelICP<true>(outRendering, pointsMap, normalsMap, pointsRay, imgSize, x, y, voxelSize, lightSource);
+	});
 }
 
 template<class TVoxel, class TIndex>
@@ -308,19 +299,41 @@ static void ForwardRender_common(const ITMScene<TVoxel, TIndex> *scene, const IT
 	const TVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
 	const typename TIndex::IndexData *voxelIndex = scene->index.getIndexData();
 
-	renderState->forwardProjection->Clear();
+	ITMTaskScheduler &scheduler = ITMTaskScheduler::GetDefault();
+	int noPixels = imgSize.x * imgSize.y;
+
+	// Splat the raycast points with a z-buffer, so that the nearest point
+	// wins regardless of the order the threads write in. The depth and the
+	// source pixel are packed into one word: positive floats compare like
+	// their bit patterns, and the source pixel breaks ties deterministically.
+	std::vector<std::atomic<unsigned long long> > zBuffer(noPixels);
+	const unsigned long long emptyEntry = ~0ull;
 
-	for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
+	scheduler.ParallelFor(0, noPixels, [&](int locId) { zBuffer[locId].store(emptyEntry, std::memory_order_relaxed); });
+
+	scheduler.ParallelFor(0, noPixels, [&](int locId)
 	{
-		int locId = x + y * imgSize.x;
 		Vector4f pixel = pointsRay[locId];
+		if (pixel.w <= 0) return;
 
-		int locId_new = forwardProjectPixel(pixel * voxelSize, M, projParams, imgSize);
-		if (locId_new >= 0) forwardProjection[locId_new] = pixel;
-	}
+		float depth;
+		int locId_new = forwardProjectPixel(pixel * voxelSize, M, projParams, imgSize, depth);
+		if (locId_new < 0 || !(depth > 0.0f)) return;
+
+		unsigned int depthBits;
+		memcpy(&depthBits, &depth, sizeof(depthBits));
+		unsigned long long entry = ((unsigned long long)depthBits << 32) | (unsigned int)locId;
+
+		std::atomic<unsigned long long> &target = zBuffer[locId_new];
+		unsigned long long current = target.load(std::memory_order_relaxed);
+		while (entry < current && !target.compare_exchange_weak(current, entry, std::memory_order_relaxed)) { }
+	});
+
+	// resolve the z-buffer and count the missing points of each row, then
+	// compact them in row order at the offsets of an exclusive scan
+	std::vector<int> rowOffsets(imgSize.y + 1, 0);
 
-	int noMissingPoints = 0;
-	for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
+	auto isMissingPoint = [&](int x, int y) -> bool
 	{
 		int locId = x + y * imgSize.x;
 		int locId2 = (int)floor((float)x / minmaximg_subsample) + (int)floor((float)y / minmaximg_subsample) * imgSize.x;
@@ -329,17 +342,39 @@ static void ForwardRender_common(const ITMScene<TVoxel, TIndex> *scene, const IT
 		Vector2f minmaxval = minmaximg[locId2];
 		float depth = currentDepth[locId];
 
-		if ((fwdPoint.w <= 0) && ((fwdPoint.x == 0 && fwdPoint.y == 0 && fwdPoint.z == 0) || (depth >= 0)) && (minmaxval.x < minmaxval.y))
-		//if ((fwdPoint.w <= 0) && (minmaxval.x < minmaxval.y))
+		return (fwdPoint.w <= 0) && ((fwdPoint.x == 0 && fwdPoint.y == 0 && fwdPoint.z == 0) || (depth >= 0)) && (minmaxval.x < minmaxval.y);
+	};
+
+	scheduler.ParallelFor(0, imgSize.y, [&](int y)
+	{
+		int noRowMissingPoints = 0;
+		for (int x = 0; x < imgSize.x; x++)
 		{
-			fwdProjMissingPoints[noMissingPoints] = locId;
-			noMissingPoints++;
+			int locId = x + y * imgSize.x;
+			unsigned long long entry = zBuffer[locId].load(std::memory_order_relaxed);
+			if (entry == emptyEntry) forwardProjection[locId] = Vector4f(0.0f);
+			else forwardProjection[locId] = pointsRay[(int)(entry & 0xffffffffull)];
+
+			if (isMissingPoint(x, y)) noRowMissingPoints++;
 		}
-	}
+		rowOffsets[y + 1] = noRowMissingPoints;
+	});
+
+	for (int y = 0; y < imgSize.y; y++) rowOffsets[y + 1] += rowOffsets[y];
+	int noMissingPoints = rowOffsets[imgSize.y];
+
+	scheduler.ParallelFor(0, imgSize.y, [&](int y)
+	{
+		int pointId = rowOffsets[y];
+		for (int x = 0; x < imgSize.x; x++)
+			if (isMissingPoint(x, y)) fwdProjMissingPoints[pointId++] = x + y * imgSize.x;
+	});
 
 	renderState->noFwdProjMissingPoints = noMissingPoints;
-    
-	for (int pointId = 0; pointId < noMissingPoints; pointId++)
+
+	// the missing points cluster in newly seen areas, so the rays are
+	// handed out in small chunks to keep the threads balanced
+	scheduler.ParallelFor(0, noMissingPoints, [&](int pointId)
 	{
 		int locId = fwdProjMissingPoints[pointId];
 		int y = locId / imgSize.x, x = locId - y*imgSize.x;
@@ -347,10 +382,13 @@ static void ForwardRender_common(const ITMScene<TVoxel, TIndex> *scene, const IT
 
 		castRay<TVoxel, TIndex>(forwardProjection[locId], x, y, voxelData, voxelIndex, invM, invProjParams,
 			1.0f / scene->sceneParams->voxelSize, scene->sceneParams->mu, minmaximg[locId2]);
-	}
+	}, 16);
 
-	for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
-		processPixelForwardRender<true>(outRendering, forwardProjection, imgSize, x, y, voxelSize, lightSource);
+	scheduler.ParallelFor(0, imgSize.y, [&](int y)
+	{
+		for (int x = 0; x < imgSize.x; x++)
+			processPixelForwardRender<true>(outRendering, forwardProjection, imgSize, x, y, voxelSize, lightSource);
+	});
 }
 
 template<class TVoxel, class TIndex>
@@ -426,39 +464,65 @@ static int RenderPointCloud(Vector4u *outRendering, Vector4f *locations, Vector4
 	const TVoxel *voxelData, const typename TIndex::IndexData *voxelIndex, bool skipPoints, float voxelSize, 
 	Vector2i imgSize, Vector3f lightSource)
 {
-	int noTotalPoints = 0;
+	ITMTaskScheduler &scheduler = ITMTaskScheduler::GetDefault();
 
-	for (int y = 0, locId = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++, locId++)
+	// first pass: shade the image and mark the pixels that become points
+	std::vector<unsigned char> isPoint(imgSize.x * imgSize.y);
+	std::vector<int> rowOffsets(imgSize.y + 1, 0);
+
+	scheduler.ParallelFor(0, imgSize.y, [&](int y)
 	{
-		Vector3f outNormal; float angle; 
-		Vector4f pointRay = ptsRay[locId];
-		Vector3f point = pointRay.toVector3();
-		bool foundPoint = pointRay.w > 0;
+		int noRowPoints = 0;
+		for (int x = 0, locId = y * imgSize.x; x < imgSize.x; x++, locId++)
+		{
+			Vector3f outNormal; float angle;
+			Vector4f pointRay = ptsRay[locId];
+			Vector3f point = pointRay.toVector3();
+			bool foundPoint = pointRay.w > 0;
 
-		computeNormalAndAngle<TVoxel, TIndex>(foundPoint, point, voxelData, voxelIndex, lightSource, outNormal, angle);
+			computeNormalAndAngle<TVoxel, TIndex>(foundPoint, point, voxelData, voxelIndex, lightSource, outNormal, angle);
 
-		if (foundPoint) drawPixelGrey(outRendering[locId], angle);
-		else outRendering[locId] = Vector4u((uchar)0);
+			if (foundPoint) drawPixelGrey(outRendering[locId], angle);
+			else outRendering[locId] = Vector4u((uchar)0);
 
-		if (skipPoints && ((x % 2 == 0) || (y % 2 == 0))) foundPoint = false;
+			if (skipPoints && ((x % 2 == 0) || (y % 2 == 0))) foundPoint = false;
 
-		if (foundPoint)
+			isPoint[locId] = foundPoint;
+			if (foundPoint) noRowPoints++;
+		}
+		rowOffsets[y + 1] = noRowPoints;
+	});
+
+	for (int y = 0; y < imgSize.y; y++) rowOffsets[y + 1] += rowOffsets[y];
+
+	// second pass: each row writes its points from its offset on, so the
+	// points keep the order of the serial scan
+	scheduler.ParallelFor(0, imgSize.y, [&](int y)
+	{
+		typename TIndex::IndexCache cache;
+		int pointId = rowOffsets[y];
+
+		for (int x = 0, locId = y * imgSize.x; x < imgSize.x; x++, locId++)
 		{
+			if (!isPoint[locId]) continue;
+
+			Vector3f point = ptsRay[locId].toVector3();
+
 			Vector4f tmp;
-			tmp = VoxelColorReader<TVoxel::hasColorInformation, TVoxel, TIndex>::interpolate(voxelData, voxelIndex, point);
+			tmp = VoxelColorReader<TVoxel::hasColorInformation, TVoxel, TIndex>::interpolate(voxelData, voxelIndex, point, cache);
 			if (tmp.w > 0.0f) { tmp.x /= tmp.w; tmp.y /= tmp.w; tmp.z /= tmp.w; tmp.w = 1.0f; }
-			colours[noTotalPoints] = tmp;
+			colours[pointId] = tmp;
 
 			Vector4f pt_ray_out;
 			pt_ray_out.x = point.x * voxelSize; pt_ray_out.y = point.y * voxelSize;
 			pt_ray_out.z = point.z * voxelSize; pt_ray_out.w = 1.0f;
-			locations[noTotalPoints] = pt_ray_out;
+			locations[pointId] = pt_ray_out;
 
-			noTotalPoints++;
+			pointId++;
 		}
-	}
+	});
 
-	return noTotalPoints;
+	return rowOffsets[imgSize.y];
 }
 
-template class ITMLib::Engine::ITMVisualisationEngine_CPU<ITMVoxel, ITMVoxelIndex>;
+ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(ITMLib::Engine::ITMVisualisationEngine_CPU)
@@ -2,14 +2,28 @@
 
 #include "ITMWeightedICPTracker_CPU.h"
 #include "../../DeviceAgnostic/ITMWeightedICPTracker.h"
+#include "../../ITMTaskScheduler.h"
 
 using namespace ITMLib::Engine;
 
+struct ITMWeightedICPTracker_CPU::AccuCell {
+	int numPoints;
+	float f;
+	float g[6];
+	float h[6+5+4+3+2+1];
+};
+
 ITMWeightedICPTracker_CPU::ITMWeightedICPTracker_CPU(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, int noICPRunTillLevel,
 	float distThresh, float terminationThreshold, const ITMLowLevelEngine *lowLevelEngine) :ITMWeightedICPTracker(imgSize, trackingRegime, noHierarchyLevels,
-	noICPRunTillLevel, distThresh, terminationThreshold, lowLevelEngine, MEMORYDEVICE_CPU) { }
+	noICPRunTillLevel, distThresh, terminationThreshold, lowLevelEngine, MEMORYDEVICE_CPU)
+{
+	rowAccu = new AccuCell[imgSize.y];
+}
 
-ITMWeightedICPTracker_CPU::~ITMWeightedICPTracker_CPU(void) { }
+ITMWeightedICPTracker_CPU::~ITMWeightedICPTracker_CPU(void)
+{
+	delete[] rowAccu;
+}
 
 int ITMWeightedICPTracker_CPU::ComputeGandH(float &f, float *nabla, float *hessian, Matrix4f approxInvPose)
 {
@@ -33,47 +47,65 @@ int ITMWeightedICPTracker_CPU::ComputeGandH(float &f, float *nabla, float *hessi
 	float sumHessian[6 * 6], sumNabla[6], sumF; int noValidPoints;
 	int noPara = shortIteration ? 3 : 6, noParaSQ = shortIteration ? 3 + 2 + 1 : 6 + 5 + 4 + 3 + 2 + 1;
 
-	noValidPoints = 0; sumF = 0.0f;
-	memset(sumHessian, 0, sizeof(float) * noParaSQ);
-	memset(sumNabla, 0, sizeof(float) * noPara);
-
-
-	for (int y = 0; y < viewImageSize.y; y++) for (int x = 0; x < viewImageSize.x; x++)
+	ITMTaskScheduler::GetDefault().ParallelFor(0, viewImageSize.y, [&](int y)
 	{
-		float localWeight = weight[x + y*viewImageSize.x] > 0 ? minSigmaZ / weight[x + y*viewImageSize.x] * 0.5f + 0.5f : 0.0f;
+		AccuCell &accu = rowAccu[y];
 
-		float localHessian[6 + 5 + 4 + 3 + 2 + 1], localNabla[6], localF = 0;
+		accu.numPoints = 0; accu.f = 0.0f;
+		for (int i = 0; i < noPara; i++) accu.g[i] = 0.0f;
+		for (int i = 0; i < noParaSQ; i++) accu.h[i] = 0.0f;
 
-		for (int i = 0; i < noPara; i++) localNabla[i] = 0.0f;
-		for (int i = 0; i < noParaSQ; i++) localHessian[i] = 0.0f;
-
-		bool isValidPoint;
-        
-		switch (iterationType)
+		for (int x = 0; x < viewImageSize.x; x++)
 		{
-		case TRACKER_ITERATION_ROTATION:
-			isValidPoint = computePerPointGH_wICP<true, true>(localNabla, localHessian, localF, localWeight, x, y, depth[x + y * viewImageSize.x], viewImageSize,
-				viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
-			break;
-		case TRACKER_ITERATION_TRANSLATION:
-			isValidPoint = computePerPointGH_wICP<true, false>(localNabla, localHessian, localF, localWeight, x, y, depth[x + y * viewImageSize.x], viewImageSize,
-				viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
-			break;
-		case TRACKER_ITERATION_BOTH:
-			isValidPoint = computePerPointGH_wICP<false, false>(localNabla, localHessian, localF, localWeight, x, y, depth[x + y * viewImageSize.x], viewImageSize,
-				viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
-			break;
-		default:
-			isValidPoint = false;
-			break;
+			float localWeight = weight[x + y*viewImageSize.x] > 0 ? minSigmaZ / weight[x + y*viewImageSize.x] * 0.5f + 0.5f : 0.0f;
+
+			float localHessian[6 + 5 + 4 + 3 + 2 + 1], localNabla[6], localF = 0;
+
+			for (int i = 0; i < noPara; i++) localNabla[i] = 0.0f;
+			for (int i = 0; i < noParaSQ; i++) localHessian[i] = 0.0f;
+
+			bool isValidPoint;
+
+			switch (iterationType)
+			{
+			case TRACKER_ITERATION_ROTATION:
+				isValidPoint = computePerPointGH_wICP<true, true>(localNabla, localHessian, localF, localWeight, x, y, depth[x + y * viewImageSize.x], viewImageSize,
+					viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
+				break;
+			case TRACKER_ITERATION_TRANSLATION:
+				isValidPoint = computePerPointGH_wICP<true, false>(localNabla, localHessian, localF, localWeight, x, y, depth[x + y * viewImageSize.x], viewImageSize,
+					viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
+				break;
+			case TRACKER_ITERATION_BOTH:
+				isValidPoint = computePerPointGH_wICP<false, false>(localNabla, localHessian, localF, localWeight, x, y, depth[x + y * viewImageSize.x], viewImageSize,
+					viewIntrinsics, sceneImageSize, sceneIntrinsics, approxInvPose, scenePose, pointsMap, normalsMap, distThresh[levelId]);
+				break;
+			default:
+				isValidPoint = false;
+				break;
+			}
+
+			if (isValidPoint)
+			{
+				accu.numPoints++; accu.f += localF;
+				for (int i = 0; i < noPara; i++) accu.g[i] += localNabla[i];
+				for (int i = 0; i < noParaSQ; i++) accu.h[i] += localHessian[i];
+			}
 		}
+	});
 
-		if (isValidPoint)
-		{
-			noValidPoints++; sumF += localF;
-			for (int i = 0; i < noPara; i++) sumNabla[i] += localNabla[i];
-			for (int i = 0; i < noParaSQ; i++) sumHessian[i] += localHessian[i];
-		}
+	// reduce the rows in a fixed order
+	noValidPoints = 0; sumF = 0.0f;
+	memset(sumHessian, 0, sizeof(float) * noParaSQ);
+	memset(sumNabla, 0, sizeof(float) * noPara);
+
+	for (int y = 0; y < viewImageSize.y; y++)
+	{
+		const AccuCell &accu = rowAccu[y];
+
+		noValidPoints += accu.numPoints; sumF += accu.f;
+		for (int i = 0; i < noPara; i++) sumNabla[i] += accu.g[i];
+		for (int i = 0; i < noParaSQ; i++) sumHessian[i] += accu.h[i];
 	}
 
 	for (int r = 0, counter = 0; r < noPara; r++) for (int c = 0; c <= r; c++, counter++) hessian[r + c * 6] = sumHessian[counter];
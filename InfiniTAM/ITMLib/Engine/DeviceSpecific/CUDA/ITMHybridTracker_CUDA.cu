@@ -0,0 +1,253 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMHybridTracker_CUDA.h"
+#include "ITMCUDAUtils.h"
+#include "../../DeviceAgnostic/ITMHybridTracker.h"
+#include "../../../../ORUtils/CUDADefines.h"
+
+using namespace ITMLib::Engine;
+
+struct ITMHybridTracker_CUDA::AccuCell {
+	int numPoints;
+	float f;
+	float g[6];
+	float h[6+5+4+3+2+1];
+};
+
+struct ITMHybridTracker_KernelParameters {
+	ITMHybridTracker_CUDA::AccuCell *accu;
+	float *depth;
+	Matrix4f approxInvPose;
+	Vector4f *pointsMap;
+	Vector4f *normalsMap;
+	Vector4f sceneIntrinsics;
+	Vector2i sceneImageSize;
+	Matrix4f scenePose;
+	Vector4f viewIntrinsics;
+	Vector2i viewImageSize;
+	float distThresh;
+	float icpWeight;
+	Matrix4f depthToRGB;
+	Vector4f rgbIntrinsics;
+	Vector2i rgbImageSize;
+	Vector4u *rgb;
+	Vector2i refImageSize;
+	Matrix4f refPose;
+	Vector4u *refRGB;
+	Vector4s *refGradX, *refGradY;
+	float photometricWeight;
+};
+
+template<bool shortIteration, bool rotationOnly>
+__global__ void hybridTrackerOneLevel_g_rt_device(ITMHybridTracker_KernelParameters para);
+
+// host methods
+
+ITMHybridTracker_CUDA::ITMHybridTracker_CUDA(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, float distThresh,
+	float terminationThreshold, float icpWeight, float photometricWeight, const ITMLowLevelEngine *lowLevelEngine)
+	:ITMHybridTracker(imgSize, trackingRegime, noHierarchyLevels, distThresh, terminationThreshold, icpWeight, photometricWeight,
+	lowLevelEngine, MEMORYDEVICE_CUDA)
+{
+	ITMSafeCall(cudaMallocHost((void**)&accu_host, sizeof(AccuCell)));
+	ITMSafeCall(cudaMalloc((void**)&accu_device, sizeof(AccuCell)));
+}
+
+ITMHybridTracker_CUDA::~ITMHybridTracker_CUDA(void)
+{
+	ITMSafeCall(cudaFreeHost(accu_host));
+	ITMSafeCall(cudaFree(accu_device));
+}
+
+int ITMHybridTracker_CUDA::ComputeGandH(float &f, float *nabla, float *hessian, Matrix4f approxInvPose)
+{
+	Vector2i viewImageSize = viewHierarchyLevel->depth->noDims;
+
+	if (iterationType == TRACKER_ITERATION_NONE) return 0;
+
+	bool shortIteration = (iterationType == TRACKER_ITERATION_ROTATION) || (iterationType == TRACKER_ITERATION_TRANSLATION);
+
+	int noPara = shortIteration ? 3 : 6;
+
+	dim3 blockSize(16, 16);
+	dim3 gridSize((int)ceil((float)viewImageSize.x / (float)blockSize.x), (int)ceil((float)viewImageSize.y / (float)blockSize.y));
+
+	ITMSafeCall(cudaMemset(accu_device, 0, sizeof(AccuCell)));
+
+	struct ITMHybridTracker_KernelParameters args;
+	args.accu = accu_device;
+	args.depth = viewHierarchyLevel->depth->GetData(MEMORYDEVICE_CUDA);
+	args.approxInvPose = approxInvPose;
+	args.pointsMap = sceneHierarchyLevel->pointsMap->GetData(MEMORYDEVICE_CUDA);
+	args.normalsMap = sceneHierarchyLevel->normalsMap->GetData(MEMORYDEVICE_CUDA);
+	args.sceneIntrinsics = sceneHierarchyLevel->intrinsics;
+	args.sceneImageSize = sceneHierarchyLevel->pointsMap->noDims;
+	args.scenePose = scenePose;
+	args.viewIntrinsics = viewHierarchyLevel->intrinsics;
+	args.viewImageSize = viewImageSize;
+	args.distThresh = distThresh[levelId];
+	args.icpWeight = icpWeight;
+	args.depthToRGB = depthToRGB;
+	args.rgbIntrinsics = rgbIntrinsics;
+	args.rgbImageSize = viewHierarchyLevel->rgb->noDims;
+	args.rgb = viewHierarchyLevel->rgb->GetData(MEMORYDEVICE_CUDA);
+	args.refPose = referencePose;
+
+	// without a reference frame only the ICP term is evaluated
+	if (referenceHierarchyLevel != NULL)
+	{
+		args.refImageSize = referenceHierarchyLevel->rgb->noDims;
+		args.refRGB = referenceHierarchyLevel->rgb->GetData(MEMORYDEVICE_CUDA);
+		args.refGradX = referenceHierarchyLevel->gradientX_rgb->GetData(MEMORYDEVICE_CUDA);
+		args.refGradY = referenceHierarchyLevel->gradientY_rgb->GetData(MEMORYDEVICE_CUDA);
+		args.photometricWeight = photometricWeight;
+	}
+	else
+	{
+		args.refImageSize = Vector2i(0, 0);
+		args.refRGB = NULL; args.refGradX = NULL; args.refGradY = NULL;
+		args.photometricWeight = 0.0f;
+	}
+
+	switch (iterationType)
+	{
+	case TRACKER_ITERATION_ROTATION:
+		hybridTrackerOneLevel_g_rt_device<true, true> << <gridSize, blockSize >> >(args);
+		break;
+	case TRACKER_ITERATION_TRANSLATION:
+		hybridTrackerOneLevel_g_rt_device<true, false> << <gridSize, blockSize >> >(args);
+		break;
+	case TRACKER_ITERATION_BOTH:
+		hybridTrackerOneLevel_g_rt_device<false, false> << <gridSize, blockSize >> >(args);
+		break;
+	default: break;
+	}
+
+	ITMSafeCall(cudaMemcpy(accu_host, accu_device, sizeof(AccuCell), cudaMemcpyDeviceToHost));
+
+	for (int r = 0, counter = 0; r < noPara; r++) for (int c = 0; c <= r; c++, counter++) hessian[r + c * 6] = accu_host->h[counter];
+	for (int r = 0; r < noPara; ++r) for (int c = r + 1; c < noPara; c++) hessian[r + c * 6] = hessian[c + r * 6];
+
+	memcpy(nabla, accu_host->g, noPara * sizeof(float));
+	f = (accu_host->numPoints > 100) ? sqrt(accu_host->f) / accu_host->numPoints : 1e5f;
+
+	return accu_host->numPoints;
+}
+
+// device functions
+
+__device__ void hybridTrackerReduce3(float *dim_shared1, float *dim_shared2, float *dim_shared3, int locId_local,
+	float v1, float v2, float v3, float *out1, float *out2, float *out3)
+{
+	dim_shared1[locId_local] = v1;
+	dim_shared2[locId_local] = v2;
+	dim_shared3[locId_local] = v3;
+	__syncthreads();
+
+	if (locId_local < 128) {
+		dim_shared1[locId_local] += dim_shared1[locId_local + 128];
+		dim_shared2[locId_local] += dim_shared2[locId_local + 128];
+		dim_shared3[locId_local] += dim_shared3[locId_local + 128];
+	}
+	__syncthreads();
+	if (locId_local < 64) {
+		dim_shared1[locId_local] += dim_shared1[locId_local + 64];
+		dim_shared2[locId_local] += dim_shared2[locId_local + 64];
+		dim_shared3[locId_local] += dim_shared3[locId_local + 64];
+	}
+	__syncthreads();
+
+	if (locId_local < 32) {
+		warpReduce(dim_shared1, locId_local);
+		warpReduce(dim_shared2, locId_local);
+		warpReduce(dim_shared3, locId_local);
+	}
+	__syncthreads();
+
+	if (locId_local == 0) {
+		atomicAdd(out1, dim_shared1[0]);
+		atomicAdd(out2, dim_shared2[0]);
+		atomicAdd(out3, dim_shared3[0]);
+	}
+	__syncthreads();
+}
+
+template<bool shortIteration, bool rotationOnly>
+__global__ void hybridTrackerOneLevel_g_rt_device(ITMHybridTracker_KernelParameters para)
+{
+	int x = threadIdx.x + blockIdx.x * blockDim.x, y = threadIdx.y + blockIdx.y * blockDim.y;
+
+	int locId_local = threadIdx.x + threadIdx.y * blockDim.x;
+
+	__shared__ float dim_shared1[256];
+	__shared__ float dim_shared2[256];
+	__shared__ float dim_shared3[256];
+	__shared__ bool should_prefix;
+
+	should_prefix = false;
+	__syncthreads();
+
+	const int noPara = shortIteration ? 3 : 6;
+	const int noParaSQ = shortIteration ? 3 + 2 + 1 : 6 + 5 + 4 + 3 + 2 + 1;
+	float localNabla[noPara], localHessian[noParaSQ], localF = 0.0f;
+	bool isValidPoint = false;
+
+	if (x < para.viewImageSize.x && y < para.viewImageSize.y)
+	{
+		isValidPoint = computePerPointGH_Hybrid<shortIteration, rotationOnly>(localNabla, localHessian, localF, x, y,
+			para.depth[x + y * para.viewImageSize.x], para.viewImageSize, para.viewIntrinsics, para.sceneImageSize, para.sceneIntrinsics,
+			para.approxInvPose, para.scenePose, para.pointsMap, para.normalsMap, para.distThresh, para.icpWeight, para.depthToRGB,
+			para.rgbIntrinsics, para.rgbImageSize, para.rgb, para.refImageSize, para.refPose, para.refRGB, para.refGradX, para.refGradY,
+			para.photometricWeight);
+		if (isValidPoint) should_prefix = true;
+	}
+
+	if (!isValidPoint) {
+		for (int i = 0; i < noPara; i++) localNabla[i] = 0.0f;
+		for (int i = 0; i < noParaSQ; i++) localHessian[i] = 0.0f;
+		localF = 0.0f;
+	}
+
+	__syncthreads();
+
+	if (!should_prefix) return;
+
+	{ //reduction for noValidPoints
+		dim_shared1[locId_local] = isValidPoint;
+		__syncthreads();
+
+		if (locId_local < 128) dim_shared1[locId_local] += dim_shared1[locId_local + 128];
+		__syncthreads();
+		if (locId_local < 64) dim_shared1[locId_local] += dim_shared1[locId_local + 64];
+		__syncthreads();
+
+		if (locId_local < 32) warpReduce(dim_shared1, locId_local);
+
+		if (locId_local == 0) atomicAdd(&(para.accu->numPoints), (int)dim_shared1[locId_local]);
+	}
+
+	{ //reduction for energy function value
+		dim_shared1[locId_local] = localF;
+		__syncthreads();
+
+		if (locId_local < 128) dim_shared1[locId_local] += dim_shared1[locId_local + 128];
+		__syncthreads();
+		if (locId_local < 64) dim_shared1[locId_local] += dim_shared1[locId_local + 64];
+		__syncthreads();
+
+		if (locId_local < 32) warpReduce(dim_shared1, locId_local);
+
+		if (locId_local == 0) atomicAdd(&(para.accu->f), dim_shared1[locId_local]);
+	}
+
+	__syncthreads();
+
+	//reduction for nabla
+	for (unsigned char paraId = 0; paraId < noPara; paraId += 3)
+		hybridTrackerReduce3(dim_shared1, dim_shared2, dim_shared3, locId_local, localNabla[paraId + 0], localNabla[paraId + 1], localNabla[paraId + 2],
+			&(para.accu->g[paraId + 0]), &(para.accu->g[paraId + 1]), &(para.accu->g[paraId + 2]));
+
+	//reduction for hessian
+	for (unsigned char paraId = 0; paraId < noParaSQ; paraId += 3)
+		hybridTrackerReduce3(dim_shared1, dim_shared2, dim_shared3, locId_local, localHessian[paraId + 0], localHessian[paraId + 1], localHessian[paraId + 2],
+			&(para.accu->h[paraId + 0]), &(para.accu->h[paraId + 1]), &(para.accu->h[paraId + 2]));
+}
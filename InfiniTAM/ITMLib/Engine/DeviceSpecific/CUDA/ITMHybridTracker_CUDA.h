@@ -0,0 +1,29 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "../../ITMHybridTracker.h"
+
+namespace ITMLib
+{
+	namespace Engine
+	{
+		class ITMHybridTracker_CUDA : public ITMHybridTracker
+		{
+		public:
+			struct AccuCell;
+
+		private:
+			AccuCell *accu_host;
+			AccuCell *accu_device;
+
+		protected:
+			int ComputeGandH(float &f, float *nabla, float *hessian, Matrix4f approxInvPose);
+
+		public:
+			ITMHybridTracker_CUDA(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, float distThresh,
+				float terminationThreshold, float icpWeight, float photometricWeight, const ITMLowLevelEngine *lowLevelEngine);
+			~ITMHybridTracker_CUDA(void);
+		};
+	}
+}
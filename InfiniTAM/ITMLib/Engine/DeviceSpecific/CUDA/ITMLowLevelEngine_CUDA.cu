@@ -14,6 +14,8 @@ __global__ void filterSubsample_device(Vector4u *imageData_out, Vector2i newDims
 
 __global__ void filterSubsampleWithHoles_device(float *imageData_out, Vector2i newDims, const float *imageData_in, Vector2i oldDims);
 __global__ void filterSubsampleWithHoles_device(Vector4f *imageData_out, Vector2i newDims, const Vector4f *imageData_in, Vector2i oldDims);
+__global__ void filterSubsampleWithHoles_device(float *depthData_out, float *uncertaintyData_out, Vector2i newDims, const float *depthData_in,
+	const float *uncertaintyData_in, Vector2i oldDims);
 
 __global__ void gradientX_device(Vector4s *grad, const Vector4u *image, Vector2i imgSize);
 __global__ void gradientY_device(Vector4s *grad, const Vector4u *image, Vector2i imgSize);
@@ -92,6 +94,26 @@ void ITMLowLevelEngine_CUDA::FilterSubsampleWithHoles(ITMFloat4Image *image_out,
 	filterSubsampleWithHoles_device << <gridSize, blockSize >> >(imageData_out, newDims, imageData_in, oldDims);
 }
 
+void ITMLowLevelEngine_CUDA::FilterSubsampleWithHoles(ITMFloatImage *depth_out, ITMFloatImage *uncertainty_out, const ITMFloatImage *depth_in,
+	const ITMFloatImage *uncertainty_in) const
+{
+	Vector2i oldDims = depth_in->noDims;
+	Vector2i newDims; newDims.x = depth_in->noDims.x / 2; newDims.y = depth_in->noDims.y / 2;
+
+	depth_out->ChangeDims(newDims);
+	uncertainty_out->ChangeDims(newDims);
+
+	const float *depthData_in = depth_in->GetData(MEMORYDEVICE_CUDA);
+	const float *uncertaintyData_in = uncertainty_in->GetData(MEMORYDEVICE_CUDA);
+	float *depthData_out = depth_out->GetData(MEMORYDEVICE_CUDA);
+	float *uncertaintyData_out = uncertainty_out->GetData(MEMORYDEVICE_CUDA);
+
+	dim3 blockSize(16, 16);
+	dim3 gridSize((int)ceil((float)newDims.x / (float)blockSize.x), (int)ceil((float)newDims.y / (float)blockSize.y));
+
+	filterSubsampleWithHoles_device << <gridSize, blockSize >> >(depthData_out, uncertaintyData_out, newDims, depthData_in, uncertaintyData_in, oldDims);
+}
+
 void ITMLowLevelEngine_CUDA::GradientX(ITMShort4Image *grad_out, const ITMUChar4Image *image_in) const
 {
 	grad_out->ChangeDims(image_in->noDims);
@@ -153,6 +175,16 @@ __global__ void filterSubsampleWithHoles_device(Vector4f *imageData_out, Vector2
 	filterSubsampleWithHoles(imageData_out, x, y, newDims, imageData_in, oldDims);
 }
 
+__global__ void filterSubsampleWithHoles_device(float *depthData_out, float *uncertaintyData_out, Vector2i newDims, const float *depthData_in,
+	const float *uncertaintyData_in, Vector2i oldDims)
+{
+	int x = threadIdx.x + blockIdx.x * blockDim.x, y = threadIdx.y + blockIdx.y * blockDim.y;
+
+	if (x > newDims.x - 1 || y > newDims.y - 1) return;
+
+	filterSubsampleWithHoles(depthData_out, uncertaintyData_out, x, y, newDims, depthData_in, uncertaintyData_in, oldDims);
+}
+
 __global__ void gradientX_device(Vector4s *grad, const Vector4u *image, Vector2i imgSize)
 {
 	int x = threadIdx.x + blockIdx.x * blockDim.x, y = threadIdx.y + blockIdx.y * blockDim.y;
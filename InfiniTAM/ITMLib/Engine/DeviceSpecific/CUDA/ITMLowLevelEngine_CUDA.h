@@ -18,6 +18,8 @@ namespace ITMLib
 			void FilterSubsample(ITMUChar4Image *image_out, const ITMUChar4Image *image_in) const;
 			void FilterSubsampleWithHoles(ITMFloatImage *image_out, const ITMFloatImage *image_in) const;
 			void FilterSubsampleWithHoles(ITMFloat4Image *image_out, const ITMFloat4Image *image_in) const;
+			void FilterSubsampleWithHoles(ITMFloatImage *depth_out, ITMFloatImage *uncertainty_out, const ITMFloatImage *depth_in,
+				const ITMFloatImage *uncertainty_in) const;
 
 			void GradientX(ITMShort4Image *grad_out, const ITMUChar4Image *image_in) const;
 			void GradientY(ITMShort4Image *grad_out, const ITMUChar4Image *image_in) const;
@@ -110,4 +110,4 @@ __global__ void meshScene_device(ITMMesh::Triangle *triangles, unsigned int *noT
 	}
 }
 
-template class ITMLib::Engine::ITMMeshingEngine_CUDA<ITMVoxel, ITMVoxelIndex>;
+ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(ITMLib::Engine::ITMMeshingEngine_CUDA)
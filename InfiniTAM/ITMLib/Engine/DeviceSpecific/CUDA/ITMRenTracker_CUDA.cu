@@ -277,4 +277,4 @@ __global__ void renTrackerOneLevel_g_device(float *g_device, float *h_device, Ve
 	//}
 }
 
-template class ITMLib::Engine::ITMRenTracker_CUDA<ITMVoxel, ITMVoxelIndex>;
+ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(ITMLib::Engine::ITMRenTracker_CUDA)
@@ -9,7 +9,7 @@
 using namespace ITMLib::Engine;
 using namespace ORUtils;
 
-ITMViewBuilder_CUDA::ITMViewBuilder_CUDA(const ITMRGBDCalib *calib):ITMViewBuilder(calib) { }
+ITMViewBuilder_CUDA::ITMViewBuilder_CUDA(const ITMRGBDCalib *calib, bool alignColourWithDepth):ITMViewBuilder(calib, alignColourWithDepth) { }
 ITMViewBuilder_CUDA::~ITMViewBuilder_CUDA(void) { }
 
 //---------------------------------------------------------------------------
@@ -23,6 +23,8 @@ __global__ void convertDisparityToDepth_device(float *depth_out, const short *de
 __global__ void convertDepthAffineToFloat_device(float *d_out, const short *d_in, Vector2i imgSize, Vector2f depthCalibParams);
 __global__ void filterDepth_device(float *imageData_out, const float *imageData_in, Vector2i imgDims);
 __global__ void ComputeNormalAndWeight_device(const float* depth_in, Vector4f* normal_out, float *sigmaL_out, Vector2i imgDims, Vector4f intrinsic);
+__global__ void registerColourToDepth_device(Vector4u *rgb_out, uchar *mask_out, const Vector4u *rgb_in, const float *depth_in, Vector2i imgSize_d, Vector2i imgSize_rgb,
+	Matrix4f depthToRGB, Vector4f intrinsics_d, Vector4f intrinsics_rgb);
 
 //---------------------------------------------------------------------------
 //
@@ -48,6 +50,7 @@ void ITMViewBuilder_CUDA::UpdateView(ITMView **view_ptr, ITMUChar4Image *rgbImag
 	}
 
 	ITMView *view = *view_ptr;
+	view->frameNo++;
 
 	view->rgb->SetFrom(rgbImage, MemoryBlock<Vector4u>::CPU_TO_CUDA);
 	this->shortImage->SetFrom(rawDepthImage, MemoryBlock<short>::CPU_TO_CUDA);
@@ -79,6 +82,8 @@ void ITMViewBuilder_CUDA::UpdateView(ITMView **view_ptr, ITMUChar4Image *rgbImag
 	{
 		this->ComputeNormalAndWeights(view->depthNormal, view->depthUncertainty, view->depth, view->calib->intrinsics_d.projectionParamsSimple.all);
 	}
+
+	UpdateRegisteredColour(view);
 }
 
 void ITMViewBuilder_CUDA::UpdateView(ITMView **view_ptr, ITMUChar4Image *rgbImage, ITMFloatImage *depthImage)
@@ -87,9 +92,26 @@ void ITMViewBuilder_CUDA::UpdateView(ITMView **view_ptr, ITMUChar4Image *rgbImag
 		*view_ptr = new ITMView(calib, rgbImage->noDims, depthImage->noDims, true);
 
 	ITMView *view = *view_ptr;
+	view->frameNo++;
 
 	view->rgb->UpdateDeviceFromHost();
 	view->depth->UpdateDeviceFromHost();
+
+	UpdateRegisteredColour(view);
+}
+
+void ITMViewBuilder_CUDA::UpdateRegisteredColour(ITMView *view)
+{
+	if (!alignColourWithDepth || view->IsColourAlignedWithDepth()) return;
+
+	if (view->rgbRegistered == NULL)
+	{
+		view->rgbRegistered = new ITMUChar4Image(view->depth->noDims, true, true);
+		view->rgbRegisteredMask = new ITMUCharImage(view->depth->noDims, true, true);
+	}
+
+	this->RegisterColourToDepth(view->rgbRegistered, view->rgbRegisteredMask, view->rgb, view->depth, view->calib->trafo_rgb_to_depth.calib_inv,
+		view->calib->intrinsics_d.projectionParamsSimple.all, view->calib->intrinsics_rgb.projectionParamsSimple.all);
 }
 
 void ITMViewBuilder_CUDA::UpdateView(ITMView **view_ptr, ITMUChar4Image *rgbImage, ITMShortImage *depthImage, bool useBilateralFilter, ITMIMUMeasurement *imuMeasurement)
@@ -167,6 +189,23 @@ void ITMLib::Engine::ITMViewBuilder_CUDA::ComputeNormalAndWeights(ITMFloat4Image
 
 }
 
+void ITMViewBuilder_CUDA::RegisterColourToDepth(ITMUChar4Image *rgb_out, ITMUCharImage *mask_out, const ITMUChar4Image *rgb_in, const ITMFloatImage *depth_in,
+	const Matrix4f & depthToRGB, Vector4f intrinsics_d, Vector4f intrinsics_rgb)
+{
+	Vector2i imgSize_d = depth_in->noDims, imgSize_rgb = rgb_in->noDims;
+
+	const float *depthData_in = depth_in->GetData(MEMORYDEVICE_CUDA);
+	const Vector4u *rgbData_in = rgb_in->GetData(MEMORYDEVICE_CUDA);
+	Vector4u *rgbData_out = rgb_out->GetData(MEMORYDEVICE_CUDA);
+	uchar *maskData_out = mask_out->GetData(MEMORYDEVICE_CUDA);
+
+	dim3 blockSize(16, 16);
+	dim3 gridSize((int)ceil((float)imgSize_d.x / (float)blockSize.x), (int)ceil((float)imgSize_d.y / (float)blockSize.y));
+
+	registerColourToDepth_device << <gridSize, blockSize >> >(rgbData_out, maskData_out, rgbData_in, depthData_in, imgSize_d, imgSize_rgb, depthToRGB,
+		intrinsics_d, intrinsics_rgb);
+}
+
 //---------------------------------------------------------------------------
 //
 // kernel function implementation
@@ -218,3 +257,13 @@ __global__ void ComputeNormalAndWeight_device(const float* depth_in, Vector4f* n
 		computeNormalAndWeight(depth_in, normal_out, sigmaZ_out, x, y, imgDims, intrinsic);
 	}
 }
+
+__global__ void registerColourToDepth_device(Vector4u *rgb_out, uchar *mask_out, const Vector4u *rgb_in, const float *depth_in, Vector2i imgSize_d, Vector2i imgSize_rgb,
+	Matrix4f depthToRGB, Vector4f intrinsics_d, Vector4f intrinsics_rgb)
+{
+	int x = threadIdx.x + blockIdx.x * blockDim.x, y = threadIdx.y + blockIdx.y * blockDim.y;
+
+	if ((x >= imgSize_d.x) || (y >= imgSize_d.y)) return;
+
+	registerColourToDepth(rgb_out, mask_out, rgb_in, depth_in, x, y, imgSize_d, imgSize_rgb, depthToRGB, intrinsics_d, intrinsics_rgb);
+}
@@ -10,6 +10,10 @@ namespace ITMLib
 	{
 		class ITMViewBuilder_CUDA : public ITMViewBuilder
 		{
+		private:
+			/// Registers the colour of the new frame to its depth, if the view builder aligns them
+			void UpdateRegisteredColour(ITMView *view);
+
 		public:
 			void ConvertDisparityToDepth(ITMFloatImage *depth_out, const ITMShortImage *depth_in, const ITMIntrinsics *depthIntrinsics, 
 				Vector2f disparityCalibParams);
@@ -17,13 +21,15 @@ namespace ITMLib
 
 			void DepthFiltering(ITMFloatImage *image_out, const ITMFloatImage *image_in);
 			void ComputeNormalAndWeights(ITMFloat4Image *normal_out, ITMFloatImage *sigmaZ_out, const ITMFloatImage *depth_in, Vector4f intrinsic);
+			void RegisterColourToDepth(ITMUChar4Image *rgb_out, ITMUCharImage *mask_out, const ITMUChar4Image *rgb_in, const ITMFloatImage *depth_in,
+				const Matrix4f & depthToRGB, Vector4f intrinsics_d, Vector4f intrinsics_rgb);
 
 			void UpdateView(ITMView **view, ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, bool useBilateralFilter, bool modelSensorNoise = false);
 			void UpdateView(ITMView **view, ITMUChar4Image *rgbImage, ITMFloatImage *depthImage);
 
 			void UpdateView(ITMView **view, ITMUChar4Image *rgbImage, ITMShortImage *depthImage, bool useBilateralFilter, ITMIMUMeasurement *imuMeasurement);
 
-			ITMViewBuilder_CUDA(const ITMRGBDCalib *calib);
+			ITMViewBuilder_CUDA(const ITMRGBDCalib *calib, bool alignColourWithDepth);
 			~ITMViewBuilder_CUDA(void);
 		};
 	}
@@ -298,6 +298,6 @@ void ITMSceneReconstructionEngine_Metal<TVoxel, ITMVoxelBlockHash>::AllocateScen
     scene->index.SetLastFreeExcessListId(lastFreeExcessListId);
 }
 
-template class ITMLib::Engine::ITMSceneReconstructionEngine_Metal<ITMVoxel, ITMVoxelIndex>;
+ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(ITMLib::Engine::ITMSceneReconstructionEngine_Metal)
 
 #endif
\ No newline at end of file
@@ -293,6 +293,6 @@ void ITMVisualisationEngine_Metal<TVoxel,ITMVoxelBlockHash>::CreateExpectedDepth
     }
 }
 
-template class ITMLib::Engine::ITMVisualisationEngine_Metal<ITMVoxel, ITMVoxelIndex>;
+ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(ITMLib::Engine::ITMVisualisationEngine_Metal)
 
 #endif
\ No newline at end of file
@@ -0,0 +1,291 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMBasicEngine.h"
+
+#include <chrono>
+
+using namespace ITMLib::Engine;
+
+template<class TVoxel, class TIndex>
+ITMBasicEngine<TVoxel, TIndex>::ITMBasicEngine(const ITMLibSettings *settings, const ITMRGBDCalib *calib, Vector2i imgSize_rgb, Vector2i imgSize_d)
+	: ITMMainEngine(settings)
+{
+	// create all the things required for marching cubes and mesh extraction
+	// - uses additional memory (lots!)
+	static const bool createMeshingEngine = true;
+
+	if ((imgSize_d.x == -1) || (imgSize_d.y == -1)) imgSize_d = imgSize_rgb;
+
+	if (settings->noVoxelBlocks <= 0 || settings->noVoxelBlocks > SDF_LOCAL_BLOCK_NUM)
+		DIEWITHEXCEPTION("The number of voxel blocks has to be between 1 and SDF_LOCAL_BLOCK_NUM");
+
+	// an engine made by an ITMEngineHost keeps to the pool of the host, the others share the process wide one
+	scheduler = ITMTaskScheduler::GetBound();
+	if (scheduler == NULL) ITMTaskScheduler::ConfigureDefault(settings->noCPUThreads, settings->firstCPUCore, settings->useNUMAPlacement);
+
+	this->scene = new ITMScene<TVoxel, TIndex>(&(settings->sceneParams), settings->useSwapping, 
+		settings->deviceType == ITMLibSettings::DEVICE_CUDA ? MEMORYDEVICE_CUDA : MEMORYDEVICE_CPU, settings->noVoxelBlocks);
+
+	meshingEngine = NULL;
+	switch (settings->deviceType)
+	{
+	case ITMLibSettings::DEVICE_CPU:
+		lowLevelEngine = new ITMLowLevelEngine_CPU();
+		viewBuilder = new ITMViewBuilder_CPU(calib, TVoxel::hasColorInformation);
+		visualisationEngine = new ITMVisualisationEngine_CPU<TVoxel, TIndex>(scene);
+		if (createMeshingEngine) meshingEngine = new ITMMeshingEngine_CPU<TVoxel, TIndex>();
+		break;
+	case ITMLibSettings::DEVICE_CUDA:
+#ifndef COMPILE_WITHOUT_CUDA
+		lowLevelEngine = new ITMLowLevelEngine_CUDA();
+		viewBuilder = new ITMViewBuilder_CUDA(calib, TVoxel::hasColorInformation);
+		visualisationEngine = new ITMVisualisationEngine_CUDA<TVoxel, TIndex>(scene);
+		if (createMeshingEngine) meshingEngine = new ITMMeshingEngine_CUDA<TVoxel, TIndex>();
+#endif
+		break;
+	case ITMLibSettings::DEVICE_METAL:
+#ifdef COMPILE_WITH_METAL
+		lowLevelEngine = new ITMLowLevelEngine_Metal();
+		viewBuilder = new ITMViewBuilder_Metal(calib, TVoxel::hasColorInformation);
+		visualisationEngine = new ITMVisualisationEngine_Metal<TVoxel, TIndex>(scene);
+		if (createMeshingEngine) meshingEngine = new ITMMeshingEngine_CPU<TVoxel, TIndex>();
+#endif
+		break;
+	}
+
+	mesh = NULL;
+	if (createMeshingEngine) mesh = new ITMMesh(settings->deviceType == ITMLibSettings::DEVICE_CUDA ? MEMORYDEVICE_CUDA : MEMORYDEVICE_CPU, settings->noVoxelBlocks);
+
+	Vector2i trackedImageSize = ITMTrackingController::GetTrackedImageSize(settings, imgSize_rgb, imgSize_d);
+
+	renderState_live = visualisationEngine->CreateRenderState(trackedImageSize);
+	renderState_freeview = NULL; //will be created by the visualisation engine
+
+	denseMapper = new ITMDenseMapper<TVoxel, TIndex>(settings);
+	denseMapper->ResetScene(scene);
+
+	imuCalibrator = new ITMIMUCalibrator_iPad();
+	tracker = ITMTrackerFactory<TVoxel, TIndex>().Make(trackedImageSize, settings, lowLevelEngine, imuCalibrator, scene);
+	trackingController = new ITMTrackingController(tracker, visualisationEngine, lowLevelEngine, settings);
+
+	trackingState = trackingController->BuildTrackingState(trackedImageSize);
+	tracker->UpdateInitialPose(trackingState);
+
+	view = NULL; // will be allocated by the view builder
+
+	mapServer = NULL;
+	tilePager = NULL;
+
+	fusionActive = true;
+	mainProcessingActive = true;
+}
+
+template<class TVoxel, class TIndex>
+ITMBasicEngine<TVoxel, TIndex>::~ITMBasicEngine()
+{
+	delete renderState_live;
+	if (renderState_freeview!=NULL) delete renderState_freeview;
+
+	if (tilePager != NULL) delete tilePager;
+	if (mapServer != NULL) delete mapServer;
+	delete scene;
+
+	delete denseMapper;
+	delete trackingController;
+
+	delete tracker;
+	delete imuCalibrator;
+
+	delete lowLevelEngine;
+	delete viewBuilder;
+
+	delete trackingState;
+	if (view != NULL) delete view;
+
+	delete visualisationEngine;
+
+	if (meshingEngine != NULL) delete meshingEngine;
+
+	if (mesh != NULL) delete mesh;
+}
+
+template<class TVoxel, class TIndex>
+ITMMesh* ITMBasicEngine<TVoxel, TIndex>::UpdateMesh(void)
+{
+	ITMTaskScheduler::Binding binding(scheduler);
+	if (mesh != NULL) meshingEngine->MeshScene(mesh, scene);
+	return mesh;
+}
+
+template<class TVoxel, class TIndex>
+void ITMBasicEngine<TVoxel, TIndex>::SaveSceneToMesh(const char *objFileName)
+{
+	if (mesh == NULL) return;
+	ITMTaskScheduler::Binding binding(scheduler);
+	meshingEngine->MeshScene(mesh, scene);
+	mesh->WriteSTL(objFileName);
+}
+
+template<class TVoxel, class TIndex>
+void ITMBasicEngine<TVoxel, TIndex>::SaveSceneToDirectory(const char *directory)
+{
+	scene->SaveToDirectory(directory);
+}
+
+template<class TVoxel, class TIndex>
+bool ITMBasicEngine<TVoxel, TIndex>::StartMapServer(const char *name)
+{
+	if (mapServer != NULL || settings->deviceType != ITMLibSettings::DEVICE_CPU) return false;
+
+	mapServer = new ITMMapServer<TVoxel, TIndex>(name, scene);
+	if (!mapServer->IsRunning()) { delete mapServer; mapServer = NULL; return false; }
+
+	return true;
+}
+
+template<class TVoxel, class TIndex>
+bool ITMBasicEngine<TVoxel, TIndex>::StartTilePager(const char *directory, float radius)
+{
+	if (tilePager != NULL || settings->deviceType != ITMLibSettings::DEVICE_CPU || settings->useSwapping) return false;
+
+	ITMTaskScheduler::Binding binding(scheduler);
+	tilePager = new ITMTilePager<TVoxel, TIndex>(directory, scene, radius);
+	if (!tilePager->IsRunning()) { delete tilePager; tilePager = NULL; return false; }
+
+	// the tiles around the first pose are in the scene before the first frame is tracked
+	tilePager->Update(trackingState->pose_d, true);
+
+	return true;
+}
+
+template<class TVoxel, class TIndex>
+void ITMBasicEngine<TVoxel, TIndex>::ProcessFrame(ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement)
+{
+	ITMTaskScheduler::Binding binding(scheduler);
+
+	// prepare image and turn it into a depth image
+	if (imuMeasurement==NULL) viewBuilder->UpdateView(&view, rgbImage, rawDepthImage, settings->useBilateralFilter,settings->modelSensorNoise);
+	else viewBuilder->UpdateView(&view, rgbImage, rawDepthImage, settings->useBilateralFilter, imuMeasurement);
+
+	if (!mainProcessingActive) return;
+
+	// tracking
+	std::chrono::steady_clock::time_point trackingStart = std::chrono::steady_clock::now();
+	trackingController->Track(trackingState, view);
+	lastTrackingTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - trackingStart).count();
+
+	// fusion
+	if (fusionActive)
+	{
+		if (mapServer != NULL) mapServer->BeginUpdate();
+		if (tilePager != NULL) tilePager->Update(trackingState->pose_d);
+		denseMapper->ProcessFrame(view, trackingState, scene, renderState_live);
+		if (mapServer != NULL) mapServer->EndUpdate();
+	}
+
+	// raycast to renderState_live for tracking and free visualisation
+	trackingController->Prepare(trackingState, view, renderState_live);
+}
+
+template<class TVoxel, class TIndex>
+void ITMBasicEngine<TVoxel, TIndex>::ResetAll(void)
+{
+	if (settings->useSwapping || tilePager != NULL)
+		DIEWITHEXCEPTION("The scene cannot be reset with swapping or while the tile pager is running");
+
+	ITMTaskScheduler::Binding binding(scheduler);
+
+	if (mapServer != NULL) mapServer->BeginUpdate();
+	denseMapper->ResetScene(scene);
+	if (mapServer != NULL) mapServer->EndUpdate();
+
+	trackingState->Reset();
+	tracker->UpdateInitialPose(trackingState);
+	tracker->Reset();
+}
+
+template<class TVoxel, class TIndex>
+Vector2i ITMBasicEngine<TVoxel, TIndex>::GetImageSize(void) const
+{
+	return renderState_live->raycastImage->noDims;
+}
+
+template<class TVoxel, class TIndex>
+void ITMBasicEngine<TVoxel, TIndex>::GetImage(ITMUChar4Image *out, GetImageType getImageType, ITMPose *pose, ITMIntrinsics *intrinsics)
+{
+	if (view == NULL) return;
+
+	ITMTaskScheduler::Binding binding(scheduler);
+
+	out->Clear();
+
+	switch (getImageType)
+	{
+	case ITMMainEngine::InfiniTAM_IMAGE_ORIGINAL_RGB:
+		out->ChangeDims(view->rgb->noDims);
+		if (settings->deviceType == ITMLibSettings::DEVICE_CUDA) 
+			out->SetFrom(view->rgb, ORUtils::MemoryBlock<Vector4u>::CUDA_TO_CPU);
+		else out->SetFrom(view->rgb, ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU);
+		break;
+	case ITMMainEngine::InfiniTAM_IMAGE_ORIGINAL_DEPTH:
+		out->ChangeDims(view->depth->noDims);
+		if (settings->trackerType==ITMLib::Objects::ITMLibSettings::TRACKER_WICP)
+		{
+			if (settings->deviceType == ITMLibSettings::DEVICE_CUDA) view->depthUncertainty->UpdateHostFromDevice();
+			ITMVisualisationEngine<TVoxel, TIndex>::WeightToUchar4(out, view->depthUncertainty);
+		}
+		else
+		{
+			if (settings->deviceType == ITMLibSettings::DEVICE_CUDA) view->depth->UpdateHostFromDevice();
+			ITMVisualisationEngine<TVoxel, TIndex>::DepthToUchar4(out, view->depth);
+		}
+
+		break;
+	case ITMMainEngine::InfiniTAM_IMAGE_SCENERAYCAST:
+	{
+		ORUtils::Image<Vector4u> *srcImage = renderState_live->raycastImage;
+		out->ChangeDims(srcImage->noDims);
+		if (settings->deviceType == ITMLibSettings::DEVICE_CUDA)
+			out->SetFrom(srcImage, ORUtils::MemoryBlock<Vector4u>::CUDA_TO_CPU);
+		else out->SetFrom(srcImage, ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU);	
+		break;
+	}
+	case ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_SHADED:
+	case ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_VOLUME:
+	case ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_NORMAL:
+	{
+		IITMVisualisationEngine::RenderImageType type = IITMVisualisationEngine::RENDER_SHADED_GREYSCALE;
+		if (getImageType == ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_VOLUME) type = IITMVisualisationEngine::RENDER_COLOUR_FROM_VOLUME;
+		else if (getImageType == ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_NORMAL) type = IITMVisualisationEngine::RENDER_COLOUR_FROM_NORMAL;
+		if (renderState_freeview == NULL) renderState_freeview = visualisationEngine->CreateRenderState(out->noDims);
+
+		visualisationEngine->FindVisibleBlocks(pose, intrinsics, renderState_freeview);
+		visualisationEngine->CreateExpectedDepths(pose, intrinsics, renderState_freeview);
+		visualisationEngine->RenderImage(pose, intrinsics, renderState_freeview, renderState_freeview->raycastImage, type);
+
+		if (settings->deviceType == ITMLibSettings::DEVICE_CUDA)
+			out->SetFrom(renderState_freeview->raycastImage, ORUtils::MemoryBlock<Vector4u>::CUDA_TO_CPU);
+		else out->SetFrom(renderState_freeview->raycastImage, ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU);
+		break;
+	}
+	case ITMMainEngine::InfiniTAM_IMAGE_UNKNOWN:
+		break;
+	};
+}
+
+template<class TVoxel, class TIndex>
+size_t ITMBasicEngine<TVoxel, TIndex>::GetMemorySize(const ITMLibSettings *settings)
+{
+	return TIndex::GetMemorySize(settings->noVoxelBlocks, sizeof(TVoxel)) + (size_t)settings->noVoxelBlocks * 32 * sizeof(ITMMesh::Triangle);
+}
+
+template<class TVoxel, class TIndex>
+void ITMBasicEngine<TVoxel, TIndex>::turnOnIntegration() { fusionActive = true; }
+template<class TVoxel, class TIndex>
+void ITMBasicEngine<TVoxel, TIndex>::turnOffIntegration() { fusionActive = false; }
+template<class TVoxel, class TIndex>
+void ITMBasicEngine<TVoxel, TIndex>::turnOnMainProcessing() { mainProcessingActive = true; }
+template<class TVoxel, class TIndex>
+void ITMBasicEngine<TVoxel, TIndex>::turnOffMainProcessing() { mainProcessingActive = false; }
+
+ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(ITMLib::Engine::ITMBasicEngine)
@@ -0,0 +1,93 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "ITMMainEngine.h"
+
+namespace ITMLib
+{
+  namespace Engine
+  {
+    /** \brief
+        The main engine for one voxel and index type of the scene,
+        which is compiled for all pairs of ITMLIB_FOR_EACH_VOXEL_INDEX
+        and made by ITMMainEngine::Make().
+    */
+    template<class TVoxel, class TIndex>
+    class ITMBasicEngine : public ITMMainEngine
+    {
+    private:
+      bool fusionActive, mainProcessingActive;
+
+      ITMLowLevelEngine *lowLevelEngine;
+      IITMVisualisationEngine *visualisationEngine;
+
+      ITMMeshingEngine<TVoxel, TIndex> *meshingEngine;
+      ITMMesh *mesh;
+
+      ITMViewBuilder *viewBuilder;
+      ITMDenseMapper<TVoxel, TIndex> *denseMapper;
+      ITMTrackingController *trackingController;
+
+      ITMTracker *tracker;
+      ITMIMUCalibrator *imuCalibrator;
+
+      ITMView *view;
+      ITMTrackingState *trackingState;
+
+      ITMScene<TVoxel, TIndex> *scene;
+      ITMRenderState *renderState_live;
+      ITMRenderState *renderState_freeview;
+
+      ITMMapServer<TVoxel, TIndex> *mapServer;
+      ITMTilePager<TVoxel, TIndex> *tilePager;
+
+      /// Pool bound to the thread that made the engine, NULL to use the
+      /// process wide one
+      ITMTaskScheduler *scheduler;
+    public:
+      /// Gives access to the meshing engine, is needed to get a full mesh.
+      ITMMeshingEngine<TVoxel, TIndex> * GetMeshingEngine(void) { return meshingEngine; }
+
+      /// Gives access to the internal world representation
+      ITMScene<TVoxel, TIndex>* GetScene(void) { return scene; }
+
+      /// Gives access to the tile pager, NULL unless StartTilePager() succeeded
+      ITMTilePager<TVoxel, TIndex>* GetTilePager(void) { return tilePager; }
+
+      ITMView* GetView() { return view; }
+      ITMTrackingState* GetTrackingState(void) { return trackingState; }
+
+      void ProcessFrame(ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement = NULL);
+
+      ITMMesh* GetMesh(void) { return mesh; }
+      ITMMesh* UpdateMesh(void);
+      void SaveSceneToMesh(const char *objFileName);
+      void SaveSceneToDirectory(const char *directory);
+
+      bool StartMapServer(const char *name);
+      bool StartTilePager(const char *directory, float radius);
+
+      void ResetAll(void);
+
+      Vector2i GetImageSize(void) const;
+      void GetImage(ITMUChar4Image *out, GetImageType getImageType, ITMPose *pose = NULL, ITMIntrinsics *intrinsics = NULL);
+
+      /// See ITMMainEngine::GetMemorySize()
+      static size_t GetMemorySize(const ITMLibSettings *settings);
+
+      void turnOnIntegration();
+      void turnOffIntegration();
+
+      void turnOnMainProcessing();
+      void turnOffMainProcessing();
+
+      /** \brief Constructor
+          Ommitting a separate image size for the depth images
+          will assume same resolution as for the RGB images.
+      */
+      ITMBasicEngine(const ITMLibSettings *settings, const ITMRGBDCalib *calib, Vector2i imgSize_rgb, Vector2i imgSize_d = Vector2i(-1,-1));
+      ~ITMBasicEngine();
+    };
+  }
+}
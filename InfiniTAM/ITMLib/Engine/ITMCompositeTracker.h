@@ -49,6 +49,11 @@ namespace ITMLib
 				for (int i = 0; i < noTrackers; i++) trackers[i]->UpdateInitialPose(trackingState);
 			}
 
+			void Reset(void)
+			{
+				for (int i = 0; i < noTrackers; i++) trackers[i]->Reset();
+			}
+
 			// Suppress the default copy constructor and assignment operator
 			ITMCompositeTracker(const ITMCompositeTracker&);
 			ITMCompositeTracker& operator=(const ITMCompositeTracker&);
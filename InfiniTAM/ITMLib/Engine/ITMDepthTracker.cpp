@@ -32,6 +32,8 @@ ITMDepthTracker::ITMDepthTracker(Vector2i imgSize, TrackerIterationType *trackin
 	this->noICPLevel = noICPRunTillLevel;
 
 	this->terminationThreshold = terminationThreshold;
+
+	this->warmStart = new ITMTrackerWarmStart(noHierarchyLevels, 1.0f, 1e-2f);
 }
 
 ITMDepthTracker::~ITMDepthTracker(void) 
@@ -41,6 +43,8 @@ ITMDepthTracker::~ITMDepthTracker(void)
 
 	delete[] this->noIterationsPerLevel;
 	delete[] this->distThresh;
+
+	delete this->warmStart;
 }
 
 void ITMDepthTracker::SetEvaluationData(ITMTrackingState *trackingState, const ITMView *view)
@@ -61,10 +65,13 @@ void ITMDepthTracker::SetEvaluationData(ITMTrackingState *trackingState, const I
 
 void ITMDepthTracker::PrepareForEvaluation()
 {
+	// the same frame tracked again keeps its pyramid
+	bool isPrepared = warmStart->IsPrepared(view);
+
 	for (int i = 1; i < viewHierarchy->noLevels; i++)
 	{
 		ITMTemplatedHierarchyLevel<ITMFloatImage> *currentLevelView = viewHierarchy->levels[i], *previousLevelView = viewHierarchy->levels[i - 1];
-		lowLevelEngine->FilterSubsampleWithHoles(currentLevelView->depth, previousLevelView->depth);
+		if (!isPrepared) lowLevelEngine->FilterSubsampleWithHoles(currentLevelView->depth, previousLevelView->depth);
 		currentLevelView->intrinsics = previousLevelView->intrinsics * 0.5f;
 
 		ITMSceneHierarchyLevel *currentLevelScene = sceneHierarchy->levels[i], *previousLevelScene = sceneHierarchy->levels[i - 1];
@@ -72,6 +79,8 @@ void ITMDepthTracker::PrepareForEvaluation()
 		//lowLevelEngine->FilterSubsampleWithHoles(currentLevelScene->normalsMap, previousLevelScene->normalsMap);
 		currentLevelScene->intrinsics = previousLevelScene->intrinsics * 0.5f;
 	}
+
+	warmStart->SetPrepared(view);
 }
 
 void ITMDepthTracker::SetEvaluationParams(int levelId)
@@ -153,6 +162,7 @@ void ITMDepthTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView
 	float hessian_good[6 * 6], hessian_new[6 * 6], A[6 * 6];
 	float nabla_good[6], nabla_new[6];
 	float step[6];
+	bool hasTracked = false;
 
 	for (int levelId = viewHierarchy->noLevels - 1; levelId >= noICPLevel; levelId--)
 	{
@@ -162,13 +172,17 @@ void ITMDepthTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView
 		Matrix4f approxInvPose = trackingState->pose_d->GetInvM();
 		ITMPose lastKnownGoodPose(*(trackingState->pose_d));
 		f_old = 1e20f;
-		float lambda = 1.0;
+		float lambda = warmStart->GetLambda(levelId);
+		bool hasGoodHessian = false;
 
 		for (int iterNo = 0; iterNo < noIterationsPerLevel[levelId]; iterNo++)
 		{
 			// evaluate error function and gradients
 			noValidPoints_new = this->ComputeGandH(f_new, nabla_new, hessian_new, approxInvPose);
 
+			// no correspondences at the initial pose, there is no system to solve
+			if ((noValidPoints_new <= 0) && !hasGoodHessian) break;
+
 			// check if error increased. If so, revert
 			if ((noValidPoints_new <= 0)||(f_new > f_old)) {
 				trackingState->pose_d->SetFrom(&lastKnownGoodPose);
@@ -181,9 +195,10 @@ void ITMDepthTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView
 				for (int i = 0; i < 6*6; ++i) hessian_good[i] = hessian_new[i] / noValidPoints_new;
 				for (int i = 0; i < 6; ++i) nabla_good[i] = nabla_new[i] / noValidPoints_new;
 				lambda /= 10.0f;
+				hasGoodHessian = true;
 			}
 			for (int i = 0; i < 6*6; ++i) A[i] = hessian_good[i];
-			for (int i = 0; i < 6; ++i) A[i+i*6] *= 1.0f + lambda;
+			warmStart->AddDamping(A, hessian_good, lambda, levelId, iterationType != TRACKER_ITERATION_BOTH ? 3 : 6);
 
 			// compute a new step and make sure we've got an SE3
 			ComputeDelta(step, nabla_good, A, iterationType != TRACKER_ITERATION_BOTH);
@@ -195,6 +210,18 @@ void ITMDepthTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView
 			// if step is small, assume it's going to decrease the error and finish
 			if (HasConverged(step)) break;
 		}
+
+		// the next frame starts this level where this one finished
+		warmStart->SetConverged(levelId, lambda, hasGoodHessian ? hessian_good : NULL, iterationType != TRACKER_ITERATION_BOTH ? 3 : 6);
+		if (hasGoodHessian) hasTracked = true;
 	}
+
+	// no level found a single correspondence
+	if (!hasTracked) trackingState->trackerResult = ITMTrackingState::TRACKING_FAILED;
+}
+
+void ITMDepthTracker::Reset(void)
+{
+	warmStart->Reset();
 }
 
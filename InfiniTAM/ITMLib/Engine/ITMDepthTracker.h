@@ -10,6 +10,7 @@
 
 #include "../Engine/ITMTracker.h"
 #include "../Engine/ITMLowLevelEngine.h"
+#include "../Engine/ITMTrackerWarmStart.h"
 
 using namespace ITMLib::Objects;
 
@@ -35,6 +36,8 @@ namespace ITMLib
 
 			float terminationThreshold;
 
+			ITMTrackerWarmStart *warmStart;
+
 			void PrepareForEvaluation();
 			void SetEvaluationParams(int levelId);
 
@@ -57,6 +60,7 @@ namespace ITMLib
 
 		public:
 			void TrackCamera(ITMTrackingState *trackingState, const ITMView *view);
+			void Reset(void);
 
 			ITMDepthTracker(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, int noICPRunTillLevel, float distThresh,
 				float terminationThreshold, const ITMLowLevelEngine *lowLevelEngine, MemoryDeviceType memoryType);
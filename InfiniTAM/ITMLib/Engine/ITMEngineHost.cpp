@@ -0,0 +1,245 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMEngineHost.h"
+
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace ITMLib::Engine;
+
+typedef std::chrono::steady_clock Clock;
+
+static double MillisecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+ITMEngineHost::ITMEngineHost(int noThreads, size_t memoryBudget, int noConcurrentFrames)
+{
+	if (noThreads <= 0) noThreads = (int)std::thread::hardware_concurrency();
+	if (noThreads <= 0) noThreads = 1;
+	if (noConcurrentFrames < 1) noConcurrentFrames = 1;
+	if (noConcurrentFrames > noThreads) noConcurrentFrames = noThreads;
+
+	this->noThreads = noThreads;
+	this->noConcurrentFrames = noConcurrentFrames;
+	this->memoryBudget = memoryBudget;
+	memoryUsed = 0;
+
+	nextTicket = 0;
+	noRunningFrames = 0;
+
+	// the pool counts one calling thread, the threads of the other running frames come on top
+	scheduler = new ITMTaskScheduler(noThreads - noConcurrentFrames + 1);
+}
+
+ITMEngineHost::~ITMEngineHost(void)
+{
+	ITMTaskScheduler::Binding binding(scheduler);
+	for (size_t engineId = 0; engineId < engines.size(); engineId++)
+	{
+		if (engines[engineId] == NULL) continue;
+		delete engines[engineId]->engine;
+		delete engines[engineId];
+	}
+
+	delete scheduler;
+}
+
+ITMEngineHost::HostedEngine* ITMEngineHost::GetHostedEngine(int engineId) const
+{
+	if (engineId < 0 || engineId >= (int)engines.size() || engines[engineId] == NULL || engines[engineId]->isRemoved)
+		throw std::runtime_error("There is no engine with id " + std::to_string(engineId));
+
+	return engines[engineId];
+}
+
+int ITMEngineHost::AddEngine(const ITMLibSettings *settings, const ITMRGBDCalib *calib, Vector2i imgSize_rgb, Vector2i imgSize_d, int priority)
+{
+	size_t memorySize = ITMMainEngine::GetMemorySize(settings);
+
+	// the memory is reserved before the engine is made, so that concurrent calls cannot exceed the budget together
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (memoryBudget > 0 && memoryUsed + memorySize > memoryBudget)
+			throw std::runtime_error("The engine needs " + std::to_string(memorySize) + " bytes, but only " +
+				std::to_string(memoryBudget - memoryUsed) + " bytes of the budget are left");
+		memoryUsed += memorySize;
+	}
+
+	ITMMainEngine *engine;
+	try
+	{
+		ITMTaskScheduler::Binding binding(scheduler);
+		engine = ITMMainEngine::Make(settings, calib, imgSize_rgb, imgSize_d);
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		memoryUsed -= memorySize;
+		throw;
+	}
+
+	HostedEngine *hostedEngine = new HostedEngine();
+	hostedEngine->engine = engine;
+	hostedEngine->isProcessing = false;
+	hostedEngine->isRemoved = false;
+	hostedEngine->stats.priority = priority;
+	hostedEngine->stats.memorySize = memorySize;
+	hostedEngine->stats.noProcessedFrames = 0;
+	hostedEngine->stats.totalProcessTime = hostedEngine->stats.maxProcessTime = 0.0;
+	hostedEngine->stats.totalWaitTime = hostedEngine->stats.maxWaitTime = 0.0;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	engines.push_back(hostedEngine);
+	return (int)engines.size() - 1;
+}
+
+void ITMEngineHost::RemoveEngine(int engineId)
+{
+	HostedEngine *hostedEngine;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		hostedEngine = GetHostedEngine(engineId);
+		hostedEngine->isRemoved = true;
+		slotFreed.notify_all();
+
+		// the waiting frames wake up, see that the engine is removed and leave the queue
+		slotFreed.wait(lock, [this, hostedEngine, engineId]() {
+			if (hostedEngine->isProcessing) return false;
+			for (size_t i = 0; i < waitingFrames.size(); i++)
+				if (waitingFrames[i].engineId == engineId) return false;
+			return true;
+		});
+
+		engines[engineId] = NULL;
+		memoryUsed -= hostedEngine->stats.memorySize;
+	}
+
+	ITMTaskScheduler::Binding binding(scheduler);
+	delete hostedEngine->engine;
+	delete hostedEngine;
+}
+
+ITMMainEngine* ITMEngineHost::GetEngine(int engineId)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return GetHostedEngine(engineId)->engine;
+}
+
+bool ITMEngineHost::IsNextFrame(long long ticket) const
+{
+	// the highest priority first, the longest waiting among equal ones, skipping engines that are busy
+	const WaitingFrame *next = NULL;
+	int nextPriority = 0;
+	for (size_t i = 0; i < waitingFrames.size(); i++)
+	{
+		const HostedEngine *hostedEngine = engines[waitingFrames[i].engineId];
+		if (hostedEngine == NULL || hostedEngine->isRemoved || hostedEngine->isProcessing) continue;
+
+		int priority = hostedEngine->stats.priority;
+		if (next == NULL || priority > nextPriority || (priority == nextPriority && waitingFrames[i].ticket < next->ticket))
+		{
+			next = &waitingFrames[i];
+			nextPriority = priority;
+		}
+	}
+
+	return next != NULL && next->ticket == ticket;
+}
+
+void ITMEngineHost::ProcessFrame(int engineId, ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement)
+{
+	Clock::time_point waitStart = Clock::now();
+
+	HostedEngine *hostedEngine;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		hostedEngine = GetHostedEngine(engineId);
+
+		WaitingFrame frame;
+		frame.engineId = engineId;
+		frame.ticket = nextTicket++;
+		waitingFrames.push_back(frame);
+
+		slotFreed.wait(lock, [this, hostedEngine, &frame]() {
+			return hostedEngine->isRemoved || (noRunningFrames < noConcurrentFrames && IsNextFrame(frame.ticket));
+		});
+
+		for (size_t i = 0; i < waitingFrames.size(); i++)
+			if (waitingFrames[i].ticket == frame.ticket) { waitingFrames.erase(waitingFrames.begin() + i); break; }
+
+		if (hostedEngine->isRemoved)
+		{
+			// RemoveEngine() waits for the queue to be free of the frames of the engine
+			lock.unlock();
+			slotFreed.notify_all();
+			throw std::runtime_error("The engine with id " + std::to_string(engineId) + " was removed");
+		}
+
+		noRunningFrames++;
+		hostedEngine->isProcessing = true;
+	}
+
+	// with another slot free, the frame now next in line can start as well
+	slotFreed.notify_all();
+
+	double waitTime = MillisecondsSince(waitStart);
+	Clock::time_point processStart = Clock::now();
+
+	std::exception_ptr failure;
+	try
+	{
+		ITMTaskScheduler::Binding binding(scheduler);
+		hostedEngine->engine->ProcessFrame(rgbImage, rawDepthImage, imuMeasurement);
+	}
+	catch (...)
+	{
+		failure = std::current_exception();
+	}
+
+	double processTime = MillisecondsSince(processStart);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		noRunningFrames--;
+		hostedEngine->isProcessing = false;
+
+		EngineStats &stats = hostedEngine->stats;
+		stats.noProcessedFrames++;
+		stats.totalProcessTime += processTime;
+		if (processTime > stats.maxProcessTime) stats.maxProcessTime = processTime;
+		stats.totalWaitTime += waitTime;
+		if (waitTime > stats.maxWaitTime) stats.maxWaitTime = waitTime;
+	}
+
+	slotFreed.notify_all();
+
+	// the slot is given back before the failure is passed on
+	if (failure) std::rethrow_exception(failure);
+}
+
+void ITMEngineHost::SetPriority(int engineId, int priority)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		GetHostedEngine(engineId)->stats.priority = priority;
+	}
+
+	slotFreed.notify_all();
+}
+
+ITMEngineHost::EngineStats ITMEngineHost::GetStats(int engineId)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return GetHostedEngine(engineId)->stats;
+}
+
+size_t ITMEngineHost::GetMemoryUsed(void)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return memoryUsed;
+}
@@ -0,0 +1,143 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "ITMMainEngine.h"
+#include "ITMTaskScheduler.h"
+
+namespace ITMLib
+{
+	namespace Engine
+	{
+		/** \brief
+		    Runs several independent engines, e.g. one per recorded
+		    sequence or robot, in one process on a fixed number of
+		    threads and within a memory budget.
+
+		    The engines are made with AddEngine() and do all their CPU
+		    work on the pool of the host instead of each using one
+		    thread per core. ProcessFrame() of the host runs at most
+		    noConcurrentFrames frames at once on the calling threads;
+		    the other calls wait for a slot, which goes to the frame of
+		    the engine with the highest priority and, among equal
+		    priorities, to the frame that has waited longest. The
+		    threads of the running frames work on the pool while they
+		    wait for it, so the host keeps no more than noThreads
+		    threads busy.
+
+		    The scene and mesh of an engine are sized by its
+		    ITMLibSettings::noVoxelBlocks, and an engine is only made
+		    if they fit into what is left of the budget.
+		*/
+		class ITMEngineHost
+		{
+		public:
+			struct EngineStats
+			{
+				int priority;
+				/// Bytes of the scene and mesh, see ITMMainEngine::GetMemorySize()
+				size_t memorySize;
+
+				int noProcessedFrames;
+				/// Time in ms the frames took to process
+				double totalProcessTime, maxProcessTime;
+				/// Time in ms the frames waited for a slot
+				double totalWaitTime, maxWaitTime;
+			};
+
+		private:
+			struct HostedEngine
+			{
+				ITMMainEngine *engine;
+				/// A frame of the engine is running
+				bool isProcessing;
+				/// RemoveEngine() was called, the waiting frames are dropped
+				bool isRemoved;
+				EngineStats stats;
+			};
+
+			struct WaitingFrame
+			{
+				int engineId;
+				long long ticket;
+			};
+
+			ITMTaskScheduler *scheduler;
+			int noThreads, noConcurrentFrames;
+			size_t memoryBudget, memoryUsed;
+
+			/// Indexed by engine id, NULL once removed engines have no frames left
+			std::vector<HostedEngine*> engines;
+			std::vector<WaitingFrame> waitingFrames;
+			long long nextTicket;
+			int noRunningFrames;
+
+			std::mutex mutex;
+			std::condition_variable slotFreed;
+
+			/// Whether the frame with @p ticket is the one to run next, mutex held
+			bool IsNextFrame(long long ticket) const;
+
+			HostedEngine* GetHostedEngine(int engineId) const;
+
+		public:
+			/** Starts a pool such that at most @p noThreads threads are
+			    busy with @p noConcurrentFrames frames running, 0 threads
+			    meaning one per hardware core. With as many concurrent
+			    frames as threads, every frame runs on a thread of its
+			    own; with one, the frames run one after the other on all
+			    threads. @p memoryBudget bytes are shared by the scenes
+			    and meshes of the engines, 0 for no limit.
+			*/
+			ITMEngineHost(int noThreads, size_t memoryBudget, int noConcurrentFrames = 1);
+
+			/// Deletes the engines, no frames may be running.
+			~ITMEngineHost(void);
+
+			/** Makes an engine with @p settings, which have to outlive
+			    it, and returns its id. Frames of engines with a higher
+			    @p priority are run first. The thread settings of
+			    @p settings are ignored. Throws std::runtime_error if the
+			    scene and mesh do not fit into the rest of the budget.
+			*/
+			int AddEngine(const ITMLibSettings *settings, const ITMRGBDCalib *calib, Vector2i imgSize_rgb, Vector2i imgSize_d = Vector2i(-1, -1),
+				int priority = 0);
+
+			/** Deletes the engine after its running frame and returns its
+			    memory to the budget. Its waiting frames are dropped, their
+			    ProcessFrame() calls throw std::runtime_error.
+			*/
+			void RemoveEngine(int engineId);
+
+			/** The engine for calls other than ProcessFrame(), which run
+			    on the pool as well but are not scheduled. They must not
+			    run concurrently with a frame of the same engine.
+			*/
+			ITMMainEngine* GetEngine(int engineId);
+
+			/** Waits for a slot and processes a frame with the engine.
+			    Frames of one engine are processed one at a time, and
+			    each engine may be fed from its own thread.
+			*/
+			void ProcessFrame(int engineId, ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement = NULL);
+
+			void SetPriority(int engineId, int priority);
+
+			EngineStats GetStats(int engineId);
+
+			int GetNumThreads(void) const { return noThreads; }
+			int GetNumConcurrentFrames(void) const { return noConcurrentFrames; }
+
+			size_t GetMemoryBudget(void) const { return memoryBudget; }
+			size_t GetMemoryUsed(void);
+
+			// Suppress the default copy constructor and assignment operator
+			ITMEngineHost(const ITMEngineHost&);
+			ITMEngineHost& operator=(const ITMEngineHost&);
+		};
+	}
+}
@@ -0,0 +1,271 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMHybridTracker.h"
+#include "../../ORUtils/Cholesky.h"
+
+#include <math.h>
+
+using namespace ITMLib::Engine;
+
+ITMHybridTracker::ITMHybridTracker(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, float distThresh,
+	float terminationThreshold, float icpWeight, float photometricWeight, const ITMLowLevelEngine *lowLevelEngine, MemoryDeviceType memoryType)
+{
+	viewHierarchy = new ITMImageHierarchy<ITMViewHierarchyLevel>(imgSize, trackingRegime, noHierarchyLevels, memoryType);
+	referenceHierarchy = new ITMImageHierarchy<ITMViewHierarchyLevel>(imgSize, trackingRegime, noHierarchyLevels, memoryType);
+	sceneHierarchy = new ITMImageHierarchy<ITMSceneHierarchyLevel>(imgSize, trackingRegime, noHierarchyLevels, memoryType, true);
+	hasReference = false; hadReference = false;
+
+	this->noIterationsPerLevel = new int[noHierarchyLevels];
+	this->distThresh = new float[noHierarchyLevels];
+
+	this->noIterationsPerLevel[0] = 2;
+	for (int levelId = 1; levelId < noHierarchyLevels; levelId++)
+	{
+		noIterationsPerLevel[levelId] = noIterationsPerLevel[levelId - 1] + 2;
+	}
+
+	float distThreshStep = distThresh / noHierarchyLevels;
+	this->distThresh[noHierarchyLevels - 1] = distThresh;
+	for (int levelId = noHierarchyLevels - 2; levelId >= 0; levelId--)
+		this->distThresh[levelId] = this->distThresh[levelId + 1] - distThreshStep;
+
+	this->lowLevelEngine = lowLevelEngine;
+
+	this->terminationThreshold = terminationThreshold;
+	this->icpWeight = icpWeight;
+	this->photometricWeight = photometricWeight;
+
+	this->warmStart = new ITMTrackerWarmStart(noHierarchyLevels, 1.0f, 1e-2f);
+}
+
+ITMHybridTracker::~ITMHybridTracker(void)
+{
+	delete this->viewHierarchy;
+	delete this->referenceHierarchy;
+	delete this->sceneHierarchy;
+
+	delete[] this->noIterationsPerLevel;
+	delete[] this->distThresh;
+
+	delete this->warmStart;
+}
+
+void ITMHybridTracker::SetEvaluationData(ITMTrackingState *trackingState, const ITMView *view)
+{
+	this->trackingState = trackingState;
+	this->view = view;
+
+	sceneHierarchy->levels[0]->intrinsics = view->calib->intrinsics_d.projectionParamsSimple.all;
+	viewHierarchy->levels[0]->intrinsics = view->calib->intrinsics_d.projectionParamsSimple.all;
+
+	// the scene hierarchy points to the raycast maps at level 0
+	sceneHierarchy->levels[0]->pointsMap = trackingState->pointCloud->locations;
+	sceneHierarchy->levels[0]->normalsMap = trackingState->pointCloud->colours;
+
+	scenePose = trackingState->pose_pointCloud->GetM();
+	depthToRGB = view->calib->trafo_rgb_to_depth.calib_inv;
+}
+
+void ITMHybridTracker::PrepareForEvaluation()
+{
+	// the same frame tracked again: its pyramid has become the reference, swap it back
+	if (warmStart->IsPrepared(view))
+	{
+		ITMImageHierarchy<ITMViewHierarchyLevel> *tmp = referenceHierarchy;
+		referenceHierarchy = viewHierarchy; viewHierarchy = tmp;
+
+		referencePose = previousReferencePose;
+		hasReference = hadReference;
+
+		for (int i = 0; i < viewHierarchy->noLevels; i++)
+			viewHierarchy->levels[i]->intrinsics = view->calib->intrinsics_d.projectionParamsSimple.all * (1.0f / (float)(1 << i));
+		for (int i = 1; i < sceneHierarchy->noLevels; i++)
+			sceneHierarchy->levels[i]->intrinsics = sceneHierarchy->levels[i - 1]->intrinsics * 0.5f;
+
+		return;
+	}
+
+	ITMViewHierarchyLevel *baseLevel = viewHierarchy->levels[0];
+
+	baseLevel->depth->ChangeDims(view->depth->noDims);
+	baseLevel->rgb->ChangeDims(view->rgb->noDims);
+	lowLevelEngine->CopyImage(baseLevel->depth, view->depth);
+	lowLevelEngine->CopyImage(baseLevel->rgb, view->rgb);
+
+	for (int i = 1; i < viewHierarchy->noLevels; i++)
+	{
+		ITMViewHierarchyLevel *currentLevelView = viewHierarchy->levels[i], *previousLevelView = viewHierarchy->levels[i - 1];
+		lowLevelEngine->FilterSubsampleWithHoles(currentLevelView->depth, previousLevelView->depth);
+		lowLevelEngine->FilterSubsample(currentLevelView->rgb, previousLevelView->rgb);
+		currentLevelView->intrinsics = previousLevelView->intrinsics * 0.5f;
+
+		ITMSceneHierarchyLevel *currentLevelScene = sceneHierarchy->levels[i], *previousLevelScene = sceneHierarchy->levels[i - 1];
+		currentLevelScene->intrinsics = previousLevelScene->intrinsics * 0.5f;
+	}
+
+	// the gradients are only used once this frame has become the reference
+	for (int i = 0; i < viewHierarchy->noLevels; i++)
+	{
+		ITMViewHierarchyLevel *currentLevel = viewHierarchy->levels[i];
+
+		lowLevelEngine->GradientX(currentLevel->gradientX_rgb, currentLevel->rgb);
+		lowLevelEngine->GradientY(currentLevel->gradientY_rgb, currentLevel->rgb);
+	}
+
+	warmStart->SetPrepared(view);
+}
+
+void ITMHybridTracker::SetEvaluationParams(int levelId)
+{
+	this->levelId = levelId;
+	this->iterationType = viewHierarchy->levels[levelId]->iterationType;
+	this->sceneHierarchyLevel = sceneHierarchy->levels[0];
+	this->viewHierarchyLevel = viewHierarchy->levels[levelId];
+	this->referenceHierarchyLevel = hasReference ? referenceHierarchy->levels[levelId] : NULL;
+	this->rgbIntrinsics = view->calib->intrinsics_rgb.projectionParamsSimple.all * (1.0f / (float)(1 << levelId));
+}
+
+void ITMHybridTracker::ComputeDelta(float *step, float *nabla, float *hessian, bool shortIteration) const
+{
+	for (int i = 0; i < 6; i++) step[i] = 0;
+
+	if (shortIteration)
+	{
+		float smallHessian[3 * 3];
+		for (int r = 0; r < 3; r++) for (int c = 0; c < 3; c++) smallHessian[r + c * 3] = hessian[r + c * 6];
+
+		ORUtils::Cholesky cholA(smallHessian, 3);
+		cholA.Backsub(step, nabla);
+	}
+	else
+	{
+		ORUtils::Cholesky cholA(hessian, 6);
+		cholA.Backsub(step, nabla);
+	}
+}
+
+bool ITMHybridTracker::HasConverged(float *step) const
+{
+	float stepLength = 0.0f;
+	for (int i = 0; i < 6; i++) stepLength += step[i] * step[i];
+
+	if (sqrt(stepLength) / 6 < terminationThreshold) return true; //converged
+
+	return false;
+}
+
+void ITMHybridTracker::ApplyDelta(const Matrix4f & para_old, const float *delta, Matrix4f & para_new) const
+{
+	float step[6];
+
+	switch (iterationType)
+	{
+	case TRACKER_ITERATION_ROTATION:
+		step[0] = (float)(delta[0]); step[1] = (float)(delta[1]); step[2] = (float)(delta[2]);
+		step[3] = 0.0f; step[4] = 0.0f; step[5] = 0.0f;
+		break;
+	case TRACKER_ITERATION_TRANSLATION:
+		step[0] = 0.0f; step[1] = 0.0f; step[2] = 0.0f;
+		step[3] = (float)(delta[0]); step[4] = (float)(delta[1]); step[5] = (float)(delta[2]);
+		break;
+	default:
+	case TRACKER_ITERATION_BOTH:
+		step[0] = (float)(delta[0]); step[1] = (float)(delta[1]); step[2] = (float)(delta[2]);
+		step[3] = (float)(delta[3]); step[4] = (float)(delta[4]); step[5] = (float)(delta[5]);
+		break;
+	}
+
+	Matrix4f Tinc;
+
+	Tinc.m00 = 1.0f;		Tinc.m10 = step[2];		Tinc.m20 = -step[1];	Tinc.m30 = step[3];
+	Tinc.m01 = -step[2];	Tinc.m11 = 1.0f;		Tinc.m21 = step[0];		Tinc.m31 = step[4];
+	Tinc.m02 = step[1];		Tinc.m12 = -step[0];	Tinc.m22 = 1.0f;		Tinc.m32 = step[5];
+	Tinc.m03 = 0.0f;		Tinc.m13 = 0.0f;		Tinc.m23 = 0.0f;		Tinc.m33 = 1.0f;
+
+	para_new = Tinc * para_old;
+}
+
+void ITMHybridTracker::TrackCamera(ITMTrackingState *trackingState, const ITMView *view)
+{
+	this->SetEvaluationData(trackingState, view);
+	this->PrepareForEvaluation();
+
+	float f_old = 1e10, f_new;
+	int noValidPoints_new;
+
+	float hessian_good[6 * 6], hessian_new[6 * 6], A[6 * 6];
+	float nabla_good[6], nabla_new[6];
+	float step[6];
+	bool hasTracked = false;
+
+	for (int levelId = viewHierarchy->noLevels - 1; levelId >= 0; levelId--)
+	{
+		this->SetEvaluationParams(levelId);
+		if (iterationType == TRACKER_ITERATION_NONE) continue;
+
+		Matrix4f approxInvPose = trackingState->pose_d->GetInvM();
+		ITMPose lastKnownGoodPose(*(trackingState->pose_d));
+		f_old = 1e20f;
+		float lambda = warmStart->GetLambda(levelId);
+		bool hasGoodHessian = false;
+
+		for (int iterNo = 0; iterNo < noIterationsPerLevel[levelId]; iterNo++)
+		{
+			// evaluate error function and gradients of both terms
+			noValidPoints_new = this->ComputeGandH(f_new, nabla_new, hessian_new, approxInvPose);
+
+			// nothing to solve for yet, e.g. the photometric term alone on the first tracked frame
+			if ((noValidPoints_new <= 0) && !hasGoodHessian) break;
+
+			// check if error increased. If so, revert
+			if ((noValidPoints_new <= 0)||(f_new > f_old)) {
+				trackingState->pose_d->SetFrom(&lastKnownGoodPose);
+				approxInvPose = trackingState->pose_d->GetInvM();
+				lambda *= 10.0f;
+			} else {
+				lastKnownGoodPose.SetFrom(trackingState->pose_d);
+				f_old = f_new;
+
+				for (int i = 0; i < 6*6; ++i) hessian_good[i] = hessian_new[i] / noValidPoints_new;
+				for (int i = 0; i < 6; ++i) nabla_good[i] = nabla_new[i] / noValidPoints_new;
+				lambda /= 10.0f;
+				hasGoodHessian = true;
+			}
+			for (int i = 0; i < 6*6; ++i) A[i] = hessian_good[i];
+			warmStart->AddDamping(A, hessian_good, lambda, levelId, iterationType != TRACKER_ITERATION_BOTH ? 3 : 6);
+
+			// compute a new step and make sure we've got an SE3
+			ComputeDelta(step, nabla_good, A, iterationType != TRACKER_ITERATION_BOTH);
+			ApplyDelta(approxInvPose, step, approxInvPose);
+			trackingState->pose_d->SetInvM(approxInvPose);
+			trackingState->pose_d->Coerce();
+			approxInvPose = trackingState->pose_d->GetInvM();
+
+			// if step is small, assume it's going to decrease the error and finish
+			if (HasConverged(step)) break;
+		}
+
+		// the next frame starts this level where this one finished
+		warmStart->SetConverged(levelId, lambda, hasGoodHessian ? hessian_good : NULL, iterationType != TRACKER_ITERATION_BOTH ? 3 : 6);
+		if (hasGoodHessian) hasTracked = true;
+	}
+
+	// neither term found a single correspondence on any level
+	if (!hasTracked) trackingState->trackerResult = ITMTrackingState::TRACKING_FAILED;
+
+	// this frame is the photometric reference for the next one
+	ITMImageHierarchy<ITMViewHierarchyLevel> *tmp = referenceHierarchy;
+	referenceHierarchy = viewHierarchy; viewHierarchy = tmp;
+
+	previousReferencePose = referencePose; hadReference = hasReference;
+	referencePose = depthToRGB * trackingState->pose_d->GetM();
+	hasReference = true;
+}
+
+void ITMHybridTracker::Reset(void)
+{
+	warmStart->Reset();
+
+	// the next frame becomes the photometric reference without being compared to this one
+	hasReference = hadReference = false;
+}
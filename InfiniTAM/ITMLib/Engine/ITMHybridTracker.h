@@ -0,0 +1,92 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "../Utils/ITMLibDefines.h"
+
+#include "../Objects/ITMImageHierarchy.h"
+#include "../Objects/ITMSceneHierarchyLevel.h"
+#include "../Objects/ITMViewHierarchyLevel.h"
+
+#include "../Engine/ITMTracker.h"
+#include "../Engine/ITMLowLevelEngine.h"
+#include "../Engine/ITMTrackerWarmStart.h"
+
+using namespace ITMLib::Objects;
+
+namespace ITMLib
+{
+	namespace Engine
+	{
+		/** Base class for engines tracking with depth and colour at
+		    the same time. Each iteration solves one Gauss-Newton system
+		    that sums the point-to-plane residuals against the raycast
+		    scene, as in ITMDepthTracker, and photometric residuals
+		    against the colour image of the previous frame, each term
+		    with its own weight. Depth and colour share one image
+		    pyramid, so the pair of trackers costs a single pass over
+		    the pixels per iteration.
+		*/
+		class ITMHybridTracker : public ITMTracker
+		{
+		private:
+			const ITMLowLevelEngine *lowLevelEngine;
+			ITMImageHierarchy<ITMSceneHierarchyLevel> *sceneHierarchy;
+			ITMImageHierarchy<ITMViewHierarchyLevel> *viewHierarchy;
+
+			/// Pyramid of the previously tracked frame, swapped with viewHierarchy after tracking.
+			ITMImageHierarchy<ITMViewHierarchyLevel> *referenceHierarchy;
+			bool hasReference;
+
+			/// Reference before the last frame became it, restored if that frame is tracked again.
+			Matrix4f previousReferencePose;
+			bool hadReference;
+
+			ITMTrackingState *trackingState; const ITMView *view;
+
+			int *noIterationsPerLevel;
+
+			float terminationThreshold;
+
+			ITMTrackerWarmStart *warmStart;
+
+			void PrepareForEvaluation();
+			void SetEvaluationParams(int levelId);
+
+			void ComputeDelta(float *delta, float *nabla, float *hessian, bool shortIteration) const;
+			void ApplyDelta(const Matrix4f & para_old, const float *delta, Matrix4f & para_new) const;
+			bool HasConverged(float *step) const;
+
+			void SetEvaluationData(ITMTrackingState *trackingState, const ITMView *view);
+		protected:
+			float *distThresh;
+			float icpWeight, photometricWeight;
+
+			int levelId;
+			TrackerIterationType iterationType;
+
+			Matrix4f scenePose;
+			ITMSceneHierarchyLevel *sceneHierarchyLevel;
+			ITMViewHierarchyLevel *viewHierarchyLevel;
+
+			/// Transformation from the depth to the colour camera and the colour intrinsics of the current level.
+			Matrix4f depthToRGB;
+			Vector4f rgbIntrinsics;
+
+			/// Colour camera pose of the reference frame and its pyramid level, NULL while there is no reference.
+			Matrix4f referencePose;
+			ITMViewHierarchyLevel *referenceHierarchyLevel;
+
+			virtual int ComputeGandH(float &f, float *nabla, float *hessian, Matrix4f approxInvPose) = 0;
+
+		public:
+			void TrackCamera(ITMTrackingState *trackingState, const ITMView *view);
+			void Reset(void);
+
+			ITMHybridTracker(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, float distThresh,
+				float terminationThreshold, float icpWeight, float photometricWeight, const ITMLowLevelEngine *lowLevelEngine,
+				MemoryDeviceType memoryType);
+			virtual ~ITMHybridTracker(void);
+		};
+	}
+}
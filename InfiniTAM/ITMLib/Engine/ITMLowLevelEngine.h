@@ -22,6 +22,10 @@ namespace ITMLib
 			virtual void FilterSubsampleWithHoles(ITMFloatImage *image_out, const ITMFloatImage *image_in) const = 0;
 			virtual void FilterSubsampleWithHoles(ITMFloat4Image *image_out, const ITMFloat4Image *image_in) const = 0;
 
+			/// Subsamples a depth image and its per-pixel uncertainty in one pass, each as with FilterSubsampleWithHoles.
+			virtual void FilterSubsampleWithHoles(ITMFloatImage *depth_out, ITMFloatImage *uncertainty_out, const ITMFloatImage *depth_in,
+				const ITMFloatImage *uncertainty_in) const = 0;
+
 			virtual void GradientX(ITMShort4Image *grad_out, const ITMUChar4Image *image_in) const = 0;
 			virtual void GradientY(ITMShort4Image *grad_out, const ITMUChar4Image *image_in) const = 0;
 
@@ -1,197 +1,34 @@
 // Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
 
-#include "ITMMainEngine.h"
+#include "ITMBasicEngine.h"
 
 using namespace ITMLib::Engine;
 
-ITMMainEngine::ITMMainEngine(const ITMLibSettings *settings, const ITMRGBDCalib *calib, Vector2i imgSize_rgb, Vector2i imgSize_d)
-{
-	// create all the things required for marching cubes and mesh extraction
-	// - uses additional memory (lots!)
-	static const bool createMeshingEngine = true;
-
-	if ((imgSize_d.x == -1) || (imgSize_d.y == -1)) imgSize_d = imgSize_rgb;
-
-	this->settings = settings;
-
-	this->scene = new ITMScene<ITMVoxel, ITMVoxelIndex>(&(settings->sceneParams), settings->useSwapping, 
-		settings->deviceType == ITMLibSettings::DEVICE_CUDA ? MEMORYDEVICE_CUDA : MEMORYDEVICE_CPU);
-
-	meshingEngine = NULL;
-	switch (settings->deviceType)
-	{
-	case ITMLibSettings::DEVICE_CPU:
-		lowLevelEngine = new ITMLowLevelEngine_CPU();
-		viewBuilder = new ITMViewBuilder_CPU(calib);
-		visualisationEngine = new ITMVisualisationEngine_CPU<ITMVoxel, ITMVoxelIndex>(scene);
-		if (createMeshingEngine) meshingEngine = new ITMMeshingEngine_CPU<ITMVoxel, ITMVoxelIndex>();
-		break;
-	case ITMLibSettings::DEVICE_CUDA:
-#ifndef COMPILE_WITHOUT_CUDA
-		lowLevelEngine = new ITMLowLevelEngine_CUDA();
-		viewBuilder = new ITMViewBuilder_CUDA(calib);
-		visualisationEngine = new ITMVisualisationEngine_CUDA<ITMVoxel, ITMVoxelIndex>(scene);
-		if (createMeshingEngine) meshingEngine = new ITMMeshingEngine_CUDA<ITMVoxel, ITMVoxelIndex>();
-#endif
-		break;
-	case ITMLibSettings::DEVICE_METAL:
-#ifdef COMPILE_WITH_METAL
-		lowLevelEngine = new ITMLowLevelEngine_Metal();
-		viewBuilder = new ITMViewBuilder_Metal(calib);
-		visualisationEngine = new ITMVisualisationEngine_Metal<ITMVoxel, ITMVoxelIndex>(scene);
-		if (createMeshingEngine) meshingEngine = new ITMMeshingEngine_CPU<ITMVoxel, ITMVoxelIndex>();
-#endif
-		break;
-	}
-
-	mesh = NULL;
-	if (createMeshingEngine) mesh = new ITMMesh(settings->deviceType == ITMLibSettings::DEVICE_CUDA ? MEMORYDEVICE_CUDA : MEMORYDEVICE_CPU);
-
-	Vector2i trackedImageSize = ITMTrackingController::GetTrackedImageSize(settings, imgSize_rgb, imgSize_d);
-
-	renderState_live = visualisationEngine->CreateRenderState(trackedImageSize);
-	renderState_freeview = NULL; //will be created by the visualisation engine
-
-	denseMapper = new ITMDenseMapper<ITMVoxel, ITMVoxelIndex>(settings);
-	denseMapper->ResetScene(scene);
-
-	imuCalibrator = new ITMIMUCalibrator_iPad();
-	tracker = ITMTrackerFactory<ITMVoxel, ITMVoxelIndex>::Instance().Make(trackedImageSize, settings, lowLevelEngine, imuCalibrator, scene);
-	trackingController = new ITMTrackingController(tracker, visualisationEngine, lowLevelEngine, settings);
-
-	trackingState = trackingController->BuildTrackingState(trackedImageSize);
-	tracker->UpdateInitialPose(trackingState);
-
-	view = NULL; // will be allocated by the view builder
-
-	fusionActive = true;
-	mainProcessingActive = true;
-	image_time_stamp = pose_time_stamp = 0.0;
-}
-
-ITMMainEngine::~ITMMainEngine()
-{
-	delete renderState_live;
-	if (renderState_freeview!=NULL) delete renderState_freeview;
-
-	delete scene;
-
-	delete denseMapper;
-	delete trackingController;
-
-	delete tracker;
-	delete imuCalibrator;
-
-	delete lowLevelEngine;
-	delete viewBuilder;
+#define MAKE_BASIC_ENGINE(X, TVoxel, TIndex) \
+	if (settings->voxelType == ITMLibSettings::VoxelTypeOf<TVoxel>() && settings->indexType == ITMLibSettings::IndexTypeOf<TIndex>()) \
+		return new ITMBasicEngine<TVoxel, TIndex>(settings, calib, imgSize_rgb, imgSize_d);
 
-	delete trackingState;
-	if (view != NULL) delete view;
+#define GET_BASIC_ENGINE_MEMORY_SIZE(X, TVoxel, TIndex) \
+	if (settings->voxelType == ITMLibSettings::VoxelTypeOf<TVoxel>() && settings->indexType == ITMLibSettings::IndexTypeOf<TIndex>()) \
+		return ITMBasicEngine<TVoxel, TIndex>::GetMemorySize(settings);
 
-	delete visualisationEngine;
-
-	if (meshingEngine != NULL) delete meshingEngine;
-
-	if (mesh != NULL) delete mesh;
-}
-
-ITMMesh* ITMMainEngine::UpdateMesh(void)
-{
-	if (mesh != NULL) meshingEngine->MeshScene(mesh, scene);
-	return mesh;
-}
-
-void ITMMainEngine::SaveSceneToMesh(const char *objFileName)
-{
-	if (mesh == NULL) return;
-	meshingEngine->MeshScene(mesh, scene);
-	mesh->WriteSTL(objFileName);
-}
-
-void ITMMainEngine::ProcessFrame(ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement)
+ITMMainEngine* ITMMainEngine::Make(const ITMLibSettings *settings, const ITMRGBDCalib *calib, Vector2i imgSize_rgb, Vector2i imgSize_d)
 {
-	// prepare image and turn it into a depth image
-	if (imuMeasurement==NULL) viewBuilder->UpdateView(&view, rgbImage, rawDepthImage, settings->useBilateralFilter,settings->modelSensorNoise);
-	else viewBuilder->UpdateView(&view, rgbImage, rawDepthImage, settings->useBilateralFilter, imuMeasurement);
+	// the Metal kernels are compiled for ITMVoxel and ITMVoxelIndex only
+	if (settings->deviceType == ITMLibSettings::DEVICE_METAL && (settings->voxelType != ITMLibSettings::VoxelTypeOf<ITMVoxel>() ||
+		settings->indexType != ITMLibSettings::IndexTypeOf<ITMVoxelIndex>()))
+		DIEWITHEXCEPTION("The Metal engines support only the default voxel and index type");
 
-	if (!mainProcessingActive) return;
+	ITMLIB_FOR_EACH_VOXEL_INDEX(MAKE_BASIC_ENGINE, )
 
-	// tracking
-	trackingController->Track(trackingState, view);
-
-	// fusion
-	if (fusionActive) denseMapper->ProcessFrame(view, trackingState, scene, renderState_live);
-
-	// raycast to renderState_live for tracking and free visualisation
-	trackingController->Prepare(trackingState, view, renderState_live);
-}
-
-Vector2i ITMMainEngine::GetImageSize(void) const
-{
-	return renderState_live->raycastImage->noDims;
+	DIEWITHEXCEPTION("ITMLib is not compiled for the selected voxel and index type");
+	return NULL;
 }
 
-void ITMMainEngine::GetImage(ITMUChar4Image *out, GetImageType getImageType, ITMPose *pose, ITMIntrinsics *intrinsics)
+size_t ITMMainEngine::GetMemorySize(const ITMLibSettings *settings)
 {
-	if (view == NULL) return;
+	ITMLIB_FOR_EACH_VOXEL_INDEX(GET_BASIC_ENGINE_MEMORY_SIZE, )
 
-	out->Clear();
-
-	switch (getImageType)
-	{
-	case ITMMainEngine::InfiniTAM_IMAGE_ORIGINAL_RGB:
-		out->ChangeDims(view->rgb->noDims);
-		if (settings->deviceType == ITMLibSettings::DEVICE_CUDA) 
-			out->SetFrom(view->rgb, ORUtils::MemoryBlock<Vector4u>::CUDA_TO_CPU);
-		else out->SetFrom(view->rgb, ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU);
-		break;
-	case ITMMainEngine::InfiniTAM_IMAGE_ORIGINAL_DEPTH:
-		out->ChangeDims(view->depth->noDims);
-		if (settings->trackerType==ITMLib::Objects::ITMLibSettings::TRACKER_WICP)
-		{
-			if (settings->deviceType == ITMLibSettings::DEVICE_CUDA) view->depthUncertainty->UpdateHostFromDevice();
-			ITMVisualisationEngine<ITMVoxel, ITMVoxelIndex>::WeightToUchar4(out, view->depthUncertainty);
-		}
-		else
-		{
-			if (settings->deviceType == ITMLibSettings::DEVICE_CUDA) view->depth->UpdateHostFromDevice();
-			ITMVisualisationEngine<ITMVoxel, ITMVoxelIndex>::DepthToUchar4(out, view->depth);
-		}
-
-		break;
-	case ITMMainEngine::InfiniTAM_IMAGE_SCENERAYCAST:
-	{
-		ORUtils::Image<Vector4u> *srcImage = renderState_live->raycastImage;
-		out->ChangeDims(srcImage->noDims);
-		if (settings->deviceType == ITMLibSettings::DEVICE_CUDA)
-			out->SetFrom(srcImage, ORUtils::MemoryBlock<Vector4u>::CUDA_TO_CPU);
-		else out->SetFrom(srcImage, ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU);	
-		break;
-	}
-	case ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_SHADED:
-	case ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_VOLUME:
-	case ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_NORMAL:
-	{
-		IITMVisualisationEngine::RenderImageType type = IITMVisualisationEngine::RENDER_SHADED_GREYSCALE;
-		if (getImageType == ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_VOLUME) type = IITMVisualisationEngine::RENDER_COLOUR_FROM_VOLUME;
-		else if (getImageType == ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_NORMAL) type = IITMVisualisationEngine::RENDER_COLOUR_FROM_NORMAL;
-		if (renderState_freeview == NULL) renderState_freeview = visualisationEngine->CreateRenderState(out->noDims);
-
-		visualisationEngine->FindVisibleBlocks(pose, intrinsics, renderState_freeview);
-		visualisationEngine->CreateExpectedDepths(pose, intrinsics, renderState_freeview);
-		visualisationEngine->RenderImage(pose, intrinsics, renderState_freeview, renderState_freeview->raycastImage, type);
-
-		if (settings->deviceType == ITMLibSettings::DEVICE_CUDA)
-			out->SetFrom(renderState_freeview->raycastImage, ORUtils::MemoryBlock<Vector4u>::CUDA_TO_CPU);
-		else out->SetFrom(renderState_freeview->raycastImage, ORUtils::MemoryBlock<Vector4u>::CPU_TO_CPU);
-		break;
-	}
-	case ITMMainEngine::InfiniTAM_IMAGE_UNKNOWN:
-		break;
-	};
+	DIEWITHEXCEPTION("ITMLib is not compiled for the selected voxel and index type");
+	return 0;
 }
-
-void ITMMainEngine::turnOnIntegration() { fusionActive = true; }
-void ITMMainEngine::turnOffIntegration() { fusionActive = false; }
-void ITMMainEngine::turnOnMainProcessing() { mainProcessingActive = true; }
-void ITMMainEngine::turnOffMainProcessing() { mainProcessingActive = false; }
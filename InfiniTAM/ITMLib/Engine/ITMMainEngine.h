@@ -30,8 +30,8 @@ namespace ITMLib
         pose.
 
         The intended use is as follows:
-        -# Create an ITMMainEngine specifying the internal settings,
-           camera parameters and image sizes
+        -# Create an ITMMainEngine with @ref Make() specifying the
+           internal settings, camera parameters and image sizes
         -# Get the pointer to the internally stored images with
            @ref GetView() and write new image information to that
            memory
@@ -42,38 +42,20 @@ namespace ITMLib
         -# Iterate the above three steps for each image in the
            sequence
 
-        To access the internal information, look at the member
-        variables @ref trackingState and @ref scene.
+        The engine is independent of the voxel and index type of the
+        scene, which are selected at runtime by the settings. To access
+        the scene and the engines working on it, cast to the
+        ITMBasicEngine of these types.
     */
     class ITMMainEngine
     {
-    private:
+    protected:
       const ITMLibSettings *settings;
 
-      bool fusionActive, mainProcessingActive;
-
-      ITMLowLevelEngine *lowLevelEngine;
-      IITMVisualisationEngine *visualisationEngine;
-
-      ITMMeshingEngine<ITMVoxel, ITMVoxelIndex> *meshingEngine;
-      ITMMesh *mesh;
-
-      ITMViewBuilder *viewBuilder;
-      ITMDenseMapper<ITMVoxel,ITMVoxelIndex> *denseMapper;
-      ITMTrackingController *trackingController;
-
-      ITMTracker *tracker;
-      ITMIMUCalibrator *imuCalibrator;
-
-      ITMView *view;
-      ITMTrackingState *trackingState;
-
-      ITMScene<ITMVoxel, ITMVoxelIndex> *scene;
-      ITMRenderState *renderState_live;
-      ITMRenderState *renderState_freeview;
-
       double image_time_stamp;
       double pose_time_stamp;
+
+      float lastTrackingTime;
     public:
       enum GetImageType
       {
@@ -91,49 +73,92 @@ namespace ITMLib
       void setPoseTimeStamp(double pose_time_stamp){this->pose_time_stamp=pose_time_stamp;}
       double getPoseTimeStamp(){return pose_time_stamp;}
 
-      /// Gives access to the meshing engine, is needed to get a full mesh.
-      ITMMeshingEngine<ITMVoxel, ITMVoxelIndex> * GetMeshingEngine(void) { return meshingEngine; }
+      /// Gives access to the settings the engine was made with
+      const ITMLibSettings* GetSettings(void) const { return settings; }
 
       /// Gives access to the current input frame
-      ITMView* GetView() { return view; }
+      virtual ITMView* GetView() = 0;
 
       /// Gives access to the current camera pose and additional tracking information
-      ITMTrackingState* GetTrackingState(void) { return trackingState; }
-
-      /// Gives access to the internal world representation
-      ITMScene<ITMVoxel, ITMVoxelIndex>* GetScene(void) { return scene; }
+      virtual ITMTrackingState* GetTrackingState(void) = 0;
 
       /// Process a frame with rgb and depth images and optionally a corresponding imu measurement
-      void ProcessFrame(ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement = NULL);
+      virtual void ProcessFrame(ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement = NULL) = 0;
+
+      /// Wall clock time in milliseconds the tracker took in the last call of ProcessFrame
+      float GetLastTrackingTime(void) const { return lastTrackingTime; }
 
       // Gives access to the data structure used internally to store any created meshes
-      ITMMesh* GetMesh(void) { return mesh; }
+      virtual ITMMesh* GetMesh(void) = 0;
 
       /// Update the internally stored mesh data structure and return a pointer to it
-      ITMMesh* UpdateMesh(void);
+      virtual ITMMesh* UpdateMesh(void) = 0;
 
       /// Extracts a mesh from the current scene and saves it to the obj file specified by the file name
-      void SaveSceneToMesh(const char *objFileName);
+      virtual void SaveSceneToMesh(const char *objFileName) = 0;
+
+      /** Saves the scene to files in the existing directory
+          @p directory, to be loaded with ITMScene::LoadFromDirectory(),
+          e.g. for merging with ITMSceneMerger. Throws
+          std::runtime_error on failure.
+      */
+      virtual void SaveSceneToDirectory(const char *directory) = 0;
+
+      /** Shares the scene with other processes under the POSIX shared
+          memory name @p name, see ITMMapServer. Returns false if the
+          scene cannot be shared, which is the case unless it is a voxel
+          block hash on the CPU.
+      */
+      virtual bool StartMapServer(const char *name) { return false; }
+
+      /** Keeps only the scene within @p radius metres of the camera
+          in memory and pages the rest to tiles in the existing
+          directory @p directory, see ITMTilePager. Tiles already in the
+          directory are loaded as the camera comes near them. Returns
+          false unless the scene is a voxel block hash on the CPU
+          without swapping. Throws std::runtime_error if the tiles do
+          not fit the scene.
+      */
+      virtual bool StartTilePager(const char *directory, float radius) { return false; }
+
+      /** Clears the scene and restarts tracking at the initial pose.
+          Must not be called while read views of the scene are held.
+          Throws std::runtime_error with swapping or while a tile pager
+          is running, whose blocks outside the scene would be kept.
+      */
+      virtual void ResetAll(void) = 0;
 
       /// Get a result image as output
-      Vector2i GetImageSize(void) const;
+      virtual Vector2i GetImageSize(void) const = 0;
 
-      void GetImage(ITMUChar4Image *out, GetImageType getImageType, ITMPose *pose = NULL, ITMIntrinsics *intrinsics = NULL);
+      virtual void GetImage(ITMUChar4Image *out, GetImageType getImageType, ITMPose *pose = NULL, ITMIntrinsics *intrinsics = NULL) = 0;
 
       /// switch for turning intergration on/off
-      void turnOnIntegration();
-      void turnOffIntegration();
+      virtual void turnOnIntegration() = 0;
+      virtual void turnOffIntegration() = 0;
 
       /// switch for turning main processing on/off
-      void turnOnMainProcessing();
-      void turnOffMainProcessing();
+      virtual void turnOnMainProcessing() = 0;
+      virtual void turnOffMainProcessing() = 0;
 
-      /** \brief Constructor
+      /** \brief Makes the engine for the voxel and index type selected in
+          the settings, an ITMBasicEngine<TVoxel,TIndex>.
           Ommitting a separate image size for the depth images
-          will assume same resolution as for the RGB images.
+          will assume same resolution as for the RGB images. Fails if
+          the library is not compiled for the selected pair, see
+          ITMLIB_FOR_EACH_VOXEL_INDEX.
       */
-      ITMMainEngine(const ITMLibSettings *settings, const ITMRGBDCalib *calib, Vector2i imgSize_rgb, Vector2i imgSize_d = Vector2i(-1,-1));
-      ~ITMMainEngine();
+      static ITMMainEngine* Make(const ITMLibSettings *settings, const ITMRGBDCalib *calib, Vector2i imgSize_rgb, Vector2i imgSize_d = Vector2i(-1,-1));
+
+      /** \brief Bytes of the scene and of the mesh of an engine made
+          with @p settings, which are most of its memory. Depends on
+          the voxel and index type and on ITMLibSettings::noVoxelBlocks.
+      */
+      static size_t GetMemorySize(const ITMLibSettings *settings);
+
+      ITMMainEngine(const ITMLibSettings *settings)
+        : settings(settings), image_time_stamp(0.0), pose_time_stamp(0.0), lastTrackingTime(0.0f) { }
+      virtual ~ITMMainEngine(void) { }
     };
   }
 }
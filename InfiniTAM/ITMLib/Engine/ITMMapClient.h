@@ -0,0 +1,177 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "../Utils/ITMLibDefines.h"
+#include "../Objects/ITMSharedMapHeader.h"
+
+#include "DeviceAgnostic/ITMRepresentationAccess.h"
+#include "DeviceAgnostic/ITMVisualisationEngine.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace ITMLib::Objects;
+
+namespace ITMLib
+{
+	namespace Engine
+	{
+		/** \brief
+		    Reads the scene shared by an ITMMapServer in another
+		    process. Header only, so that consumers only need the
+		    ITMLib headers.
+
+		    The shared memory is mapped read only. Every query reads
+		    the scene between two loads of the seqlock of the server
+		    and is repeated if the server updated the scene meanwhile,
+		    so results always come from a single state of the scene.
+		    Queries can be issued from several threads at once.
+		*/
+		template<class TVoxel>
+		class ITMMapClient
+		{
+		private:
+			const ITMSharedMapHeader *header;
+			const ITMHashEntry *entries;
+			const TVoxel *voxelBlocks;
+
+			size_t entriesSize, voxelBlocksSize;
+
+			static const void* MapReadOnly(const char *name, size_t minSize, size_t &size)
+			{
+#ifdef _WIN32
+				return NULL;
+#else
+				int fd = shm_open(name, O_RDONLY, 0);
+				if (fd < 0) return NULL;
+
+				struct stat info;
+				if (fstat(fd, &info) != 0 || (size_t)info.st_size < minSize) { close(fd); return NULL; }
+				size = (size_t)info.st_size;
+
+				void *data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+				close(fd);
+				return data == MAP_FAILED ? NULL : data;
+#endif
+			}
+
+			static void Unmap(const void *data, size_t size)
+			{
+#ifndef _WIN32
+				if (data != NULL) munmap(const_cast<void*>(data), size);
+#endif
+			}
+
+		public:
+			/** Calls @p query with the hash entries and voxel blocks
+			    until the scene did not change while it ran, and returns
+			    its result. @p query must not keep pointers into the
+			    scene, nor act on results before it returns.
+			*/
+			template<class TQuery>
+			auto Read(TQuery query) const -> decltype(query((const ITMHashEntry*)NULL, (const TVoxel*)NULL))
+			{
+				while (true)
+				{
+					unsigned long long sequenceBefore = header->sequence.load(std::memory_order_acquire);
+					if (sequenceBefore & 1) { sched_yield(); continue; }
+
+					auto result = query(entries, voxelBlocks);
+
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if (header->sequence.load(std::memory_order_relaxed) == sequenceBefore) return result;
+				}
+			}
+
+			/// SDF value in [-1, 1] of the voxel at @p voxelPos, 1 if it is not allocated
+			float ReadSDF(const Vector3i &voxelPos, bool &isFound) const
+			{
+				struct Result { float sdf; bool isFound; };
+				Result result = Read([&](const ITMHashEntry *entries, const TVoxel *voxelBlocks) {
+					Result r; r.sdf = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, entries, voxelPos, r.isFound).sdf);
+					return r;
+				});
+				isFound = result.isFound;
+				return result.sdf;
+			}
+
+			/// Trilinearly interpolated SDF value at @p point, in metres
+			float ReadSDFInterpolated(const Vector3f &point, bool &isFound) const
+			{
+				float oneOverVoxelSize = 1.0f / header->voxelSize;
+				struct Result { float sdf; bool isFound; };
+				Result result = Read([&](const ITMHashEntry *entries, const TVoxel *voxelBlocks) {
+					Result r; ITMVoxelBlockHash::IndexCache cache;
+					r.sdf = readFromSDF_float_interpolated(voxelBlocks, entries, point * oneOverVoxelSize, r.isFound, cache);
+					return r;
+				});
+				isFound = result.isFound;
+				return result.sdf;
+			}
+
+			/** Casts the ray through pixel (@p x, @p y) of a camera with
+			    inverse pose @p invM and inverse projection parameters
+			    @p invProjParams (see ITMIntrinsics), over the view
+			    frustum of the scene. @p pt_out is the surface point in
+			    voxel coordinates, as found by the raycast of the server.
+			*/
+			bool CastRay(Vector4f &pt_out, int x, int y, const Matrix4f &invM, const Vector4f &invProjParams) const
+			{
+				float oneOverVoxelSize = 1.0f / header->voxelSize, mu = header->mu;
+				Vector2f viewFrustum_minmax(header->viewFrustum_min, header->viewFrustum_max);
+				Read([&](const ITMHashEntry *entries, const TVoxel *voxelBlocks) {
+					return castRay<TVoxel, ITMVoxelBlockHash>(pt_out, x, y, voxelBlocks, entries, invM, invProjParams, oneOverVoxelSize, mu, viewFrustum_minmax);
+				});
+				return pt_out.w > 0.0f;
+			}
+
+			/// False if the server was not found or shares a scene of another voxel type
+			bool IsOpen(void) const { return voxelBlocks != NULL; }
+
+			const ITMSharedMapHeader* GetHeader(void) const { return header; }
+
+			unsigned long long GetNoFramesIntegrated(void) const { return header->noFramesIntegrated.load(); }
+
+			explicit ITMMapClient(const char *name)
+			{
+				header = NULL; entries = NULL; voxelBlocks = NULL;
+				entriesSize = voxelBlocksSize = 0;
+
+				size_t headerSize;
+				header = (const ITMSharedMapHeader*)MapReadOnly(name, sizeof(ITMSharedMapHeader), headerSize);
+				if (header == NULL) return;
+
+				if (header->magic != ITMSharedMapHeader::magicNumber || header->version != ITMSharedMapHeader::currentVersion ||
+					header->voxelTypeSize != (int)sizeof(TVoxel) || header->hasColorInformation != TVoxel::hasColorInformation ||
+					header->noTotalEntries != ITMVoxelBlockHash::noTotalEntries || header->voxelBlockSize != SDF_BLOCK_SIZE3) return;
+				std::atomic_thread_fence(std::memory_order_acquire);
+
+				char entriesName[256], voxelBlocksName[256];
+				ITMSharedMapHeader::GetEntriesName(entriesName, sizeof(entriesName), name);
+				ITMSharedMapHeader::GetVoxelBlocksName(voxelBlocksName, sizeof(voxelBlocksName), name);
+
+				entries = (const ITMHashEntry*)MapReadOnly(entriesName, header->noTotalEntries * sizeof(ITMHashEntry), entriesSize);
+				if (entries == NULL) return;
+
+				voxelBlocks = (const TVoxel*)MapReadOnly(voxelBlocksName, (size_t)header->noVoxelBlocks * header->voxelBlockSize * sizeof(TVoxel), voxelBlocksSize);
+			}
+
+			~ITMMapClient(void)
+			{
+				Unmap(voxelBlocks, voxelBlocksSize);
+				Unmap(entries, entriesSize);
+				Unmap(header, sizeof(ITMSharedMapHeader));
+			}
+
+			// Suppress the default copy constructor and assignment operator
+			ITMMapClient(const ITMMapClient&);
+			ITMMapClient& operator=(const ITMMapClient&);
+		};
+	}
+}
@@ -0,0 +1,109 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMMapServer.h"
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace ITMLib::Engine;
+
+template<class TVoxel>
+ITMSharedMapHeader* ITMMapServer<TVoxel, ITMVoxelBlockHash>::CreateSharedHeader(const char *name)
+{
+#if defined(_WIN32) || defined(COMPILE_WITH_METAL)
+	return NULL;
+#else
+	int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+	if (fd < 0) return NULL;
+	if (ftruncate(fd, (off_t)sizeof(ITMSharedMapHeader)) != 0) { close(fd); shm_unlink(name); return NULL; }
+
+	void *data = mmap(NULL, sizeof(ITMSharedMapHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) { shm_unlink(name); return NULL; }
+
+	// the atomics are constructed rather than written over, value initialisation zeroes the rest
+	return new (data) ITMSharedMapHeader();
+#endif
+}
+
+template<class TVoxel>
+ITMMapServer<TVoxel, ITMVoxelBlockHash>::ITMMapServer(const char *name, ITMScene<TVoxel, ITMVoxelBlockHash> *scene)
+{
+	isRunning = false;
+	headerName = NULL;
+
+	header = CreateSharedHeader(name);
+	if (header == NULL) return;
+	headerName = strdup(name);
+
+	if (!header->sequence.is_lock_free()) return;
+
+	// magic, sequence and noFramesIntegrated start at 0
+	header->version = ITMSharedMapHeader::currentVersion;
+
+	header->voxelTypeSize = sizeof(TVoxel);
+	header->hasColorInformation = TVoxel::hasColorInformation;
+	header->noTotalEntries = ITMVoxelBlockHash::noTotalEntries;
+	header->noVoxelBlocks = scene->index.getNumAllocatedVoxelBlocks();
+	header->voxelBlockSize = scene->index.getVoxelBlockSize();
+
+	header->voxelSize = scene->sceneParams->voxelSize;
+	header->mu = scene->sceneParams->mu;
+	header->viewFrustum_min = scene->sceneParams->viewFrustum_min;
+	header->viewFrustum_max = scene->sceneParams->viewFrustum_max;
+	header->maxW = scene->sceneParams->maxW;
+
+	char entriesName[256], voxelBlocksName[256];
+	ITMSharedMapHeader::GetEntriesName(entriesName, sizeof(entriesName), name);
+	ITMSharedMapHeader::GetVoxelBlocksName(voxelBlocksName, sizeof(voxelBlocksName), name);
+
+	// moving the scene keeps its content, so a failure leaves it usable in private memory
+	if (!scene->index.MoveToSharedMemory(entriesName)) return;
+	if (!scene->localVBA.MoveToSharedMemory(voxelBlocksName)) return;
+
+	std::atomic_thread_fence(std::memory_order_release);
+	header->magic = ITMSharedMapHeader::magicNumber;
+
+	isRunning = true;
+}
+
+template<class TVoxel>
+ITMMapServer<TVoxel, ITMVoxelBlockHash>::~ITMMapServer(void)
+{
+	if (header == NULL) return;
+
+#ifndef _WIN32
+	header->~ITMSharedMapHeader();
+	munmap(header, sizeof(ITMSharedMapHeader));
+	shm_unlink(headerName);
+#endif
+	free(headerName);
+}
+
+template<class TVoxel>
+void ITMMapServer<TVoxel, ITMVoxelBlockHash>::BeginUpdate(void)
+{
+	if (!isRunning) return;
+
+	std::atomic<unsigned long long> &sequence = header->sequence;
+	sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+template<class TVoxel>
+void ITMMapServer<TVoxel, ITMVoxelBlockHash>::EndUpdate(void)
+{
+	if (!isRunning) return;
+
+	header->noFramesIntegrated.fetch_add(1, std::memory_order_relaxed);
+	header->sequence.store(header->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(ITMLib::Engine::ITMMapServer)
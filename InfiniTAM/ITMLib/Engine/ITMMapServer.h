@@ -0,0 +1,78 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "../Utils/ITMLibDefines.h"
+
+#include "../Objects/ITMScene.h"
+#include "../Objects/ITMSharedMapHeader.h"
+
+using namespace ITMLib::Objects;
+
+namespace ITMLib
+{
+	namespace Engine
+	{
+		/** \brief
+		    Shares the scene with other processes through POSIX shared
+		    memory, to be read with ITMMapClient.
+
+		    The hash entries and voxel blocks of the scene are moved
+		    into shared memory objects, so fusion keeps writing to them
+		    directly and nothing is copied per frame. A header with the
+		    scene parameters, the number of integrated frames and a
+		    seqlock is published next to them. The owner of the scene
+		    calls BeginUpdate() and EndUpdate() around everything that
+		    writes to the scene, i.e. allocation, integration and
+		    swapping.
+
+		    Only the voxel block hash on the CPU is supported. The
+		    shared memory objects of the scene stay until the scene is
+		    deleted, the header is removed with the server.
+		*/
+		template<class TVoxel, class TIndex>
+		class ITMMapServer
+		{
+		public:
+			bool IsRunning(void) const { return false; }
+
+			void BeginUpdate(void) { }
+			void EndUpdate(void) { }
+
+			ITMMapServer(const char *name, ITMScene<TVoxel, TIndex> *scene) { }
+		};
+
+		template<class TVoxel>
+		class ITMMapServer<TVoxel, ITMVoxelBlockHash>
+		{
+		private:
+			/// Constructed in place in the shared memory object @ref headerName, NULL if it could not be mapped
+			ITMSharedMapHeader *header;
+			char *headerName;
+			bool isRunning;
+
+			static ITMSharedMapHeader* CreateSharedHeader(const char *name);
+
+		public:
+			/// False if the shared memory could not be set up, the scene is unchanged then
+			bool IsRunning(void) const { return isRunning; }
+
+			/// Makes the sequence odd, readers retry until EndUpdate()
+			void BeginUpdate(void);
+
+			/// Counts the frame and makes the sequence even again
+			void EndUpdate(void);
+
+			/** Moves the scene to shared memory under @p name, which
+			    has to start with a slash, e.g. "/infinitam_map". Must
+			    be called while nothing else uses the scene.
+			*/
+			ITMMapServer(const char *name, ITMScene<TVoxel, ITMVoxelBlockHash> *scene);
+			~ITMMapServer(void);
+
+			// Suppress the default copy constructor and assignment operator
+			ITMMapServer(const ITMMapServer&);
+			ITMMapServer& operator=(const ITMMapServer&);
+		};
+	}
+}
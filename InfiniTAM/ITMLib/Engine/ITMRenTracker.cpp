@@ -36,17 +36,15 @@ static inline void GetMFromParam(float* pose, Matrix4f& M)
 }
 
 
-static void ComputeSingleStep(float *step, float *ATA, float *ATb, float lambda)
+static void ComputeSingleStep(float *step, float *ATA, float *ATb, float lambda, const ITMTrackerWarmStart *warmStart)
 {
 	float tmpATA[6 * 6];
 	memcpy(tmpATA, ATA, 6 * 6 * sizeof(float));
 	memset(step, 0, 6 * sizeof(float));
 
-	for (int i = 0; i < 6 * 6; i += 7)
-	{
-		float &ele = tmpATA[i];
-		if (!(fabs(ele) < 1e-15f)) ele *= (1.0f + lambda); else ele = lambda*1e-10f;
-	}
+	// Marquardt scaling with the diagonal of the previous frame, unless the parameter is not constrained at all
+	warmStart->AddDamping(tmpATA, ATA, lambda, 0);
+	for (int i = 0; i < 6 * 6; i += 7) if (fabs(ATA[i]) < 1e-15f) tmpATA[i] = lambda*1e-10f;
 
 	ORUtils::Cholesky cholA(tmpATA, 6);
 	cholA.Backsub(step, ATb);
@@ -65,6 +63,9 @@ ITMRenTracker<TVoxel, TIndex>::ITMRenTracker(Vector2i imgSize, TrackerIterationT
 
 	this->lowLevelEngine = lowLevelEngine;
 	this->scene = scene;
+
+	// only the finest level is optimised
+	this->warmStart = new ITMTrackerWarmStart(1, 1000.0f, 1e-2f);
 }
 
 template<class TVoxel, class TIndex>
@@ -73,6 +74,7 @@ ITMRenTracker<TVoxel,TIndex>::~ITMRenTracker(void)
 	delete tempImage1;
 	delete tempImage2;
 	delete viewHierarchy;
+	delete warmStart;
 };
 
 template<class TVoxel, class TIndex>
@@ -108,7 +110,7 @@ void ITMRenTracker<TVoxel,TIndex>::TrackCamera(ITMTrackingState *trackingState,
 	this->PrepareForEvaluation(view);
 
 	// // Carl lm
-	float lastEnergy = 0.0f, currentEnergy = 0.0f, lambda = 1000.0f;
+	float lastEnergy = 0.0f, currentEnergy = 0.0f, lambda = warmStart->GetLambda(0);
 	float step[6]; Matrix4f invM, tmpM;
 
 	bool converged = false;
@@ -131,7 +133,7 @@ void ITMRenTracker<TVoxel,TIndex>::TrackCamera(ITMTrackingState *trackingState,
 
 			while (true)
 			{
-				ComputeSingleStep(step, hessian, nabla, lambda);
+				ComputeSingleStep(step, hessian, nabla, lambda, warmStart);
 
 				// check if step size is very small, if so, converge.
 				float MAXnorm = 0.0;
@@ -157,10 +159,26 @@ void ITMRenTracker<TVoxel,TIndex>::TrackCamera(ITMTrackingState *trackingState,
 		}
 	}
 
+	// a diverged solution keeps the previous pose
+	for (int i = 0; i < 16; i++) if (!(fabs(invM.m[i]) < 1e20f))
+	{
+		trackingState->trackerResult = ITMTrackingState::TRACKING_FAILED;
+		return;
+	}
+
+	// the next frame starts with the damping and Hessian this one finished with
+	warmStart->SetConverged(0, lambda, hessian);
+
 	trackingState->pose_d->SetInvM(invM);
 	trackingState->pose_d->Coerce();
 }
 
+template<class TVoxel, class TIndex>
+void ITMRenTracker<TVoxel,TIndex>::Reset(void)
+{
+	warmStart->Reset();
+}
+
 template<class TVoxel, class TIndex>
 void ITMRenTracker<TVoxel,TIndex>::applyDelta(const ITMPose & para_old, const float *delta, ITMPose & para_new) const
 {
@@ -303,5 +321,5 @@ static inline bool minimizeLM(const ITMRenTracker<TVoxel,TIndex> & tracker, ITMP
 	return true;
 }
 
-template class ITMLib::Engine::ITMRenTracker<ITMVoxel, ITMVoxelIndex>;
+ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(ITMLib::Engine::ITMRenTracker)
 
@@ -9,6 +9,7 @@
 
 #include "../Engine/ITMTracker.h"
 #include "../Engine/ITMLowLevelEngine.h"
+#include "../Engine/ITMTrackerWarmStart.h"
 
 using namespace ITMLib::Objects;
 
@@ -31,6 +32,8 @@ namespace ITMLib
 			const ITMView *view;
 
 			int *noIterationsPerLevel;
+
+			ITMTrackerWarmStart *warmStart;
 			
 			void PrepareForEvaluation(const ITMView *view);
 
@@ -55,6 +58,7 @@ namespace ITMLib
 			int numParameters(void) const { return 6; }
 
 			void TrackCamera(ITMTrackingState *trackingState, const ITMView *view);
+			void Reset(void);
 
 			ITMRenTracker(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, const ITMLowLevelEngine *lowLevelEngine, 
 				const ITMScene<TVoxel, TIndex> *scene, MemoryDeviceType memoryType);
@@ -0,0 +1,277 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMSceneMerger.h"
+#include "DeviceAgnostic/ITMSceneMerger.h"
+#include "DeviceSpecific/CPU/ITMHashTableEditing_CPU.h"
+#include "DeviceSpecific/CPU/ITMSurfacePointExtractor_CPU.h"
+#include "ITMTaskScheduler.h"
+
+#include "../Objects/ITMPose.h"
+#include "../../ORUtils/Cholesky.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace ITMLib::Engine;
+
+// points and blocks per chunk of the loops below, fixed so that the sums do not depend on the number of threads
+static const int noPointsPerChunk = 1024;
+static const int noBlocksPerChunk = 64;
+
+struct SceneAlignmentGH { float g[6]; float h[21]; float f; int noValidPoints; };
+
+static bool isBlockPosLess(const Vector3s &a, const Vector3s &b)
+{
+	if (a.x != b.x) return a.x < b.x;
+	if (a.y != b.y) return a.y < b.y;
+	return a.z < b.z;
+}
+
+/** Samples B at the voxels of the block of A at @p blockPos and fuses
+    the samples into @p voxelBlock. If @p voxelBlock is NULL, only checks
+    whether any voxel of the block would get a sample. Returns whether
+    any did.
+*/
+template<class TVoxel>
+static bool resampleBlock(TVoxel *voxelBlock, const Vector3s &blockPos, const ITMScene<TVoxel, ITMVoxelBlockHash> *sceneA,
+	const ITMScene<TVoxel, ITMVoxelBlockHash> *sceneB, const Matrix4f &M_AtoB, ITMVoxelBlockHash::IndexCache &cache)
+{
+	const TVoxel *voxelDataB = sceneB->localVBA.GetVoxelBlocks();
+	const ITMHashEntry *hashTableB = sceneB->index.GetEntries();
+
+	float voxelSizeA = sceneA->sceneParams->voxelSize;
+	float oneOverVoxelSizeB = 1.0f / sceneB->sceneParams->voxelSize;
+	float sdfScale = sceneB->sceneParams->mu / sceneA->sceneParams->mu;
+	int maxW = sceneA->sceneParams->maxW;
+
+	Vector3i globalPos = blockPos.toInt() * SDF_BLOCK_SIZE;
+	bool hasSamples = false;
+
+	for (int z = 0; z < SDF_BLOCK_SIZE; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+	{
+		Vector4f pt_A((globalPos + Vector3i(x, y, z)).toFloat() * voxelSizeA, 1.0f);
+		Vector4f pt_B = M_AtoB * pt_A;
+
+		TVoxel cell[8]; Vector3f coeff;
+		if (!readObservedCell(cell, coeff, voxelDataB, hashTableB, pt_B.toVector3() * oneOverVoxelSizeB, cache)) continue;
+
+		if (voxelBlock == NULL) return true;
+
+		int locId = x + y * SDF_BLOCK_SIZE + z * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
+		FuseResampledVoxel<TVoxel::hasColorInformation, TVoxel>::compute(voxelBlock[locId], cell, coeff, sdfScale, maxW);
+		hasSamples = true;
+	}
+
+	return hasSamples;
+}
+
+template<class TVoxel>
+ITMSceneMerger<TVoxel, ITMVoxelBlockHash>::ITMSceneMerger(void)
+{
+	pointExtractor = new ITMSurfacePointExtractor_CPU<TVoxel, ITMVoxelBlockHash>();
+	points = new ITMSurfacePoints(MEMORYDEVICE_CPU);
+
+	maxNoIterations = 30;
+	minStepLength = 1e-6f;
+
+	noAlignedPoints = 0; alignmentRMS = 0.0f;
+	noBlocksMerged = noBlocksAllocated = noBlocksDropped = 0;
+}
+
+template<class TVoxel>
+ITMSceneMerger<TVoxel, ITMVoxelBlockHash>::~ITMSceneMerger(void)
+{
+	delete points;
+	delete pointExtractor;
+}
+
+template<class TVoxel>
+Matrix4f ITMSceneMerger<TVoxel, ITMVoxelBlockHash>::EstimateTransform(const ITMScene<TVoxel, ITMVoxelBlockHash> *sceneA,
+	const ITMScene<TVoxel, ITMVoxelBlockHash> *sceneB, const Matrix4f &initialGuess)
+{
+	pointExtractor->ExtractPoints(points, sceneB);
+
+	const Vector4f *pointData = points->points->GetData(MEMORYDEVICE_CPU);
+	int noTotalPoints = (int)points->noTotalPoints;
+
+	const TVoxel *voxelDataA = sceneA->localVBA.GetVoxelBlocks();
+	const ITMHashEntry *hashTableA = sceneA->index.GetEntries();
+	float oneOverVoxelSize = 1.0f / sceneA->sceneParams->voxelSize, mu = sceneA->sceneParams->mu;
+
+	// residuals beyond one voxel are down-weighted (Huber), they are mostly parts of B that A has not seen alike
+	float huberDelta = sceneA->sceneParams->voxelSize;
+
+	ITMPose pose(initialGuess);
+	noAlignedPoints = 0; alignmentRMS = 0.0f;
+
+	SceneAlignmentGH zero;
+	for (int i = 0; i < 6; i++) zero.g[i] = 0.0f;
+	for (int i = 0; i < 21; i++) zero.h[i] = 0.0f;
+	zero.f = 0.0f; zero.noValidPoints = 0;
+
+	for (int iterNo = 0; iterNo < maxNoIterations; iterNo++)
+	{
+		Matrix4f M = pose.GetM();
+
+		SceneAlignmentGH sum = ITMTaskScheduler::GetDefault().ParallelReduce(0, noTotalPoints, noPointsPerChunk, zero,
+			[&](int begin, int end, SceneAlignmentGH &partial)
+			{
+				ITMVoxelBlockHash::IndexCache cache;
+
+				for (int pointId = begin; pointId < end; pointId++)
+				{
+					Vector3f point_A = (M * Vector4f(pointData[pointId].toVector3(), 1.0f)).toVector3();
+
+					float residual, jacobian[6];
+					if (!computeSDFAlignmentTerm(residual, jacobian, point_A, voxelDataA, hashTableA, oneOverVoxelSize, mu, cache)) continue;
+
+					float weight = fabs(residual) <= huberDelta ? 1.0f : huberDelta / fabs(residual);
+
+					for (int r = 0, counter = 0; r < 6; r++)
+					{
+						partial.g[r] += weight * jacobian[r] * residual;
+						for (int c = 0; c <= r; c++, counter++) partial.h[counter] += weight * jacobian[r] * jacobian[c];
+					}
+
+					partial.f += residual * residual;
+					partial.noValidPoints++;
+				}
+			},
+			[](SceneAlignmentGH &result, const SceneAlignmentGH &partial)
+			{
+				for (int i = 0; i < 6; i++) result.g[i] += partial.g[i];
+				for (int i = 0; i < 21; i++) result.h[i] += partial.h[i];
+				result.f += partial.f; result.noValidPoints += partial.noValidPoints;
+			});
+
+		noAlignedPoints = sum.noValidPoints;
+		if (noAlignedPoints < 100) break;
+		alignmentRMS = sqrt(sum.f / noAlignedPoints);
+
+		float hessian[6 * 6], step[6];
+		for (int r = 0, counter = 0; r < 6; r++) for (int c = 0; c <= r; c++, counter++)
+			hessian[r + c * 6] = hessian[c + r * 6] = sum.h[counter];
+
+		ORUtils::Cholesky cholA(hessian, 6);
+		cholA.Backsub(step, sum.g);
+
+		// rotation (small angle) and translation, applied on the left
+		Matrix4f Tinc;
+		Tinc.m00 = 1.0f;		Tinc.m10 = step[2];		Tinc.m20 = -step[1];	Tinc.m30 = -step[3];
+		Tinc.m01 = -step[2];	Tinc.m11 = 1.0f;		Tinc.m21 = step[0];		Tinc.m31 = -step[4];
+		Tinc.m02 = step[1];		Tinc.m12 = -step[0];	Tinc.m22 = 1.0f;		Tinc.m32 = -step[5];
+		Tinc.m03 = 0.0f;		Tinc.m13 = 0.0f;		Tinc.m23 = 0.0f;		Tinc.m33 = 1.0f;
+
+		pose.SetM(Tinc * M);
+		pose.Coerce();
+
+		float stepLength = 0.0f;
+		for (int i = 0; i < 6; i++) stepLength += step[i] * step[i];
+		if (sqrt(stepLength) < minStepLength) break;
+	}
+
+	return noAlignedPoints < 100 ? initialGuess : pose.GetM();
+}
+
+template<class TVoxel>
+void ITMSceneMerger<TVoxel, ITMVoxelBlockHash>::MergeInto(ITMScene<TVoxel, ITMVoxelBlockHash> *sceneA,
+	const ITMScene<TVoxel, ITMVoxelBlockHash> *sceneB, const Matrix4f &M_BtoA)
+{
+	const ITMHashEntry *hashTableB = sceneB->index.GetEntries();
+	int noTotalEntriesB = sceneB->index.noTotalEntries;
+
+	float voxelSizeB = sceneB->sceneParams->voxelSize;
+	float oneOverBlockSizeA = 1.0f / (sceneA->sceneParams->voxelSize * SDF_BLOCK_SIZE);
+
+	Matrix4f M_AtoB; M_BtoA.inv(M_AtoB);
+
+	// blocks of A covered by the bounding boxes of the blocks of B, moved into A
+	const int noEntriesPerChunk = 4096;
+	int noChunks = (noTotalEntriesB + noEntriesPerChunk - 1) / noEntriesPerChunk;
+	std::vector<std::vector<Vector3s> > chunkBlocks(noChunks);
+
+	ITMTaskScheduler::GetDefault().ParallelFor(0, noChunks, [&](int chunkId)
+	{
+		std::vector<Vector3s> &dest = chunkBlocks[chunkId];
+
+		int entryEnd = MIN((chunkId + 1) * noEntriesPerChunk, noTotalEntriesB);
+		for (int entryId = chunkId * noEntriesPerChunk; entryId < entryEnd; entryId++)
+		{
+			const ITMHashEntry &hashEntryB = hashTableB[entryId];
+			if (hashEntryB.ptr < 0) continue;
+
+			// a block reaches up to the first voxel of its neighbours when interpolating
+			Vector3f blockMin(1e10f), blockMax(-1e10f);
+			for (int cornerId = 0; cornerId < 8; cornerId++)
+			{
+				Vector3i corner = (hashEntryB.pos.toInt() + Vector3i(cornerId & 1, (cornerId >> 1) & 1, (cornerId >> 2) & 1)) * SDF_BLOCK_SIZE;
+				Vector3f corner_A = (M_BtoA * Vector4f(corner.toFloat() * voxelSizeB, 1.0f)).toVector3() * oneOverBlockSizeA;
+
+				blockMin.x = MIN(blockMin.x, corner_A.x); blockMin.y = MIN(blockMin.y, corner_A.y); blockMin.z = MIN(blockMin.z, corner_A.z);
+				blockMax.x = MAX(blockMax.x, corner_A.x); blockMax.y = MAX(blockMax.y, corner_A.y); blockMax.z = MAX(blockMax.z, corner_A.z);
+			}
+
+			Vector3i minBlock((int)floor(blockMin.x), (int)floor(blockMin.y), (int)floor(blockMin.z));
+			Vector3i maxBlock((int)floor(blockMax.x), (int)floor(blockMax.y), (int)floor(blockMax.z));
+
+			for (int z = minBlock.z; z <= maxBlock.z; z++) for (int y = minBlock.y; y <= maxBlock.y; y++) for (int x = minBlock.x; x <= maxBlock.x; x++)
+				dest.push_back(Vector3s((short)x, (short)y, (short)z));
+		}
+	}, 1);
+
+	std::vector<Vector3s> candidateBlocks;
+	for (int chunkId = 0; chunkId < noChunks; chunkId++)
+		candidateBlocks.insert(candidateBlocks.end(), chunkBlocks[chunkId].begin(), chunkBlocks[chunkId].end());
+
+	std::sort(candidateBlocks.begin(), candidateBlocks.end(), isBlockPosLess);
+	candidateBlocks.erase(std::unique(candidateBlocks.begin(), candidateBlocks.end(),
+		[](const Vector3s &a, const Vector3s &b) { return IS_EQUAL3(a, b); }), candidateBlocks.end());
+
+	int noCandidateBlocks = (int)candidateBlocks.size();
+
+	// find the blocks that exist in A, and which of the others would receive samples
+	std::vector<int> blockPtrs(noCandidateBlocks);
+	std::vector<char> needsAllocation(noCandidateBlocks, 0);
+	const ITMHashEntry *hashTableA = sceneA->index.GetEntries();
+
+	ITMTaskScheduler::GetDefault().ParallelFor(0, noCandidateBlocks, [&](int blockId)
+	{
+		ITMVoxelBlockHash::IndexCache cache;
+
+		int hashIdx = findHashEntry_CPU(hashTableA, candidateBlocks[blockId]);
+		blockPtrs[blockId] = hashIdx >= 0 ? hashTableA[hashIdx].ptr : -2;
+		if (hashIdx < 0)
+			needsAllocation[blockId] = resampleBlock<TVoxel>(NULL, candidateBlocks[blockId], sceneA, sceneB, M_AtoB, cache);
+	}, noBlocksPerChunk);
+
+	// allocation changes the hash table, in the order of the candidates so that the result is deterministic
+	noBlocksAllocated = noBlocksDropped = 0;
+	for (int blockId = 0; blockId < noCandidateBlocks; blockId++)
+	{
+		if (!needsAllocation[blockId]) continue;
+
+		int hashIdx = allocateVoxelBlock_CPU(sceneA, candidateBlocks[blockId]);
+		if (hashIdx >= 0) { blockPtrs[blockId] = sceneA->index.GetEntries()[hashIdx].ptr; noBlocksAllocated++; }
+		else noBlocksDropped++;
+	}
+
+	// resample and fuse, every block of A is written by one task only
+	TVoxel *voxelDataA = sceneA->localVBA.GetVoxelBlocks();
+
+	noBlocksMerged = ITMTaskScheduler::GetDefault().ParallelReduce(0, noCandidateBlocks, noBlocksPerChunk, 0,
+		[&](int begin, int end, int &partial)
+		{
+			ITMVoxelBlockHash::IndexCache cache;
+
+			for (int blockId = begin; blockId < end; blockId++)
+			{
+				if (blockPtrs[blockId] < 0) continue;
+
+				TVoxel *voxelBlock = voxelDataA + blockPtrs[blockId] * SDF_BLOCK_SIZE3;
+				if (resampleBlock(voxelBlock, candidateBlocks[blockId], sceneA, sceneB, M_AtoB, cache)) partial++;
+			}
+		},
+		[](int &result, const int &partial) { result += partial; });
+}
+
+ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(ITMLib::Engine::ITMSceneMerger)
@@ -0,0 +1,92 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "../Utils/ITMLibDefines.h"
+
+#include "../Objects/ITMScene.h"
+#include "../Objects/ITMSurfacePoints.h"
+#include "ITMSurfacePointExtractor.h"
+
+using namespace ITMLib::Objects;
+
+namespace ITMLib
+{
+	namespace Engine
+	{
+		/** \brief
+		    Combines two scenes that were mapped in separate sessions,
+		    e.g. after loading them with ITMScene::LoadFromDirectory().
+
+		    EstimateTransform() aligns the surface points of scene B
+		    with the SDF of scene A by Gauss-Newton, starting from a
+		    guess that has to bring the scenes to within about the
+		    truncation band of each other. MergeInto() then resamples B
+		    into the grid of A and fuses it into A by weight averaging,
+		    as if the frames of B had been integrated into A.
+
+		    Only the voxel block hash on the CPU is supported, and only
+		    blocks in the active memory of both scenes take part, so
+		    scenes mapped with swapping should be loaded without it.
+		*/
+		template<class TVoxel, class TIndex>
+		class ITMSceneMerger
+		{};
+
+		template<class TVoxel>
+		class ITMSceneMerger<TVoxel, ITMVoxelBlockHash>
+		{
+		private:
+			ITMSurfacePointExtractor<TVoxel, ITMVoxelBlockHash> *pointExtractor;
+			ITMSurfacePoints *points;
+
+			int maxNoIterations;
+			float minStepLength;
+
+			int noAlignedPoints;
+			float alignmentRMS;
+
+			int noBlocksMerged, noBlocksAllocated, noBlocksDropped;
+
+		public:
+			/// Stops the alignment after @p maxNoIterations Gauss-Newton steps
+			void SetMaxNoIterations(int maxNoIterations) { this->maxNoIterations = maxNoIterations; }
+
+			/// Only aligns surface points between voxels with at least @p minWeight observations
+			void SetMinimumWeight(int minWeight) { pointExtractor->SetMinimumWeight(minWeight); }
+
+			/** Refines @p initialGuess, the transform from the
+			    coordinates of scene B to those of scene A, and returns
+			    it. The result is @p initialGuess if too few points of B
+			    fall into the observed part of A.
+			*/
+			Matrix4f EstimateTransform(const ITMScene<TVoxel, ITMVoxelBlockHash> *sceneA, const ITMScene<TVoxel, ITMVoxelBlockHash> *sceneB,
+				const Matrix4f &initialGuess);
+
+			/** Fuses scene B, moved into scene A by @p M_BtoA, into
+			    scene A. Blocks of A that B covers are allocated, until
+			    A runs out of blocks or hash entries.
+			*/
+			void MergeInto(ITMScene<TVoxel, ITMVoxelBlockHash> *sceneA, const ITMScene<TVoxel, ITMVoxelBlockHash> *sceneB, const Matrix4f &M_BtoA);
+
+			/// Number of points of B used in the last iteration of EstimateTransform()
+			int GetNoAlignedPoints(void) const { return noAlignedPoints; }
+			/// Root mean square SDF of A at these points, in metres
+			float GetAlignmentRMS(void) const { return alignmentRMS; }
+
+			/// Blocks of A that received samples of B in the last MergeInto()
+			int GetNoBlocksMerged(void) const { return noBlocksMerged; }
+			/// Of these, blocks that had to be allocated
+			int GetNoBlocksAllocated(void) const { return noBlocksAllocated; }
+			/// Blocks of A that would have received samples but could not be allocated
+			int GetNoBlocksDropped(void) const { return noBlocksDropped; }
+
+			ITMSceneMerger(void);
+			~ITMSceneMerger(void);
+
+			// Suppress the default copy constructor and assignment operator
+			ITMSceneMerger(const ITMSceneMerger&);
+			ITMSceneMerger& operator=(const ITMSceneMerger&);
+		};
+	}
+}
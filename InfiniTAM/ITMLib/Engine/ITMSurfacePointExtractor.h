@@ -0,0 +1,48 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "../Utils/ITMLibDefines.h"
+
+#include "../Objects/ITMScene.h"
+#include "../Objects/ITMSurfacePoints.h"
+
+using namespace ITMLib::Objects;
+
+namespace ITMLib
+{
+	namespace Engine
+	{
+		/** \brief
+		    Extracts the surface of a scene as points with normals,
+		    without building a mesh.
+
+		    One point is emitted on every voxel edge whose end points
+		    have different signs, at the zero crossing of the linearly
+		    interpolated SDF. These are the vertices marching cubes
+		    would produce, without the triangles and without
+		    duplicates.
+		*/
+		template<class TVoxel, class TIndex>
+		class ITMSurfacePointExtractor
+		{
+		protected:
+			int minWeight;
+			bool useROI;
+			Vector3f roiMin, roiMax;
+
+		public:
+			virtual void ExtractPoints(ITMSurfacePoints *points, const ITMScene<TVoxel,TIndex> *scene) = 0;
+
+			/// Only keeps points between voxels with at least @p minWeight observations, 0 keeps all
+			void SetMinimumWeight(int minWeight) { this->minWeight = minWeight; }
+
+			/// Only keeps points inside the axis-aligned box [roiMin, roiMax], in metres
+			void SetROI(const Vector3f &roiMin, const Vector3f &roiMax) { useROI = true; this->roiMin = roiMin; this->roiMax = roiMax; }
+			void ClearROI(void) { useROI = false; }
+
+			ITMSurfacePointExtractor(void) : minWeight(0), useROI(false), roiMin(0.0f), roiMax(0.0f) { }
+			virtual ~ITMSurfacePointExtractor(void) { }
+		};
+	}
+}
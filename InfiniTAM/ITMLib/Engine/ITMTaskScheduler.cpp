@@ -0,0 +1,383 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMTaskScheduler.h"
+
+#include <iterator>
+#include <memory>
+#include <stdio.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+using namespace ITMLib::Engine;
+
+// index of the worker queue owned by the current thread, -1 for threads outside any pool
+static thread_local ITMTaskScheduler *currentScheduler = NULL;
+static thread_local int currentWorkerId = -1;
+
+// pool set by ITMTaskScheduler::Binding on threads outside any pool
+static thread_local ITMTaskScheduler *boundScheduler = NULL;
+
+ITMTaskScheduler::ITMTaskScheduler(int noThreads, int firstCore, bool numaAware)
+	: noQueuedTasks(0), nextQueue(0), shutdown(false)
+{
+	if (noThreads <= 0) noThreads = (int)std::thread::hardware_concurrency();
+	if (noThreads <= 0) noThreads = 1;
+	this->noThreads = noThreads;
+
+	// every node needs at least one worker, otherwise tasks bound to it would never run
+	std::vector<std::vector<int> > nodeCores;
+	if (numaAware) nodeCores = GetNUMANodeCores();
+	noNodes = (int)nodeCores.size() < noThreads - 1 ? (int)nodeCores.size() : noThreads - 1;
+	if (noNodes < 2) noNodes = 1;
+
+	// queue 0 takes tasks spawned from outside the pool, it is served by all workers through stealing
+	for (int i = 0; i < noThreads; i++) queues.push_back(new WorkQueue());
+
+	// the calling thread is not bound to any node when the pool is NUMA aware
+	nodeOfQueue.assign(noThreads, 0);
+	queuesOfNode.resize(noNodes);
+	if (noNodes > 1) nodeOfQueue[0] = -1;
+	else queuesOfNode[0].push_back(0);
+
+	std::vector<int> pinToCore(noThreads, -1);
+	for (int workerId = 1; workerId < noThreads; workerId++)
+	{
+		if (noNodes > 1)
+		{
+			int node = (workerId - 1) * noNodes / (noThreads - 1);
+			const std::vector<int> &cores = nodeCores[node];
+
+			nodeOfQueue[workerId] = node;
+			pinToCore[workerId] = cores[queuesOfNode[node].size() % cores.size()];
+		}
+		else if (firstCore >= 0) pinToCore[workerId] = firstCore + workerId;
+
+		queuesOfNode[nodeOfQueue[workerId]].push_back(workerId);
+	}
+
+	// the calling thread is not pinned, it may be any thread of the application
+	for (int workerId = 1; workerId < noThreads; workerId++)
+		workers.push_back(std::thread(&ITMTaskScheduler::WorkerLoop, this, workerId, pinToCore[workerId]));
+}
+
+ITMTaskScheduler::~ITMTaskScheduler(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		shutdown = true;
+	}
+	wakeUp.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+	for (size_t i = 0; i < queues.size(); i++) delete queues[i];
+}
+
+void ITMTaskScheduler::PinCurrentThread(int core)
+{
+	int noCores = (int)std::thread::hardware_concurrency();
+	if (noCores > 0) core = core % noCores;
+
+#if defined(__linux__)
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	CPU_SET(core, &cpuSet);
+	pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+#elif defined(_WIN32)
+	SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core);
+#endif
+}
+
+std::vector<std::vector<int> > ITMTaskScheduler::GetNUMANodeCores(void)
+{
+	std::vector<std::vector<int> > nodeCores;
+
+#if defined(__linux__)
+	// node ids can have gaps, nodes without cores only hold memory and are skipped
+	for (int nodeId = 0; nodeId < 256; nodeId++)
+	{
+		char fileName[64];
+		sprintf(fileName, "/sys/devices/system/node/node%d/cpulist", nodeId);
+
+		FILE *f = fopen(fileName, "r");
+		if (f == NULL) continue;
+
+		std::vector<int> cores;
+		int first, last;
+		while (fscanf(f, "%d", &first) == 1)
+		{
+			last = first;
+			int separator = fgetc(f);
+			if (separator == '-') { if (fscanf(f, "%d", &last) != 1) break; separator = fgetc(f); }
+			for (int core = first; core <= last; core++) cores.push_back(core);
+			if (separator != ',') break;
+		}
+		fclose(f);
+
+		if (!cores.empty()) nodeCores.push_back(cores);
+	}
+#endif
+
+	return nodeCores;
+}
+
+void ITMTaskScheduler::DiscardPages(void *ptr, size_t size)
+{
+#if defined(__linux__)
+	size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+
+	// only whole pages inside the range may be dropped
+	size_t begin = ((size_t)ptr + pageSize - 1) / pageSize * pageSize;
+	size_t end = ((size_t)ptr + size) / pageSize * pageSize;
+	if (end > begin) madvise((void*)begin, end - begin, MADV_DONTNEED);
+#endif
+}
+
+int ITMTaskScheduler::GetQueueForCurrentThread(void) const
+{
+	if (currentScheduler == this) return currentWorkerId;
+	return 0;
+}
+
+void ITMTaskScheduler::PushTask(int queueId, const Task &task)
+{
+	{
+		std::lock_guard<std::mutex> lock(queues[queueId]->mutex);
+		queues[queueId]->tasks.push_front(task);
+	}
+
+	noQueuedTasks++;
+	if (!workers.empty())
+	{
+		// take the lock so that a worker about to sleep cannot miss the notification
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+
+	// a single woken worker might not be allowed to run a task bound to a node
+	if (task.node < 0) wakeUp.notify_one();
+	else wakeUp.notify_all();
+}
+
+void ITMTaskScheduler::Spawn(TaskGroup &group, const std::function<void()> &function)
+{
+	Task task;
+	task.function = function;
+	task.group = &group;
+	task.node = -1;
+
+	group.noPendingTasks++;
+	PushTask(GetQueueForCurrentThread(), task);
+}
+
+void ITMTaskScheduler::SpawnOnNode(TaskGroup &group, int node, const std::function<void()> &function)
+{
+	if (noNodes == 1) { Spawn(group, function); return; }
+
+	Task task;
+	task.function = function;
+	task.group = &group;
+	task.node = node % noNodes;
+
+	group.noPendingTasks++;
+
+	// stay on the own queue if possible, otherwise spread over the workers of the node
+	int queueId = GetQueueForCurrentThread();
+	if (nodeOfQueue[queueId] != task.node)
+	{
+		const std::vector<int> &nodeQueues = queuesOfNode[task.node];
+		queueId = nodeQueues[nextQueue++ % nodeQueues.size()];
+	}
+
+	PushTask(queueId, task);
+}
+
+bool ITMTaskScheduler::PopTask(int queueId, Task &task)
+{
+	WorkQueue *queue = queues[queueId];
+	std::lock_guard<std::mutex> lock(queue->mutex);
+	if (queue->tasks.empty()) return false;
+
+	task = queue->tasks.front();
+	queue->tasks.pop_front();
+	noQueuedTasks--;
+	return true;
+}
+
+bool ITMTaskScheduler::StealTask(int thiefId, Task &task)
+{
+	int thiefNode = nodeOfQueue[thiefId];
+
+	// victims on the own node first, then the others; tasks bound to another node are left alone
+	for (int pass = 0; pass < (noNodes > 1 ? 2 : 1); pass++) for (int offset = 1; offset < noThreads; offset++)
+	{
+		int victimId = (thiefId + offset) % noThreads;
+		if (noNodes > 1 && (pass == 0) != (nodeOfQueue[victimId] == thiefNode)) continue;
+
+		WorkQueue *queue = queues[victimId];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+
+		for (std::deque<Task>::reverse_iterator it = queue->tasks.rbegin(); it != queue->tasks.rend(); ++it)
+		{
+			if (it->node >= 0 && it->node != thiefNode) continue;
+
+			task = *it;
+			queue->tasks.erase(std::next(it).base());
+			noQueuedTasks--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ITMTaskScheduler::RunTask(Task &task)
+{
+	task.function();
+	task.group->noPendingTasks--;
+}
+
+bool ITMTaskScheduler::RunPendingTask(void)
+{
+	if (noQueuedTasks.load() == 0) return false;
+
+	int queueId = GetQueueForCurrentThread();
+
+	Task task;
+	if (PopTask(queueId, task) || StealTask(queueId, task))
+	{
+		RunTask(task);
+		return true;
+	}
+
+	return false;
+}
+
+void ITMTaskScheduler::Wait(TaskGroup &group)
+{
+	while (group.noPendingTasks.load() > 0)
+	{
+		if (!RunPendingTask()) std::this_thread::yield();
+	}
+}
+
+void ITMTaskScheduler::WorkerLoop(int workerId, int pinToCore)
+{
+	currentScheduler = this;
+	currentWorkerId = workerId;
+
+	if (pinToCore >= 0) PinCurrentThread(pinToCore);
+
+	while (true)
+	{
+		if (RunPendingTask()) continue;
+
+		// the queued tasks are bound to other nodes
+		if (noQueuedTasks.load() > 0) { std::this_thread::yield(); continue; }
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wakeUp.wait(lock, [this]() { return shutdown || noQueuedTasks.load() > 0; });
+		if (shutdown) break;
+	}
+}
+
+static std::mutex defaultSchedulerMutex;
+static std::unique_ptr<ITMTaskScheduler> defaultScheduler;
+static int defaultNoThreads = 0, defaultFirstCore = -1;
+static bool defaultNUMAAware = false;
+
+void ITMTaskScheduler::ConfigureDefault(int noThreads, int firstCore, bool numaAware)
+{
+	std::lock_guard<std::mutex> lock(defaultSchedulerMutex);
+
+	// engines and tile pagers keep references to the pool, so once it exists it is never replaced
+	if (defaultScheduler)
+	{
+		if (noThreads != defaultNoThreads || firstCore != defaultFirstCore || numaAware != defaultNUMAAware)
+			fprintf(stderr, "task scheduler: the default pool is already running, its configuration is kept\n");
+		return;
+	}
+
+	defaultNoThreads = noThreads;
+	defaultFirstCore = firstCore;
+	defaultNUMAAware = numaAware;
+}
+
+ITMTaskScheduler& ITMTaskScheduler::GetDefault(void)
+{
+	if (currentScheduler != NULL) return *currentScheduler;
+	if (boundScheduler != NULL) return *boundScheduler;
+
+	std::lock_guard<std::mutex> lock(defaultSchedulerMutex);
+
+	if (!defaultScheduler) defaultScheduler.reset(new ITMTaskScheduler(defaultNoThreads, defaultFirstCore, defaultNUMAAware));
+	return *defaultScheduler;
+}
+
+ITMTaskScheduler* ITMTaskScheduler::GetBound(void)
+{
+	return boundScheduler;
+}
+
+ITMTaskScheduler::Binding::Binding(ITMTaskScheduler *scheduler)
+{
+	previous = boundScheduler;
+	if (scheduler != NULL) boundScheduler = scheduler;
+}
+
+ITMTaskScheduler::Binding::~Binding(void)
+{
+	boundScheduler = previous;
+}
+
+ITMTaskGraph::~ITMTaskGraph(void)
+{
+	for (size_t i = 0; i < nodes.size(); i++) delete nodes[i];
+}
+
+int ITMTaskGraph::AddTask(const std::function<void()> &function)
+{
+	Node *node = new Node();
+	node->function = function;
+	node->noDependencies = 0;
+	node->noUnfinishedDependencies = 0;
+
+	nodes.push_back(node);
+	return (int)nodes.size() - 1;
+}
+
+void ITMTaskGraph::AddDependency(int before, int after)
+{
+	nodes[before]->successors.push_back(after);
+	nodes[after]->noDependencies++;
+}
+
+void ITMTaskGraph::SpawnNode(ITMTaskScheduler &scheduler, ITMTaskScheduler::TaskGroup &group, int nodeId)
+{
+	scheduler.Spawn(group, [this, &scheduler, &group, nodeId]() {
+		Node *node = nodes[nodeId];
+		node->function();
+
+		for (size_t i = 0; i < node->successors.size(); i++)
+		{
+			int successorId = node->successors[i];
+			if (--nodes[successorId]->noUnfinishedDependencies == 0) SpawnNode(scheduler, group, successorId);
+		}
+	});
+}
+
+void ITMTaskGraph::Run(ITMTaskScheduler &scheduler)
+{
+	for (size_t i = 0; i < nodes.size(); i++) nodes[i]->noUnfinishedDependencies = nodes[i]->noDependencies;
+
+	ITMTaskScheduler::TaskGroup group;
+	for (size_t i = 0; i < nodes.size(); i++)
+		if (nodes[i]->noDependencies == 0) SpawnNode(scheduler, group, (int)i);
+
+	scheduler.Wait(group);
+}
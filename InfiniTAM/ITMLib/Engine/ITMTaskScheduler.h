@@ -0,0 +1,258 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ITMLib
+{
+	namespace Engine
+	{
+		/** \brief
+		    Work-stealing thread pool used by the CPU engines.
+
+		    Each worker owns a task deque. It takes work from the front
+		    of its own deque and, when that is empty, steals from the
+		    back of the others. A thread waiting for tasks it spawned
+		    keeps executing queued tasks instead of blocking, so parallel
+		    loops can be nested and stages can be run concurrently from
+		    inside a task.
+
+		    With a single thread everything runs inline on the caller.
+
+		    If the pool is NUMA aware, the workers are spread evenly over
+		    the NUMA nodes and pinned to their cores. Tasks can then be
+		    bound to a node with @ref SpawnOnNode; they are only executed
+		    by workers of that node, which is what lets data be placed
+		    on, and processed by, the same node.
+		*/
+		class ITMTaskScheduler
+		{
+		public:
+			/// Tracks completion of a set of tasks spawned with @ref Spawn.
+			class TaskGroup
+			{
+				friend class ITMTaskScheduler;
+				std::atomic<int> noPendingTasks;
+
+			public:
+				TaskGroup(void) : noPendingTasks(0) { }
+			};
+
+			/** Makes @ref GetDefault return @p scheduler on the calling
+			    thread for the lifetime of the binding, so that engines
+			    sharing a process can each run on their own pool. A NULL
+			    scheduler leaves the current binding as it is.
+			*/
+			class Binding
+			{
+				ITMTaskScheduler *previous;
+
+			public:
+				explicit Binding(ITMTaskScheduler *scheduler);
+				~Binding(void);
+
+				// Suppress the default copy constructor and assignment operator
+				Binding(const Binding&);
+				Binding& operator=(const Binding&);
+			};
+
+		private:
+			struct Task
+			{
+				std::function<void()> function;
+				TaskGroup *group;
+				int node;
+			};
+
+			struct WorkQueue
+			{
+				std::mutex mutex;
+				std::deque<Task> tasks;
+			};
+
+			int noThreads, noNodes;
+			std::vector<std::thread> workers;
+			std::vector<WorkQueue*> queues;
+			std::vector<int> nodeOfQueue;
+			std::vector<std::vector<int> > queuesOfNode;
+
+			std::atomic<int> noQueuedTasks;
+			std::atomic<unsigned int> nextQueue;
+			std::mutex sleepMutex;
+			std::condition_variable wakeUp;
+			bool shutdown;
+
+			int GetQueueForCurrentThread(void) const;
+			void PushTask(int queueId, const Task &task);
+			bool PopTask(int queueId, Task &task);
+			bool StealTask(int thiefId, Task &task);
+			void RunTask(Task &task);
+			void WorkerLoop(int workerId, int pinToCore);
+
+			static void PinCurrentThread(int core);
+			static std::vector<std::vector<int> > GetNUMANodeCores(void);
+
+		public:
+			/** Creates the pool. @p noThreads counts the calling thread, so
+			    noThreads - 1 workers are started; 0 or less uses one thread
+			    per hardware core. If @p firstCore is not negative, worker i
+			    is pinned to core firstCore + i, which keeps the pool off the
+			    cores of co-located processes; the calling thread is never
+			    pinned. With @p numaAware the workers are pinned node by node
+			    instead and @p firstCore is ignored.
+			*/
+			explicit ITMTaskScheduler(int noThreads = 0, int firstCore = -1, bool numaAware = false);
+			~ITMTaskScheduler(void);
+
+			int GetNumThreads(void) const { return noThreads; }
+
+			/// Number of NUMA nodes that have workers, 1 unless the pool is NUMA aware.
+			int GetNumNodes(void) const { return noNodes; }
+
+			/// Queues @p function as part of @p group.
+			void Spawn(TaskGroup &group, const std::function<void()> &function);
+
+			/// Queues @p function as part of @p group, to be run by a worker of NUMA node @p node.
+			void SpawnOnNode(TaskGroup &group, int node, const std::function<void()> &function);
+
+			/** Drops the physical pages backing [ptr, ptr + size) on systems
+			    that support it, so that they are placed again on the NUMA
+			    node of the thread that first writes them. The content of
+			    the range is lost.
+			*/
+			static void DiscardPages(void *ptr, size_t size);
+
+			/// Executes queued tasks until all tasks of @p group have finished.
+			void Wait(TaskGroup &group);
+
+			/// Executes at most one queued task, returns whether there was one.
+			bool RunPendingTask(void);
+
+			/** Calls body(i) for every i in [begin, end). The range is cut
+			    into chunks of @p grainSize iterations, or into a few chunks
+			    per thread if @p grainSize is 0.
+			*/
+			template<class TBody>
+			void ParallelFor(int begin, int end, const TBody &body, int grainSize = 0)
+			{
+				ParallelForRange(begin, end, [&body](int chunkBegin, int chunkEnd) {
+					for (int i = chunkBegin; i < chunkEnd; i++) body(i);
+				}, grainSize);
+			}
+
+			/// Like @ref ParallelFor, but calls body(chunkBegin, chunkEnd) once per chunk.
+			template<class TBody>
+			void ParallelForRange(int begin, int end, const TBody &body, int grainSize = 0)
+			{
+				int noItems = end - begin;
+				if (noItems <= 0) return;
+
+				if (grainSize <= 0) grainSize = (noItems + 4 * noThreads - 1) / (4 * noThreads);
+				int noChunks = (noItems + grainSize - 1) / grainSize;
+
+				if (noThreads == 1 || noChunks == 1) { body(begin, end); return; }
+
+				TaskGroup group;
+				for (int chunkId = 1; chunkId < noChunks; chunkId++)
+				{
+					int chunkBegin = begin + chunkId * grainSize;
+					int chunkEnd = chunkBegin + grainSize < end ? chunkBegin + grainSize : end;
+					Spawn(group, [&body, chunkBegin, chunkEnd]() { body(chunkBegin, chunkEnd); });
+				}
+
+				body(begin, begin + grainSize < end ? begin + grainSize : end);
+				Wait(group);
+			}
+
+			/** Reduces over [begin, end). body(chunkBegin, chunkEnd, partial)
+			    accumulates a chunk into @p partial, which starts as
+			    @p identity; combine(result, partial) merges chunks.
+
+			    The chunking depends only on @p grainSize, and the partial
+			    results are combined in chunk order, so floating point sums
+			    come out bit-identical for any number of threads.
+			*/
+			template<class T, class TBody, class TCombine>
+			T ParallelReduce(int begin, int end, int grainSize, const T &identity, const TBody &body, const TCombine &combine)
+			{
+				T result = identity;
+
+				int noItems = end - begin;
+				if (noItems <= 0) return result;
+				if (grainSize <= 0) grainSize = noItems;
+
+				int noChunks = (noItems + grainSize - 1) / grainSize;
+				std::vector<T> partials(noChunks, identity);
+
+				ParallelFor(0, noChunks, [&](int chunkId) {
+					int chunkBegin = begin + chunkId * grainSize;
+					int chunkEnd = chunkBegin + grainSize < end ? chunkBegin + grainSize : end;
+					body(chunkBegin, chunkEnd, partials[chunkId]);
+				}, 1);
+
+				for (int chunkId = 0; chunkId < noChunks; chunkId++) combine(result, partials[chunkId]);
+
+				return result;
+			}
+
+			/** Sets how the pool returned by @ref GetDefault is created.
+			    Once the default pool exists it is kept, and a different
+			    configuration is ignored with a warning, so call this before
+			    the engines start working.
+			*/
+			static void ConfigureDefault(int noThreads, int firstCore = -1, bool numaAware = false);
+
+			/** Pool used by the CPU engines: the pool of the calling
+			    worker, else the one bound to the calling thread with a
+			    @ref Binding, else the process wide pool set up by
+			    @ref ConfigureDefault.
+			*/
+			static ITMTaskScheduler& GetDefault(void);
+
+			/// Pool bound to the calling thread, NULL if there is none.
+			static ITMTaskScheduler* GetBound(void);
+		};
+
+		/** \brief
+		    Set of tasks with dependencies, executed on an ITMTaskScheduler.
+
+		    Tasks become ready when all the tasks they depend on have
+		    finished; independent tasks run concurrently.
+		*/
+		class ITMTaskGraph
+		{
+		private:
+			struct Node
+			{
+				std::function<void()> function;
+				std::vector<int> successors;
+				int noDependencies;
+				std::atomic<int> noUnfinishedDependencies;
+			};
+
+			std::vector<Node*> nodes;
+
+			void SpawnNode(ITMTaskScheduler &scheduler, ITMTaskScheduler::TaskGroup &group, int nodeId);
+
+		public:
+			ITMTaskGraph(void) { }
+			~ITMTaskGraph(void);
+
+			/// Adds a task and returns its id, for use in @ref AddDependency.
+			int AddTask(const std::function<void()> &function);
+
+			/// Makes task @p after wait for task @p before.
+			void AddDependency(int before, int after);
+
+			/// Runs all tasks and returns once they have finished. The graph can be run again.
+			void Run(ITMTaskScheduler &scheduler);
+		};
+	}
+}
@@ -0,0 +1,496 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMTilePager.h"
+#include "DeviceAgnostic/ITMSceneMerger.h"
+#include "DeviceSpecific/CPU/ITMHashTableEditing_CPU.h"
+#include "ITMTaskScheduler.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+using namespace ITMLib::Engine;
+
+/// Checksum of a set of blocks that does not depend on their order
+template<class TVoxel>
+static unsigned long long computeTileChecksum(const Vector3s *blockPos, const TVoxel *voxels, int noBlocks)
+{
+	unsigned long long checksum = 0;
+
+	for (int blockId = 0; blockId < noBlocks; blockId++)
+	{
+		// FNV-1a over the position and the voxels of the block
+		unsigned long long hash = 14695981039346656037ULL;
+
+		const unsigned char *bytes = reinterpret_cast<const unsigned char*>(&blockPos[blockId]);
+		for (size_t i = 0; i < sizeof(Vector3s); i++) hash = (hash ^ bytes[i]) * 1099511628211ULL;
+
+		bytes = reinterpret_cast<const unsigned char*>(voxels + blockId * SDF_BLOCK_SIZE3);
+		for (size_t i = 0; i < SDF_BLOCK_SIZE3 * sizeof(TVoxel); i++) hash = (hash ^ bytes[i]) * 1099511628211ULL;
+
+		checksum += hash;
+	}
+
+	return checksum;
+}
+
+/// Fuses the voxels of a block read from a tile into a block of the scene, skipping voxels never observed
+template<class TVoxel>
+static void fuseTileBlock(TVoxel *voxelBlock, const TVoxel *tileBlock, int maxW)
+{
+	for (int locId = 0; locId < SDF_BLOCK_SIZE3; locId++)
+	{
+		if (tileBlock[locId].w_depth == 0) continue;
+
+		TVoxel cell[8];
+		for (int i = 0; i < 8; i++) cell[i] = tileBlock[locId];
+
+		FuseResampledVoxel<TVoxel::hasColorInformation, TVoxel>::compute(voxelBlock[locId], cell, Vector3f(0.0f), 1.0f, maxW);
+	}
+}
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<class TVoxel>
+ITMTilePager<TVoxel, ITMVoxelBlockHash>::ITMTilePager(const char *directory, ITMScene<TVoxel, ITMVoxelBlockHash> *scene, float radius, int tileSize)
+	: scene(scene), scheduler(&ITMTaskScheduler::GetDefault()), tileIndex(directory, tileSize, sizeof(TVoxel), scene->sceneParams->voxelSize)
+{
+	this->radius = radius;
+	tileLength = tileIndex.GetTileSize() * SDF_BLOCK_SIZE * scene->sceneParams->voxelSize;
+
+	const ITMTileIndex::TileMap &tiles = tileIndex.GetTiles();
+	for (ITMTileIndex::TileMap::const_iterator it = tiles.begin(); it != tiles.end(); ++it) filedTiles.insert(it->first);
+
+	hasCameraTile = false;
+	nextLoadId = 0;
+
+	noPendingLoads = noPendingJobs = 0;
+	stopRequested = false;
+
+	noTilesLoaded = noTilesWritten = noFailedJobs = 0;
+	totalLoadTime = maxLoadTime = lastUpdateTime = 0.0;
+
+	thread = std::thread(&ITMTilePager::Run, this);
+}
+
+template<class TVoxel>
+ITMTilePager<TVoxel, ITMVoxelBlockHash>::~ITMTilePager(void)
+{
+	Flush();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopRequested = true;
+	}
+	jobAvailable.notify_all();
+	thread.join();
+}
+
+template<class TVoxel>
+float ITMTilePager<TVoxel, ITMVoxelBlockHash>::DistanceToTile(const Vector3f &point, const Vector3i &tile) const
+{
+	Vector3f tileMin = tile.toFloat() * tileLength, tileMax = tileMin + Vector3f(tileLength);
+
+	Vector3f d;
+	d.x = MAX(MAX(tileMin.x - point.x, point.x - tileMax.x), 0.0f);
+	d.y = MAX(MAX(tileMin.y - point.y, point.y - tileMax.y), 0.0f);
+	d.z = MAX(MAX(tileMin.z - point.z, point.z - tileMax.z), 0.0f);
+
+	return sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+}
+
+template<class TVoxel>
+void ITMTilePager<TVoxel, ITMVoxelBlockHash>::Enqueue(Job &job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (job.isLoad) noPendingLoads++;
+		noPendingJobs++;
+
+		jobs.push_back(Job());
+		std::swap(jobs.back(), job);
+	}
+	jobAvailable.notify_all();
+}
+
+template<class TVoxel>
+void ITMTilePager<TVoxel, ITMVoxelBlockHash>::Update(const ITMPose *pose_d, bool waitForLoads)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	InstallLoadedTiles();
+
+	Matrix4f invM = pose_d->GetInvM();
+	Vector3f cameraPos(invM.m[12], invM.m[13], invM.m[14]);
+
+	Vector3f blockPos = cameraPos / (scene->sceneParams->voxelSize * SDF_BLOCK_SIZE);
+	Vector3i tile = tileIndex.GetTile(Vector3s((short)floor(blockPos.x), (short)floor(blockPos.y), (short)floor(blockPos.z)));
+
+	// nothing comes into or goes out of range before the camera moves to another tile
+	if (!hasCameraTile || tile != cameraTile)
+	{
+		RequestTiles(cameraPos);
+		WriteBack(cameraPos, true);
+
+		cameraTile = tile;
+		hasCameraTile = true;
+	}
+
+	if (waitForLoads)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobAvailable.wait(lock, [this] { return noPendingLoads == 0; });
+		}
+		InstallLoadedTiles();
+	}
+
+	lastUpdateTime = millisecondsSince(start);
+}
+
+template<class TVoxel>
+void ITMTilePager<TVoxel, ITMVoxelBlockHash>::RequestTiles(const Vector3f &cameraPos)
+{
+	// tiles without a file have nothing to load, fusion allocates their blocks
+	for (typename std::set<Vector3i, ITMTileIndex::TileLess>::const_iterator it = filedTiles.begin(); it != filedTiles.end(); ++it)
+	{
+		if (DistanceToTile(cameraPos, *it) > radius || residentTiles.count(*it) > 0) continue;
+
+		ResidentTile &residentTile = residentTiles[*it];
+		residentTile.state = TILE_LOADING;
+		residentTile.loadedFromFile = false;
+		residentTile.checksum = 0;
+		residentTile.loadId = nextLoadId++;
+
+		Job job;
+		job.isLoad = true;
+		job.loadId = residentTile.loadId;
+		job.tile = *it;
+		Enqueue(job);
+	}
+}
+
+template<class TVoxel>
+void ITMTilePager<TVoxel, ITMVoxelBlockHash>::InstallLoadedTiles(void)
+{
+	std::deque<Job> tiles;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tiles.swap(loadedTiles);
+	}
+
+	ITMHashEntry *hashTable = scene->index.GetEntries();
+	TVoxel *voxelBlocks = scene->localVBA.GetVoxelBlocks();
+	int *allocationList = scene->localVBA.GetAllocationList();
+	bool isPublishing = scene->epochs.IsPublishing();
+	int maxW = scene->sceneParams->maxW;
+
+	for (size_t tileId = 0; tileId < tiles.size(); tileId++)
+	{
+		const Job &job = tiles[tileId];
+
+		// the tile went out of range, or was requested again, while it was read
+		typename std::map<Vector3i, ResidentTile, ITMTileIndex::TileLess>::iterator it = residentTiles.find(job.tile);
+		if (it == residentTiles.end() || it->second.state != TILE_LOADING || it->second.loadId != job.loadId) continue;
+
+		bool isComplete = true;
+		for (size_t blockId = 0; blockId < job.blockPos.size(); blockId++)
+		{
+			const TVoxel *tileBlock = &job.voxels[blockId * SDF_BLOCK_SIZE3];
+
+			int hashIdx = findHashEntry_CPU(hashTable, job.blockPos[blockId]);
+			if (hashIdx < 0)
+			{
+				hashIdx = allocateVoxelBlock_CPU(scene, job.blockPos[blockId]);
+				if (hashIdx < 0) { isComplete = false; continue; }
+
+				memcpy(voxelBlocks + hashTable[hashIdx].ptr * SDF_BLOCK_SIZE3, tileBlock, SDF_BLOCK_SIZE3 * sizeof(TVoxel));
+				continue;
+			}
+
+			// fusion got to the block first, e.g. while the tile was read
+			int ptr = hashTable[hashIdx].ptr;
+			if (ptr < 0) { isComplete = false; continue; }
+
+			if (isPublishing && scene->epochs.IsShared(ptr))
+			{
+				if (scene->localVBA.lastFreeBlockId < 0) { isComplete = false; continue; }
+
+				int copyPtr = allocationList[scene->localVBA.lastFreeBlockId--];
+				memcpy(voxelBlocks + copyPtr * SDF_BLOCK_SIZE3, voxelBlocks + ptr * SDF_BLOCK_SIZE3, SDF_BLOCK_SIZE3 * sizeof(TVoxel));
+				scene->epochs.RetireBlock(ptr);
+				hashTable[hashIdx].ptr = ptr = copyPtr;
+			}
+
+			fuseTileBlock(voxelBlocks + ptr * SDF_BLOCK_SIZE3, tileBlock, maxW);
+		}
+
+		it->second.state = TILE_RESIDENT;
+		it->second.loadedFromFile = isComplete;
+		it->second.checksum = job.checksum;
+	}
+}
+
+template<class TVoxel>
+void ITMTilePager<TVoxel, ITMVoxelBlockHash>::WriteBack(const Vector3f &cameraPos, bool removeBlocks)
+{
+	const ITMHashEntry *hashTable = scene->index.GetEntries();
+	const TVoxel *voxelBlocks = scene->localVBA.GetVoxelBlocks();
+	int noTotalEntries = scene->index.noTotalEntries;
+	float evictionDistance = radius + tileLength;
+
+	// blocks to write, in the order of the hash table
+	const int noEntriesPerChunk = 4096;
+	int noChunks = (noTotalEntries + noEntriesPerChunk - 1) / noEntriesPerChunk;
+	std::vector<std::vector<int> > chunkEntries(noChunks);
+
+	scheduler->ParallelFor(0, noChunks, [&](int chunkId)
+	{
+		std::vector<int> &dest = chunkEntries[chunkId];
+
+		int entryEnd = MIN((chunkId + 1) * noEntriesPerChunk, noTotalEntries);
+		for (int entryId = chunkId * noEntriesPerChunk; entryId < entryEnd; entryId++)
+		{
+			if (hashTable[entryId].ptr < 0) continue;
+			if (removeBlocks && DistanceToTile(cameraPos, tileIndex.GetTile(hashTable[entryId].pos)) <= evictionDistance) continue;
+
+			dest.push_back(entryId);
+		}
+	}, 1);
+
+	std::map<Vector3i, Job, ITMTileIndex::TileLess> tileJobs;
+	for (int chunkId = 0; chunkId < noChunks; chunkId++) for (size_t i = 0; i < chunkEntries[chunkId].size(); i++)
+	{
+		const ITMHashEntry &hashEntry = hashTable[chunkEntries[chunkId][i]];
+
+		Job &job = tileJobs[tileIndex.GetTile(hashEntry.pos)];
+		job.blockPos.push_back(hashEntry.pos);
+
+		size_t offset = job.voxels.size();
+		job.voxels.resize(offset + SDF_BLOCK_SIZE3);
+		memcpy(&job.voxels[offset], voxelBlocks + hashEntry.ptr * SDF_BLOCK_SIZE3, SDF_BLOCK_SIZE3 * sizeof(TVoxel));
+	}
+
+	for (typename std::map<Vector3i, Job, ITMTileIndex::TileLess>::iterator it = tileJobs.begin(); it != tileJobs.end(); ++it)
+	{
+		Job &job = it->second;
+		job.isLoad = false;
+		job.loadId = -1;
+		job.tile = it->first;
+
+		// only a tile that holds all blocks of its file, or has no file, can replace the file
+		typename std::map<Vector3i, ResidentTile, ITMTileIndex::TileLess>::const_iterator resident = residentTiles.find(job.tile);
+		bool isResident = resident != residentTiles.end();
+		bool isComplete = isResident ? resident->second.state == TILE_RESIDENT && resident->second.loadedFromFile : filedTiles.count(job.tile) == 0;
+
+		job.mergeWithFile = !isComplete;
+		job.skipIfUnchanged = isResident && isComplete;
+		job.reportChecksum = !removeBlocks && isComplete;
+		job.checksum = job.skipIfUnchanged ? resident->second.checksum : 0;
+
+		if (removeBlocks)
+		{
+			for (size_t blockId = 0; blockId < job.blockPos.size(); blockId++) removeVoxelBlock_CPU(scene, job.blockPos[blockId]);
+		}
+
+		filedTiles.insert(job.tile);
+		Enqueue(job);
+	}
+
+	if (!removeBlocks) return;
+
+	for (typename std::map<Vector3i, ResidentTile, ITMTileIndex::TileLess>::iterator it = residentTiles.begin(); it != residentTiles.end();)
+	{
+		if (DistanceToTile(cameraPos, it->first) > evictionDistance) residentTiles.erase(it++);
+		else ++it;
+	}
+}
+
+template<class TVoxel>
+void ITMTilePager<TVoxel, ITMVoxelBlockHash>::Flush(void)
+{
+	InstallLoadedTiles();
+	WriteBack(Vector3f(0.0f), false);
+
+	std::vector<std::pair<Vector3i, unsigned long long> > checksums;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		jobAvailable.wait(lock, [this] { return noPendingJobs == 0; });
+		checksums.swap(writtenTiles);
+	}
+
+	// the files of these tiles now hold exactly the blocks in memory, they must not be merged with them later
+	for (size_t i = 0; i < checksums.size(); i++)
+	{
+		ResidentTile &residentTile = residentTiles[checksums[i].first];
+		residentTile.state = TILE_RESIDENT;
+		residentTile.loadedFromFile = true;
+		residentTile.checksum = checksums[i].second;
+		residentTile.loadId = -1;
+	}
+}
+
+template<class TVoxel>
+void ITMTilePager<TVoxel, ITMVoxelBlockHash>::LoadTile(Job &job)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	tileIndex.ReadTile(job.tile, job.blockPos, job.voxels);
+	job.checksum = computeTileChecksum(job.blockPos.empty() ? NULL : &job.blockPos[0], job.voxels.empty() ? NULL : &job.voxels[0],
+		(int)job.blockPos.size());
+
+	job.loadTime = millisecondsSince(start);
+}
+
+template<class TVoxel>
+bool ITMTilePager<TVoxel, ITMVoxelBlockHash>::WriteTile(Job &job)
+{
+	int noBlocks = (int)job.blockPos.size();
+
+	unsigned long long checksum = computeTileChecksum(&job.blockPos[0], &job.voxels[0], noBlocks);
+	if (job.skipIfUnchanged && checksum == job.checksum) return false;
+	job.checksum = checksum;
+
+	if (job.mergeWithFile)
+	{
+		std::vector<Vector3s> fileBlockPos;
+		std::vector<TVoxel> fileVoxels;
+		tileIndex.ReadTile(job.tile, fileBlockPos, fileVoxels);
+
+		std::map<Vector3i, int, ITMTileIndex::TileLess> blockIds;
+		for (int blockId = 0; blockId < noBlocks; blockId++) blockIds[job.blockPos[blockId].toInt()] = blockId;
+
+		for (size_t fileBlockId = 0; fileBlockId < fileBlockPos.size(); fileBlockId++)
+		{
+			const TVoxel *fileBlock = &fileVoxels[fileBlockId * SDF_BLOCK_SIZE3];
+
+			std::map<Vector3i, int, ITMTileIndex::TileLess>::const_iterator it = blockIds.find(fileBlockPos[fileBlockId].toInt());
+			if (it != blockIds.end())
+			{
+				fuseTileBlock(&job.voxels[it->second * SDF_BLOCK_SIZE3], fileBlock, scene->sceneParams->maxW);
+				continue;
+			}
+
+			job.blockPos.push_back(fileBlockPos[fileBlockId]);
+			job.voxels.insert(job.voxels.end(), fileBlock, fileBlock + SDF_BLOCK_SIZE3);
+		}
+
+		noBlocks = (int)job.blockPos.size();
+	}
+
+	ITMTileIndex::TileInfo info;
+	info.noBlocks = noBlocks;
+	info.fileBytes = tileIndex.WriteTile(job.tile, &job.blockPos[0], &job.voxels[0], noBlocks);
+
+	// the index is only touched here and in the constructor, the main thread keeps its own set of tiles
+	tileIndex.Set(job.tile, info);
+	tileIndex.Save();
+
+	return true;
+}
+
+template<class TVoxel>
+void ITMTilePager<TVoxel, ITMVoxelBlockHash>::Run(void)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (true)
+	{
+		jobAvailable.wait(lock, [this] { return stopRequested || !jobs.empty(); });
+		if (jobs.empty()) break;
+
+		Job job;
+		std::swap(job, jobs.front());
+		jobs.pop_front();
+
+		lock.unlock();
+
+		bool failed = false, written = false;
+		try
+		{
+			if (job.isLoad) LoadTile(job); else written = WriteTile(job);
+		}
+		catch (std::exception &e)
+		{
+			fprintf(stderr, "tile pager: %s\n", e.what());
+			failed = true;
+		}
+
+		lock.lock();
+
+		if (failed) noFailedJobs++;
+
+		if (job.isLoad)
+		{
+			// a tile that could not be read stays loading, so that its file is merged and not replaced
+			if (!failed)
+			{
+				noTilesLoaded++;
+				totalLoadTime += job.loadTime;
+				maxLoadTime = MAX(maxLoadTime, job.loadTime);
+
+				loadedTiles.push_back(Job());
+				std::swap(loadedTiles.back(), job);
+			}
+			noPendingLoads--;
+		}
+		else if (!failed)
+		{
+			if (written) noTilesWritten++;
+			if (job.reportChecksum) writtenTiles.push_back(std::make_pair(job.tile, job.checksum));
+		}
+
+		noPendingJobs--;
+		jobAvailable.notify_all();
+	}
+}
+
+template<class TVoxel>
+int ITMTilePager<TVoxel, ITMVoxelBlockHash>::GetNoResidentTiles(void) const
+{
+	int noResidentTiles = 0;
+	for (typename std::map<Vector3i, ResidentTile, ITMTileIndex::TileLess>::const_iterator it = residentTiles.begin(); it != residentTiles.end(); ++it)
+		if (it->second.state == TILE_RESIDENT) noResidentTiles++;
+
+	return noResidentTiles;
+}
+
+template<class TVoxel>
+int ITMTilePager<TVoxel, ITMVoxelBlockHash>::GetNoTilesLoaded(void)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return noTilesLoaded;
+}
+
+template<class TVoxel>
+int ITMTilePager<TVoxel, ITMVoxelBlockHash>::GetNoTilesWritten(void)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return noTilesWritten;
+}
+
+template<class TVoxel>
+int ITMTilePager<TVoxel, ITMVoxelBlockHash>::GetNoFailedJobs(void)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return noFailedJobs;
+}
+
+template<class TVoxel>
+double ITMTilePager<TVoxel, ITMVoxelBlockHash>::GetAverageLoadTime(void)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return noTilesLoaded == 0 ? 0.0 : totalLoadTime / noTilesLoaded;
+}
+
+template<class TVoxel>
+double ITMTilePager<TVoxel, ITMVoxelBlockHash>::GetMaxLoadTime(void)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return maxLoadTime;
+}
+
+ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(ITMLib::Engine::ITMTilePager)
@@ -0,0 +1,180 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Utils/ITMLibDefines.h"
+
+#include "../Objects/ITMPose.h"
+#include "../Objects/ITMScene.h"
+#include "../Objects/ITMTileIndex.h"
+
+#include "ITMTaskScheduler.h"
+
+using namespace ITMLib::Objects;
+
+namespace ITMLib
+{
+	namespace Engine
+	{
+		/** \brief
+		    Keeps only the part of the scene around the camera in
+		    memory and pages the rest to a directory of tiles, see
+		    ITMTileIndex, so that sessions far larger than the voxel
+		    block array can be mapped.
+
+		    Update() is called with the camera pose before every
+		    fusion step. Tiles within the radius of the camera are
+		    requested and read on a background thread, then fused into
+		    the scene at a later Update(). Blocks of tiles further away
+		    than the radius plus one tile are removed from the hash
+		    table, which returns their voxel blocks and excess entries
+		    to the allocation lists, and written back on the
+		    background thread unless they did not change since they
+		    were read. Tiles of the directory are merged with the
+		    blocks written back, so nothing mapped earlier is lost.
+
+		    Only the voxel block hash on the CPU without swapping is
+		    supported.
+		*/
+		template<class TVoxel, class TIndex>
+		class ITMTilePager
+		{
+		public:
+			bool IsRunning(void) const { return false; }
+
+			void Update(const ITMPose *pose_d, bool waitForLoads = false) { }
+			void Flush(void) { }
+
+			ITMTilePager(const char *directory, ITMScene<TVoxel, TIndex> *scene, float radius, int tileSize = 64) { }
+		};
+
+		template<class TVoxel>
+		class ITMTilePager<TVoxel, ITMVoxelBlockHash>
+		{
+		private:
+			enum TileState { TILE_LOADING, TILE_RESIDENT };
+
+			struct ResidentTile
+			{
+				TileState state;
+				/// All blocks of the file of the tile are in the scene
+				bool loadedFromFile;
+				/// Checksum of the blocks as read or last written
+				unsigned long long checksum;
+				/// Identifies the load job, a tile may be requested again before an earlier load arrives
+				int loadId;
+			};
+
+			struct Job
+			{
+				bool isLoad;
+				int loadId;
+				Vector3i tile;
+				std::vector<Vector3s> blockPos;
+				std::vector<TVoxel> voxels;
+
+				/// Write: fuse the blocks with those of the file first
+				bool mergeWithFile;
+				/// Write: skip if the checksum equals @ref checksum
+				bool skipIfUnchanged;
+				/// Write: report the checksum written to Flush()
+				bool reportChecksum;
+				/// Load: checksum of what was read, write: of what is written
+				unsigned long long checksum;
+				double loadTime;
+			};
+
+			ITMScene<TVoxel, ITMVoxelBlockHash> *scene;
+			/// Pool of the thread that made the pager, also used by the destructor
+			ITMTaskScheduler *scheduler;
+			ITMTileIndex tileIndex;
+			float radius, tileLength;
+
+			/// Tiles with a file that are loading or in the scene
+			std::map<Vector3i, ResidentTile, ITMTileIndex::TileLess> residentTiles;
+			/// Tiles that are in the index or queued to be written, i.e. that will have a file
+			std::set<Vector3i, ITMTileIndex::TileLess> filedTiles;
+			Vector3i cameraTile;
+			bool hasCameraTile;
+			int nextLoadId;
+
+			std::deque<Job> jobs;
+			std::deque<Job> loadedTiles;
+			std::vector<std::pair<Vector3i, unsigned long long> > writtenTiles;
+			int noPendingLoads, noPendingJobs;
+
+			std::mutex mutex;
+			std::condition_variable jobAvailable;
+			bool stopRequested;
+
+			int noTilesLoaded, noTilesWritten, noFailedJobs;
+			double totalLoadTime, maxLoadTime, lastUpdateTime;
+
+			std::thread thread;
+
+			void Run(void);
+			void Enqueue(Job &job);
+
+			void InstallLoadedTiles(void);
+			void RequestTiles(const Vector3f &cameraPos);
+			void WriteBack(const Vector3f &cameraPos, bool removeBlocks);
+			float DistanceToTile(const Vector3f &point, const Vector3i &tile) const;
+
+			void LoadTile(Job &job);
+			/// False if the write was skipped
+			bool WriteTile(Job &job);
+
+		public:
+			bool IsRunning(void) const { return true; }
+
+			/** Pages tiles in and out for the camera at @p pose_d. With
+			    @p waitForLoads, the tiles around the camera are in the
+			    scene when Update() returns; otherwise they appear over
+			    the following calls. Must not run concurrently with
+			    anything else that uses the scene.
+			*/
+			void Update(const ITMPose *pose_d, bool waitForLoads = false);
+
+			/// Writes all tiles in memory to the directory and blocks until they are written
+			void Flush(void);
+
+			/// Tiles around the camera that were read from the directory and are in the scene
+			int GetNoResidentTiles(void) const;
+			int GetNoTilesLoaded(void);
+			int GetNoTilesWritten(void);
+			/// Tiles that could not be read or written, reported on stderr
+			int GetNoFailedJobs(void);
+			/// Time to read a tile on the background thread, in ms
+			double GetAverageLoadTime(void);
+			double GetMaxLoadTime(void);
+			/// Time the last Update() took on the calling thread, in ms
+			double GetLastUpdateTime(void) const { return lastUpdateTime; }
+
+			/** Pages @p scene in and out of @p directory, which has to
+			    exist and may hold tiles of an earlier session. Tiles
+			    within @p radius metres of the camera are kept in memory.
+			    @p tileSize is the number of voxel blocks along a side of
+			    a tile, unless the directory has tiles already. Throws
+			    std::runtime_error if the tiles of the directory do not
+			    fit the scene.
+			*/
+			ITMTilePager(const char *directory, ITMScene<TVoxel, ITMVoxelBlockHash> *scene, float radius, int tileSize = 64);
+
+			/// Writes all tiles in memory back before returning
+			~ITMTilePager(void);
+
+			// Suppress the default copy constructor and assignment operator
+			ITMTilePager(const ITMTilePager&);
+			ITMTilePager& operator=(const ITMTilePager&);
+		};
+	}
+}
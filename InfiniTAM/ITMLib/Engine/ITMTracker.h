@@ -31,6 +31,12 @@ namespace ITMLib
 			*/
 			virtual void UpdateInitialPose(ITMTrackingState *trackingState) {}
 
+			/** Forgets what the tracker carried over from earlier
+			    frames. Called when the engine is reset and after a frame
+			    failed to track, see ITMTrackingState::trackerResult.
+			*/
+			virtual void Reset(void) {}
+
 			virtual ~ITMTracker(void) {}
 		};
 	}
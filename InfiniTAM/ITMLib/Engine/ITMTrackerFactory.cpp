@@ -2,4 +2,4 @@
 
 #include "ITMTrackerFactory.h"
 
-template class ITMLib::Engine::ITMTrackerFactory<ITMVoxel, ITMVoxelIndex>;
+ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(ITMLib::Engine::ITMTrackerFactory)
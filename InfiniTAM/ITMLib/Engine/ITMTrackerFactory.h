@@ -14,6 +14,7 @@
 #include "DeviceSpecific/CPU/ITMColorTracker_CPU.h"
 #include "DeviceSpecific/CPU/ITMDepthTracker_CPU.h"
 #include "DeviceSpecific/CPU/ITMExternalTracker_CPU.h"
+#include "DeviceSpecific/CPU/ITMHybridTracker_CPU.h"
 #include "DeviceSpecific/CPU/ITMWeightedICPTracker_CPU.h"
 #include "DeviceSpecific/CPU/ITMRenTracker_CPU.h"
 #include "../Utils/ITMLibSettings.h"
@@ -22,6 +23,7 @@
 #include "DeviceSpecific/CUDA/ITMColorTracker_CUDA.h"
 #include "DeviceSpecific/CUDA/ITMDepthTracker_CUDA.h"
 #include "DeviceSpecific/CUDA/ITMExternalTracker_CUDA.h"
+#include "DeviceSpecific/CUDA/ITMHybridTracker_CUDA.h"
 #include "DeviceSpecific/CUDA/ITMWeightedICPTracker_CUDA.h"
 #include "DeviceSpecific/CUDA/ITMRenTracker_CUDA.h"
 #endif
@@ -49,10 +51,10 @@ namespace ITMLib
       /** A map of maker functions for the various different tracker types. */
       std::map<ITMLibSettings::TrackerType,Maker> makers;
 
-      //#################### SINGLETON IMPLEMENTATION ####################
-    private:
+      //#################### CONSTRUCTORS ####################
+    public:
       /**
-       * \brief Constructs a tracker factory.
+       * \brief Constructs a tracker factory, each engine makes its own.
        */
       ITMTrackerFactory()
       {
@@ -62,16 +64,7 @@ namespace ITMLib
         makers.insert(std::make_pair(ITMLibSettings::TRACKER_WICP, &MakeWeightedICPTracker));
         makers.insert(std::make_pair(ITMLibSettings::TRACKER_IMU, &MakeIMUTracker));
         makers.insert(std::make_pair(ITMLibSettings::TRACKER_REN, &MakeRenTracker));
-      }
-
-    public:
-      /**
-       * \brief Gets the singleton instance for the current set of template parameters.
-       */
-      static ITMTrackerFactory& Instance()
-      {
-        static ITMTrackerFactory s_instance;
-        return s_instance;
+        makers.insert(std::make_pair(ITMLibSettings::TRACKER_HYBRID, &MakeHybridTracker));
       }
 
       //#################### PUBLIC MEMBER FUNCTIONS ####################
@@ -378,7 +371,8 @@ namespace ITMLib
               trackedImageSize,
               settings->trackingRegime,
               2,
-              lowLevelEngine, scene
+              lowLevelEngine, scene,
+              settings->useSDFGradientCache
             );
           }
           case ITMLibSettings::DEVICE_CUDA:
@@ -402,7 +396,8 @@ namespace ITMLib
               trackedImageSize,
               settings->trackingRegime,
               2,
-              lowLevelEngine, scene
+              lowLevelEngine, scene,
+              settings->useSDFGradientCache
             );
 #else
             break;
@@ -413,6 +408,67 @@ namespace ITMLib
 
         DIEWITHEXCEPTION("Failed to make Ren tracker");
       }
+
+      /**
+       * \brief Makes a hybrid ICP and photometric tracker.
+       */
+      static ITMTracker *MakeHybridTracker(const Vector2i& trackedImageSize, const ITMLibSettings *settings, const ITMLowLevelEngine *lowLevelEngine,
+                                           ITMIMUCalibrator *imuCalibrator, ITMScene<TVoxel,TIndex> *scene)
+      {
+        switch(settings->deviceType)
+        {
+          case ITMLibSettings::DEVICE_CPU:
+          {
+            return new ITMHybridTracker_CPU(
+              trackedImageSize,
+              settings->trackingRegime,
+              settings->noHierarchyLevels,
+              settings->depthTrackerICPThreshold,
+              settings->depthTrackerTerminationThreshold,
+              settings->hybridTrackerICPWeight,
+              settings->hybridTrackerPhotometricWeight,
+              lowLevelEngine
+            );
+          }
+          case ITMLibSettings::DEVICE_CUDA:
+          {
+#ifndef COMPILE_WITHOUT_CUDA
+            return new ITMHybridTracker_CUDA(
+              trackedImageSize,
+              settings->trackingRegime,
+              settings->noHierarchyLevels,
+              settings->depthTrackerICPThreshold,
+              settings->depthTrackerTerminationThreshold,
+              settings->hybridTrackerICPWeight,
+              settings->hybridTrackerPhotometricWeight,
+              lowLevelEngine
+            );
+#else
+            break;
+#endif
+          }
+          case ITMLibSettings::DEVICE_METAL:
+          {
+#ifdef COMPILE_WITH_METAL
+            return new ITMHybridTracker_CPU(
+              trackedImageSize,
+              settings->trackingRegime,
+              settings->noHierarchyLevels,
+              settings->depthTrackerICPThreshold,
+              settings->depthTrackerTerminationThreshold,
+              settings->hybridTrackerICPWeight,
+              settings->hybridTrackerPhotometricWeight,
+              lowLevelEngine
+            );
+#else
+            break;
+#endif
+          }
+          default: break;
+        }
+
+        DIEWITHEXCEPTION("Failed to make hybrid tracker");
+      }
     };
   }
 }
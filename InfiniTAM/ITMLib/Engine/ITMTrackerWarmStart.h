@@ -0,0 +1,133 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "../Utils/ITMLibDefines.h"
+#include "../Objects/ITMView.h"
+
+using namespace ITMLib::Objects;
+
+namespace ITMLib
+{
+	namespace Engine
+	{
+		/** \brief
+		    State an iterative tracker carries from one TrackCamera call
+		    to the next.
+
+		    For every pyramid level it keeps the Levenberg-Marquardt
+		    damping the level finished with and the diagonal of its
+		    final (per point) Hessian. In steady motion the next frame
+		    starts close to the optimum, so starting from the converged
+		    damping instead of the default saves the iterations spent
+		    on shrinking it again. The stored diagonal scales the
+		    damping term (Marquardt scaling with the running maximum of
+		    the diagonal), which keeps the first steps of a level well
+		    conditioned when the current Hessian is poor.
+
+		    It also remembers which frame the image pyramid was built
+		    for, so a tracker asked to track the same frame again can
+		    skip rebuilding it.
+		*/
+		class ITMTrackerWarmStart
+		{
+		private:
+			int noLevels;
+			float defaultLambda, minLambda;
+
+			float *lambda;
+			float *hessianDiag;
+			bool *hasHessian;
+
+			const ITMView *preparedView;
+			int preparedFrameNo;
+
+		public:
+			/** @p defaultLambda is used for levels that have not converged
+			    yet and is also the largest damping a level starts with.
+			*/
+			ITMTrackerWarmStart(int noLevels, float defaultLambda, float minLambda)
+			{
+				this->noLevels = noLevels;
+				this->defaultLambda = defaultLambda;
+				this->minLambda = minLambda;
+
+				lambda = new float[noLevels];
+				hessianDiag = new float[noLevels * 6];
+				hasHessian = new bool[noLevels];
+
+				Reset();
+			}
+
+			~ITMTrackerWarmStart(void)
+			{
+				delete[] lambda;
+				delete[] hessianDiag;
+				delete[] hasHessian;
+			}
+
+			/// Forgets everything, e.g. after the tracker has been reset or lost track.
+			void Reset(void)
+			{
+				for (int levelId = 0; levelId < noLevels; levelId++)
+				{
+					lambda[levelId] = defaultLambda;
+					hasHessian[levelId] = false;
+				}
+
+				preparedView = NULL;
+				preparedFrameNo = -1;
+			}
+
+			/// Damping to start level @p levelId with.
+			float GetLambda(int levelId) const { return lambda[levelId]; }
+
+			/** Stores the damping and the Hessian (6x6, column major, of
+			    which the first @p noPara rows and columns are used) that
+			    level @p levelId finished with. @p hessian may be NULL.
+			*/
+			void SetConverged(int levelId, float finalLambda, const float *hessian, int noPara = 6)
+			{
+				if (finalLambda > defaultLambda) finalLambda = defaultLambda;
+				if (finalLambda < minLambda) finalLambda = minLambda;
+				lambda[levelId] = finalLambda;
+
+				if (hessian == NULL) return;
+
+				float *diag = &hessianDiag[levelId * 6];
+				for (int i = 0; i < 6; i++) diag[i] = i < noPara ? hessian[i + i * 6] : 0.0f;
+				hasHessian[levelId] = true;
+			}
+
+			/** Adds lambda * D to the diagonal of @p A, where D is the
+			    larger of the diagonal of @p hessian and the one stored for
+			    level @p levelId. Without a stored diagonal this is the
+			    usual A_ii = H_ii * (1 + lambda).
+			*/
+			void AddDamping(float *A, const float *hessian, float lambda, int levelId, int noPara = 6) const
+			{
+				const float *diag = hasHessian[levelId] ? &hessianDiag[levelId * 6] : NULL;
+
+				for (int i = 0; i < noPara; i++)
+				{
+					float scale = hessian[i + i * 6];
+					if (diag != NULL && diag[i] > scale) scale = diag[i];
+					A[i + i * 6] = hessian[i + i * 6] + lambda * scale;
+				}
+			}
+
+			/// Whether the pyramid was last built for the images @p view currently holds.
+			bool IsPrepared(const ITMView *view) const { return view == preparedView && view->frameNo == preparedFrameNo; }
+
+			void SetPrepared(const ITMView *view)
+			{
+				preparedView = view;
+				preparedFrameNo = view != NULL ? view->frameNo : -1;
+			}
+
+			// Suppress the default copy constructor and assignment operator
+			ITMTrackerWarmStart(const ITMTrackerWarmStart&);
+			ITMTrackerWarmStart& operator=(const ITMTrackerWarmStart&);
+		};
+	}
+}
@@ -10,8 +10,12 @@ using namespace ITMLib::Engine;
 
 void ITMTrackingController::Track(ITMTrackingState *trackingState, const ITMView *view)
 {
+	trackingState->trackerResult = ITMTrackingState::TRACKING_GOOD;
 	if (trackingState->age_pointCloud!=-1) tracker->TrackCamera(trackingState, view);
 
+	// the damping and Hessians of a lost frame would only mislead the next one
+	if (trackingState->trackerResult == ITMTrackingState::TRACKING_FAILED) tracker->Reset();
+
 	trackingState->requiresFullRendering = trackingState->TrackerFarFromPointCloud() || !settings->useApproximateRaycast;
 }
 
@@ -21,6 +21,8 @@ namespace ITMLib
 		{
 		protected:
 			const ITMRGBDCalib *calib;
+			/// Whether UpdateView() aligns the colour image with the depth image, as needed to fuse colour
+			bool alignColourWithDepth;
 			ITMShortImage *shortImage;
 			ITMFloatImage *floatImage;
 
@@ -31,6 +33,9 @@ namespace ITMLib
 
 			virtual void DepthFiltering(ITMFloatImage *image_out, const ITMFloatImage *image_in) = 0;
 			virtual void ComputeNormalAndWeights(ITMFloat4Image *normal_out, ITMFloatImage *sigmaZ_out, const ITMFloatImage *depth_in, Vector4f intrinsic) = 0;
+			/// Resamples @p rgb_in into the depth image, setting @p mask_out to 1 where a colour was found.
+			virtual void RegisterColourToDepth(ITMUChar4Image *rgb_out, ITMUCharImage *mask_out, const ITMUChar4Image *rgb_in, const ITMFloatImage *depth_in,
+				const Matrix4f & depthToRGB, Vector4f intrinsics_d, Vector4f intrinsics_rgb) = 0;
 
 			virtual void UpdateView(ITMView **view, ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, bool useBilateralFilter, bool modelSensorNoise = false) = 0;
 			virtual void UpdateView(ITMView **view, ITMUChar4Image *rgbImage, ITMFloatImage *depthImage) = 0;
@@ -38,9 +43,10 @@ namespace ITMLib
 			virtual void UpdateView(ITMView **view, ITMUChar4Image *rgbImage, ITMShortImage *depthImage, bool useBilateralFilter,
 				ITMIMUMeasurement *imuMeasurement) = 0;
 
-			ITMViewBuilder(const ITMRGBDCalib *calib)
+			ITMViewBuilder(const ITMRGBDCalib *calib, bool alignColourWithDepth)
 			{
 				this->calib = calib;
+				this->alignColourWithDepth = alignColourWithDepth;
 				this->shortImage = NULL;
 				this->floatImage = NULL;
 			}
@@ -42,6 +42,9 @@ ITMWeightedICPTracker::ITMWeightedICPTracker(Vector2i imgSize, TrackerIterationT
 	this->noICPLevel = noICPRunTillLevel;
 
 	this->terminationThreshold = terminationThreshold;
+
+	// the Gauss-Newton iterations are undamped, only the pyramid is carried over
+	this->warmStart = new ITMTrackerWarmStart(noHierarchyLevels, 0.0f, 0.0f);
 }
 
 ITMWeightedICPTracker::~ITMWeightedICPTracker(void)
@@ -52,6 +55,8 @@ ITMWeightedICPTracker::~ITMWeightedICPTracker(void)
 	
 
 	delete[] this->noIterationsPerLevel;
+
+	delete this->warmStart;
 }
 
 void ITMWeightedICPTracker::SetEvaluationData(ITMTrackingState *trackingState, const ITMView *view)
@@ -74,20 +79,23 @@ void ITMWeightedICPTracker::SetEvaluationData(ITMTrackingState *trackingState, c
 
 void ITMWeightedICPTracker::PrepareForEvaluation()
 {
+	// the same frame tracked again keeps its pyramid
+	bool isPrepared = warmStart->IsPrepared(view);
+
 	for (int i = 1; i < viewHierarchy->noLevels; i++)
 	{
-
-
+		// the depth and its uncertainty from the view builder are subsampled together
 		ITMTemplatedHierarchyLevel<ITMFloatImage> *currentWICPLevel = viewHierarchy->levels[i], *previousWICPHierarch = viewHierarchy->levels[i - 1];
-		lowLevelEngine->FilterSubsampleWithHoles(currentWICPLevel->depth, previousWICPHierarch->depth);
+		ITMTemplatedHierarchyLevel<ITMFloatImage> *currentWeightLevel = weightHierarchy->levels[i], *previousWeightLevel = weightHierarchy->levels[i - 1];
+		if (!isPrepared)
+			lowLevelEngine->FilterSubsampleWithHoles(currentWICPLevel->depth, currentWeightLevel->depth, previousWICPHierarch->depth, previousWeightLevel->depth);
 		currentWICPLevel->intrinsics = previousWICPHierarch->intrinsics * 0.5f;
 
-		currentWICPLevel = weightHierarchy->levels[i], previousWICPHierarch = weightHierarchy->levels[i - 1];
-		lowLevelEngine->FilterSubsampleWithHoles(currentWICPLevel->depth, previousWICPHierarch->depth);
-
 		ITMSceneHierarchyLevel *currentLevelScene = sceneHierarchy->levels[i], *previousLevelScene = sceneHierarchy->levels[i - 1];
 		currentLevelScene->intrinsics = previousLevelScene->intrinsics * 0.5f;
 	}
+
+	warmStart->SetPrepared(view);
 }
 
 void ITMWeightedICPTracker::SetEvaluationParams(int levelId)
@@ -166,6 +174,7 @@ void ITMWeightedICPTracker::TrackCamera(ITMTrackingState *trackingState, const I
 	Matrix4f approxInvPose = trackingState->pose_d->GetInvM();
 
 	float f_old = 1e10, f_new;
+	bool hasTracked = false;
 
 	for (int levelId = viewHierarchy->noLevels - 1; levelId >= noICPLevel; levelId--)
 	{
@@ -178,6 +187,7 @@ void ITMWeightedICPTracker::TrackCamera(ITMTrackingState *trackingState, const I
 			int noValidPoints = this->ComputeGandH(f_new, nabla, hessian, approxInvPose);
 
 			if (noValidPoints <= 0) break;
+			hasTracked = true;
 			if (f_new > f_old) break;
 
 			ComputeDelta(step, nabla, hessian, iterationType != TRACKER_ITERATION_BOTH);
@@ -188,5 +198,13 @@ void ITMWeightedICPTracker::TrackCamera(ITMTrackingState *trackingState, const I
 			if (HasConverged(step)) break;
 		}
 	}
+
+	// no level found a single correspondence
+	if (!hasTracked) trackingState->trackerResult = ITMTrackingState::TRACKING_FAILED;
+}
+
+void ITMWeightedICPTracker::Reset(void)
+{
+	warmStart->Reset();
 }
 
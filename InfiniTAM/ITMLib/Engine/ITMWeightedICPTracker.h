@@ -10,6 +10,7 @@
 
 #include "../Engine/ITMTracker.h"
 #include "../Engine/ITMLowLevelEngine.h"
+#include "../Engine/ITMTrackerWarmStart.h"
 
 using namespace ITMLib::Objects;
 
@@ -37,6 +38,8 @@ namespace ITMLib
 
 			float terminationThreshold;
 
+			ITMTrackerWarmStart *warmStart;
+
 			float hessian[6 * 6];
 			float nabla[6];
 			float step[6];
@@ -64,6 +67,7 @@ namespace ITMLib
 
 		public:
 			void TrackCamera(ITMTrackingState *trackingState, const ITMView *view);
+			void Reset(void);
 
 			ITMWeightedICPTracker(Vector2i imgSize, TrackerIterationType *trackingRegime, int noHierarchyLevels, int noICPRunTillLevel, float distThresh,
 				float terminationThreshold, const ITMLowLevelEngine *lowLevelEngine, MemoryDeviceType memoryType);
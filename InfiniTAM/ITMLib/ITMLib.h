@@ -8,6 +8,8 @@
 #include "Objects/ITMScene.h"
 #include "Objects/ITMView.h"
 
+#include "Engine/ITMTaskScheduler.h"
+
 #include "Engine/ITMLowLevelEngine.h"
 #include "Engine/DeviceSpecific/CPU/ITMLowLevelEngine_CPU.h"
 #ifndef COMPILE_WITHOUT_CUDA
@@ -32,6 +34,12 @@
 #include "Engine/DeviceSpecific/CUDA/ITMWeightedICPTracker_CUDA.h"
 #endif
 
+#include "Engine/ITMHybridTracker.h"
+#include "Engine/DeviceSpecific/CPU/ITMHybridTracker_CPU.h"
+#ifndef COMPILE_WITHOUT_CUDA
+#include "Engine/DeviceSpecific/CUDA/ITMHybridTracker_CUDA.h"
+#endif
+
 #include "Engine/ITMSceneReconstructionEngine.h"
 #include "Engine/DeviceSpecific/CPU/ITMSceneReconstructionEngine_CPU.h"
 #ifndef COMPILE_WITHOUT_CUDA
@@ -99,6 +107,13 @@
 #include "Engine/DeviceSpecific/CPU/ITMMeshingEngine_CPU.h"
 #endif
 
+#include "Engine/ITMSurfacePointExtractor.h"
+#include "Engine/DeviceSpecific/CPU/ITMSurfacePointExtractor_CPU.h"
+
+#include "Engine/ITMMapServer.h"
+#include "Engine/ITMSceneMerger.h"
+#include "Engine/ITMTilePager.h"
+
 #include "Engine/ITMDenseMapper.h"
 #include "Engine/ITMMainEngine.h"
 
@@ -71,7 +71,7 @@ namespace ITMLib
 #endif
 			}
 
-			void SaveToFile(char *fileName) const
+			void SaveToFile(const char *fileName) const
 			{
 				TVoxel *storedData = storedVoxelBlocks;
 
@@ -87,7 +87,7 @@ namespace ITMLib
 				fclose(f);
 			}
 
-			void ReadFromFile(char *fileName)
+			void ReadFromFile(const char *fileName)
 			{
 				TVoxel *storedData = storedVoxelBlocks;
 				FILE *f = fopen(fileName, "rb");
@@ -3,9 +3,13 @@
 #pragma once
 
 #include <stdlib.h>
+#include <fstream>
+#include <stdexcept>
+#include <string>
 
 #include "../Utils/ITMLibDefines.h"
 #include "../../ORUtils/MemoryBlock.h"
+#include "../../ORUtils/MemoryBlockPersister.h"
 
 namespace ITMLib
 {
@@ -29,6 +33,9 @@ namespace ITMLib
 			inline const TVoxel *GetVoxelBlocks(void) const { return voxelBlocks->GetData(memoryType); }
 			int *GetAllocationList(void) { return allocationList->GetData(memoryType); }
 
+			/** Moves the voxel blocks into POSIX shared memory, see ORUtils::MemoryBlock::MoveToSharedMemory(). */
+			bool MoveToSharedMemory(const char *voxelBlocksName) { return voxelBlocks->MoveToSharedMemory(voxelBlocksName); }
+
 #ifdef COMPILE_WITH_METAL
 			const void* GetVoxelBlocks_MB() const { return voxelBlocks->GetMetalBuffer(); }
 			const void* GetAllocationList_MB(void) const { return allocationList->GetMetalBuffer(); }
@@ -37,11 +44,56 @@ namespace ITMLib
 
 			int allocatedSize;
 
+			/** Writes the voxel blocks, the allocation list and the last
+			    free block id to voxel.dat, alloc.dat and vba.txt in
+			    @p outputDirectory. vba.txt also holds the size of a
+			    voxel, so that scenes of another voxel type are rejected
+			    when loading.
+			*/
+			void SaveToDirectory(const std::string &outputDirectory) const
+			{
+				std::string lastFreeBlockIdFileName = outputDirectory + "/vba.txt";
+				std::ofstream ofs(lastFreeBlockIdFileName.c_str());
+				if (!ofs) throw std::runtime_error("Could not open " + lastFreeBlockIdFileName + " for writing");
+				ofs << lastFreeBlockId << ' ' << sizeof(TVoxel);
+
+				ORUtils::MemoryBlockPersister::SaveMemoryBlock(outputDirectory + "/voxel.dat", *voxelBlocks, memoryType);
+				ORUtils::MemoryBlockPersister::SaveMemoryBlock(outputDirectory + "/alloc.dat", *allocationList, memoryType);
+			}
+
+			/** Reads what SaveToDirectory() wrote, throws std::runtime_error on failure. */
+			void LoadFromDirectory(const std::string &inputDirectory)
+			{
+				std::string lastFreeBlockIdFileName = inputDirectory + "/vba.txt";
+				std::ifstream ifs(lastFreeBlockIdFileName.c_str());
+				size_t voxelSize;
+				if (!(ifs >> lastFreeBlockId >> voxelSize)) throw std::runtime_error("Could not read " + lastFreeBlockIdFileName);
+				if (voxelSize != sizeof(TVoxel)) throw std::runtime_error("The scene in " + inputDirectory + " has another voxel type");
+
+				ORUtils::MemoryBlockPersister::LoadMemoryBlock(inputDirectory + "/voxel.dat", *voxelBlocks, memoryType);
+				ORUtils::MemoryBlockPersister::LoadMemoryBlock(inputDirectory + "/alloc.dat", *allocationList, memoryType);
+			}
+
+			/** On NUMA systems the voxel blocks are spread over the nodes
+			    in stripes of this many bytes, which keeps whole pages on
+			    one node. Consecutive entries of the allocation list lie in
+			    the same stripe, so the blocks handed out cycle through the
+			    nodes stripe by stripe.
+			*/
+			static const int numaStripeSize = 2 * 1024 * 1024;
+
+			int noBlocksPerNUMAStripe;
+
+			/// NUMA node out of @p noNodes that owns voxel block @p blockId.
+			inline int GetNUMANodeOfBlock(int blockId, int noNodes) const { return (blockId / noBlocksPerNUMAStripe) % noNodes; }
+
 			ITMLocalVBA(MemoryDeviceType memoryType, int noBlocks, int blockSize)
 			{
 				this->memoryType = memoryType;
 
 				allocatedSize = noBlocks * blockSize;
+				noBlocksPerNUMAStripe = numaStripeSize / (blockSize * (int)sizeof(TVoxel));
+				if (noBlocksPerNUMAStripe < 1) noBlocksPerNUMAStripe = 1;
 
 				voxelBlocks = new ORUtils::MemoryBlock<TVoxel>(allocatedSize, memoryType);
 				allocationList = new ORUtils::MemoryBlock<int>(noBlocks, memoryType);
@@ -19,14 +19,16 @@ namespace ITMLib
 			MemoryDeviceType memoryType;
 
 			uint noTotalTriangles;
-			static const uint noMaxTriangles = SDF_LOCAL_BLOCK_NUM * 32;
+			uint noMaxTriangles;
 
 			ORUtils::MemoryBlock<Triangle> *triangles;
 
-			explicit ITMMesh(MemoryDeviceType memoryType)
+			/** Room for 32 triangles per voxel block of a scene of @p noVoxelBlocks blocks. */
+			explicit ITMMesh(MemoryDeviceType memoryType, int noVoxelBlocks = SDF_LOCAL_BLOCK_NUM)
 			{
 				this->memoryType = memoryType;
 				this->noTotalTriangles = 0;
+				this->noMaxTriangles = (uint)noVoxelBlocks * 32;
 
 				triangles = new ORUtils::MemoryBlock<Triangle>(noMaxTriangles, memoryType);
 			}
@@ -9,6 +9,11 @@
 #include "../Utils/ITMLibDefines.h"
 #include "../../ORUtils/MemoryBlock.h"
 
+#ifndef __METALC__
+#include <string>
+#include "../../ORUtils/MemoryBlockPersister.h"
+#endif
+
 namespace ITMLib
 {
 	namespace Objects
@@ -46,7 +51,8 @@ namespace ITMLib
 
 #ifndef __METALC__
 		public:
-			ITMPlainVoxelArray(MemoryDeviceType memoryType)
+			/** The array is a single block of fixed size, @p noVoxelBlocks is ignored. */
+			ITMPlainVoxelArray(MemoryDeviceType memoryType, int noVoxelBlocks = 1)
 			{
 				this->memoryType = memoryType;
 
@@ -73,12 +79,32 @@ namespace ITMLib
 
 			const Vector3i getVolumeSize(void) { return indexData->GetData(MEMORYDEVICE_CPU)->size; }
 
+			/** Bytes of the array for voxels of @p voxelSize bytes, without making it. */
+			static size_t GetMemorySize(int noVoxelBlocks, size_t voxelSize)
+			{
+				Vector3i size = IndexData().size;
+				return (size_t)size.x * size.y * size.z * voxelSize + sizeof(int) + sizeof(IndexData);
+			}
+
 			const IndexData* getIndexData(void) const { return indexData->GetData(memoryType); }
 
 #ifdef COMPILE_WITH_METAL
 			const void *getIndexData_MB() const { return indexData->GetMetalBuffer(); }
 #endif
 
+			/** Writes the size and offset of the volume to index.dat in @p outputDirectory. */
+			void SaveToDirectory(const std::string &outputDirectory) const
+			{
+				ORUtils::MemoryBlockPersister::SaveMemoryBlock(outputDirectory + "/index.dat", *indexData, MEMORYDEVICE_CPU);
+			}
+
+			/** Reads what SaveToDirectory() wrote, throws std::runtime_error on failure. */
+			void LoadFromDirectory(const std::string &inputDirectory)
+			{
+				ORUtils::MemoryBlockPersister::LoadMemoryBlock(inputDirectory + "/index.dat", *indexData, MEMORYDEVICE_CPU);
+				indexData->UpdateDeviceFromHost();
+			}
+
 			// Suppress the default copy constructor and assignment operator
 			ITMPlainVoxelArray(const ITMPlainVoxelArray&);
 			ITMPlainVoxelArray& operator=(const ITMPlainVoxelArray&);
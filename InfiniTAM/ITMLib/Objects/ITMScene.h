@@ -2,11 +2,14 @@
 
 #pragma once
 
+#include <string>
+
 #include "../Utils/ITMLibDefines.h"
 
 #include "ITMSceneParams.h"
 #include "ITMLocalVBA.h"
 #include "ITMGlobalCache.h"
+#include "ITMSceneEpochs.h"
 
 namespace ITMLib
 {
@@ -34,14 +37,51 @@ namespace ITMLib
 			/** Global content of the 8x8x8 voxel blocks -- stored on host only */
 			ITMGlobalCache<TVoxel> *globalCache;
 
-			ITMScene(const ITMSceneParams *sceneParams, bool useSwapping, MemoryDeviceType memoryType)
-				: index(memoryType), localVBA(memoryType, index.getNumAllocatedVoxelBlocks(), index.getVoxelBlockSize())
+			/** Snapshots published for readers on other threads -- voxel block hash on host only */
+			ITMSceneEpochs<TVoxel> epochs;
+
+			/** With a voxel block hash, @p noVoxelBlocks blocks are kept in memory. */
+			ITMScene(const ITMSceneParams *sceneParams, bool useSwapping, MemoryDeviceType memoryType, int noVoxelBlocks = SDF_LOCAL_BLOCK_NUM)
+				: index(memoryType, noVoxelBlocks), localVBA(memoryType, index.getNumAllocatedVoxelBlocks(), index.getVoxelBlockSize())
 			{
 				this->sceneParams = sceneParams;
 				this->useSwapping = useSwapping;
 				if (useSwapping) globalCache = new ITMGlobalCache<TVoxel>();
 			}
 
+			/** Saves the scene to files in the existing directory
+			    @p outputDirectory, including the blocks swapped out to
+			    the global cache. Throws std::runtime_error on failure.
+			*/
+			void SaveToDirectory(const std::string &outputDirectory) const
+			{
+				localVBA.SaveToDirectory(outputDirectory);
+				index.SaveToDirectory(outputDirectory);
+				if (useSwapping) globalCache->SaveToFile((outputDirectory + "/global.dat").c_str());
+			}
+
+			/** Loads a scene saved by SaveToDirectory() into this one,
+			    which has to be made with the same parameters. Throws
+			    std::runtime_error on failure.
+			*/
+			void LoadFromDirectory(const std::string &inputDirectory)
+			{
+				localVBA.LoadFromDirectory(inputDirectory);
+				index.LoadFromDirectory(inputDirectory);
+				if (useSwapping) globalCache->ReadFromFile((inputDirectory + "/global.dat").c_str());
+			}
+
+			/** Pins the last snapshot of the scene published by the
+			    reconstruction engine, to be read while fusion goes on.
+			    The first call only enables publishing, so the view is
+			    invalid until the next frame is integrated. Views are
+			    not available with swapping or a plain voxel array.
+			*/
+			ITMSceneReadView<TVoxel> AcquireReadView(void)
+			{
+				return epochs.AcquireReadView(localVBA.GetVoxelBlocks());
+			}
+
 			~ITMScene(void)
 			{
 				if (useSwapping) delete globalCache;
@@ -0,0 +1,264 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <atomic>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+#include "../Utils/ITMLibDefines.h"
+#include "../../ORUtils/MemoryBlock.h"
+#include "ITMLocalVBA.h"
+
+namespace ITMLib
+{
+	namespace Objects
+	{
+		template<class TVoxel> class ITMSceneEpochs;
+
+		/** \brief
+		    Read access to a snapshot of a scene, as published at the
+		    end of a frame.
+
+		    The hash entries and voxel blocks of the snapshot do not
+		    change while the view is held, even though fusion goes on
+		    concurrently. Views are cheap to acquire and should be
+		    released soon, since the voxel blocks replaced after the
+		    snapshot cannot be reused before that.
+		*/
+		template<class TVoxel>
+		class ITMSceneReadView
+		{
+			friend class ITMSceneEpochs<TVoxel>;
+
+			ITMSceneEpochs<TVoxel> *epochs;
+			int slot;
+			unsigned long long epoch;
+
+			const ITMHashEntry *entries;
+			const TVoxel *voxelBlocks;
+
+			ITMSceneReadView(ITMSceneEpochs<TVoxel> *epochs, int slot, unsigned long long epoch, const ITMHashEntry *entries, const TVoxel *voxelBlocks)
+				: epochs(epochs), slot(slot), epoch(epoch), entries(entries), voxelBlocks(voxelBlocks) { }
+
+		public:
+			/// False if no snapshot was published yet
+			bool IsValid(void) const { return entries != NULL; }
+
+			/// Number of the frame the snapshot was published after, counting from 1
+			unsigned long long GetEpoch(void) const { return epoch; }
+
+			/// Hash table of the snapshot, to be used with readVoxel() and the like
+			const ITMHashEntry *GetEntries(void) const { return entries; }
+			const TVoxel *GetVoxelBlocks(void) const { return voxelBlocks; }
+
+			/// Unpins the snapshot, the view is invalid afterwards
+			void Release(void);
+
+			ITMSceneReadView(void) : epochs(NULL), slot(-1), epoch(0), entries(NULL), voxelBlocks(NULL) { }
+
+			ITMSceneReadView(ITMSceneReadView &&other)
+				: epochs(other.epochs), slot(other.slot), epoch(other.epoch), entries(other.entries), voxelBlocks(other.voxelBlocks)
+			{
+				other.epochs = NULL; other.entries = NULL;
+			}
+
+			ITMSceneReadView& operator=(ITMSceneReadView &&other)
+			{
+				if (this != &other)
+				{
+					Release();
+					epochs = other.epochs; slot = other.slot; epoch = other.epoch;
+					entries = other.entries; voxelBlocks = other.voxelBlocks;
+					other.epochs = NULL; other.entries = NULL;
+				}
+				return *this;
+			}
+
+			~ITMSceneReadView(void) { Release(); }
+
+			// Suppress the default copy constructor and assignment operator
+			ITMSceneReadView(const ITMSceneReadView&);
+			ITMSceneReadView& operator=(const ITMSceneReadView&);
+		};
+
+		/** \brief
+		    Publishes snapshots of a voxel block hash scene for readers
+		    on other threads, see ITMScene::AcquireReadView().
+
+		    Nothing is done before the first view is requested. From
+		    then on, the reconstruction engine publishes a copy of the
+		    hash table after every frame, alternating between two
+		    tables. Voxel blocks that are referenced by the published
+		    table are copied to a free block before fusion first writes
+		    to them (copy on write), and the replaced blocks are retired.
+		    A retired block goes back to the allocation list once a newer
+		    snapshot is published and no reader pins an older one.
+
+		    Readers pin the epoch of the snapshot they read in one of a
+		    fixed number of slots. If the table a publication would
+		    overwrite is still pinned, the publication is skipped and
+		    readers keep seeing the previous frame.
+		*/
+		template<class TVoxel>
+		class ITMSceneEpochs
+		{
+		public:
+			/// Maximum number of views held at the same time
+			static const int maxNoReaders = 64;
+
+		private:
+			std::atomic<unsigned long long> readerEpochs[maxNoReaders];
+			std::atomic<unsigned long long> publishedEpoch;
+			std::atomic<bool> readViewsRequested;
+
+			ORUtils::MemoryBlock<ITMHashEntry> *publishedEntries[2];
+
+			/// Blocks replaced by the writer, with the last epoch that references them
+			std::vector<std::pair<unsigned long long, int> > retiredBlocks;
+
+			/// One flag per voxel block, set if the last snapshot references the block
+			std::vector<unsigned char> sharedBlocks;
+
+			unsigned long long GetOldestPinnedEpoch(void) const
+			{
+				unsigned long long oldest = ~0ull;
+				for (int slot = 0; slot < maxNoReaders; slot++)
+				{
+					unsigned long long epoch = readerEpochs[slot].load();
+					if (epoch != 0 && epoch < oldest) oldest = epoch;
+				}
+				return oldest;
+			}
+
+		public:
+			ITMSceneEpochs(void) : publishedEpoch(0), readViewsRequested(false)
+			{
+				for (int slot = 0; slot < maxNoReaders; slot++) readerEpochs[slot].store(0);
+				publishedEntries[0] = publishedEntries[1] = NULL;
+			}
+
+			~ITMSceneEpochs(void)
+			{
+				delete publishedEntries[0];
+				delete publishedEntries[1];
+			}
+
+			/** Pins the last published snapshot. Returns an invalid view
+			    if nothing was published yet, which is the case until the
+			    writer finishes the first frame after the first request,
+			    or if all slots are taken.
+			*/
+			ITMSceneReadView<TVoxel> AcquireReadView(const TVoxel *voxelBlocks)
+			{
+				readViewsRequested.store(true);
+
+				unsigned long long epoch = publishedEpoch.load();
+				if (epoch == 0) return ITMSceneReadView<TVoxel>();
+
+				int slot = 0;
+				for (; slot < maxNoReaders; slot++)
+				{
+					unsigned long long expected = 0;
+					if (readerEpochs[slot].compare_exchange_strong(expected, epoch)) break;
+				}
+				if (slot == maxNoReaders) return ITMSceneReadView<TVoxel>();
+
+				// the writer checks the slots before it overwrites a table, so the
+				// pin only holds if the epoch did not move on in the meantime
+				while (true)
+				{
+					unsigned long long currentEpoch = publishedEpoch.load();
+					if (currentEpoch == epoch) break;
+					epoch = currentEpoch;
+					readerEpochs[slot].store(epoch);
+				}
+
+				return ITMSceneReadView<TVoxel>(this, slot, epoch, publishedEntries[epoch % 2]->GetData(MEMORYDEVICE_CPU), voxelBlocks);
+			}
+
+			void Unpin(int slot) { readerEpochs[slot].store(0); }
+
+			/// Whether the writer has to publish snapshots and copy blocks on write
+			bool IsPublishing(void) const { return readViewsRequested.load(); }
+
+			/// Hash table of the last snapshot, NULL if there is none. Writer only.
+			const ITMHashEntry *GetPublishedEntries(void) const
+			{
+				unsigned long long epoch = publishedEpoch.load();
+				return epoch == 0 ? NULL : publishedEntries[epoch % 2]->GetData(MEMORYDEVICE_CPU);
+			}
+
+			/** Whether the last snapshot references the block, which
+			    must then be copied before it is written to. Decided by
+			    the block rather than the hash entry, since removing a
+			    block moves the entries of its chain. Writer only.
+			*/
+			bool IsShared(int blockId) const { return blockId >= 0 && (size_t)blockId < sharedBlocks.size() && sharedBlocks[blockId] != 0; }
+
+			/// Hands a block that was replaced by a copy over for reclamation. Writer only.
+			void RetireBlock(int blockId) { retiredBlocks.push_back(std::make_pair(publishedEpoch.load(), blockId)); }
+
+			/** Publishes @p entries as the snapshot of the next epoch and
+			    reclaims the retired blocks that no reader can see any
+			    more. Writer only. Returns false if the publication was
+			    skipped because readers still pin the table it would
+			    overwrite.
+			*/
+			bool Publish(const ITMHashEntry *entries, int noEntries, ITMLocalVBA<TVoxel> &localVBA, int blockSize)
+			{
+				if (publishedEntries[0] == NULL)
+				{
+					publishedEntries[0] = new ORUtils::MemoryBlock<ITMHashEntry>(noEntries, MEMORYDEVICE_CPU);
+					publishedEntries[1] = new ORUtils::MemoryBlock<ITMHashEntry>(noEntries, MEMORYDEVICE_CPU);
+				}
+
+				unsigned long long epoch = publishedEpoch.load();
+
+				// the table of epoch + 1 was last used by epoch - 1
+				if (epoch >= 1 && GetOldestPinnedEpoch() <= epoch - 1) return false;
+
+				memcpy(publishedEntries[(epoch + 1) % 2]->GetData(MEMORYDEVICE_CPU), entries, noEntries * sizeof(ITMHashEntry));
+				publishedEpoch.store(epoch + 1);
+
+				sharedBlocks.assign(localVBA.allocatedSize / blockSize, 0);
+				for (int entryId = 0; entryId < noEntries; entryId++)
+					if (entries[entryId].ptr >= 0) sharedBlocks[entries[entryId].ptr] = 1;
+
+				unsigned long long oldestPinned = GetOldestPinnedEpoch();
+				TVoxel *voxelBlocks = localVBA.GetVoxelBlocks();
+				int *allocationList = localVBA.GetAllocationList();
+
+				size_t noKept = 0;
+				for (size_t i = 0; i < retiredBlocks.size(); i++)
+				{
+					if (retiredBlocks[i].first >= oldestPinned) { retiredBlocks[noKept++] = retiredBlocks[i]; continue; }
+
+					int blockId = retiredBlocks[i].second;
+					for (int j = 0; j < blockSize; j++) voxelBlocks[blockId * blockSize + j] = TVoxel();
+					allocationList[++localVBA.lastFreeBlockId] = blockId;
+				}
+				retiredBlocks.resize(noKept);
+
+				return true;
+			}
+
+			/** Forgets the retired blocks when the scene is reset, which
+			    must not happen while views are held.
+			*/
+			void Reset(void) { retiredBlocks.clear(); sharedBlocks.clear(); }
+
+			// Suppress the default copy constructor and assignment operator
+			ITMSceneEpochs(const ITMSceneEpochs&);
+			ITMSceneEpochs& operator=(const ITMSceneEpochs&);
+		};
+
+		template<class TVoxel>
+		inline void ITMSceneReadView<TVoxel>::Release(void)
+		{
+			if (epochs != NULL) epochs->Unpin(slot);
+			epochs = NULL; entries = NULL; voxelBlocks = NULL;
+		}
+	}
+}
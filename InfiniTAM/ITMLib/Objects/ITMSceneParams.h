@@ -46,6 +46,14 @@ namespace ITMLib
 			/** Stop integration once maxW has been reached. */
 			bool stopIntegratingAtMaxW;
 
+			/** \brief
+			    Weight each depth observation by the sensor noise
+			    model (ITMView::depthUncertainty) instead of
+			    counting every observation once. Requires the view
+			    builder to model the sensor noise.
+			*/
+			bool useSensorNoiseWeighting;
+
 			ITMSceneParams(float mu, int maxW, float voxelSize, 
 				float viewFrustum_min, float viewFrustum_max, bool stopIntegratingAtMaxW)
 			{
@@ -54,6 +62,7 @@ namespace ITMLib
 				this->voxelSize = voxelSize;
 				this->viewFrustum_min = viewFrustum_min; this->viewFrustum_max = viewFrustum_max;
 				this->stopIntegratingAtMaxW = stopIntegratingAtMaxW;
+				this->useSensorNoiseWeighting = false;
 			}
 
 			explicit ITMSceneParams(const ITMSceneParams *sceneParams) { this->SetFrom(sceneParams); }
@@ -66,6 +75,7 @@ namespace ITMLib
 				this->mu = sceneParams->mu;
 				this->maxW = sceneParams->maxW;
 				this->stopIntegratingAtMaxW = sceneParams->stopIntegratingAtMaxW;
+				this->useSensorNoiseWeighting = sceneParams->useSensorNoiseWeighting;
 			}
 		};
 	}
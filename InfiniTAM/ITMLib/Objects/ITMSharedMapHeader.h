@@ -0,0 +1,54 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <atomic>
+#include <stdio.h>
+
+namespace ITMLib
+{
+	namespace Objects
+	{
+		/** \brief
+		    Start of the shared memory published by
+		    ITMLib::Engine::ITMMapServer and read by
+		    ITMLib::Engine::ITMMapClient.
+
+		    The hash entries and voxel blocks are in two further
+		    shared memory objects, whose names are derived from the
+		    name of the header with GetEntriesName() and
+		    GetVoxelBlocksName().
+
+		    @ref sequence is a seqlock: it is odd while the server
+		    updates the scene. A reader that sees the same even value
+		    before and after reading has read a consistent scene.
+		*/
+		struct ITMSharedMapHeader
+		{
+			/// Written last, once the scene is in place
+			static const unsigned int magicNumber = 0x4d415449;
+			static const unsigned int currentVersion = 1;
+
+			unsigned int magic, version;
+
+			std::atomic<unsigned long long> sequence;
+
+			/// Number of frames integrated since the server was started
+			std::atomic<unsigned long long> noFramesIntegrated;
+
+			/// Layout of the scene, to be checked by the client against its voxel type
+			int voxelTypeSize;
+			bool hasColorInformation;
+			int noTotalEntries;
+			int noVoxelBlocks;
+			int voxelBlockSize;
+
+			/// Copied from ITMLib::Objects::ITMSceneParams
+			float voxelSize, mu, viewFrustum_min, viewFrustum_max;
+			int maxW;
+
+			static void GetEntriesName(char *entriesName, size_t size, const char *name) { snprintf(entriesName, size, "%s_entries", name); }
+			static void GetVoxelBlocksName(char *voxelBlocksName, size_t size, const char *name) { snprintf(voxelBlocksName, size, "%s_voxels", name); }
+		};
+	}
+}
@@ -0,0 +1,114 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "../Utils/ITMLibDefines.h"
+#include "../../ORUtils/MemoryBlock.h"
+
+#include <stdio.h>
+
+namespace ITMLib
+{
+	namespace Objects
+	{
+		/** \brief
+		    Points on the zero level set of the scene, as extracted by
+		    ITMSurfacePointExtractor.
+
+		    The blocks are reallocated when a scene has more points
+		    than they can hold, so that they never take more memory
+		    than the largest point set extracted so far.
+		*/
+		class ITMSurfacePoints
+		{
+		public:
+			MemoryDeviceType memoryType;
+
+			uint noTotalPoints, noMaxPoints;
+
+			/// Whether @ref colours holds the colour of the voxels
+			bool hasColours;
+
+			/// Positions in metres, w is the smaller weight of the two voxels the point lies between
+			ORUtils::MemoryBlock<Vector4f> *points;
+			/// Unit normals pointing out of the surface, w is 0
+			ORUtils::MemoryBlock<Vector4f> *normals;
+			/// RGB in [0, 1] and w = 1 if @ref hasColours
+			ORUtils::MemoryBlock<Vector4f> *colours;
+
+			explicit ITMSurfacePoints(MemoryDeviceType memoryType)
+			{
+				this->memoryType = memoryType;
+				this->noTotalPoints = 0;
+				this->noMaxPoints = 0;
+				this->hasColours = false;
+
+				points = new ORUtils::MemoryBlock<Vector4f>(1, memoryType);
+				normals = new ORUtils::MemoryBlock<Vector4f>(1, memoryType);
+				colours = new ORUtils::MemoryBlock<Vector4f>(1, memoryType);
+			}
+
+			/// Makes room for at least @p noPoints points, the content is lost if the blocks are reallocated
+			void Reserve(uint noPoints)
+			{
+				if (noPoints <= noMaxPoints) return;
+
+				delete points; delete normals; delete colours;
+				points = new ORUtils::MemoryBlock<Vector4f>(noPoints, memoryType);
+				normals = new ORUtils::MemoryBlock<Vector4f>(noPoints, memoryType);
+				colours = new ORUtils::MemoryBlock<Vector4f>(noPoints, memoryType);
+				noMaxPoints = noPoints;
+			}
+
+			/** Writes the points as binary little endian PLY, with the
+			    properties x, y, z, nx, ny, nz, red, green, blue (if
+			    there are colours) and confidence, the voxel weight.
+			*/
+			bool WritePLY(const char *fileName) const
+			{
+				if (memoryType != MEMORYDEVICE_CPU) return false;
+
+				FILE *f = fopen(fileName, "wb");
+				if (f == NULL) return false;
+
+				fprintf(f, "ply\nformat binary_little_endian 1.0\nelement vertex %u\n", noTotalPoints);
+				fprintf(f, "property float x\nproperty float y\nproperty float z\n");
+				fprintf(f, "property float nx\nproperty float ny\nproperty float nz\n");
+				if (hasColours) fprintf(f, "property uchar red\nproperty uchar green\nproperty uchar blue\n");
+				fprintf(f, "property float confidence\nend_header\n");
+
+				const Vector4f *pointData = points->GetData(MEMORYDEVICE_CPU);
+				const Vector4f *normalData = normals->GetData(MEMORYDEVICE_CPU);
+				const Vector4f *colourData = colours->GetData(MEMORYDEVICE_CPU);
+
+				for (uint i = 0; i < noTotalPoints; i++)
+				{
+					fwrite(&pointData[i].x, sizeof(float), 3, f);
+					fwrite(&normalData[i].x, sizeof(float), 3, f);
+					if (hasColours)
+					{
+						uchar rgb[3];
+						for (int c = 0; c < 3; c++) rgb[c] = (uchar)(CLAMP(colourData[i][c], 0.0f, 1.0f) * 255.0f + 0.5f);
+						fwrite(rgb, sizeof(uchar), 3, f);
+					}
+					fwrite(&pointData[i].w, sizeof(float), 1, f);
+				}
+
+				bool ok = !ferror(f);
+				fclose(f);
+				return ok;
+			}
+
+			~ITMSurfacePoints()
+			{
+				delete points;
+				delete normals;
+				delete colours;
+			}
+
+			// Suppress the default copy constructor and assignment operator
+			ITMSurfacePoints(const ITMSurfacePoints&);
+			ITMSurfacePoints& operator=(const ITMSurfacePoints&);
+		};
+	}
+}
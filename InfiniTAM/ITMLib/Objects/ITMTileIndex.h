@@ -0,0 +1,198 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <stdio.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../Utils/ITMLibDefines.h"
+
+namespace ITMLib
+{
+	namespace Objects
+	{
+		/** \brief
+		    On-disk layout of a scene cut into cubic tiles of
+		    tileSize^3 voxel blocks, as written and read by
+		    ITMTilePager.
+
+		    Every tile that holds blocks is a file
+		    tile_<x>_<y>_<z>.dat with a header (magic, version, number
+		    of blocks, size of a voxel), the block positions and then
+		    the voxels of the blocks in the same order. The index
+		    tiles.txt lists the tiles with their number of blocks and
+		    file size, after a header with the tile size, voxel type
+		    size and voxel size the tiles were written with. Files are
+		    written to a temporary name and renamed, so a crash never
+		    leaves a partial tile behind.
+		*/
+		class ITMTileIndex
+		{
+		public:
+			struct TileInfo
+			{
+				int noBlocks;
+				long long fileBytes;
+			};
+
+			struct TileLess
+			{
+				bool operator()(const Vector3i &a, const Vector3i &b) const
+				{
+					if (a.x != b.x) return a.x < b.x;
+					if (a.y != b.y) return a.y < b.y;
+					return a.z < b.z;
+				}
+			};
+
+			typedef std::map<Vector3i, TileInfo, TileLess> TileMap;
+
+		private:
+			static const int tileMagic = 0x454c4954; // "TILE"
+			static const int tileVersion = 1;
+
+			std::string directory;
+			int tileSize, voxelTypeSize;
+			float voxelSize;
+
+			TileMap tiles;
+
+			std::string IndexFileName(void) const { return directory + "/tiles.txt"; }
+
+			static void Check(bool ok, const std::string &fileName)
+			{
+				if (!ok) throw std::runtime_error("Could not read " + fileName);
+			}
+
+		public:
+			/// Number of voxel blocks along each side of a tile
+			int GetTileSize(void) const { return tileSize; }
+
+			const TileMap& GetTiles(void) const { return tiles; }
+
+			/// Tile containing the voxel block at @p blockPos
+			Vector3i GetTile(const Vector3s &blockPos) const
+			{
+				Vector3i tile;
+				tile.x = (blockPos.x >= 0 ? blockPos.x : blockPos.x - tileSize + 1) / tileSize;
+				tile.y = (blockPos.y >= 0 ? blockPos.y : blockPos.y - tileSize + 1) / tileSize;
+				tile.z = (blockPos.z >= 0 ? blockPos.z : blockPos.z - tileSize + 1) / tileSize;
+				return tile;
+			}
+
+			/// NULL if the tile has no file
+			const TileInfo* Find(const Vector3i &tile) const
+			{
+				TileMap::const_iterator it = tiles.find(tile);
+				return it == tiles.end() ? NULL : &it->second;
+			}
+
+			void Set(const Vector3i &tile, const TileInfo &info) { tiles[tile] = info; }
+
+			std::string TileFileName(const Vector3i &tile) const
+			{
+				std::ostringstream fileName;
+				fileName << directory << "/tile_" << tile.x << '_' << tile.y << '_' << tile.z << ".dat";
+				return fileName.str();
+			}
+
+			/** Rewrites tiles.txt from the tiles set so far, throws
+			    std::runtime_error on failure.
+			*/
+			void Save(void) const
+			{
+				std::string fileName = IndexFileName(), tmpFileName = fileName + ".tmp";
+				{
+					std::ofstream ofs(tmpFileName.c_str());
+					if (!ofs) throw std::runtime_error("Could not open " + tmpFileName + " for writing");
+
+					ofs << "InfiniTAM tiles " << tileVersion << '\n' << tileSize << ' ' << voxelTypeSize << ' ' << voxelSize << '\n';
+					for (TileMap::const_iterator it = tiles.begin(); it != tiles.end(); ++it)
+						ofs << it->first.x << ' ' << it->first.y << ' ' << it->first.z << ' ' << it->second.noBlocks << ' ' << it->second.fileBytes << '\n';
+
+					if (!ofs) throw std::runtime_error("Could not write " + tmpFileName);
+				}
+				if (rename(tmpFileName.c_str(), fileName.c_str()) != 0) throw std::runtime_error("Could not rename " + tmpFileName);
+			}
+
+			/** Writes the blocks at @p blockPos with their voxels, @p
+			    noBlocks * SDF_BLOCK_SIZE3 of them, to the file of @p tile
+			    and returns the size of the file. Throws
+			    std::runtime_error on failure.
+			*/
+			template<class TVoxel>
+			long long WriteTile(const Vector3i &tile, const Vector3s *blockPos, const TVoxel *voxels, int noBlocks) const
+			{
+				std::string fileName = TileFileName(tile), tmpFileName = fileName + ".tmp";
+				{
+					std::ofstream ofs(tmpFileName.c_str(), std::ios::binary);
+					if (!ofs) throw std::runtime_error("Could not open " + tmpFileName + " for writing");
+
+					int header[4] = { tileMagic, tileVersion, noBlocks, (int)sizeof(TVoxel) };
+					ofs.write(reinterpret_cast<const char*>(header), sizeof(header));
+					ofs.write(reinterpret_cast<const char*>(blockPos), noBlocks * sizeof(Vector3s));
+					ofs.write(reinterpret_cast<const char*>(voxels), (size_t)noBlocks * SDF_BLOCK_SIZE3 * sizeof(TVoxel));
+
+					if (!ofs) throw std::runtime_error("Could not write " + tmpFileName);
+				}
+				if (rename(tmpFileName.c_str(), fileName.c_str()) != 0) throw std::runtime_error("Could not rename " + tmpFileName);
+
+				return (long long)sizeof(int) * 4 + (long long)noBlocks * (sizeof(Vector3s) + SDF_BLOCK_SIZE3 * sizeof(TVoxel));
+			}
+
+			/** Reads the file of @p tile into @p blockPos and @p voxels,
+			    empty if the tile has no file. Throws std::runtime_error
+			    if the file is damaged or of another voxel type.
+			*/
+			template<class TVoxel>
+			void ReadTile(const Vector3i &tile, std::vector<Vector3s> &blockPos, std::vector<TVoxel> &voxels) const
+			{
+				blockPos.clear(); voxels.clear();
+
+				std::string fileName = TileFileName(tile);
+				std::ifstream ifs(fileName.c_str(), std::ios::binary);
+				if (!ifs) return;
+
+				int header[4];
+				Check(ifs.read(reinterpret_cast<char*>(header), sizeof(header)) && header[0] == tileMagic && header[1] == tileVersion
+					&& header[2] >= 0 && header[3] == (int)sizeof(TVoxel), fileName);
+
+				blockPos.resize(header[2]);
+				voxels.resize((size_t)header[2] * SDF_BLOCK_SIZE3);
+				if (header[2] == 0) return;
+
+				Check(!!ifs.read(reinterpret_cast<char*>(&blockPos[0]), blockPos.size() * sizeof(Vector3s)), fileName);
+				Check(!!ifs.read(reinterpret_cast<char*>(&voxels[0]), voxels.size() * sizeof(TVoxel)), fileName);
+			}
+
+			/** Reads tiles.txt from @p directory if it exists, the tile
+			    size stored there then replaces @p tileSize. Throws
+			    std::runtime_error if the index is damaged or was written
+			    for another voxel type or voxel size.
+			*/
+			ITMTileIndex(const std::string &directory, int tileSize, int voxelTypeSize, float voxelSize)
+				: directory(directory), tileSize(tileSize), voxelTypeSize(voxelTypeSize), voxelSize(voxelSize)
+			{
+				std::string fileName = IndexFileName();
+				std::ifstream ifs(fileName.c_str());
+				if (!ifs) return;
+
+				std::string magic, kind; int version, fileVoxelTypeSize; float fileVoxelSize;
+				Check(ifs >> magic >> kind >> version >> this->tileSize >> fileVoxelTypeSize >> fileVoxelSize && magic == "InfiniTAM" && kind == "tiles"
+					&& version == tileVersion && this->tileSize > 0, fileName);
+
+				if (fileVoxelTypeSize != voxelTypeSize || fabs(fileVoxelSize - voxelSize) > 1e-6f)
+					throw std::runtime_error(fileName + " was written for another voxel type or voxel size");
+
+				Vector3i tile; TileInfo info;
+				while (ifs >> tile.x >> tile.y >> tile.z >> info.noBlocks >> info.fileBytes) tiles[tile] = info;
+				Check(ifs.eof(), fileName);
+			}
+		};
+	}
+}
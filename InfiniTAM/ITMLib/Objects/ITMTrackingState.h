@@ -19,6 +19,13 @@ namespace ITMLib
 		class ITMTrackingState
 		{
 		public:
+			enum TrackingResult
+			{
+				TRACKING_GOOD,
+				/// The tracker found nothing to align the frame with
+				TRACKING_FAILED
+			};
+
 			/** @brief
 			    Excerpt of the scene used by the tracker to align
 			    a new frame.
@@ -38,6 +45,9 @@ namespace ITMLib
 
 			bool requiresFullRendering;
 
+			/// Outcome of tracking the last frame, set by the tracker
+			TrackingResult trackerResult;
+
 			bool TrackerFarFromPointCloud(void) const
 			{
 				// if no point cloud exists, yet
@@ -70,6 +80,19 @@ namespace ITMLib
 				this->pose_pointCloud->SetFrom(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
 
 				requiresFullRendering = true;
+				trackerResult = TRACKING_GOOD;
+			}
+
+			/// Starts over from the origin without a point cloud.
+			void Reset(void)
+			{
+				this->pose_d->SetFrom(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+
+				this->age_pointCloud = -1;
+				this->pose_pointCloud->SetFrom(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+
+				requiresFullRendering = true;
+				trackerResult = TRACKING_GOOD;
 			}
 
 			~ITMTrackingState(void)
@@ -33,6 +33,18 @@ namespace ITMLib
 			/// allocated when needed
 			ITMFloatImage *depthUncertainty;
 
+			/// RGB colour image resampled into the depth image, i.e. pixel-aligned with @ref depth.
+			/// allocated when needed
+			ITMUChar4Image *rgbRegistered;
+
+			/// 1 where @ref rgbRegistered holds a colour, 0 where the depth pixel has none.
+			/// allocated with @ref rgbRegistered
+			ITMUCharImage *rgbRegisteredMask;
+
+			/// Incremented by the view builder whenever new images are loaded, so that
+			/// consumers can tell a new frame from the same frame being processed again.
+			int frameNo;
+
 			ITMView(const ITMRGBDCalib *calibration, Vector2i imgSize_rgb, Vector2i imgSize_d, bool useGPU)
 			{
 				this->calib = new ITMRGBDCalib(*calibration);
@@ -40,8 +52,33 @@ namespace ITMLib
 				this->depth = new ITMFloatImage(imgSize_d, true, useGPU);
 				this->depthNormal = NULL;
 				this->depthUncertainty = NULL;
+				this->rgbRegistered = NULL;
+				this->rgbRegisteredMask = NULL;
+				this->frameNo = 0;
+			}
+
+			/// Whether the RGB and depth cameras coincide, so that @ref rgb is already pixel-aligned with @ref depth.
+			bool IsColourAlignedWithDepth(void) const
+			{
+				if (rgb->noDims != depth->noDims) return false;
+				if (calib->intrinsics_rgb.projectionParamsSimple.all != calib->intrinsics_d.projectionParamsSimple.all) return false;
+
+				const Matrix4f &rgbToDepth = calib->trafo_rgb_to_depth.calib;
+				for (int i = 0; i < 16; i++)
+					if (rgbToDepth.m[i] != ((i % 5 == 0) ? 1.0f : 0.0f)) return false;
+				return true;
+			}
+
+			/// Colour image pixel-aligned with @ref depth, or NULL if there is none.
+			const ITMUChar4Image *GetRGBAlignedWithDepth(void) const
+			{
+				if (rgbRegistered != NULL) return rgbRegistered;
+				return IsColourAlignedWithDepth() ? rgb : NULL;
 			}
 
+			/// Valid pixels of GetRGBAlignedWithDepth(), NULL if all of them are.
+			const ITMUCharImage *GetRGBAlignedWithDepthMask(void) const { return rgbRegisteredMask; }
+
 			virtual ~ITMView(void)
 			{
 				delete calib;
@@ -51,6 +88,8 @@ namespace ITMLib
 
 				if (depthNormal != NULL) delete depthNormal;
 				if (depthUncertainty != NULL) delete depthUncertainty;
+				if (rgbRegistered != NULL) delete rgbRegistered;
+				if (rgbRegisteredMask != NULL) delete rgbRegisteredMask;
 			}
 
 			// Suppress the default copy constructor and assignment operator
@@ -4,11 +4,17 @@
 
 #ifndef __METALC__
 #include <stdlib.h>
+#include <fstream>
+#include <stdexcept>
+#include <string>
 #endif
 
 #include "../Utils/ITMLibDefines.h"
 
 #include "../../ORUtils/MemoryBlock.h"
+#ifndef __METALC__
+#include "../../ORUtils/MemoryBlockPersister.h"
+#endif
 
 namespace ITMLib
 {
@@ -40,6 +46,9 @@ namespace ITMLib
 		private:
 			int lastFreeExcessListId;
 
+			/** Number of voxel blocks in the VBA of the scene. */
+			int noVoxelBlocks;
+
 			/** The actual data in the hash table. */
 			ORUtils::MemoryBlock<ITMHashEntry> *hashEntries;
 
@@ -53,9 +62,14 @@ namespace ITMLib
 			MemoryDeviceType memoryType;
 
 		public:
-			ITMVoxelBlockHash(MemoryDeviceType memoryType)
+			/** The scene keeps @p noVoxelBlocks voxel blocks in
+			    memory, at most SDF_LOCAL_BLOCK_NUM. The hash table
+			    itself always has @ref noTotalEntries entries.
+			*/
+			ITMVoxelBlockHash(MemoryDeviceType memoryType, int noVoxelBlocks = SDF_LOCAL_BLOCK_NUM)
 			{
 				this->memoryType = memoryType;
+				this->noVoxelBlocks = noVoxelBlocks;
 				hashEntries = new ORUtils::MemoryBlock<ITMHashEntry>(noTotalEntries, memoryType);
 				excessAllocationList = new ORUtils::MemoryBlock<int>(SDF_EXCESS_LIST_SIZE, memoryType);
 			}
@@ -80,6 +94,9 @@ namespace ITMLib
 			const int *GetExcessAllocationList(void) const { return excessAllocationList->GetData(memoryType); }
 			int *GetExcessAllocationList(void) { return excessAllocationList->GetData(memoryType); }
 
+			/** Moves the hash entries into POSIX shared memory, see ORUtils::MemoryBlock::MoveToSharedMemory(). */
+			bool MoveToSharedMemory(const char *entriesName) { return hashEntries->MoveToSharedMemory(entriesName); }
+
 			int GetLastFreeExcessListId(void) { return lastFreeExcessListId; }
 			void SetLastFreeExcessListId(int lastFreeExcessListId) { this->lastFreeExcessListId = lastFreeExcessListId; }
 
@@ -89,10 +106,45 @@ namespace ITMLib
 			const void* getIndexData_MB(void) const { return hashEntries->GetMetalBuffer(); }
 #endif
 
+			/** Writes the hash entries, the excess allocation list and
+			    the last free excess list id to hash.dat, excess.dat and
+			    last.txt in @p outputDirectory.
+			*/
+			void SaveToDirectory(const std::string &outputDirectory) const
+			{
+				std::string lastFreeExcessListIdFileName = outputDirectory + "/last.txt";
+				std::ofstream ofs(lastFreeExcessListIdFileName.c_str());
+				if (!ofs) throw std::runtime_error("Could not open " + lastFreeExcessListIdFileName + " for writing");
+				ofs << lastFreeExcessListId;
+
+				ORUtils::MemoryBlockPersister::SaveMemoryBlock(outputDirectory + "/hash.dat", *hashEntries, memoryType);
+				ORUtils::MemoryBlockPersister::SaveMemoryBlock(outputDirectory + "/excess.dat", *excessAllocationList, memoryType);
+			}
+
+			/** Reads what SaveToDirectory() wrote, throws std::runtime_error on failure. */
+			void LoadFromDirectory(const std::string &inputDirectory)
+			{
+				std::string lastFreeExcessListIdFileName = inputDirectory + "/last.txt";
+				std::ifstream ifs(lastFreeExcessListIdFileName.c_str());
+				if (!(ifs >> lastFreeExcessListId)) throw std::runtime_error("Could not read " + lastFreeExcessListIdFileName);
+
+				ORUtils::MemoryBlockPersister::LoadMemoryBlock(inputDirectory + "/hash.dat", *hashEntries, memoryType);
+				ORUtils::MemoryBlockPersister::LoadMemoryBlock(inputDirectory + "/excess.dat", *excessAllocationList, memoryType);
+			}
+
 			/** Maximum number of total entries. */
-			int getNumAllocatedVoxelBlocks(void) { return SDF_LOCAL_BLOCK_NUM; }
+			int getNumAllocatedVoxelBlocks(void) { return noVoxelBlocks; }
 			int getVoxelBlockSize(void) { return SDF_BLOCK_SIZE3; }
 
+			/** Bytes of the hash table and of a VBA of @p noVoxelBlocks
+			    blocks of voxels of @p voxelSize bytes, without making them.
+			*/
+			static size_t GetMemorySize(int noVoxelBlocks, size_t voxelSize)
+			{
+				return noTotalEntries * sizeof(ITMHashEntry) + SDF_EXCESS_LIST_SIZE * sizeof(int) +
+					(size_t)noVoxelBlocks * (voxelBlockSize * voxelSize + sizeof(int));
+			}
+
 			// Suppress the default copy constructor and assignment operator
 			ITMVoxelBlockHash(const ITMVoxelBlockHash&);
 			ITMVoxelBlockHash& operator=(const ITMVoxelBlockHash&);
@@ -198,6 +198,27 @@ struct ITMVoxel_f {
   }
 };
 
+/** The voxel and index types the engines are compiled for. Each pair can be
+    selected at runtime with ITMLibSettings::voxelType and
+    ITMLibSettings::indexType, the typedefs below choose the default pair
+    and have to be one of them. F is called as F(X, TVoxel, TIndex) for
+    every pair. Define ITMLIB_FOR_EACH_VOXEL_INDEX before including this
+    file to build the library for other pairs, e.g. only for the default
+    one to save compile time.
+*/
+#ifndef ITMLIB_FOR_EACH_VOXEL_INDEX
+#define ITMLIB_FOR_EACH_VOXEL_INDEX(F, X)                   \
+  F(X, ITMVoxel_s, ITMLib::Objects::ITMVoxelBlockHash)      \
+  F(X, ITMVoxel_s, ITMLib::Objects::ITMPlainVoxelArray)     \
+  F(X, ITMVoxel_f_rgb, ITMLib::Objects::ITMVoxelBlockHash)  \
+  F(X, ITMVoxel_f_rgb, ITMLib::Objects::ITMPlainVoxelArray)
+#endif
+
+/// Explicitly instantiates the class template C<TVoxel,TIndex> for all pairs
+/// of ITMLIB_FOR_EACH_VOXEL_INDEX.
+#define ITMLIB_INSTANTIATE_CLASS(C, TVoxel, TIndex) template class C<TVoxel, TIndex>;
+#define ITMLIB_INSTANTIATE_FOR_VOXEL_INDEX(C) ITMLIB_FOR_EACH_VOXEL_INDEX(ITMLIB_INSTANTIATE_CLASS, C)
+
 /** This chooses the information stored at each voxel. At the moment, valid
     options are ITMVoxel_s, ITMVoxel_f, ITMVoxel_s_rgb and ITMVoxel_f_rgb
 */
@@ -14,9 +14,17 @@ ITMLibSettings::ITMLibSettings(void)
   /// For ITMDepthTracker: ICP iteration termination threshold
   depthTrackerTerminationThreshold = 1e-3f;
 
+  /// relative weights of the depth and colour terms of the hybrid tracker,
+  /// the photometric residuals are intensities between 0 and 1
+  hybridTrackerICPWeight = 1.0f;
+  hybridTrackerPhotometricWeight = 1e-4f;
+
   /// skips every other point when using the colour tracker
   skipPoints = true;
 
+  /// recomputes the SDF gradients for every point when using the Ren tracker
+  useSDFGradientCache = false;
+
 #ifndef COMPILE_WITHOUT_CUDA
   deviceType = DEVICE_CUDA;
 #else
@@ -27,6 +35,11 @@ ITMLibSettings::ITMLibSettings(void)
 #endif
 #endif
 
+  /// use all cores for the CPU engines, without pinning threads
+  noCPUThreads = 0;
+  firstCPUCore = -1;
+  useNUMAPlacement = false;
+
   // currently using only CPU for External tracker
   // deviceType = DEVICE_CPU;
 
@@ -34,26 +47,48 @@ ITMLibSettings::ITMLibSettings(void)
   /// requires more testing
   useSwapping = false;
 
+  /// the largest voxel block array the hash supports
+  noVoxelBlocks = SDF_LOCAL_BLOCK_NUM;
+
   /// enables or disables approximate raycast
   useApproximateRaycast = false;
 
   /// enable or disable bilateral depth filtering;
   useBilateralFilter = false;
 
-  // trackerType = TRACKER_COLOR;
-  trackerType = TRACKER_EXTERNAL;
-  // trackerType = TRACKER_ICP;
-  // trackerType = TRACKER_REN;
-  // trackerType = TRACKER_IMU;
-  // trackerType = TRACKER_WICP;
+  /// weight depth observations by the sensor noise model during fusion
+  sceneParams.useSensorNoiseWeighting = false;
+
+  /// the scene representation chosen by the typedefs in ITMLibDefines.h
+  voxelType = VoxelTypeOf<ITMVoxel>();
+  indexType = IndexTypeOf<ITMVoxelIndex>();
+
+  /// also builds the tracking regime
+  trackingRegime = NULL;
+  // SetTrackerType(TRACKER_COLOR);
+  SetTrackerType(TRACKER_EXTERNAL);
+  // SetTrackerType(TRACKER_ICP);
+  // SetTrackerType(TRACKER_REN);
+  // SetTrackerType(TRACKER_IMU);
+  // SetTrackerType(TRACKER_WICP);
+  // SetTrackerType(TRACKER_HYBRID);
+
+  if (trackerType == TRACKER_EXTERNAL) {
+    std::cout << "TRACKER_EXTERNAL" << std::endl;
+  }
+}
+
+void ITMLibSettings::SetTrackerType(TrackerType trackerType) {
+  this->trackerType = trackerType;
 
   /// model the sensor noise as  the weight for weighted ICP
   modelSensorNoise = false;
-  if (trackerType == TRACKER_WICP) {
+  if (trackerType == TRACKER_WICP || sceneParams.useSensorNoiseWeighting) {
     modelSensorNoise = true;
   }
 
   // builds the tracking regime. level 0 is full resolution
+  delete[] trackingRegime;
   if (trackerType == TRACKER_IMU) {
     noHierarchyLevels = 2;
     trackingRegime = new TrackerIterationType[noHierarchyLevels];
@@ -78,13 +113,49 @@ ITMLibSettings::ITMLibSettings(void)
     noICPRunTillLevel = 0;
   }
 
-  if ((trackerType == TRACKER_COLOR) && (!ITMVoxel::hasColorInformation)) {
+  if ((trackerType == TRACKER_COLOR) && (!VoxelHasColourInformation())) {
     printf(
         "Error: Color tracker requires a voxel type with color information!\n");
   }
-  if (trackerType == TRACKER_EXTERNAL) {
-    std::cout << "TRACKER_EXTERNAL" << std::endl;
-  }
+}
+
+void ITMLibSettings::SetTrackingRegime(int noHierarchyLevels,
+                                       const TrackerIterationType* regime) {
+  delete[] trackingRegime;
+
+  this->noHierarchyLevels = noHierarchyLevels;
+  trackingRegime = new TrackerIterationType[noHierarchyLevels];
+  for (int i = 0; i < noHierarchyLevels; i++) trackingRegime[i] = regime[i];
+}
+
+void ITMLibSettings::SetFrom(const ITMLibSettings* settings) {
+  deviceType = settings->deviceType;
+  noCPUThreads = settings->noCPUThreads;
+  firstCPUCore = settings->firstCPUCore;
+  useNUMAPlacement = settings->useNUMAPlacement;
+  useSwapping = settings->useSwapping;
+  noVoxelBlocks = settings->noVoxelBlocks;
+  useApproximateRaycast = settings->useApproximateRaycast;
+  useBilateralFilter = settings->useBilateralFilter;
+  modelSensorNoise = settings->modelSensorNoise;
+
+  trackerType = settings->trackerType;
+  SetTrackingRegime(settings->noHierarchyLevels, settings->trackingRegime);
+  noICPRunTillLevel = settings->noICPRunTillLevel;
+  useSDFGradientCache = settings->useSDFGradientCache;
+  skipPoints = settings->skipPoints;
+  depthTrackerICPThreshold = settings->depthTrackerICPThreshold;
+  depthTrackerTerminationThreshold = settings->depthTrackerTerminationThreshold;
+  hybridTrackerICPWeight = settings->hybridTrackerICPWeight;
+  hybridTrackerPhotometricWeight = settings->hybridTrackerPhotometricWeight;
+
+  voxelType = settings->voxelType;
+  indexType = settings->indexType;
+  sceneParams.SetFrom(&settings->sceneParams);
+}
+
+bool ITMLibSettings::VoxelHasColourInformation(void) const {
+  return voxelType == VOXEL_S_RGB || voxelType == VOXEL_F_RGB;
 }
 
 ITMLibSettings::~ITMLibSettings() { delete[] trackingRegime; }
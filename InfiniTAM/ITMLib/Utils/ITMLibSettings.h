@@ -15,9 +15,26 @@ class ITMLibSettings {
   /// Select the type of device to use
   DeviceType deviceType;
 
+  /// Number of threads used by the CPU engines, 0 for one per hardware core
+  int noCPUThreads;
+
+  /// If not negative, the worker threads of the CPU engines are pinned to
+  /// consecutive cores after this one, which is left to the calling thread,
+  /// to keep them off cores used by other processes.
+  int firstCPUCore;
+
+  /// Spreads the CPU engine threads and the voxel blocks over the NUMA
+  /// nodes, so that each block is integrated on the node holding it.
+  bool useNUMAPlacement;
+
   /// Enables swapping between host and device.
   bool useSwapping;
 
+  /// Number of voxel blocks a voxel block hash scene keeps in memory, at most
+  /// SDF_LOCAL_BLOCK_NUM. Sets the size of the voxel block array and of the
+  /// mesh, see ITMMainEngine::GetMemorySize().
+  int noVoxelBlocks;
+
   bool useApproximateRaycast;
 
   bool useBilateralFilter;
@@ -37,7 +54,9 @@ class ITMLibSettings {
     //! Identifies a tracker based on depth image and IMU measurement
     TRACKER_IMU,
     //! Identifies a tracker that use weighted ICP only on depth image
-    TRACKER_WICP
+    TRACKER_WICP,
+    //! Identifies a tracker solving for ICP and photometric alignment jointly
+    TRACKER_HYBRID
   } TrackerType;
 
   /// Select the type of tracker to use
@@ -53,6 +72,11 @@ class ITMLibSettings {
   /// refinement.
   int noICPRunTillLevel;
 
+  /// For ITMRenTracker on the CPU: cache the SDF gradients of the voxel blocks
+  /// read during tracking, which costs 16 bytes per voxel of the voxel block
+  /// array, allocated with the tracker.
+  bool useSDFGradientCache;
+
   /// For ITMColorTracker: skip every other point in energy function evaluation.
   bool skipPoints;
 
@@ -62,9 +86,48 @@ class ITMLibSettings {
   /// For ITMDepthTracker: ICP iteration termination threshold
   float depthTrackerTerminationThreshold;
 
+  /// For ITMHybridTracker: weights of the point-to-plane and of the
+  /// photometric residuals in the joint Gauss-Newton system. Setting one of
+  /// them to 0 disables the term.
+  float hybridTrackerICPWeight;
+  float hybridTrackerPhotometricWeight;
+
+  /// Voxel types, see ITMLibDefines.h
+  typedef enum { VOXEL_S, VOXEL_F, VOXEL_S_RGB, VOXEL_F_RGB } VoxelType;
+
+  /// Ways of indexing the voxels of the scene
+  typedef enum { INDEX_HASH, INDEX_ARRAY } IndexType;
+
+  /// Select the voxel type and the index of the scene. The pair has to be one
+  /// the library is compiled for, see ITMLIB_FOR_EACH_VOXEL_INDEX, and
+  /// defaults to ITMVoxel and ITMVoxelIndex.
+  VoxelType voxelType;
+  IndexType indexType;
+
   /// Further, scene specific parameters such as voxel size
   ITMLib::Objects::ITMSceneParams sceneParams;
 
+  /// Whether the selected voxel type stores colour, as the colour tracker and
+  /// the colour renderings need.
+  bool VoxelHasColourInformation(void) const;
+
+  /// The enumeration values of the voxel and index types.
+  template <class TVoxel>
+  static VoxelType VoxelTypeOf(void);
+  template <class TIndex>
+  static IndexType IndexTypeOf(void);
+
+  /// Selects the tracker and resets the settings that depend on it: the
+  /// tracking regime, noICPRunTillLevel and modelSensorNoise.
+  void SetTrackerType(TrackerType trackerType);
+
+  /// Replaces the tracking regime, level 0 being the full resolution.
+  void SetTrackingRegime(int noHierarchyLevels,
+                         const TrackerIterationType* regime);
+
+  /// Copies all settings of @p settings, including the tracking regime.
+  void SetFrom(const ITMLibSettings* settings);
+
   ITMLibSettings(void);
   ~ITMLibSettings(void);
 
@@ -72,5 +135,34 @@ class ITMLibSettings {
   ITMLibSettings(const ITMLibSettings&);
   ITMLibSettings& operator=(const ITMLibSettings&);
 };
+
+template <>
+inline ITMLibSettings::VoxelType ITMLibSettings::VoxelTypeOf<ITMVoxel_s>(void) {
+  return VOXEL_S;
+}
+template <>
+inline ITMLibSettings::VoxelType ITMLibSettings::VoxelTypeOf<ITMVoxel_f>(void) {
+  return VOXEL_F;
+}
+template <>
+inline ITMLibSettings::VoxelType ITMLibSettings::VoxelTypeOf<ITMVoxel_s_rgb>(
+    void) {
+  return VOXEL_S_RGB;
+}
+template <>
+inline ITMLibSettings::VoxelType ITMLibSettings::VoxelTypeOf<ITMVoxel_f_rgb>(
+    void) {
+  return VOXEL_F_RGB;
+}
+template <>
+inline ITMLibSettings::IndexType
+ITMLibSettings::IndexTypeOf<ITMVoxelBlockHash>(void) {
+  return INDEX_HASH;
+}
+template <>
+inline ITMLibSettings::IndexType
+ITMLibSettings::IndexTypeOf<ITMPlainVoxelArray>(void) {
+  return INDEX_ARRAY;
+}
 }
 }
@@ -0,0 +1,256 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMLibSettingsIO.h"
+
+#include <fstream>
+#include <stdio.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ITMLib::Objects;
+
+static const char *deviceTypeNames[] = { "cpu", "cuda", "metal" };
+static const char *trackerTypeNames[] = { "color", "external", "icp", "ren", "imu", "wicp", "hybrid" };
+static const char *voxelTypeNames[] = { "s", "f", "s_rgb", "f_rgb" };
+static const char *indexTypeNames[] = { "hash", "array" };
+
+// indexed by TrackerIterationType
+static const char *iterationTypeNames[] = { "", "rotation", "translation", "both", "none" };
+
+static bool parseName(const std::string & value, const char **names, int noNames, int & dest)
+{
+	for (int i = 0; i < noNames; i++)
+	{
+		if (value.compare(names[i]) == 0) { dest = i; return true; }
+	}
+	return false;
+}
+
+static bool parseBool(const std::string & value, bool & dest)
+{
+	if (value == "true" || value == "1") { dest = true; return true; }
+	if (value == "false" || value == "0") { dest = false; return true; }
+	return false;
+}
+
+template<typename T> static bool parseNumber(const std::string & value, T & dest)
+{
+	std::stringstream stream(value);
+	T tmp; stream >> tmp;
+	if (stream.fail() || !stream.eof()) return false;
+
+	dest = tmp;
+	return true;
+}
+
+static bool parseTrackingRegime(const std::string & value, ITMLibSettings & dest)
+{
+	std::stringstream stream(value);
+	std::vector<TrackerIterationType> regime;
+
+	std::string word;
+	while (stream >> word)
+	{
+		int type;
+		if (!parseName(word, iterationTypeNames, 5, type) || type == 0) return false;
+		regime.push_back((TrackerIterationType)type);
+	}
+	if (regime.empty()) return false;
+
+	dest.SetTrackingRegime((int)regime.size(), &regime[0]);
+	return true;
+}
+
+static bool applySetting(const std::string & key, const std::string & value, ITMLibSettings & dest)
+{
+	ITMSceneParams & scene = dest.sceneParams;
+
+	if (key == "deviceType")
+	{
+		int type;
+		if (!parseName(value, deviceTypeNames, 3, type)) return false;
+		dest.deviceType = (ITMLibSettings::DeviceType)type;
+		return true;
+	}
+	if (key == "voxelType")
+	{
+		int type;
+		if (!parseName(value, voxelTypeNames, 4, type)) return false;
+		dest.voxelType = (ITMLibSettings::VoxelType)type;
+		return true;
+	}
+	if (key == "indexType")
+	{
+		int type;
+		if (!parseName(value, indexTypeNames, 2, type)) return false;
+		dest.indexType = (ITMLibSettings::IndexType)type;
+		return true;
+	}
+	if (key == "trackingRegime") return parseTrackingRegime(value, dest);
+
+	if (key == "noCPUThreads") return parseNumber(value, dest.noCPUThreads);
+	if (key == "firstCPUCore") return parseNumber(value, dest.firstCPUCore);
+	if (key == "useNUMAPlacement") return parseBool(value, dest.useNUMAPlacement);
+	if (key == "useSwapping") return parseBool(value, dest.useSwapping);
+	if (key == "noVoxelBlocks") return parseNumber(value, dest.noVoxelBlocks);
+	if (key == "useApproximateRaycast") return parseBool(value, dest.useApproximateRaycast);
+	if (key == "useBilateralFilter") return parseBool(value, dest.useBilateralFilter);
+	if (key == "modelSensorNoise") return parseBool(value, dest.modelSensorNoise);
+	if (key == "noICPRunTillLevel") return parseNumber(value, dest.noICPRunTillLevel);
+	if (key == "useSDFGradientCache") return parseBool(value, dest.useSDFGradientCache);
+	if (key == "skipPoints") return parseBool(value, dest.skipPoints);
+	if (key == "depthTrackerICPThreshold") return parseNumber(value, dest.depthTrackerICPThreshold);
+	if (key == "depthTrackerTerminationThreshold") return parseNumber(value, dest.depthTrackerTerminationThreshold);
+	if (key == "hybridTrackerICPWeight") return parseNumber(value, dest.hybridTrackerICPWeight);
+	if (key == "hybridTrackerPhotometricWeight") return parseNumber(value, dest.hybridTrackerPhotometricWeight);
+
+	if (key == "sceneParams.voxelSize") return parseNumber(value, scene.voxelSize);
+	if (key == "sceneParams.viewFrustum_min") return parseNumber(value, scene.viewFrustum_min);
+	if (key == "sceneParams.viewFrustum_max") return parseNumber(value, scene.viewFrustum_max);
+	if (key == "sceneParams.mu") return parseNumber(value, scene.mu);
+	if (key == "sceneParams.maxW") return parseNumber(value, scene.maxW);
+	if (key == "sceneParams.stopIntegratingAtMaxW") return parseBool(value, scene.stopIntegratingAtMaxW);
+	if (key == "sceneParams.useSensorNoiseWeighting") return parseBool(value, scene.useSensorNoiseWeighting);
+
+	return false;
+}
+
+static bool isAppliedBeforeTracker(const std::string & key)
+{
+	return key == "voxelType" || key == "indexType";
+}
+
+static std::string trim(const std::string & s)
+{
+	size_t first = s.find_first_not_of(" \t\r\n");
+	if (first == std::string::npos) return "";
+	size_t last = s.find_last_not_of(" \t\r\n");
+	return s.substr(first, last - first + 1);
+}
+
+bool ITMLib::Objects::readLibSettings(std::istream & src, ITMLibSettings & dest)
+{
+	// parsed into a copy, so that dest is left as it was if the file is invalid
+	ITMLibSettings parsed;
+	parsed.SetFrom(&dest);
+
+	std::vector<std::pair<std::string, std::string> > settings;
+
+	std::string line;
+	for (int lineNo = 1; std::getline(src, line); lineNo++)
+	{
+		size_t comment = line.find('#');
+		if (comment != std::string::npos) line.erase(comment);
+		line = trim(line);
+		if (line.empty()) continue;
+
+		size_t separator = line.find('=');
+		if (separator == std::string::npos)
+		{
+			fprintf(stderr, "settings line %d: expected \"key = value\"\n", lineNo);
+			return false;
+		}
+
+		settings.push_back(std::make_pair(trim(line.substr(0, separator)), trim(line.substr(separator + 1))));
+	}
+	if (src.bad()) return false;
+
+	// the voxel and index types first, as the tracker type is checked against them
+	for (size_t i = 0; i < settings.size(); i++)
+	{
+		if (!isAppliedBeforeTracker(settings[i].first)) continue;
+
+		if (!applySetting(settings[i].first, settings[i].second, parsed))
+		{
+			fprintf(stderr, "settings: invalid key or value \"%s = %s\"\n", settings[i].first.c_str(), settings[i].second.c_str());
+			return false;
+		}
+	}
+
+	// the tracker type resets the tracking regime and the settings depending on it
+	for (size_t i = 0; i < settings.size(); i++)
+	{
+		if (settings[i].first != "trackerType") continue;
+
+		int type;
+		if (!parseName(settings[i].second, trackerTypeNames, 7, type))
+		{
+			fprintf(stderr, "settings: unknown tracker type \"%s\"\n", settings[i].second.c_str());
+			return false;
+		}
+		parsed.SetTrackerType((ITMLibSettings::TrackerType)type);
+	}
+
+	for (size_t i = 0; i < settings.size(); i++)
+	{
+		if (settings[i].first == "trackerType" || isAppliedBeforeTracker(settings[i].first)) continue;
+
+		if (!applySetting(settings[i].first, settings[i].second, parsed))
+		{
+			fprintf(stderr, "settings: invalid key or value \"%s = %s\"\n", settings[i].first.c_str(), settings[i].second.c_str());
+			return false;
+		}
+	}
+
+	// the weighted ICP tracker and the weights of the fused observations need the noise model of the
+	// view builder, whatever the file says
+	if (parsed.trackerType == ITMLibSettings::TRACKER_WICP || parsed.sceneParams.useSensorNoiseWeighting) parsed.modelSensorNoise = true;
+
+	dest.SetFrom(&parsed);
+	return true;
+}
+
+bool ITMLib::Objects::readLibSettings(const char *fileName, ITMLibSettings & dest)
+{
+	std::ifstream f(fileName);
+	if (!f.is_open()) return false;
+	return ITMLib::Objects::readLibSettings(f, dest);
+}
+
+void ITMLib::Objects::writeLibSettings(std::ostream & dest, const ITMLibSettings & src)
+{
+	const ITMSceneParams & scene = src.sceneParams;
+	const char *boolNames[] = { "false", "true" };
+
+	dest << "deviceType = " << deviceTypeNames[src.deviceType] << "\n";
+	dest << "noCPUThreads = " << src.noCPUThreads << "\n";
+	dest << "firstCPUCore = " << src.firstCPUCore << "\n";
+	dest << "useNUMAPlacement = " << boolNames[src.useNUMAPlacement] << "\n";
+	dest << "useSwapping = " << boolNames[src.useSwapping] << "\n";
+	dest << "noVoxelBlocks = " << src.noVoxelBlocks << "\n";
+	dest << "useApproximateRaycast = " << boolNames[src.useApproximateRaycast] << "\n";
+	dest << "useBilateralFilter = " << boolNames[src.useBilateralFilter] << "\n";
+	dest << "modelSensorNoise = " << boolNames[src.modelSensorNoise] << "\n";
+
+	dest << "\ntrackerType = " << trackerTypeNames[src.trackerType] << "\n";
+	dest << "trackingRegime =";
+	for (int i = 0; i < src.noHierarchyLevels; i++) dest << " " << iterationTypeNames[src.trackingRegime[i]];
+	dest << "\n";
+	dest << "noICPRunTillLevel = " << src.noICPRunTillLevel << "\n";
+	dest << "useSDFGradientCache = " << boolNames[src.useSDFGradientCache] << "\n";
+	dest << "skipPoints = " << boolNames[src.skipPoints] << "\n";
+	dest << "depthTrackerICPThreshold = " << src.depthTrackerICPThreshold << "\n";
+	dest << "depthTrackerTerminationThreshold = " << src.depthTrackerTerminationThreshold << "\n";
+	dest << "hybridTrackerICPWeight = " << src.hybridTrackerICPWeight << "\n";
+	dest << "hybridTrackerPhotometricWeight = " << src.hybridTrackerPhotometricWeight << "\n";
+
+	dest << "\nvoxelType = " << voxelTypeNames[src.voxelType] << "\n";
+	dest << "indexType = " << indexTypeNames[src.indexType] << "\n";
+	dest << "sceneParams.voxelSize = " << scene.voxelSize << "\n";
+	dest << "sceneParams.viewFrustum_min = " << scene.viewFrustum_min << "\n";
+	dest << "sceneParams.viewFrustum_max = " << scene.viewFrustum_max << "\n";
+	dest << "sceneParams.mu = " << scene.mu << "\n";
+	dest << "sceneParams.maxW = " << scene.maxW << "\n";
+	dest << "sceneParams.stopIntegratingAtMaxW = " << boolNames[scene.stopIntegratingAtMaxW] << "\n";
+	dest << "sceneParams.useSensorNoiseWeighting = " << boolNames[scene.useSensorNoiseWeighting] << "\n";
+}
+
+bool ITMLib::Objects::writeLibSettings(const char *fileName, const ITMLibSettings & src)
+{
+	std::ofstream f(fileName);
+	if (!f.is_open()) return false;
+
+	ITMLib::Objects::writeLibSettings(f, src);
+	return !f.fail();
+}
@@ -0,0 +1,38 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include "ITMLibSettings.h"
+
+#include <iostream>
+
+namespace ITMLib
+{
+	namespace Objects
+	{
+		/** Reads settings from lines of the form "key = value". Empty
+		    lines and everything after '#' are ignored. The keys are the
+		    names of the members of ITMLibSettings, "sceneParams.<name>"
+		    for the scene parameters; see writeLibSettings() for a
+		    complete file. Enumerations are given by name (e.g.
+		    "trackerType = icp", "deviceType = cuda", "voxelType = f_rgb",
+		    "indexType = array") and the tracking
+		    regime as a list of "both", "translation", "rotation" or
+		    "none" per level, starting at full resolution.
+
+		    Settings missing from the file keep their value in @p dest.
+		    The tracker type is applied first and sets the tracking
+		    regime, noICPRunTillLevel and modelSensorNoise, which the
+		    file may then override; modelSensorNoise stays on where the
+		    weighted ICP tracker or the sensor noise weighting need it.
+		    Returns false, leaving @p dest unchanged, if a key is
+		    unknown or a value cannot be parsed.
+		*/
+		bool readLibSettings(std::istream & src, ITMLibSettings & dest);
+		bool readLibSettings(const char *fileName, ITMLibSettings & dest);
+
+		/// Writes all settings in the format read by readLibSettings().
+		void writeLibSettings(std::ostream & dest, const ITMLibSettings & src);
+		bool writeLibSettings(const char *fileName, const ITMLibSettings & src);
+	}
+}
@@ -1,6 +1,7 @@
 // Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
 
 #include <cstdlib>
+#include <cstring>
 
 #include "Engine/ImageSourceEngine.h"
 #include "Engine/UIEngine.h"
@@ -10,6 +11,8 @@
 #include "Engine/OpenNIEngine.h"
 #include "Engine/RealSenseEngine.h"
 
+#include "ITMLib/Utils/ITMLibSettingsIO.h"
+
 using namespace InfiniTAM::Engine;
 
 /** Create a default source of depth images from a list of command line
@@ -91,8 +94,16 @@ int main(int argc, char** argv) try {
   const char* arg2 = NULL;
   const char* arg3 = NULL;
   const char* arg4 = NULL;
+  const char* settingsFile = NULL;
+
+  // the settings file is the only named argument and comes first
+  int firstArg = 1;
+  if (argc > 2 && strcmp(argv[1], "--settings") == 0) {
+    settingsFile = argv[2];
+    firstArg = 3;
+  }
 
-  int arg = 1;
+  int arg = firstArg;
   do {
     if (argv[arg] != NULL) {
       arg1 = argv[arg];
@@ -119,9 +130,10 @@ int main(int argc, char** argv) try {
     }
   } while (false);
 
-  if (arg == 1) {
+  if (arg == firstArg) {
     printf(
-        "usage: %s [<calibfile> [<imagesource>] ]\n"
+        "usage: %s [--settings <settingsfile>] [<calibfile> [<imagesource>] ]\n"
+        "  <settingsfile>: ITMLibSettings to use instead of the defaults\n"
         "  <calibfile>   : path to a file containing intrinsic calibration "
         "parameters\n"
         "  <imagesource> : either one argument to specify OpenNI device ID\n"
@@ -146,7 +158,15 @@ int main(int argc, char** argv) try {
   }
 
   ITMLibSettings* internalSettings = new ITMLibSettings();
-  ITMMainEngine* mainEngine = new ITMMainEngine(
+  if (settingsFile != NULL) {
+    printf("using settings file: %s\n", settingsFile);
+    if (!readLibSettings(settingsFile, *internalSettings)) {
+      std::cout << "failed to read the settings file" << std::endl;
+      return -1;
+    }
+  }
+
+  ITMMainEngine* mainEngine = ITMMainEngine::Make(
       internalSettings, &imageSource->calib, imageSource->getRGBImageSize(),
       imageSource->getDepthImageSize());
 
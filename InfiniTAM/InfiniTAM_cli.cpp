@@ -1,12 +1,18 @@
 // Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
 
 #include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
 
+#include "Engine/AsyncImageSourceEngine.h"
 #include "Engine/CLIEngine.h"
 #include "Engine/ImageSourceEngine.h"
 #include "Engine/Kinect2Engine.h"
 #include "Engine/OpenNIEngine.h"
 
+#include "ITMLib/Utils/ITMLibSettingsIO.h"
+
 using namespace InfiniTAM::Engine;
 
 int main(int argc, char** argv) {
@@ -15,8 +21,78 @@ int main(int argc, char** argv) {
     const char* imagesource_part1 = NULL;
     const char* imagesource_part2 = NULL;
     const char* imagesource_part3 = NULL;
+    const char* settingsFile = NULL;
+    const char* renderTypeList = NULL;
+    const char* renderFolder = "./Files/Out";
+    const char* sceneFolder = NULL;
+    const char* tileFolder = NULL;
+    float tileRadius = 10.0f;
+    const char* capturePolicy = NULL;
+    int renderEveryNthFrame = 1;
+
+    // the named arguments come first, each with one value
+    int firstArg = 1;
+    while (firstArg + 1 < argc && strncmp(argv[firstArg], "--", 2) == 0) {
+      const char* name = argv[firstArg];
+      const char* value = argv[firstArg + 1];
+      if (strcmp(name, "--settings") == 0) {
+        settingsFile = value;
+      } else if (strcmp(name, "--render") == 0) {
+        renderTypeList = value;
+      } else if (strcmp(name, "--render-every") == 0) {
+        renderEveryNthFrame = atoi(value);
+      } else if (strcmp(name, "--render-dir") == 0) {
+        renderFolder = value;
+      } else if (strcmp(name, "--save-scene") == 0) {
+        sceneFolder = value;
+      } else if (strcmp(name, "--tiles") == 0) {
+        tileFolder = value;
+      } else if (strcmp(name, "--tile-radius") == 0) {
+        tileRadius = (float)atof(value);
+      } else if (strcmp(name, "--capture") == 0) {
+        capturePolicy = value;
+      } else {
+        std::cerr << "unknown argument " << name << '\n';
+        return EXIT_FAILURE;
+      }
+      firstArg += 2;
+    }
+
+    AsyncImageSourceEngine::Policy policy =
+        AsyncImageSourceEngine::POLICY_LATEST_FRAME;
+    if (capturePolicy != NULL) {
+      if (strcmp(capturePolicy, "next") == 0) {
+        policy = AsyncImageSourceEngine::POLICY_NEXT_FRAME;
+      } else if (strcmp(capturePolicy, "latest") == 0) {
+        policy = AsyncImageSourceEngine::POLICY_LATEST_FRAME;
+      } else if (strcmp(capturePolicy, "every") == 0) {
+        policy = AsyncImageSourceEngine::POLICY_EVERY_FRAME;
+      } else {
+        std::cerr << "unknown capture policy " << capturePolicy << '\n';
+        return EXIT_FAILURE;
+      }
+    }
+
+    std::vector<ITMMainEngine::GetImageType> renderTypes;
+    if (renderTypeList != NULL) {
+      std::string list(renderTypeList);
+      size_t start = 0;
+      while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+
+        ITMMainEngine::GetImageType type;
+        if (!CLIEngine::ParseImageType(list.substr(start, end - start).c_str(),
+                                       type)) {
+          std::cerr << "unknown image type in " << renderTypeList << '\n';
+          return EXIT_FAILURE;
+        }
+        renderTypes.push_back(type);
+        start = end + 1;
+      }
+    }
 
-    int arg = 1;
+    int arg = firstArg;
     do {
       if (argv[arg] != NULL)
         calibFile = argv[arg];
@@ -39,9 +115,31 @@ int main(int argc, char** argv) {
         break;
     } while (false);
 
-    if (arg == 1) {
+    if (arg == firstArg) {
       printf(
-          "usage: %s [<calibfile> [<imagesource>] ]\n"
+          "usage: %s [--settings <settingsfile>] [--render <images> "
+          "[--render-every <n>] [--render-dir <dir>]] [--save-scene "
+          "<scenedir>] [--tiles <tiledir> [--tile-radius <r>]] [--capture "
+          "<policy>] [<calibfile> [<imagesource>] ]\n"
+          "  <settingsfile>: ITMLibSettings to use instead of the defaults\n"
+          "  <images>      : comma separated list of images to write for every "
+          "<n>-th frame\n"
+          "                  (1 by default) into <dir> (./Files/Out by "
+          "default): rgb, depth,\n"
+          "                  raycast, shaded, colour or normals, the last three "
+          "seen from\n"
+          "                  the tracked camera\n"
+          "  <scenedir>    : existing directory to save the scene to at the "
+          "end, e.g.\n"
+          "                  for InfiniTAM_merge\n"
+          "  <tiledir>     : existing directory to page the scene to, only "
+          "the scene within\n"
+          "                  <r> metres (10 by default) of the camera stays "
+          "in memory\n"
+          "  <policy>      : capture images on a separate thread and take "
+          "the next one\n"
+          "                  captured (next), the newest one (latest) or "
+          "every one (every)\n"
           "  <calibfile>   : path to a file containing intrinsic calibration "
           "parameters\n"
           "  <imagesource> : either one argument to specify OpenNI device ID\n"
@@ -57,6 +155,13 @@ int main(int argc, char** argv) {
 
     printf("initialising ...\n");
     ITMLibSettings* internalSettings = new ITMLibSettings();
+    if (settingsFile != NULL) {
+      printf("using settings file: %s\n", settingsFile);
+      if (!readLibSettings(settingsFile, *internalSettings)) {
+        std::cerr << "failed to read the settings file" << '\n';
+        return EXIT_FAILURE;
+      }
+    }
 
     ImageSourceEngine* imageSource;
     IMUSourceEngine* imuSource = NULL;
@@ -89,15 +194,52 @@ int main(int argc, char** argv) {
       }
     }
 
-    ITMMainEngine* mainEngine = new ITMMainEngine(
+    if (capturePolicy != NULL) {
+      if (imuSource != NULL) {
+        // dropping images would put them out of step with the imu data
+        std::cerr << "images with imu data cannot be captured separately"
+                  << '\n';
+        return EXIT_FAILURE;
+      }
+      printf("capturing images on a separate thread (%s)\n", capturePolicy);
+      imageSource = new AsyncImageSourceEngine(imageSource, policy);
+    }
+
+    ITMMainEngine* mainEngine = ITMMainEngine::Make(
         internalSettings, &imageSource->calib, imageSource->getRGBImageSize(),
         imageSource->getDepthImageSize());
 
+    if (tileFolder != NULL) {
+      printf("paging the scene to %s\n", tileFolder);
+      if (!mainEngine->StartTilePager(tileFolder, tileRadius)) {
+        std::cerr << "the scene cannot be paged with these settings" << '\n';
+        return EXIT_FAILURE;
+      }
+    }
+
     CLIEngine::Instance()->Initialise(imageSource, imuSource, mainEngine,
                                       internalSettings->deviceType);
+    if (!renderTypes.empty()) {
+      printf("rendering every %d. frame to %s\n", renderEveryNthFrame,
+             renderFolder);
+      CLIEngine::Instance()->SetRenderOutput(renderTypes, renderEveryNthFrame,
+                                             renderFolder);
+    }
     CLIEngine::Instance()->Run();
+    if (sceneFolder != NULL) {
+      printf("saving scene to %s\n", sceneFolder);
+      mainEngine->SaveSceneToDirectory(sceneFolder);
+    }
     CLIEngine::Instance()->Shutdown();
 
+    if (capturePolicy != NULL) {
+      AsyncImageSourceEngine* asyncSource =
+          static_cast<AsyncImageSourceEngine*>(imageSource);
+      printf("captured %d images, dropped %d\n",
+             asyncSource->GetNoCapturedFrames(),
+             asyncSource->GetNoDroppedFrames());
+    }
+
     delete mainEngine;
     delete internalSettings;
     delete imageSource;
@@ -0,0 +1,258 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include <cstdlib>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "Engine/ImageSourceEngine.h"
+#include "Utils/TrajectoryUtils.h"
+
+using namespace InfiniTAM::Engine;
+
+/// A tracking regime to evaluate, NULL levels keep the one set by
+/// ITMLibSettings::SetTrackerType().
+struct RegimeConfig {
+  const char* name;
+  int noHierarchyLevels;
+  const TrackerIterationType* levels;
+};
+
+struct TrackerConfig {
+  const char* name;
+  ITMLibSettings::TrackerType type;
+};
+
+static const TrackerIterationType regimeThreeLevels[] = {
+    TRACKER_ITERATION_BOTH, TRACKER_ITERATION_BOTH, TRACKER_ITERATION_ROTATION};
+static const TrackerIterationType regimeTwoLevels[] = {
+    TRACKER_ITERATION_BOTH, TRACKER_ITERATION_TRANSLATION};
+
+static const RegimeConfig regimes[] = {
+    {"default", 0, NULL},
+    {"3-levels", 3, regimeThreeLevels},
+    {"2-levels", 2, regimeTwoLevels}};
+
+// the external and the IMU tracker need inputs other than images
+static const TrackerConfig trackers[] = {
+    {"icp", ITMLibSettings::TRACKER_ICP},
+    {"wicp", ITMLibSettings::TRACKER_WICP},
+    {"ren", ITMLibSettings::TRACKER_REN},
+    {"hybrid", ITMLibSettings::TRACKER_HYBRID},
+    {"color", ITMLibSettings::TRACKER_COLOR}};
+
+/// Poses further apart in time are not associated, as in the TUM RGB-D tools
+static const double defaultMaxTimeDifference = 0.02;
+
+struct RunResult {
+  const char *trackerName, *regimeName;
+  int noFrames;
+  float meanTrackingTime, maxTrackingTime;
+  TrajectoryErrors errors;
+};
+
+/** Replays the sequence from the first frame with one configuration. The
+    frames take their @p timestamps, and the ground truth ones of the same
+    index if there are none.
+*/
+static RunResult RunConfiguration(const char* calibFile, const char* rgbMask,
+                                  const char* depthMask, int maxFrames,
+                                  const TrackerConfig& tracker,
+                                  const RegimeConfig& regime,
+                                  const std::vector<double>& timestamps,
+                                  const std::vector<TrajectoryPose>& groundTruth,
+                                  double maxTimeDifference,
+                                  const char* outputDir) {
+  ITMLibSettings* internalSettings = new ITMLibSettings();
+  internalSettings->SetTrackerType(tracker.type);
+  if (regime.levels != NULL)
+    internalSettings->SetTrackingRegime(regime.noHierarchyLevels, regime.levels);
+
+  ImageSourceEngine* imageSource =
+      new ImageFileReader(calibFile, rgbMask, depthMask);
+  ITMMainEngine* mainEngine = ITMMainEngine::Make(
+      internalSettings, &imageSource->calib, imageSource->getRGBImageSize(),
+      imageSource->getDepthImageSize());
+
+  bool allocateGPU =
+      internalSettings->deviceType == ITMLibSettings::DEVICE_CUDA;
+  ITMUChar4Image* inputRGBImage =
+      new ITMUChar4Image(imageSource->getRGBImageSize(), true, allocateGPU);
+  ITMShortImage* inputRawDepthImage =
+      new ITMShortImage(imageSource->getDepthImageSize(), true, allocateGPU);
+
+  std::vector<TrajectoryPose> estimate;
+  RunResult result;
+  result.trackerName = tracker.name;
+  result.regimeName = regime.name;
+  result.meanTrackingTime = 0.0f;
+  result.maxTrackingTime = 0.0f;
+
+  int frameNo = 0;
+  while (frameNo < maxFrames && imageSource->hasMoreImages()) {
+    imageSource->getImages(inputRGBImage, inputRawDepthImage);
+    mainEngine->ProcessFrame(inputRGBImage, inputRawDepthImage);
+
+    // the first frame defines the world coordinate frame and is not tracked
+    float trackingTime = mainEngine->GetLastTrackingTime();
+    if (frameNo > 0) {
+      result.meanTrackingTime += trackingTime;
+      if (trackingTime > result.maxTrackingTime)
+        result.maxTrackingTime = trackingTime;
+    }
+
+    double timestamp;
+    if (!timestamps.empty())
+      timestamp = frameNo < (int)timestamps.size() ? timestamps[frameNo]
+                                                   : (double)frameNo;
+    else
+      timestamp = frameNo < (int)groundTruth.size()
+                      ? groundTruth[frameNo].timestamp
+                      : (double)frameNo;
+    estimate.push_back(MakeTrajectoryPose(
+        timestamp, mainEngine->GetTrackingState()->pose_d->GetM()));
+
+    frameNo++;
+  }
+
+  result.noFrames = frameNo;
+  if (frameNo > 1) result.meanTrackingTime /= (float)(frameNo - 1);
+
+  std::vector<TrajectoryPose> associatedEstimate, associatedGroundTruth;
+  AssociateTrajectories(estimate, groundTruth, maxTimeDifference,
+                        associatedEstimate, associatedGroundTruth);
+  result.errors =
+      EvaluateTrajectory(associatedEstimate, associatedGroundTruth,
+                         (int)associatedEstimate.size());
+
+  if (outputDir != NULL) {
+    char fileName[2048];
+    snprintf(fileName, sizeof(fileName), "%s/%s_%s.txt", outputDir,
+             tracker.name, regime.name);
+    if (!WriteTrajectory(estimate, fileName))
+      printf("could not write trajectory to %s\n", fileName);
+  }
+
+  delete inputRGBImage;
+  delete inputRawDepthImage;
+  delete mainEngine;
+  delete imageSource;
+  delete internalSettings;
+
+  return result;
+}
+
+int main(int argc, char** argv) {
+  const char* timestampFile = NULL;
+  double maxTimeDifference = defaultMaxTimeDifference;
+
+  // the named arguments come first, each with one value
+  int firstArg = 1;
+  while (firstArg + 1 < argc && strncmp(argv[firstArg], "--", 2) == 0) {
+    const char* name = argv[firstArg];
+    const char* value = argv[firstArg + 1];
+    if (strcmp(name, "--timestamps") == 0) {
+      timestampFile = value;
+    } else if (strcmp(name, "--max-difference") == 0) {
+      maxTimeDifference = atof(value);
+    } else {
+      printf("unknown argument %s\n", name);
+      return EXIT_FAILURE;
+    }
+    firstArg += 2;
+  }
+
+  if (argc - firstArg < 4) {
+    printf(
+        "usage: %s [--timestamps <timestamps>] [--max-difference <seconds>]\n"
+        "          <calibfile> <rgbmask> <depthmask> <groundtruth> "
+        "[<noframes> [<outputdir>]]\n"
+        "  <timestamps>  : timestamps of the images in their first column, "
+        "one per image,\n"
+        "                  e.g. depth.txt of TUM RGB-D or data.csv of "
+        "ETH/EuRoC; without\n"
+        "                  them the i-th image takes the timestamp of the "
+        "i-th pose of the\n"
+        "                  ground truth\n"
+        "  <seconds>     : poses further apart in time are not associated, "
+        "%g by default\n"
+        "  <groundtruth> : camera poses in the TUM RGB-D (timestamp tx ty tz "
+        "qx qy qz qw)\n"
+        "                  or ETH/EuRoC (timestamp,px,py,pz,qw,qx,qy,qz) "
+        "format, each\n"
+        "                  estimated pose is compared with the one of the "
+        "nearest timestamp\n"
+        "  <noframes>    : number of frames to replay, all by default\n"
+        "  <outputdir>   : if given, the estimated trajectories are written "
+        "there\n"
+        "\n"
+        "Replays the sequence with every tracker and tracking regime and "
+        "reports the\n"
+        "absolute trajectory error (ATE) and the relative pose error between "
+        "consecutive\n"
+        "frames (RPE) together with the time spent in the tracker.\n\n",
+        argv[0], defaultMaxTimeDifference);
+    return EXIT_FAILURE;
+  }
+
+  const char* calibFile = argv[firstArg];
+  const char* rgbMask = argv[firstArg + 1];
+  const char* depthMask = argv[firstArg + 2];
+  const char* groundTruthFile = argv[firstArg + 3];
+  int maxFrames = argc > firstArg + 4 ? atoi(argv[firstArg + 4]) : 0;
+  const char* outputDir = argc > firstArg + 5 ? argv[firstArg + 5] : NULL;
+
+  std::vector<TrajectoryPose> groundTruth;
+  if (!ReadTrajectory(groundTruth, groundTruthFile) || groundTruth.empty()) {
+    printf("could not read ground truth from %s\n", groundTruthFile);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<double> timestamps;
+  if (timestampFile != NULL &&
+      (!ReadTimestamps(timestamps, timestampFile) || timestamps.empty())) {
+    printf("could not read timestamps from %s\n", timestampFile);
+    return EXIT_FAILURE;
+  }
+
+  int noTimestamps =
+      timestamps.empty() ? (int)groundTruth.size() : (int)timestamps.size();
+  if (maxFrames <= 0 || maxFrames > noTimestamps) maxFrames = noTimestamps;
+
+  // every run uses the voxel type of the default settings
+  const ITMLibSettings defaultSettings;
+
+  std::vector<RunResult> results;
+  for (size_t t = 0; t < sizeof(trackers) / sizeof(trackers[0]); t++) {
+    if (trackers[t].type == ITMLibSettings::TRACKER_COLOR &&
+        !defaultSettings.VoxelHasColourInformation())
+      continue;
+
+    for (size_t r = 0; r < sizeof(regimes) / sizeof(regimes[0]); r++) {
+      printf("running %s with the %s regime ...\n", trackers[t].name,
+             regimes[r].name);
+      results.push_back(RunConfiguration(calibFile, rgbMask, depthMask,
+                                         maxFrames, trackers[t], regimes[r],
+                                         timestamps, groundTruth,
+                                         maxTimeDifference, outputDir));
+    }
+  }
+
+  printf(
+      "\n%-8s %-10s %6s %6s %10s %10s %10s %12s %12s %10s %10s\n", "tracker",
+      "regime", "frames", "poses", "ate_rmse", "ate_mean", "ate_max", "rpe_t_rmse",
+      "rpe_r_rmse", "track_ms", "max_ms");
+  for (size_t i = 0; i < results.size(); i++) {
+    const RunResult& r = results[i];
+    printf("%-8s %-10s %6d %6d %10.4f %10.4f %10.4f %12.4f %12.4f %10.2f "
+           "%10.2f\n",
+           r.trackerName, r.regimeName, r.noFrames, r.errors.noPoses,
+           r.errors.ate_rmse,
+           r.errors.ate_mean, r.errors.ate_max, r.errors.rpe_translation_rmse,
+           r.errors.rpe_rotation_rmse, r.meanTrackingTime, r.maxTrackingTime);
+  }
+  printf("(poses associated with the ground truth, translations in its units, "
+         "rotations in\ndegrees, times in ms per frame)\n");
+
+  return EXIT_SUCCESS;
+}
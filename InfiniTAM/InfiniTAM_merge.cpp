@@ -0,0 +1,134 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "ITMLib/ITMLib.h"
+#include "ITMLib/Utils/ITMLibSettingsIO.h"
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+/// Loads scene A and B, aligns B to A, fuses B into A and saves A.
+template <class TVoxel>
+static void MergeScenes(const ITMLibSettings& settings,
+                        const Matrix4f& initialGuess, const char* sceneDirA,
+                        const char* sceneDirB, const char* outputDir, TVoxel*,
+                        ITMVoxelBlockHash*) {
+  typedef ITMScene<TVoxel, ITMVoxelBlockHash> Scene;
+  Scene sceneA(&settings.sceneParams, false, MEMORYDEVICE_CPU);
+  Scene sceneB(&settings.sceneParams, false, MEMORYDEVICE_CPU);
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  sceneA.LoadFromDirectory(sceneDirA);
+  sceneB.LoadFromDirectory(sceneDirB);
+  printf("loaded scenes in %.1f ms\n", MillisecondsSince(start));
+
+  ITMSceneMerger<TVoxel, ITMVoxelBlockHash> merger;
+
+  start = std::chrono::steady_clock::now();
+  Matrix4f M_BtoA = merger.EstimateTransform(&sceneA, &sceneB, initialGuess);
+  printf("aligned %d points in %.1f ms, rms %.2f mm\n",
+         merger.GetNoAlignedPoints(), MillisecondsSince(start),
+         merger.GetAlignmentRMS() * 1000.0f);
+
+  ITMPose pose(M_BtoA);
+  Vector3f translation, rotation;
+  pose.GetParams(translation, rotation);
+  printf("transform from B to A: %f %f %f %f %f %f\n", translation.x,
+         translation.y, translation.z, rotation.x, rotation.y, rotation.z);
+
+  start = std::chrono::steady_clock::now();
+  merger.MergeInto(&sceneA, &sceneB, M_BtoA);
+  printf("merged %d blocks (%d new, %d dropped) in %.1f ms\n",
+         merger.GetNoBlocksMerged(), merger.GetNoBlocksAllocated(),
+         merger.GetNoBlocksDropped(), MillisecondsSince(start));
+
+  sceneA.SaveToDirectory(outputDir);
+}
+
+template <class TVoxel>
+static void MergeScenes(const ITMLibSettings&, const Matrix4f&, const char*,
+                        const char*, const char*, TVoxel*,
+                        ITMPlainVoxelArray*) {
+  throw std::runtime_error("only scenes with a voxel block hash can be merged");
+}
+
+#define MERGE_SCENES(X, TVoxel, TIndex)                                \
+  if (settings->voxelType == ITMLibSettings::VoxelTypeOf<TVoxel>() &&  \
+      settings->indexType == ITMLibSettings::IndexTypeOf<TIndex>()) {  \
+    MergeScenes(*settings, initialGuess.GetM(), argv[firstArg],        \
+                argv[firstArg + 1], argv[firstArg + 2], (TVoxel*)NULL, \
+                (TIndex*)NULL);                                        \
+    delete settings;                                                   \
+    return 0;                                                          \
+  }
+
+int main(int argc, char** argv) {
+  try {
+    const char* settingsFile = NULL;
+    ITMPose initialGuess;
+
+    // the named arguments come first
+    int firstArg = 1;
+    while (firstArg < argc && strncmp(argv[firstArg], "--", 2) == 0) {
+      const char* name = argv[firstArg];
+      if (strcmp(name, "--settings") == 0 && firstArg + 1 < argc) {
+        settingsFile = argv[firstArg + 1];
+        firstArg += 2;
+      } else if (strcmp(name, "--guess") == 0 && firstArg + 6 < argc) {
+        float params[6];
+        for (int i = 0; i < 6; i++) params[i] = atof(argv[firstArg + 1 + i]);
+        initialGuess.SetFrom(params);
+        firstArg += 7;
+      } else {
+        std::cerr << "unknown or incomplete argument " << name << '\n';
+        return EXIT_FAILURE;
+      }
+    }
+
+    if (argc - firstArg != 3) {
+      printf(
+          "usage: %s [--settings <settingsfile>] [--guess <tx> <ty> <tz> "
+          "<rx> <ry> <rz>]\n"
+          "          <scenedir A> <scenedir B> <outputdir>\n"
+          "  <settingsfile>: ITMLibSettings the scenes were mapped with\n"
+          "  <tx> ... <rz> : rough transform from scene B to scene A, as "
+          "translation\n"
+          "                  in metres and rotation vector in radians, "
+          "identity by\n"
+          "                  default\n"
+          "  <scenedir>    : directories written with --save-scene of "
+          "InfiniTAM_cli\n"
+          "  <outputdir>   : existing directory for the merged scene\n",
+          argv[0]);
+      return EXIT_FAILURE;
+    }
+
+    ITMLibSettings* settings = new ITMLibSettings();
+    if (settingsFile != NULL && !readLibSettings(settingsFile, *settings)) {
+      std::cerr << "failed to read the settings file" << '\n';
+      return EXIT_FAILURE;
+    }
+    if (settings->useSwapping) {
+      std::cerr << "scenes mapped with swapping cannot be merged" << '\n';
+      return EXIT_FAILURE;
+    }
+
+    ITMLIB_FOR_EACH_VOXEL_INDEX(MERGE_SCENES, )
+
+    std::cerr << "ITMLib is not compiled for the selected voxel and index type"
+              << '\n';
+    return EXIT_FAILURE;
+  } catch (std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return EXIT_FAILURE;
+  }
+}
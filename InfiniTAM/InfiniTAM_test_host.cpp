@@ -0,0 +1,239 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+#include "Engine/SyntheticImageSource.h"
+#include "ITMLib/Engine/ITMBasicEngine.h"
+#include "ITMLib/Engine/ITMEngineHost.h"
+
+using namespace InfiniTAM::Engine;
+
+typedef ITMScene<ITMVoxel, ITMVoxelBlockHash> Scene;
+typedef ITMBasicEngine<ITMVoxel, ITMVoxelBlockHash> BasicEngine;
+
+static const int noEngines = 4;
+
+/// Enough for the synthetic room, so that the engines fit into memory at once
+static const int noVoxelBlocks = 0x4000;
+
+/// Frames of the sequence in memory, so that the runs time processing only
+struct Sequence {
+  ITMRGBDCalib calib;
+  Vector2i imgSize;
+  std::vector<ITMUChar4Image*> rgb;
+  std::vector<ITMShortImage*> depth;
+};
+
+struct RunResult {
+  unsigned long long sceneHash, raycastHash;
+  int noBlocks;
+};
+
+/// Sum of the checksums of the allocated blocks, with their positions, which
+/// does not depend on where in the hash table and the VBA they are
+static unsigned long long SceneChecksum(Scene* scene, int& noBlocks) {
+  const ITMHashEntry* entries = scene->index.GetEntries();
+  const ITMVoxel* voxelBlocks = scene->localVBA.GetVoxelBlocks();
+
+  unsigned long long sum = 0;
+  noBlocks = 0;
+  for (int entryId = 0; entryId < scene->index.noTotalEntries; entryId++) {
+    const ITMHashEntry& entry = entries[entryId];
+    if (entry.ptr < 0) continue;
+
+    unsigned long long hash = 1469598103934665603ull ^
+                              (unsigned long long)(entry.pos.x * 73856093 ^
+                                                   entry.pos.y * 19349663 ^
+                                                   entry.pos.z * 83492791);
+    const unsigned char* data =
+        (const unsigned char*)(voxelBlocks + entry.ptr * SDF_BLOCK_SIZE3);
+    for (size_t i = 0; i < SDF_BLOCK_SIZE3 * sizeof(ITMVoxel); i++) {
+      hash ^= data[i];
+      hash *= 1099511628211ull;
+    }
+    sum += hash;
+    noBlocks++;
+  }
+  return sum;
+}
+
+/// Hashes the scene and the raycast of the engine after its last frame
+static bool HashEngine(ITMMainEngine* mainEngine, Vector2i imgSize,
+                       RunResult& result) {
+  BasicEngine* engine = dynamic_cast<BasicEngine*>(mainEngine);
+  if (engine == NULL) {
+    printf("the settings do not select ITMVoxel in a voxel block hash\n");
+    return false;
+  }
+  result.sceneHash = SceneChecksum(engine->GetScene(), result.noBlocks);
+
+  ITMUChar4Image raycast(imgSize, true, false);
+  mainEngine->GetImage(&raycast, ITMMainEngine::InfiniTAM_IMAGE_SCENERAYCAST);
+  const Vector4u* pixels = raycast.GetData(MEMORYDEVICE_CPU);
+  result.raycastHash = 1469598103934665603ull;
+  for (int i = 0; i < imgSize.x * imgSize.y; i++) {
+    result.raycastHash ^= pixels[i].x;
+    result.raycastHash *= 1099511628211ull;
+  }
+  return true;
+}
+
+static void MakeSettings(ITMLibSettings& settings) {
+  settings.SetTrackerType(ITMLibSettings::TRACKER_ICP);
+  settings.noVoxelBlocks = noVoxelBlocks;
+}
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+/// Processes the sequence with an engine of its own, returns the time in ms
+static double RunSingle(const Sequence& sequence, RunResult& result,
+                        bool& isValid) {
+  ITMLibSettings settings;
+  MakeSettings(settings);
+  ITMMainEngine* engine = ITMMainEngine::Make(&settings, &sequence.calib,
+                                              sequence.imgSize, sequence.imgSize);
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (size_t f = 0; f < sequence.rgb.size(); f++)
+    engine->ProcessFrame(sequence.rgb[f], sequence.depth[f]);
+  double time = MillisecondsSince(start);
+
+  isValid = HashEngine(engine, sequence.imgSize, result);
+  delete engine;
+  return time;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf(
+        "usage: %s <calibfile> [<noframes> [<rgbmask> <depthmask>]]\n"
+        "  <noframes>  : number of frames to process, 20 by default\n"
+        "  <rgbmask>   : processes recorded images, a synthetic room is "
+        "rendered\n"
+        "  <depthmask>   otherwise\n"
+        "\n"
+        "Processes the sequence with %d engines of one ITMEngineHost, fed "
+        "concurrently,\n"
+        "and %d times with an engine of its own, all with the ICP tracker. "
+        "Fails if a\n"
+        "hosted engine ends with a different scene or raycast than the "
+        "single runs.\n\n",
+        argv[0], noEngines, noEngines);
+    return EXIT_FAILURE;
+  }
+
+  int noFrames = argc > 2 ? atoi(argv[2]) : 20;
+
+  ImageSourceEngine* imageSource;
+  if (argc > 4)
+    imageSource = new ImageFileReader(argv[1], argv[3], argv[4]);
+  else
+    imageSource = new SyntheticImageSource(
+        argv[1], SyntheticImageSource::SCENE_ROOM, noFrames);
+
+  Sequence sequence;
+  sequence.calib = imageSource->calib;
+  while ((int)sequence.rgb.size() < noFrames && imageSource->hasMoreImages()) {
+    sequence.rgb.push_back(new ITMUChar4Image(true, false));
+    sequence.depth.push_back(new ITMShortImage(true, false));
+    imageSource->getImages(sequence.rgb.back(), sequence.depth.back());
+  }
+  delete imageSource;
+
+  if (sequence.rgb.empty()) {
+    printf("no images to process\n");
+    return EXIT_FAILURE;
+  }
+  sequence.imgSize = sequence.depth[0]->noDims;
+
+  bool isFailed = false;
+
+  std::vector<RunResult> singleResults(noEngines);
+  double singleTime = 0.0;
+  for (int e = 0; e < noEngines; e++) {
+    bool isValid;
+    singleTime += RunSingle(sequence, singleResults[e], isValid);
+    if (!isValid) return EXIT_FAILURE;
+    if (singleResults[e].sceneHash != singleResults[0].sceneHash ||
+        singleResults[e].raycastHash != singleResults[0].raycastHash) {
+      printf("FAILED: single run %d differs from the first one\n", e);
+      isFailed = true;
+    }
+  }
+  int noProcessed = noEngines * (int)sequence.rgb.size();
+  printf("single runs: %d blocks, scene %016llx, raycast %016llx, %.2f fps\n",
+         singleResults[0].noBlocks, singleResults[0].sceneHash,
+         singleResults[0].raycastHash, noProcessed / singleTime * 1000.0);
+
+  std::vector<ITMLibSettings> settings(noEngines);
+  ITMEngineHost host(0, 0, noEngines);
+  std::vector<int> engineIds;
+  for (int e = 0; e < noEngines; e++) {
+    MakeSettings(settings[e]);
+    engineIds.push_back(host.AddEngine(&settings[e], &sequence.calib,
+                                       sequence.imgSize, sequence.imgSize));
+  }
+
+  // not vector<bool>, whose elements share bytes across the feeders
+  std::vector<char> isFed(noEngines, 1);
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  std::vector<std::thread> feeders;
+  for (int e = 0; e < noEngines; e++)
+    feeders.push_back(std::thread([&, e]() {
+      try {
+        for (size_t f = 0; f < sequence.rgb.size(); f++)
+          host.ProcessFrame(engineIds[e], sequence.rgb[f], sequence.depth[f]);
+      } catch (std::exception& exception) {
+        printf("engine %d: %s\n", e, exception.what());
+        isFed[e] = 0;
+      }
+    }));
+  for (size_t e = 0; e < feeders.size(); e++) feeders[e].join();
+  double hostTime = MillisecondsSince(start);
+  printf("host with %d threads and %d concurrent frames: %.2f fps\n",
+         host.GetNumThreads(), host.GetNumConcurrentFrames(),
+         noProcessed / hostTime * 1000.0);
+
+  for (int e = 0; e < noEngines; e++) {
+    RunResult result;
+    if (!isFed[e] ||
+        !HashEngine(host.GetEngine(engineIds[e]), sequence.imgSize, result)) {
+      printf("FAILED: engine %d did not process the sequence\n", e);
+      isFailed = true;
+      continue;
+    }
+
+    ITMEngineHost::EngineStats stats = host.GetStats(engineIds[e]);
+    printf("engine %d: %d blocks, scene %016llx, raycast %016llx, %d frames "
+           "in %.1f ms each, waited %.1f ms each\n",
+           e, result.noBlocks, result.sceneHash, result.raycastHash,
+           stats.noProcessedFrames,
+           stats.totalProcessTime / MAX(stats.noProcessedFrames, 1),
+           stats.totalWaitTime / MAX(stats.noProcessedFrames, 1));
+
+    if (result.sceneHash != singleResults[0].sceneHash ||
+        result.raycastHash != singleResults[0].raycastHash) {
+      printf("FAILED: engine %d differs from the single runs\n", e);
+      isFailed = true;
+    }
+  }
+
+  for (size_t f = 0; f < sequence.rgb.size(); f++) {
+    delete sequence.rgb[f];
+    delete sequence.depth[f];
+  }
+
+  if (!isFailed) printf("passed\n");
+  return isFailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,256 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include <chrono>
+#include <cstdlib>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Engine/SyntheticImageSource.h"
+#include "ITMLib/Engine/ITMBasicEngine.h"
+#include "ITMLib/Engine/ITMMapClient.h"
+
+using namespace InfiniTAM::Engine;
+
+typedef ITMBasicEngine<ITMVoxel, ITMVoxelBlockHash> BasicEngine;
+
+/// Largest difference in metres between the points raycast by the server
+/// and by the client
+static const float maxPointDifference = 1e-4f;
+
+static bool ReadAll(int fd, void* data, size_t size) {
+  char* bytes = (char*)data;
+  while (size > 0) {
+    ssize_t n = read(fd, bytes, size);
+    if (n <= 0) return false;
+    bytes += n;
+    size -= (size_t)n;
+  }
+  return true;
+}
+
+static bool WriteAll(int fd, const void* data, size_t size) {
+  const char* bytes = (const char*)data;
+  while (size > 0) {
+    ssize_t n = write(fd, bytes, size);
+    if (n <= 0) return false;
+    bytes += n;
+    size -= (size_t)n;
+  }
+  return true;
+}
+
+static Vector4f InvProjParams(const ITMIntrinsics& intrinsics) {
+  return Vector4f(1.0f / intrinsics.projectionParamsSimple.fx,
+                  1.0f / intrinsics.projectionParamsSimple.fy,
+                  intrinsics.projectionParamsSimple.px,
+                  intrinsics.projectionParamsSimple.py);
+}
+
+/** The client process: queries the map with random interpolated lookups
+    while the server integrates, until the server sends the pose to raycast
+    from, and returns the raycast through @p toServer.
+*/
+static int RunClient(const char* name, int fromServer, int toServer,
+                     const ITMRGBDCalib& calib, Vector2i imgSize) {
+  ITMMapClient<ITMVoxel> client(name);
+  if (!client.IsOpen()) {
+    printf("client: could not open the map %s\n", name);
+    return EXIT_FAILURE;
+  }
+
+  long noQueries = 0, noNearSurface = 0;
+  unsigned int seed = 1;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  while (true) {
+    pollfd request = {fromServer, POLLIN, 0};
+    if (poll(&request, 1, 0) != 0) break;
+
+    for (int i = 0; i < 1000; i++) {
+      float coordinates[3];
+      for (int c = 0; c < 3; c++) {
+        seed = seed * 1664525u + 1013904223u;
+        coordinates[c] = ((seed >> 8) % 4000) / 1000.0f - 2.0f;
+      }
+      bool isFound;
+      float sdf = client.ReadSDFInterpolated(
+          Vector3f(coordinates[0], coordinates[1], coordinates[2] + 2.0f),
+          isFound);
+      if (sdf < 1.0f) noNearSurface++;
+    }
+    noQueries += 1000;
+  }
+  double queryTime = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  printf("client: %ld interpolated lookups while the server integrated "
+         "(%.2f M/s), %ld within the truncation band\n",
+         noQueries, noQueries / queryTime / 1e6, noNearSurface);
+
+  Matrix4f invM;
+  if (!ReadAll(fromServer, &invM, sizeof(invM))) return EXIT_FAILURE;
+
+  Vector4f invProjParams = InvProjParams(calib.intrinsics_d);
+  std::vector<Vector4f> points(imgSize.x * imgSize.y);
+  start = std::chrono::steady_clock::now();
+  for (int y = 0; y < imgSize.y; y++)
+    for (int x = 0; x < imgSize.x; x++)
+      client.CastRay(points[x + y * imgSize.x], x, y, invM, invProjParams);
+  printf("client: raycast in %.1f ms\n",
+         std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+             .count());
+
+  if (!WriteAll(toServer, &points[0], points.size() * sizeof(Vector4f)))
+    return EXIT_FAILURE;
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf(
+        "usage: %s <calibfile> [<noframes> [<rgbmask> <depthmask>]]\n"
+        "  <noframes>  : number of frames to integrate, 20 by default\n"
+        "  <rgbmask>   : integrates recorded images with the ICP tracker, a "
+        "synthetic\n"
+        "  <depthmask>   room with ground truth poses is rendered otherwise\n"
+        "\n"
+        "Shares the scene through a map server with a forked client "
+        "process, which\n"
+        "queries it while the frames are integrated. Fails if the raycast of "
+        "the client\n"
+        "differs from the one of the server.\n\n",
+        argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int noFrames = argc > 2 ? atoi(argv[2]) : 20;
+
+  ImageSourceEngine* imageSource;
+  SyntheticImageSource* syntheticSource = NULL;
+  if (argc > 4) {
+    imageSource = new ImageFileReader(argv[1], argv[3], argv[4]);
+  } else {
+    syntheticSource = new SyntheticImageSource(
+        argv[1], SyntheticImageSource::SCENE_ROOM, noFrames);
+    imageSource = syntheticSource;
+  }
+
+  ITMLibSettings settings;
+  if (syntheticSource == NULL)
+    settings.SetTrackerType(ITMLibSettings::TRACKER_ICP);
+
+  Vector2i imgSize = imageSource->getDepthImageSize();
+  ITMMainEngine* mainEngine =
+      ITMMainEngine::Make(&settings, &imageSource->calib,
+                          imageSource->getRGBImageSize(), imgSize);
+  BasicEngine* engine = dynamic_cast<BasicEngine*>(mainEngine);
+  if (engine == NULL) {
+    printf("the settings do not select ITMVoxel in a voxel block hash\n");
+    return EXIT_FAILURE;
+  }
+
+  char name[64];
+  snprintf(name, sizeof(name), "/InfiniTAM_test_%d", (int)getpid());
+  if (!mainEngine->StartMapServer(name)) {
+    printf("could not start the map server %s\n", name);
+    return EXIT_FAILURE;
+  }
+
+  int toClient[2], toServer[2];
+  if (pipe(toClient) != 0 || pipe(toServer) != 0) {
+    printf("could not create the pipes\n");
+    return EXIT_FAILURE;
+  }
+
+  // a client that failed must not take the server down with SIGPIPE
+  signal(SIGPIPE, SIG_IGN);
+
+  fflush(stdout);
+  pid_t client = fork();
+  if (client < 0) {
+    printf("could not fork the client\n");
+    return EXIT_FAILURE;
+  }
+  if (client == 0) {
+    int result = RunClient(name, toClient[0], toServer[1], imageSource->calib,
+                           imgSize);
+    fflush(stdout);
+    _exit(result);
+  }
+
+  ITMUChar4Image* rgb = new ITMUChar4Image(true, false);
+  ITMShortImage* rawDepth = new ITMShortImage(true, false);
+  int frameNo = 0;
+  for (; frameNo < noFrames && imageSource->hasMoreImages(); frameNo++) {
+    imageSource->getImages(rgb, rawDepth);
+    if (syntheticSource != NULL)
+      engine->GetTrackingState()->pose_d->SetFrom(
+          &syntheticSource->getCurrentPose());
+    mainEngine->ProcessFrame(rgb, rawDepth);
+  }
+  printf("server: integrated %d frames\n", frameNo);
+
+  Matrix4f invM = engine->GetTrackingState()->pose_d->GetInvM();
+  std::vector<Vector4f> clientPoints(imgSize.x * imgSize.y);
+  bool isReceived =
+      WriteAll(toClient[1], &invM, sizeof(invM)) &&
+      ReadAll(toServer[0], &clientPoints[0],
+              clientPoints.size() * sizeof(Vector4f));
+
+  int status = 0;
+  waitpid(client, &status, 0);
+  if (!isReceived || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    printf("FAILED: the client did not return a raycast\n");
+    return EXIT_FAILURE;
+  }
+
+  ITMScene<ITMVoxel, ITMVoxelBlockHash>* scene = engine->GetScene();
+  const ITMSceneParams& sceneParams = *scene->sceneParams;
+  Vector4f invProjParams = InvProjParams(imageSource->calib.intrinsics_d);
+  long noHits = 0, noDifferent = 0;
+  float maxDifference = 0.0f;
+  for (int y = 0; y < imgSize.y; y++)
+    for (int x = 0; x < imgSize.x; x++) {
+      Vector4f pt;
+      castRay<ITMVoxel, ITMVoxelBlockHash>(
+          pt, x, y, scene->localVBA.GetVoxelBlocks(),
+          scene->index.getIndexData(), invM, invProjParams,
+          1.0f / sceneParams.voxelSize, sceneParams.mu,
+          Vector2f(sceneParams.viewFrustum_min, sceneParams.viewFrustum_max));
+
+      const Vector4f& clientPt = clientPoints[x + y * imgSize.x];
+      if (pt.w > 0.0f) noHits++;
+      if ((pt.w > 0.0f) != (clientPt.w > 0.0f)) {
+        noDifferent++;
+        continue;
+      }
+      if (pt.w <= 0.0f) continue;
+
+      float difference = sceneParams.voxelSize *
+                         MAX(fabsf(pt.x - clientPt.x),
+                             MAX(fabsf(pt.y - clientPt.y),
+                                 fabsf(pt.z - clientPt.z)));
+      if (difference > maxDifference) maxDifference = difference;
+      if (difference > maxPointDifference) noDifferent++;
+    }
+  printf("server: %ld of %d pixels hit the surface, the client differs in "
+         "%ld (max %g m)\n",
+         noHits, imgSize.x * imgSize.y, noDifferent, maxDifference);
+
+  delete rgb;
+  delete rawDepth;
+  delete mainEngine;
+  delete imageSource;
+
+  if (noHits == 0 || noDifferent > 0) {
+    printf("FAILED: the raycast of the client differs from the server\n");
+    return EXIT_FAILURE;
+  }
+  printf("passed\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,182 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include <chrono>
+#include <cstdlib>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+#include "Engine/SyntheticImageSource.h"
+#include "ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h"
+#include "ITMLib/Engine/ITMBasicEngine.h"
+
+using namespace InfiniTAM::Engine;
+
+typedef ITMScene<ITMVoxel, ITMVoxelBlockHash> Scene;
+typedef ITMBasicEngine<ITMVoxel, ITMVoxelBlockHash> BasicEngine;
+
+static const int noFrames = 20;
+
+/// Largest errors of the estimated transform, in metres and degrees
+static const float maxTranslationError = 0.005f;
+static const float maxRotationError = 0.5f;
+
+/// Largest mean difference of the SDF near the surface after merging, as a
+/// fraction of the truncation band
+static const float maxMeanSDFDifference = 0.05f;
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+/** Maps the synthetic room in the coordinates of a world that @p M_toRoom
+    moves into those of the room, and returns the time spent in
+    ProcessFrame() in ms.
+*/
+static double MapRoom(BasicEngine* engine, const char* calibFile,
+                      const Matrix4f& M_toRoom) {
+  SyntheticImageSource imageSource(calibFile, SyntheticImageSource::SCENE_ROOM,
+                                   noFrames);
+  ITMUChar4Image rgb(true, false);
+  ITMShortImage rawDepth(true, false);
+
+  double totalTime = 0.0;
+  while (imageSource.hasMoreImages()) {
+    imageSource.getImages(&rgb, &rawDepth);
+    engine->GetTrackingState()->pose_d->SetM(
+        imageSource.getCurrentPose().GetM() * M_toRoom);
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    engine->ProcessFrame(&rgb, &rawDepth);
+    totalTime += MillisecondsSince(start);
+  }
+  return totalTime;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf(
+        "usage: %s <calibfile>\n"
+        "\n"
+        "Maps a synthetic room twice, the second time in coordinates moved "
+        "by a known\n"
+        "transform, and merges the second scene into the first from a "
+        "perturbed guess.\n"
+        "Fails if the estimated transform misses the known one or if the "
+        "merged SDF\n"
+        "differs from the original.\n\n",
+        argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  ITMLibSettings settings;
+  SyntheticImageSource calibSource(argv[1], SyntheticImageSource::SCENE_ROOM,
+                                   0);
+  Vector2i imgSize = calibSource.getDepthImageSize();
+  BasicEngine engineA(&settings, &calibSource.calib, imgSize, imgSize);
+  BasicEngine engineB(&settings, &calibSource.calib, imgSize, imgSize);
+
+  ITMPose knownTransform, guess;
+  knownTransform.SetFrom(0.1f, -0.05f, 0.08f, 0.02f, 0.05f, -0.03f);
+  guess.SetFrom(0.11f, -0.045f, 0.072f, 0.025f, 0.045f, -0.025f);
+  Matrix4f identity;
+  identity.setIdentity();
+
+  double timeA = MapRoom(&engineA, argv[1], identity);
+  double timeB = MapRoom(&engineB, argv[1], knownTransform.GetM());
+  Scene* sceneA = engineA.GetScene();
+  Scene* sceneB = engineB.GetScene();
+
+  // the original of scene A, to compare the merged scene with
+  std::vector<ITMHashEntry> entries(
+      sceneA->index.GetEntries(),
+      sceneA->index.GetEntries() + sceneA->index.noTotalEntries);
+  std::vector<ITMVoxel> voxelBlocks(
+      sceneA->localVBA.GetVoxelBlocks(),
+      sceneA->localVBA.GetVoxelBlocks() + sceneA->localVBA.allocatedSize);
+
+  ITMSceneMerger<ITMVoxel, ITMVoxelBlockHash> merger;
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  Matrix4f estimate = merger.EstimateTransform(sceneA, sceneB, guess.GetM());
+  double estimateTime = MillisecondsSince(start);
+
+  // the error of the estimate as the transform between the two
+  ITMPose error(estimate * knownTransform.GetInvM());
+  Vector3f translationError, rotationError;
+  error.GetParams(translationError, rotationError);
+  float translationErrorNorm = sqrtf(dot(translationError, translationError));
+  float rotationErrorNorm =
+      sqrtf(dot(rotationError, rotationError)) * 180.0f / (float)M_PI;
+  printf("aligned %d points in %.1f ms, rms %.2f mm, error of the transform "
+         "%.2f mm and %.3f degrees\n",
+         merger.GetNoAlignedPoints(), estimateTime,
+         merger.GetAlignmentRMS() * 1000.0f, translationErrorNorm * 1000.0f,
+         rotationErrorNorm);
+
+  start = std::chrono::steady_clock::now();
+  merger.MergeInto(sceneA, sceneB, estimate);
+  double mergeTime = MillisecondsSince(start);
+  printf("merged %d blocks (%d new, %d dropped) in %.1f ms, integrating the "
+         "%d frames of B took %.1f ms (A %.1f ms)\n",
+         merger.GetNoBlocksMerged(), merger.GetNoBlocksAllocated(),
+         merger.GetNoBlocksDropped(), mergeTime, noFrames, timeB, timeA);
+
+  // the merged SDF at the observed voxels of the original within half the
+  // truncation band, where both sessions saw the same surface
+  double sumDifference = 0.0;
+  float maxDifference = 0.0f;
+  long noCompared = 0, noMissing = 0;
+  ITMVoxelBlockHash::IndexCache cache;
+  for (size_t entryId = 0; entryId < entries.size(); entryId++) {
+    const ITMHashEntry& entry = entries[entryId];
+    if (entry.ptr < 0) continue;
+
+    for (int locId = 0; locId < SDF_BLOCK_SIZE3; locId++) {
+      const ITMVoxel& original = voxelBlocks[entry.ptr * SDF_BLOCK_SIZE3 + locId];
+      float sdf = ITMVoxel::SDF_valueToFloat(original.sdf);
+      if (original.w_depth == 0 || fabsf(sdf) > 0.5f) continue;
+
+      Vector3i pos = entry.pos.toInt() * SDF_BLOCK_SIZE +
+                     Vector3i(locId % SDF_BLOCK_SIZE,
+                              (locId / SDF_BLOCK_SIZE) % SDF_BLOCK_SIZE,
+                              locId / (SDF_BLOCK_SIZE * SDF_BLOCK_SIZE));
+      bool isFound;
+      ITMVoxel merged =
+          readVoxel(sceneA->localVBA.GetVoxelBlocks(),
+                    sceneA->index.GetEntries(), pos, isFound, cache);
+      if (!isFound || merged.w_depth == 0) {
+        noMissing++;
+        continue;
+      }
+
+      float difference = fabsf(ITMVoxel::SDF_valueToFloat(merged.sdf) - sdf);
+      sumDifference += difference;
+      if (difference > maxDifference) maxDifference = difference;
+      noCompared++;
+    }
+  }
+  float meanDifference =
+      noCompared > 0 ? (float)(sumDifference / noCompared) : 1.0f;
+  printf("SDF near the surface differs from the original by %.4f on average, "
+         "at most %.4f, over %ld voxels (%ld missing), in units of the "
+         "truncation band\n",
+         meanDifference, maxDifference, noCompared, noMissing);
+
+  bool isPassed = true;
+  if (translationErrorNorm > maxTranslationError ||
+      rotationErrorNorm > maxRotationError) {
+    printf("FAILED: the estimated transform misses the known one\n");
+    isPassed = false;
+  }
+  if (noMissing > 0 || meanDifference > maxMeanSDFDifference) {
+    printf("FAILED: the merged SDF differs from the original\n");
+    isPassed = false;
+  }
+  if (isPassed) printf("passed\n");
+  return isPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,295 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "Engine/SyntheticImageSource.h"
+#include "ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h"
+#include "ITMLib/Engine/DeviceAgnostic/ITMVisualisationEngine.h"
+#include "ITMLib/Engine/ITMBasicEngine.h"
+
+using namespace InfiniTAM::Engine;
+
+typedef ITMBasicEngine<ITMVoxel, ITMVoxelBlockHash> BasicEngine;
+
+static const int noReaders = 4;
+static const int noLookupsPerView = 100000;
+static const float maxThroughputRegression = 0.1f;
+
+/// Frames of the sequence in memory, so that the replays time fusion only
+struct Sequence {
+  ITMRGBDCalib calib;
+  Vector2i imgSize;
+  std::vector<ITMUChar4Image*> rgb;
+  std::vector<ITMShortImage*> depth;
+  /// Ground truth for the external tracker, empty if the poses are tracked
+  std::vector<ITMPose> poses;
+};
+
+struct ReaderStats {
+  std::atomic<long> noViews, noBlocksChecked, noLookups, noRaycastHits;
+  std::atomic<long> noMismatches, noLookupsMissed;
+
+  ReaderStats()
+      : noViews(0),
+        noBlocksChecked(0),
+        noLookups(0),
+        noRaycastHits(0),
+        noMismatches(0),
+        noLookupsMissed(0) {}
+};
+
+static unsigned long long BlockChecksum(const ITMVoxel* voxelBlock) {
+  const unsigned char* data = (const unsigned char*)voxelBlock;
+  unsigned long long hash = 1469598103934665603ull;
+  for (size_t i = 0; i < SDF_BLOCK_SIZE3 * sizeof(ITMVoxel); i++) {
+    hash ^= data[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+/** Reads snapshots until @p isDone is set: every view is checksummed block by
+    block, looked up at random voxels and raycast from the last pose of the
+    writer, then checksummed again. Any change of a block in between is a torn
+    read.
+*/
+static void RunReader(BasicEngine* engine, const Sequence& sequence,
+                      std::mutex& poseMutex, const Matrix4f& lastInvM,
+                      unsigned int seed, std::atomic<bool>& isDone,
+                      ReaderStats& stats) {
+  ITMScene<ITMVoxel, ITMVoxelBlockHash>* scene = engine->GetScene();
+  const ITMSceneParams& sceneParams = *scene->sceneParams;
+  const ITMIntrinsics& intrinsics = sequence.calib.intrinsics_d;
+  Vector4f invProjParams(1.0f / intrinsics.projectionParamsSimple.fx,
+                         1.0f / intrinsics.projectionParamsSimple.fy,
+                         intrinsics.projectionParamsSimple.px,
+                         intrinsics.projectionParamsSimple.py);
+
+  std::vector<int> entryIds;
+  std::vector<unsigned long long> checksums;
+
+  while (!isDone) {
+    ITMSceneReadView<ITMVoxel> view = scene->AcquireReadView();
+    if (!view.IsValid()) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    const ITMHashEntry* entries = view.GetEntries();
+    const ITMVoxel* voxelBlocks = view.GetVoxelBlocks();
+
+    entryIds.clear();
+    checksums.clear();
+    for (int entryId = 0; entryId < scene->index.noTotalEntries; entryId++) {
+      if (entries[entryId].ptr < 0) continue;
+      entryIds.push_back(entryId);
+      checksums.push_back(
+          BlockChecksum(voxelBlocks + entries[entryId].ptr * SDF_BLOCK_SIZE3));
+    }
+    if (entryIds.empty()) continue;
+
+    ITMVoxelBlockHash::IndexCache cache;
+    for (int i = 0; i < noLookupsPerView; i++) {
+      seed = seed * 1664525u + 1013904223u;
+      const ITMHashEntry& entry = entries[entryIds[(seed >> 8) % entryIds.size()]];
+      int locId = (seed >> 20) % SDF_BLOCK_SIZE3;
+      Vector3i pos = entry.pos.toInt() * SDF_BLOCK_SIZE +
+                     Vector3i(locId % SDF_BLOCK_SIZE,
+                              (locId / SDF_BLOCK_SIZE) % SDF_BLOCK_SIZE,
+                              locId / (SDF_BLOCK_SIZE * SDF_BLOCK_SIZE));
+
+      bool isFound;
+      ITMVoxel voxel = readVoxel(voxelBlocks, entries, pos, isFound, cache);
+      if (!isFound ||
+          memcmp(&voxel, voxelBlocks + entry.ptr * SDF_BLOCK_SIZE3 + locId,
+                 sizeof(ITMVoxel)) != 0)
+        stats.noLookupsMissed++;
+    }
+    stats.noLookups += noLookupsPerView;
+
+    Matrix4f invM;
+    {
+      std::lock_guard<std::mutex> lock(poseMutex);
+      invM = lastInvM;
+    }
+    long noHits = 0;
+    for (int y = 0; y < sequence.imgSize.y; y++)
+      for (int x = 0; x < sequence.imgSize.x; x++) {
+        Vector4f pt;
+        castRay<ITMVoxel, ITMVoxelBlockHash>(
+            pt, x, y, voxelBlocks, entries, invM, invProjParams,
+            1.0f / sceneParams.voxelSize, sceneParams.mu,
+            Vector2f(sceneParams.viewFrustum_min, sceneParams.viewFrustum_max));
+        if (pt.w > 0.0f) noHits++;
+      }
+    stats.noRaycastHits += noHits;
+
+    for (size_t i = 0; i < entryIds.size(); i++)
+      if (BlockChecksum(voxelBlocks + entries[entryIds[i]].ptr *
+                                          SDF_BLOCK_SIZE3) != checksums[i])
+        stats.noMismatches++;
+
+    stats.noBlocksChecked += (long)entryIds.size();
+    stats.noViews++;
+  }
+}
+
+/** Replays the sequence and returns the time spent in ProcessFrame(), in ms.
+    With @p publish, snapshots are published after every frame, and
+    @p noReaderThreads read them while the engine runs.
+*/
+static double Replay(const Sequence& sequence, bool publish,
+                     int noReaderThreads, ReaderStats& stats) {
+  ITMLibSettings settings;
+  if (sequence.poses.empty())
+    settings.SetTrackerType(ITMLibSettings::TRACKER_ICP);
+
+  ITMMainEngine* mainEngine = ITMMainEngine::Make(
+      &settings, &sequence.calib, sequence.imgSize, sequence.imgSize);
+  BasicEngine* engine = dynamic_cast<BasicEngine*>(mainEngine);
+  if (engine == NULL) {
+    printf("the settings do not select ITMVoxel in a voxel block hash\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // the first request enables publishing
+  if (publish) engine->GetScene()->AcquireReadView();
+
+  std::mutex poseMutex;
+  Matrix4f lastInvM = engine->GetTrackingState()->pose_d->GetInvM();
+  std::atomic<bool> isDone(false);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < noReaderThreads; r++)
+    readers.push_back(std::thread(RunReader, engine, std::cref(sequence),
+                                  std::ref(poseMutex), std::cref(lastInvM),
+                                  r + 1, std::ref(isDone), std::ref(stats)));
+
+  double totalTime = 0.0;
+  for (size_t f = 0; f < sequence.rgb.size(); f++) {
+    if (!sequence.poses.empty())
+      engine->GetTrackingState()->pose_d->SetFrom(&sequence.poses[f]);
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    engine->ProcessFrame(sequence.rgb[f], sequence.depth[f]);
+    totalTime += std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+
+    std::lock_guard<std::mutex> lock(poseMutex);
+    lastInvM = engine->GetTrackingState()->pose_d->GetInvM();
+  }
+
+  isDone = true;
+  for (size_t r = 0; r < readers.size(); r++) readers[r].join();
+
+  delete mainEngine;
+  return totalTime;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf(
+        "usage: %s <calibfile> [<noframes> [<rgbmask> <depthmask>]]\n"
+        "  <noframes>  : number of frames to replay, 30 by default\n"
+        "  <rgbmask>   : replays recorded images with the ICP tracker, a "
+        "synthetic\n"
+        "  <depthmask>   room with ground truth poses is rendered otherwise\n"
+        "\n"
+        "Replays the sequence while %d threads read snapshots of the scene "
+        "with random\n"
+        "voxel lookups and raycasts, and fails if a block of a snapshot "
+        "changes while\n"
+        "it is read, or if publishing the snapshots slows fusion down by "
+        "more than %d%%.\n\n",
+        argv[0], noReaders, (int)(maxThroughputRegression * 100.0f));
+    return EXIT_FAILURE;
+  }
+
+  int noFrames = argc > 2 ? atoi(argv[2]) : 30;
+
+  ImageSourceEngine* imageSource;
+  SyntheticImageSource* syntheticSource = NULL;
+  if (argc > 4) {
+    imageSource = new ImageFileReader(argv[1], argv[3], argv[4]);
+  } else {
+    syntheticSource = new SyntheticImageSource(
+        argv[1], SyntheticImageSource::SCENE_ROOM, noFrames);
+    imageSource = syntheticSource;
+  }
+
+  Sequence sequence;
+  sequence.calib = imageSource->calib;
+  sequence.imgSize = imageSource->getDepthImageSize();
+  while ((int)sequence.rgb.size() < noFrames && imageSource->hasMoreImages()) {
+    sequence.rgb.push_back(new ITMUChar4Image(true, false));
+    sequence.depth.push_back(new ITMShortImage(true, false));
+    imageSource->getImages(sequence.rgb.back(), sequence.depth.back());
+    if (syntheticSource != NULL)
+      sequence.poses.push_back(syntheticSource->getCurrentPose());
+  }
+  sequence.imgSize = sequence.depth.empty() ? sequence.imgSize
+                                            : sequence.depth[0]->noDims;
+  delete imageSource;
+
+  if (sequence.rgb.empty()) {
+    printf("no images to replay\n");
+    return EXIT_FAILURE;
+  }
+
+  // without readers, publishing only costs the copy of the hash table and
+  // of the blocks written after each publication
+  double timeWithout = 0.0, timeWith = 0.0;
+  for (int run = 0; run < 2; run++) {
+    ReaderStats unused;
+    double t = Replay(sequence, false, 0, unused);
+    if (run == 0 || t < timeWithout) timeWithout = t;
+    t = Replay(sequence, true, 0, unused);
+    if (run == 0 || t < timeWith) timeWith = t;
+  }
+  double regression = timeWith / timeWithout - 1.0;
+  printf("fusion without publishing %.2f ms/frame, with publishing %.2f "
+         "ms/frame (%+.1f%%)\n",
+         timeWithout / sequence.rgb.size(), timeWith / sequence.rgb.size(),
+         regression * 100.0);
+
+  ReaderStats stats;
+  double timeReaders = Replay(sequence, true, noReaders, stats);
+  printf("fusion with %d readers %.2f ms/frame\n", noReaders,
+         timeReaders / sequence.rgb.size());
+  printf("readers: %ld views, %ld blocks checked, %ld lookups (%ld missed), "
+         "%ld raycast hits, %ld torn blocks\n",
+         stats.noViews.load(), stats.noBlocksChecked.load(),
+         stats.noLookups.load(), stats.noLookupsMissed.load(),
+         stats.noRaycastHits.load(), stats.noMismatches.load());
+
+  for (size_t f = 0; f < sequence.rgb.size(); f++) {
+    delete sequence.rgb[f];
+    delete sequence.depth[f];
+  }
+
+  bool isFailed = false;
+  if (stats.noViews == 0) {
+    printf("FAILED: no snapshot was read\n");
+    isFailed = true;
+  }
+  if (stats.noMismatches > 0 || stats.noLookupsMissed > 0) {
+    printf("FAILED: snapshots changed while they were read\n");
+    isFailed = true;
+  }
+  if (regression > maxThroughputRegression) {
+    printf("FAILED: publishing slows fusion down by more than %d%%\n",
+           (int)(maxThroughputRegression * 100.0f));
+    isFailed = true;
+  }
+  if (!isFailed) printf("passed\n");
+
+  return isFailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
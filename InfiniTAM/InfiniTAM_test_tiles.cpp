@@ -0,0 +1,315 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <dirent.h>
+#include <stdio.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "Engine/SyntheticImageSource.h"
+#include "ITMLib/Engine/ITMBasicEngine.h"
+
+using namespace InfiniTAM::Engine;
+
+typedef ITMScene<ITMVoxel, ITMVoxelBlockHash> Scene;
+typedef ITMBasicEngine<ITMVoxel, ITMVoxelBlockHash> BasicEngine;
+
+/// The corridor is walked 200 m forward at 0.2 m per frame, then 30 m back,
+/// further than tiles stay in memory behind the camera
+static const int noCorridorFrames = 1150;
+static const int noCorridorReturnFrames = 150;
+static const float corridorVoxelSize = 0.02f;
+static const float corridorRadius = 8.0f;
+
+/// Resident blocks in the second half of the corridor may exceed the maximum
+/// of the first half by this factor
+static const float maxResidentGrowth = 1.25f;
+
+/// Sum of the checksums of the allocated blocks, with their positions, which
+/// does not depend on where in the hash table and the VBA they are
+static unsigned long long SceneChecksum(Scene* scene, int& noBlocks) {
+  const ITMHashEntry* entries = scene->index.GetEntries();
+  const ITMVoxel* voxelBlocks = scene->localVBA.GetVoxelBlocks();
+
+  unsigned long long sum = 0;
+  noBlocks = 0;
+  for (int entryId = 0; entryId < scene->index.noTotalEntries; entryId++) {
+    const ITMHashEntry& entry = entries[entryId];
+    if (entry.ptr < 0) continue;
+
+    unsigned long long hash = 1469598103934665603ull ^
+                              (unsigned long long)(entry.pos.x * 73856093 ^
+                                                   entry.pos.y * 19349663 ^
+                                                   entry.pos.z * 83492791);
+    const unsigned char* data =
+        (const unsigned char*)(voxelBlocks + entry.ptr * SDF_BLOCK_SIZE3);
+    for (size_t i = 0; i < SDF_BLOCK_SIZE3 * sizeof(ITMVoxel); i++) {
+      hash ^= data[i];
+      hash *= 1099511628211ull;
+    }
+    sum += hash;
+    noBlocks++;
+  }
+  return sum;
+}
+
+/** Checks that every voxel block and excess entry is either referenced by the
+    hash table or on its allocation list, exactly once.
+*/
+static bool IsSceneConsistent(Scene* scene) {
+  const ITMHashEntry* entries = scene->index.GetEntries();
+  int noBlocks = scene->localVBA.allocatedSize / SDF_BLOCK_SIZE3;
+  int noExcessEntries = scene->index.noTotalEntries - SDF_BUCKET_NUM;
+
+  std::vector<int> blockUses(noBlocks, 0), excessUses(noExcessEntries, 0);
+  for (int bucket = 0; bucket < SDF_BUCKET_NUM; bucket++) {
+    int entryId = bucket;
+    while (true) {
+      const ITMHashEntry& entry = entries[entryId];
+      if (entry.ptr >= 0) blockUses[entry.ptr]++;
+      if (entry.offset < 1) break;
+      excessUses[entry.offset - 1]++;
+      entryId = SDF_BUCKET_NUM + entry.offset - 1;
+    }
+  }
+
+  const int* allocationList = scene->localVBA.GetAllocationList();
+  for (int i = 0; i <= scene->localVBA.lastFreeBlockId; i++)
+    blockUses[allocationList[i]]++;
+  const int* excessAllocationList = scene->index.GetExcessAllocationList();
+  for (int i = 0; i <= scene->index.GetLastFreeExcessListId(); i++)
+    excessUses[excessAllocationList[i]]++;
+
+  for (int i = 0; i < noBlocks; i++)
+    if (blockUses[i] != 1) return false;
+  for (int i = 0; i < noExcessEntries; i++)
+    if (excessUses[i] != 1) return false;
+  return true;
+}
+
+static void RemoveDirectory(const std::string& directory) {
+  DIR* dir = opendir(directory.c_str());
+  if (dir == NULL) return;
+  for (dirent* entry = readdir(dir); entry != NULL; entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if (name != "." && name != "..") unlink((directory + "/" + name).c_str());
+  }
+  closedir(dir);
+  rmdir(directory.c_str());
+}
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+/** Maps the synthetic room, pages the scene out to tiles and back in, and
+    reads the tiles into a new scene. Both must equal the original.
+*/
+static bool TestRoundTrip(const char* calibFile, const std::string& directory) {
+  SyntheticImageSource imageSource(calibFile, SyntheticImageSource::SCENE_ROOM,
+                                   20);
+  ITMLibSettings settings;
+  BasicEngine engine(&settings, &imageSource.calib,
+                     imageSource.getRGBImageSize(),
+                     imageSource.getDepthImageSize());
+
+  ITMUChar4Image rgb(true, false);
+  ITMShortImage rawDepth(true, false);
+  while (imageSource.hasMoreImages()) {
+    imageSource.getImages(&rgb, &rawDepth);
+    engine.GetTrackingState()->pose_d->SetFrom(&imageSource.getCurrentPose());
+    engine.ProcessFrame(&rgb, &rawDepth);
+  }
+
+  Scene* scene = engine.GetScene();
+  int noBlocks;
+  unsigned long long checksum = SceneChecksum(scene, noBlocks);
+  printf("round trip: %d blocks mapped\n", noBlocks);
+
+  ITMPose home, far;
+  far.SetFrom(-500.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+
+  bool isPassed = true;
+  {
+    ITMTilePager<ITMVoxel, ITMVoxelBlockHash> pager(directory.c_str(), scene,
+                                                   100.0f);
+    pager.Update(&home, true);
+    pager.Flush();
+
+    // everything is out of range and removed from the scene
+    pager.Update(&far, true);
+    int noBlocksFar;
+    SceneChecksum(scene, noBlocksFar);
+    bool isConsistentFar = IsSceneConsistent(scene);
+
+    pager.Update(&home, true);
+    int noBlocksBack;
+    bool isEqualBack = SceneChecksum(scene, noBlocksBack) == checksum;
+    bool isConsistentBack = IsSceneConsistent(scene);
+
+    printf("round trip: %d tiles written, %d blocks left far away, %d blocks "
+           "after %d tiles were read back (%.2f ms per tile, max %.2f ms)\n",
+           pager.GetNoTilesWritten(), noBlocksFar, noBlocksBack,
+           pager.GetNoTilesLoaded(), pager.GetAverageLoadTime(),
+           pager.GetMaxLoadTime());
+
+    if (noBlocksFar != 0 || !isConsistentFar || !isConsistentBack) {
+      printf("FAILED: the hash table and the allocation lists disagree\n");
+      isPassed = false;
+    }
+    if (!isEqualBack || noBlocksBack != noBlocks) {
+      printf("FAILED: the scene read back differs from the original\n");
+      isPassed = false;
+    }
+  }
+
+  Scene freshScene(&settings.sceneParams, false, MEMORYDEVICE_CPU);
+  ITMSceneReconstructionEngine_CPU<ITMVoxel, ITMVoxelBlockHash>
+      reconstructionEngine;
+  reconstructionEngine.ResetScene(&freshScene);
+  {
+    ITMTilePager<ITMVoxel, ITMVoxelBlockHash> pager(directory.c_str(),
+                                                   &freshScene, 100.0f);
+    pager.Update(&home, true);
+  }
+  int noBlocksFresh;
+  bool isEqualFresh = SceneChecksum(&freshScene, noBlocksFresh) == checksum;
+  printf("round trip: %d blocks read into a new scene\n", noBlocksFresh);
+  if (!isEqualFresh || noBlocksFresh != noBlocks ||
+      !IsSceneConsistent(&freshScene)) {
+    printf("FAILED: the scene read from the tiles differs from the original\n");
+    isPassed = false;
+  }
+
+  return isPassed;
+}
+
+/** Walks the synthetic corridor with the tile pager of the engine and checks
+    that the blocks in memory stay bounded and that nothing fails to page.
+*/
+static bool TestCorridor(const char* calibFile, const std::string& directory) {
+  SyntheticImageSource imageSource(
+      calibFile, SyntheticImageSource::SCENE_CORRIDOR, noCorridorFrames,
+      Vector2i(320, 240), 0.5f, noCorridorReturnFrames);
+  ITMLibSettings settings;
+  settings.sceneParams.voxelSize = corridorVoxelSize;
+  settings.sceneParams.mu = 4.0f * corridorVoxelSize;
+
+  BasicEngine engine(&settings, &imageSource.calib,
+                     imageSource.getRGBImageSize(),
+                     imageSource.getDepthImageSize());
+  if (!engine.StartTilePager(directory.c_str(), corridorRadius)) {
+    printf("FAILED: could not start the tile pager\n");
+    return false;
+  }
+
+  Scene* scene = engine.GetScene();
+  int noBlocks = scene->localVBA.allocatedSize / SDF_BLOCK_SIZE3;
+  int maxResidentFirstHalf = 0, maxResidentSecondHalf = 0;
+  std::vector<double> frameTimes, updateTimes;
+
+  ITMUChar4Image rgb(true, false);
+  ITMShortImage rawDepth(true, false);
+  for (int frameNo = 0; imageSource.hasMoreImages(); frameNo++) {
+    imageSource.getImages(&rgb, &rawDepth);
+    engine.GetTrackingState()->pose_d->SetFrom(&imageSource.getCurrentPose());
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    engine.ProcessFrame(&rgb, &rawDepth);
+    frameTimes.push_back(MillisecondsSince(start));
+    updateTimes.push_back(engine.GetTilePager()->GetLastUpdateTime());
+
+    int noResident = noBlocks - scene->localVBA.lastFreeBlockId - 1;
+    int& maxResident = frameNo < noCorridorFrames / 2 ? maxResidentFirstHalf
+                                                      : maxResidentSecondHalf;
+    maxResident = std::max(maxResident, noResident);
+  }
+
+  ITMTilePager<ITMVoxel, ITMVoxelBlockHash>* pager = engine.GetTilePager();
+  int noFailedJobs = pager->GetNoFailedJobs();
+  int noTilesLoaded = pager->GetNoTilesLoaded();
+
+  std::vector<double> sortedTimes = frameTimes;
+  std::sort(sortedTimes.begin(), sortedTimes.end());
+  double meanTime = 0.0, meanUpdateTime = 0.0, maxUpdateTime = 0.0;
+  for (size_t i = 0; i < frameTimes.size(); i++) {
+    meanTime += frameTimes[i] / frameTimes.size();
+    meanUpdateTime += updateTimes[i] / updateTimes.size();
+    maxUpdateTime = std::max(maxUpdateTime, updateTimes[i]);
+  }
+
+  printf("corridor: %d frames, at most %d blocks of %d in memory in the "
+         "first half, %d in the second\n",
+         (int)frameTimes.size(), maxResidentFirstHalf, noBlocks,
+         maxResidentSecondHalf);
+  printf("corridor: %d tiles written, %d read (%.2f ms per tile, max %.2f "
+         "ms), %d failed\n",
+         pager->GetNoTilesWritten(), noTilesLoaded, pager->GetAverageLoadTime(),
+         pager->GetMaxLoadTime(), noFailedJobs);
+  printf("corridor: frame time mean %.2f ms, median %.2f ms, 99th percentile "
+         "%.2f ms, max %.2f ms; pager update mean %.2f ms, max %.2f ms\n",
+         meanTime, sortedTimes[sortedTimes.size() / 2],
+         sortedTimes[sortedTimes.size() * 99 / 100], sortedTimes.back(),
+         meanUpdateTime, maxUpdateTime);
+
+  bool isPassed = true;
+  if (maxResidentSecondHalf > maxResidentGrowth * maxResidentFirstHalf) {
+    printf("FAILED: the blocks in memory grow with the distance walked\n");
+    isPassed = false;
+  }
+  if (noFailedJobs > 0 || noTilesLoaded == 0) {
+    printf("FAILED: tiles were not paged back in on the way back\n");
+    isPassed = false;
+  }
+  if (!IsSceneConsistent(scene)) {
+    printf("FAILED: the hash table and the allocation lists disagree\n");
+    isPassed = false;
+  }
+  return isPassed;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf(
+        "usage: %s <calibfile>\n"
+        "\n"
+        "Pages a synthetic room out to tiles and back in, which must leave "
+        "the scene\n"
+        "unchanged, and walks a synthetic 200 m corridor with the tile "
+        "pager, which\n"
+        "must keep the number of blocks in memory bounded. The tiles are "
+        "written to\n"
+        "temporary directories.\n\n",
+        argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  char roundTripDirectory[] = "/tmp/InfiniTAM_tiles_XXXXXX";
+  char corridorDirectory[] = "/tmp/InfiniTAM_tiles_XXXXXX";
+  if (mkdtemp(roundTripDirectory) == NULL ||
+      mkdtemp(corridorDirectory) == NULL) {
+    printf("could not create the tile directories\n");
+    return EXIT_FAILURE;
+  }
+
+  bool isPassed = true;
+  try {
+    isPassed &= TestRoundTrip(argv[1], roundTripDirectory);
+    isPassed &= TestCorridor(argv[1], corridorDirectory);
+  } catch (std::exception& e) {
+    printf("FAILED: %s\n", e.what());
+    isPassed = false;
+  }
+
+  RemoveDirectory(roundTripDirectory);
+  RemoveDirectory(corridorDirectory);
+
+  if (isPassed) printf("passed\n");
+  return isPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
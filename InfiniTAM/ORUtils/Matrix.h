@@ -4,6 +4,8 @@
 #include <string.h>
 #include <ostream>
 
+#include "PlatformIndependence.h"
+
 /************************************************************************/
 /* WARNING: the following 3x3 and 4x4 matrix are using column major, to	*/
 /* be consistent with OpenGL default rather than most C/C++ default.	*/
@@ -55,6 +57,16 @@ namespace ORUtils {
 	template<class T>
 	class Matrix4 : public Matrix4_ < T >
 	{
+	private:
+		// Matrix.h ends with a SIMD version for float
+		_CPU_AND_GPU_CODE_ static inline Matrix4 multiply(const Matrix4 &lhs, const Matrix4 &rhs) {
+			Matrix4 r;
+			r.setZeros();
+			for (int x = 0; x < 4; x++) for (int y = 0; y < 4; y++) for (int k = 0; k < 4; k++)
+				r(x, y) += lhs(k, y) * rhs(x, k);
+			return r;
+		}
+
 	public:
 		_CPU_AND_GPU_CODE_ Matrix4() {}
 		_CPU_AND_GPU_CODE_ Matrix4(T t) { setValues(t); }
@@ -100,11 +112,7 @@ namespace ORUtils {
 		}
 
 		_CPU_AND_GPU_CODE_ inline friend Matrix4 operator * (const Matrix4 &lhs, const Matrix4 &rhs)	{
-			Matrix4 r;
-			r.setZeros();
-			for (int x = 0; x < 4; x++) for (int y = 0; y < 4; y++) for (int k = 0; k < 4; k++)
-				r(x, y) += lhs(k, y) * rhs(x, k);
-			return r;
+			return multiply(lhs, rhs);
 		}
 
 		_CPU_AND_GPU_CODE_ inline friend Matrix4 operator + (const Matrix4 &lhs, const Matrix4 &rhs) {
@@ -112,6 +120,7 @@ namespace ORUtils {
 			return res += rhs;
 		}
 
+		// Matrix.h ends with a SIMD version for float
 		_CPU_AND_GPU_CODE_ inline Vector4<T> operator *(const Vector4<T> &rhs) const {
 			Vector4<T> r;
 			r[0] = this->m[0] * rhs[0] + this->m[4] * rhs[1] + this->m[8] * rhs[2] + this->m[12] * rhs[3];
@@ -442,3 +451,34 @@ namespace ORUtils {
 
 
 };
+
+#if defined(ORUTILS_SIMD_SSE2) || defined(ORUTILS_SIMD_NEON)
+#include "Vector.h"
+
+namespace ORUtils {
+	// the columns scaled by the components of rhs, summed in the same order as the generic code
+	template<> inline Vector4<float> Matrix4<float>::operator *(const Vector4<float> &rhs) const {
+		SIMD::Float4 r = SIMD::multiply(SIMD::load(this->m), SIMD::broadcast(rhs.x));
+		r = SIMD::add(r, SIMD::multiply(SIMD::load(this->m + 4), SIMD::broadcast(rhs.y)));
+		r = SIMD::add(r, SIMD::multiply(SIMD::load(this->m + 8), SIMD::broadcast(rhs.z)));
+		r = SIMD::add(r, SIMD::multiply(SIMD::load(this->m + 12), SIMD::broadcast(rhs.w)));
+		Vector4<float> v; SIMD::store(v.v, r); return v;
+	}
+
+	// column x of the product is lhs times column x of rhs
+	template<> inline Matrix4<float> Matrix4<float>::multiply(const Matrix4<float> &lhs, const Matrix4<float> &rhs) {
+		SIMD::Float4 c0 = SIMD::load(lhs.m), c1 = SIMD::load(lhs.m + 4), c2 = SIMD::load(lhs.m + 8), c3 = SIMD::load(lhs.m + 12);
+		Matrix4<float> r;
+		for (int x = 0; x < 4; x++)
+		{
+			const float *col = rhs.m + 4 * x;
+			SIMD::Float4 c = SIMD::multiply(c0, SIMD::broadcast(col[0]));
+			c = SIMD::add(c, SIMD::multiply(c1, SIMD::broadcast(col[1])));
+			c = SIMD::add(c, SIMD::multiply(c2, SIMD::broadcast(col[2])));
+			c = SIMD::add(c, SIMD::multiply(c3, SIMD::broadcast(col[3])));
+			SIMD::store(r.m + 4 * x, c);
+		}
+		return r;
+	}
+}
+#endif
@@ -17,6 +17,12 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #endif
 
 #ifndef MEMORY_DEVICE_TYPE
@@ -35,6 +41,9 @@ namespace ORUtils
 	protected:
 #ifndef __METALC__
 		bool isAllocated_CPU, isAllocated_CUDA, isMetalCompatible;
+
+		/** Name of the POSIX shared memory object the CPU data is mapped from, NULL if it is not shared. */
+		char *sharedMemoryName;
 #endif
 		/** Pointer to memory on CPU host. */
 		DEVICEPTR(T)* data_cpu;
@@ -94,6 +103,7 @@ namespace ORUtils
 			this->isAllocated_CPU = false;
 			this->isAllocated_CUDA = false;
 			this->isMetalCompatible = false;
+			this->sharedMemoryName = NULL;
 
 			Allocate(dataSize, allocate_CPU, allocate_CUDA, metalCompatible);
 			Clear();
@@ -108,6 +118,7 @@ namespace ORUtils
 			this->isAllocated_CPU = false;
 			this->isAllocated_CUDA = false;
 			this->isMetalCompatible = false;
+			this->sharedMemoryName = NULL;
 
 			switch (memoryType)
 			{
@@ -167,6 +178,41 @@ namespace ORUtils
 
 		virtual ~MemoryBlock() { this->Free(); }
 
+		/** Moves the CPU data into a POSIX shared memory object of
+		the given name (e.g. "/infinitam_map"), which other processes
+		can map with shm_open() and mmap(). The content is kept, the
+		object is unlinked again when the block is freed. Only blocks
+		on CPU only are supported, and not on Windows or with Metal.
+		*/
+		bool MoveToSharedMemory(const char *name)
+		{
+#if defined(_WIN32) || defined(COMPILE_WITH_METAL)
+			return false;
+#else
+			if (!isAllocated_CPU || isAllocated_CUDA || sharedMemoryName != NULL || dataSize == 0) return false;
+
+			size_t noBytes = dataSize * sizeof(T);
+
+			int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+			if (fd < 0) return false;
+			if (ftruncate(fd, (off_t)noBytes) != 0) { close(fd); shm_unlink(name); return false; }
+
+			void *sharedData = mmap(NULL, noBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			close(fd);
+			if (sharedData == MAP_FAILED) { shm_unlink(name); return false; }
+
+			memcpy(sharedData, data_cpu, noBytes);
+			delete[] data_cpu;
+
+			data_cpu = (T*)sharedData;
+			sharedMemoryName = strdup(name);
+			return true;
+#endif
+		}
+
+		/** Name given to MoveToSharedMemory(), NULL if the data is not in shared memory. */
+		const char *GetSharedMemoryName(void) const { return sharedMemoryName; }
+
 		/** Allocate image data of the specified size. If the
 		data has been allocated before, the data is freed.
 		*/
@@ -222,6 +268,16 @@ namespace ORUtils
 
 		void Free()
 		{
+#ifndef _WIN32
+			if (sharedMemoryName != NULL)
+			{
+				munmap(data_cpu, dataSize * sizeof(T));
+				shm_unlink(sharedMemoryName);
+				free(sharedMemoryName);
+				sharedMemoryName = NULL;
+				isAllocated_CPU = false;
+			}
+#endif
 			if (isAllocated_CPU)
 			{
 				int allocType = 0;
@@ -118,7 +118,7 @@ private:
    * \throws std::runtime_error If the read is unsuccessful.
    */
   template <typename T>
-  static void ReadBlockData(std::istream& is, ORUtils::MemoryBlock<T>& block, int blockSize)
+  static void ReadBlockData(std::istream& is, ORUtils::MemoryBlock<T>& block, size_t blockSize)
   {
     // Try and read the block's size.
     if(block.dataSize != blockSize)
@@ -144,7 +144,7 @@ private:
    * \throws std::runtime_error If the read is unsuccessful.
    */
   template <typename T>
-  static void ReadBlockData(const std::string& filename, ORUtils::MemoryBlock<T>& block, int blockSize)
+  static void ReadBlockData(const std::string& filename, ORUtils::MemoryBlock<T>& block, size_t blockSize)
   {
     std::ifstream fs(filename.c_str(), std::ios::binary);
     if(!fs) throw std::runtime_error("Could not open " + filename + " for reading");
@@ -184,8 +184,9 @@ private:
   template <typename T>
   static void WriteBlock(std::ostream& os, const ORUtils::MemoryBlock<T>& block)
   {
-    // Try and write the block's size.
-    if(!os.write(reinterpret_cast<const char *>(&block.dataSize), sizeof(block.dataSize)))
+    // Try and write the block's size, as the int that ReadBlockSize expects.
+    int blockSize = static_cast<int>(block.dataSize);
+    if(!os.write(reinterpret_cast<const char *>(&blockSize), sizeof(int)))
     {
       throw std::runtime_error("Could not write memory block size");
     }
@@ -31,6 +31,19 @@
 #define CONSTPTR(x) x
 #endif
 
+// SSE2 or NEON versions of the hot float vector and matrix operations, see
+// the end of Vector.h and Matrix.h; never used in CUDA device or Metal code,
+// but the host pass of nvcc compiles the host code of .cu files with them
+#if !defined(__CUDA_ARCH__) && !defined(__METALC__) && !defined(COMPILE_WITHOUT_SIMD)
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define ORUTILS_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ORUTILS_SIMD_NEON
+#endif
+#endif
+
 #ifdef ANDROID
 #define DIEWITHEXCEPTION(x) { fprintf(stderr, "%s\n", x); exit(-1); }
 #else
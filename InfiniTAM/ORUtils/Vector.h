@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <float.h>
 #include <math.h>
 #include <ostream>
 
@@ -379,6 +380,18 @@ namespace ORUtils {
 
 	template <class T> class Vector4 : public Vector4_ < T >
 	{
+	private:
+		// component-wise operations, Vector.h ends with SIMD versions for float
+		_CPU_AND_GPU_CODE_ static inline Vector4<T> add(const Vector4<T> &lhs, const Vector4<T> &rhs) {
+			return Vector4<T>(lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z, lhs.w + rhs.w);
+		}
+		_CPU_AND_GPU_CODE_ static inline Vector4<T> subtract(const Vector4<T> &lhs, const Vector4<T> &rhs) {
+			return Vector4<T>(lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z, lhs.w - rhs.w);
+		}
+		_CPU_AND_GPU_CODE_ static inline Vector4<T> multiply(const Vector4<T> &lhs, const Vector4<T> &rhs) {
+			return Vector4<T>(lhs.x * rhs.x, lhs.y * rhs.y, lhs.z * rhs.z, lhs.w * rhs.w);
+		}
+
 	public:
 		typedef T value_type;
 		_CPU_AND_GPU_CODE_ inline int size() const { return 4; }
@@ -436,7 +449,7 @@ namespace ORUtils {
 
 		// component-wise vector multiply assign
 		_CPU_AND_GPU_CODE_ friend Vector4<T> &operator *= (Vector4<T> &lhs, const Vector4<T> &rhs) {
-			lhs.x *= rhs.x; lhs.y *= rhs.y; lhs.z *= rhs.z; lhs.w *= rhs.w; return lhs;
+			return lhs = multiply(lhs, rhs);
 		}
 
 		// scalar divide assign
@@ -451,12 +464,12 @@ namespace ORUtils {
 
 		// component-wise vector add assign
 		_CPU_AND_GPU_CODE_ friend Vector4<T> &operator += (Vector4<T> &lhs, const Vector4<T> &rhs)	{
-			lhs.x += rhs.x; lhs.y += rhs.y; lhs.z += rhs.z; lhs.w += rhs.w; return lhs;
+			return lhs = add(lhs, rhs);
 		}
 
 		// component-wise vector subtract assign
 		_CPU_AND_GPU_CODE_ friend Vector4<T> &operator -= (Vector4<T> &lhs, const Vector4<T> &rhs)	{
-			lhs.x -= rhs.x; lhs.y -= rhs.y; lhs.z -= rhs.z; lhs.w -= rhs.w; return lhs;
+			return lhs = subtract(lhs, rhs);
 		}
 
 		// unary negate
@@ -466,12 +479,12 @@ namespace ORUtils {
 
 		// vector add
 		_CPU_AND_GPU_CODE_ friend Vector4<T> operator + (const Vector4<T> &lhs, const Vector4<T> &rhs) {
-			Vector4<T> rv(lhs); return rv += rhs;
+			return add(lhs, rhs);
 		}
 
 		// vector subtract
 		_CPU_AND_GPU_CODE_ friend Vector4<T> operator - (const Vector4<T> &lhs, const Vector4<T> &rhs) {
-			Vector4<T> rv(lhs); return rv -= rhs;
+			return subtract(lhs, rhs);
 		}
 
 		// scalar multiply
@@ -486,7 +499,7 @@ namespace ORUtils {
 
 		// vector component-wise multiply
 		_CPU_AND_GPU_CODE_ friend Vector4<T> operator * (const Vector4<T> &lhs, const Vector4<T> &rhs) {
-			Vector4<T> rv(lhs); return rv *= rhs;
+			return multiply(lhs, rhs);
 		}
 
 		// scalar divide
@@ -850,4 +863,82 @@ namespace ORUtils {
 			rv[i] = max(lhs[i], rhs[i]);
 		return rv;
 	}
+
+#if defined(ORUTILS_SIMD_SSE2) || defined(ORUTILS_SIMD_NEON)
+	////////////////////////////////////////////////////////////////////////////////
+	// SIMD versions of the hot float operations. Component-wise operations give
+	// the same results as the generic code, dot and normalize round differently
+	// by a few ulp. Unaligned loads and stores keep the layout of the vectors.
+	////////////////////////////////////////////////////////////////////////////////
+
+	namespace SIMD {
+#ifdef ORUTILS_SIMD_SSE2
+		typedef __m128 Float4;
+		inline Float4 load(const float *p) { return _mm_loadu_ps(p); }
+		inline void store(float *p, Float4 a) { _mm_storeu_ps(p, a); }
+		inline Float4 broadcast(float f) { return _mm_set1_ps(f); }
+		inline Float4 add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+		inline Float4 subtract(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+		inline Float4 multiply(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+
+		// (a0 + a2) + (a1 + a3)
+		inline float horizontalSum(Float4 a) {
+			Float4 s = _mm_add_ps(a, _mm_movehl_ps(a, a));
+			return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+		}
+
+		// 12 bit estimate and one Newton step, for normal positive numbers only
+		inline float reciprocalSqrt(float x) {
+			float r = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+			return r * (1.5f - 0.5f * x * r * r);
+		}
+#else
+		typedef float32x4_t Float4;
+		inline Float4 load(const float *p) { return vld1q_f32(p); }
+		inline void store(float *p, Float4 a) { vst1q_f32(p, a); }
+		inline Float4 broadcast(float f) { return vdupq_n_f32(f); }
+		inline Float4 add(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+		inline Float4 subtract(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+		inline Float4 multiply(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+
+		// (a0 + a2) + (a1 + a3)
+		inline float horizontalSum(Float4 a) {
+			float32x2_t s = vadd_f32(vget_low_f32(a), vget_high_f32(a));
+			return vget_lane_f32(vpadd_f32(s, s), 0);
+		}
+
+		// the NEON estimate has 8 bits, two Newton steps, for normal positive numbers only
+		inline float reciprocalSqrt(float x) {
+			float32x2_t v = vdup_n_f32(x), r = vrsqrte_f32(v);
+			r = vmul_f32(r, vrsqrts_f32(vmul_f32(v, r), r));
+			r = vmul_f32(r, vrsqrts_f32(vmul_f32(v, r), r));
+			return vget_lane_f32(r, 0);
+		}
+#endif
+	}
+
+	template<> inline Vector4<float> Vector4<float>::add(const Vector4<float> &lhs, const Vector4<float> &rhs) {
+		Vector4<float> r; SIMD::store(r.v, SIMD::add(SIMD::load(lhs.v), SIMD::load(rhs.v))); return r;
+	}
+
+	template<> inline Vector4<float> Vector4<float>::subtract(const Vector4<float> &lhs, const Vector4<float> &rhs) {
+		Vector4<float> r; SIMD::store(r.v, SIMD::subtract(SIMD::load(lhs.v), SIMD::load(rhs.v))); return r;
+	}
+
+	template<> inline Vector4<float> Vector4<float>::multiply(const Vector4<float> &lhs, const Vector4<float> &rhs) {
+		Vector4<float> r; SIMD::store(r.v, SIMD::multiply(SIMD::load(lhs.v), SIMD::load(rhs.v))); return r;
+	}
+
+	template<> inline float dot<Vector4<float> >(const Vector4<float> &lhs, const Vector4<float> &rhs) {
+		return SIMD::horizontalSum(SIMD::multiply(SIMD::load(lhs.v), SIMD::load(rhs.v)));
+	}
+
+	template<> inline Vector3<float> normalize<Vector3<float> >(const Vector3<float> &vec) {
+		float lengthSq = dot(vec, vec);
+		// zero, denormals, infinity and NaN take the generic path
+		if (!(lengthSq >= FLT_MIN && lengthSq <= FLT_MAX))
+			return lengthSq == 0 ? Vector3<float>(0.0f) : vec / (float)sqrt(lengthSq);
+		return vec * SIMD::reciprocalSqrt(lengthSq);
+	}
+#endif
 };
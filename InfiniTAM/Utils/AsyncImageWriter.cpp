@@ -0,0 +1,85 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "AsyncImageWriter.h"
+
+#include "FileUtils.h"
+
+AsyncImageWriter::AsyncImageWriter(Vector2i imgSize, int noImages)
+{
+	for (int i = 0; i < noImages; i++) images.push_back(new ITMUChar4Image(imgSize, true, false));
+	freeImages = images;
+
+	stopRequested = false;
+	noDroppedImages = 0;
+
+	thread = std::thread(&AsyncImageWriter::Run, this);
+}
+
+AsyncImageWriter::~AsyncImageWriter(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopRequested = true;
+	}
+	jobAvailable.notify_all();
+	thread.join();
+
+	for (size_t i = 0; i < images.size(); i++) delete images[i];
+}
+
+ITMUChar4Image* AsyncImageWriter::GetImage(void)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (freeImages.empty()) { noDroppedImages++; return NULL; }
+
+	ITMUChar4Image *image = freeImages.back();
+	freeImages.pop_back();
+	return image;
+}
+
+void AsyncImageWriter::Write(ITMUChar4Image *image, const std::string & fileName)
+{
+	Job job;
+	job.image = image;
+	job.fileName = fileName;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(job);
+	}
+	jobAvailable.notify_all();
+}
+
+int AsyncImageWriter::GetNoDroppedImages(void)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return noDroppedImages;
+}
+
+void AsyncImageWriter::Flush(void)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	jobAvailable.wait(lock, [this] { return freeImages.size() == images.size(); });
+}
+
+void AsyncImageWriter::Run(void)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (true)
+	{
+		jobAvailable.wait(lock, [this] { return stopRequested || !jobs.empty(); });
+		if (jobs.empty()) break;
+
+		Job job = jobs.front();
+		jobs.pop_front();
+
+		lock.unlock();
+		SaveImageToFile(job.image, job.fileName.c_str());
+		lock.lock();
+
+		freeImages.push_back(job.image);
+		jobAvailable.notify_all();
+	}
+}
@@ -0,0 +1,63 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../ITMLib/Utils/ITMLibDefines.h"
+
+/** \brief
+    Writes images to files on a background thread, so that the
+    thread producing them does not wait for the disk.
+
+    Images are taken from a fixed pool with @ref GetImage(), filled
+    and handed back with @ref Write(). If all images of the pool are
+    still waiting to be written, @ref GetImage() returns NULL and the
+    caller is expected to skip the image; the number of skipped images
+    is reported by @ref GetNoDroppedImages().
+*/
+class AsyncImageWriter
+{
+private:
+	struct Job
+	{
+		ITMUChar4Image *image;
+		std::string fileName;
+	};
+
+	std::vector<ITMUChar4Image*> images;
+	std::vector<ITMUChar4Image*> freeImages;
+	std::deque<Job> jobs;
+
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	bool stopRequested;
+	int noDroppedImages;
+
+	std::thread thread;
+
+	void Run(void);
+
+public:
+	/// Returns an image of the pool to render into, NULL if none is free
+	ITMUChar4Image* GetImage(void);
+
+	/// Queues an image returned by GetImage() to be written as ppm
+	void Write(ITMUChar4Image *image, const std::string & fileName);
+
+	/// Number of times GetImage() found the pool exhausted
+	int GetNoDroppedImages(void);
+
+	/// Blocks until all queued images are written
+	void Flush(void);
+
+	AsyncImageWriter(Vector2i imgSize, int noImages);
+
+	/// Writes the images still queued before returning
+	~AsyncImageWriter(void);
+};
@@ -251,6 +251,7 @@ static bool pnm_writedata(FILE *f, int xsize, int ysize, FormatType type, const
 void SaveImageToFile(const ITMUChar4Image* image, const char* fileName, bool flipVertical)
 {
 	FILE *f = fopen(fileName, "wb");
+	if (f == NULL) return;
 	if (!pnm_writeheader(f, image->noDims.x, image->noDims.y, RGB_8u)) {
 		fclose(f); return;
 	}
@@ -0,0 +1,364 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "TrajectoryUtils.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef ORUtils::Matrix4<double> Matrix4d;
+
+static const double RAD_TO_DEG = 180.0 / 3.14159265358979323846;
+
+static Matrix4d PoseFromQuaternion(double tx, double ty, double tz, double qw, double qx, double qy, double qz)
+{
+	double norm = sqrt(qw * qw + qx * qx + qy * qy + qz * qz);
+	qw /= norm; qx /= norm; qy /= norm; qz /= norm;
+
+	Matrix4d M; M.setIdentity();
+
+	// at(column, row)
+	M.at(0, 0) = 1 - 2 * (qy * qy + qz * qz); M.at(1, 0) = 2 * (qx * qy - qz * qw);     M.at(2, 0) = 2 * (qx * qz + qy * qw);
+	M.at(0, 1) = 2 * (qx * qy + qz * qw);     M.at(1, 1) = 1 - 2 * (qx * qx + qz * qz); M.at(2, 1) = 2 * (qy * qz - qx * qw);
+	M.at(0, 2) = 2 * (qx * qz - qy * qw);     M.at(1, 2) = 2 * (qy * qz + qx * qw);     M.at(2, 2) = 1 - 2 * (qx * qx + qy * qy);
+	M.at(3, 0) = tx; M.at(3, 1) = ty; M.at(3, 2) = tz;
+
+	return M;
+}
+
+static void QuaternionFromPose(const Matrix4d &M, double &qw, double &qx, double &qy, double &qz)
+{
+	double trace = M.at(0, 0) + M.at(1, 1) + M.at(2, 2);
+
+	// pick the largest component to divide by
+	if (trace > 0)
+	{
+		double s = 2.0 * sqrt(trace + 1.0);
+		qw = 0.25 * s;
+		qx = (M.at(1, 2) - M.at(2, 1)) / s; qy = (M.at(2, 0) - M.at(0, 2)) / s; qz = (M.at(0, 1) - M.at(1, 0)) / s;
+	}
+	else if (M.at(0, 0) > M.at(1, 1) && M.at(0, 0) > M.at(2, 2))
+	{
+		double s = 2.0 * sqrt(1.0 + M.at(0, 0) - M.at(1, 1) - M.at(2, 2));
+		qw = (M.at(1, 2) - M.at(2, 1)) / s;
+		qx = 0.25 * s; qy = (M.at(1, 0) + M.at(0, 1)) / s; qz = (M.at(2, 0) + M.at(0, 2)) / s;
+	}
+	else if (M.at(1, 1) > M.at(2, 2))
+	{
+		double s = 2.0 * sqrt(1.0 + M.at(1, 1) - M.at(0, 0) - M.at(2, 2));
+		qw = (M.at(2, 0) - M.at(0, 2)) / s;
+		qx = (M.at(1, 0) + M.at(0, 1)) / s; qy = 0.25 * s; qz = (M.at(2, 1) + M.at(1, 2)) / s;
+	}
+	else
+	{
+		double s = 2.0 * sqrt(1.0 + M.at(2, 2) - M.at(0, 0) - M.at(1, 1));
+		qw = (M.at(0, 1) - M.at(1, 0)) / s;
+		qx = (M.at(2, 0) + M.at(0, 2)) / s; qy = (M.at(2, 1) + M.at(1, 2)) / s; qz = 0.25 * s;
+	}
+}
+
+bool ReadTrajectory(std::vector<TrajectoryPose> &poses, const char *fileName)
+{
+	FILE *f = fopen(fileName, "r");
+	if (f == NULL) return false;
+
+	poses.clear();
+
+	char line[1024];
+	while (fgets(line, sizeof(line), f) != NULL)
+	{
+		if (line[0] == '#') continue;
+
+		TrajectoryPose pose;
+		double t[3], q[4];
+
+		if (strchr(line, ',') != NULL)
+		{
+			// ETH/EuRoC: timestamp in ns, position, quaternion with w first
+			if (sscanf(line, "%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf", &pose.timestamp, &t[0], &t[1], &t[2], &q[0], &q[1], &q[2], &q[3]) != 8) continue;
+			pose.timestamp *= 1e-9;
+		}
+		else
+		{
+			// TUM: timestamp in s, position, quaternion with w last
+			if (sscanf(line, "%lf %lf %lf %lf %lf %lf %lf %lf", &pose.timestamp, &t[0], &t[1], &t[2], &q[1], &q[2], &q[3], &q[0]) != 8) continue;
+		}
+
+		pose.cameraToWorld = PoseFromQuaternion(t[0], t[1], t[2], q[0], q[1], q[2], q[3]);
+		poses.push_back(pose);
+	}
+
+	fclose(f);
+	return true;
+}
+
+bool ReadTimestamps(std::vector<double> &timestamps, const char *fileName)
+{
+	FILE *f = fopen(fileName, "r");
+	if (f == NULL) return false;
+
+	timestamps.clear();
+
+	char line[1024];
+	while (fgets(line, sizeof(line), f) != NULL)
+	{
+		if (line[0] == '#') continue;
+
+		double timestamp;
+		if (sscanf(line, "%lf", &timestamp) != 1) continue;
+
+		// ETH/EuRoC timestamps are in ns
+		if (strchr(line, ',') != NULL) timestamp *= 1e-9;
+		timestamps.push_back(timestamp);
+	}
+
+	fclose(f);
+	return true;
+}
+
+bool WriteTrajectory(const std::vector<TrajectoryPose> &poses, const char *fileName)
+{
+	FILE *f = fopen(fileName, "w");
+	if (f == NULL) return false;
+
+	fprintf(f, "# timestamp tx ty tz qx qy qz qw\n");
+	for (size_t i = 0; i < poses.size(); i++)
+	{
+		const Matrix4d &M = poses[i].cameraToWorld;
+		double qw, qx, qy, qz;
+		QuaternionFromPose(M, qw, qx, qy, qz);
+
+		fprintf(f, "%.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f\n", poses[i].timestamp, M.at(3, 0), M.at(3, 1), M.at(3, 2), qx, qy, qz, qw);
+	}
+
+	fclose(f);
+	return true;
+}
+
+TrajectoryPose MakeTrajectoryPose(double timestamp, const Matrix4f &worldToCamera)
+{
+	Matrix4d M;
+	for (int i = 0; i < 16; i++) M.m[i] = worldToCamera.m[i];
+
+	TrajectoryPose pose;
+	pose.timestamp = timestamp;
+	M.inv(pose.cameraToWorld);
+
+	return pose;
+}
+
+struct TimestampPair
+{
+	double difference;
+	int estimateId, groundTruthId;
+
+	bool operator <(const TimestampPair &other) const
+	{
+		if (difference != other.difference) return difference < other.difference;
+		if (estimateId != other.estimateId) return estimateId < other.estimateId;
+		return groundTruthId < other.groundTruthId;
+	}
+};
+
+static bool HasEarlierTimestamp(const TrajectoryPose &pose, double timestamp) { return pose.timestamp < timestamp; }
+
+void AssociateTrajectories(const std::vector<TrajectoryPose> &estimate, const std::vector<TrajectoryPose> &groundTruth,
+	double maxDifference, std::vector<TrajectoryPose> &associatedEstimate, std::vector<TrajectoryPose> &associatedGroundTruth)
+{
+	associatedEstimate.clear();
+	associatedGroundTruth.clear();
+
+	// the candidates of each estimated pose are found by binary search in the ground truth sorted by time
+	std::vector<TrajectoryPose> sortedGroundTruth(groundTruth);
+	std::stable_sort(sortedGroundTruth.begin(), sortedGroundTruth.end(),
+		[](const TrajectoryPose &a, const TrajectoryPose &b) { return a.timestamp < b.timestamp; });
+
+	std::vector<TimestampPair> candidates;
+	for (int i = 0; i < (int)estimate.size(); i++)
+	{
+		double timestamp = estimate[i].timestamp;
+		std::vector<TrajectoryPose>::const_iterator it = std::lower_bound(sortedGroundTruth.begin(), sortedGroundTruth.end(),
+			timestamp - maxDifference, HasEarlierTimestamp);
+
+		for (; it != sortedGroundTruth.end() && it->timestamp <= timestamp + maxDifference; ++it)
+		{
+			TimestampPair pair;
+			pair.difference = fabs(it->timestamp - timestamp);
+			pair.estimateId = i;
+			pair.groundTruthId = (int)(it - sortedGroundTruth.begin());
+			candidates.push_back(pair);
+		}
+	}
+
+	// closest pairs first, each pose in one pair at most
+	std::sort(candidates.begin(), candidates.end());
+
+	std::vector<int> matches(estimate.size(), -1);
+	std::vector<bool> isGroundTruthUsed(sortedGroundTruth.size(), false);
+	for (size_t i = 0; i < candidates.size(); i++)
+	{
+		const TimestampPair &pair = candidates[i];
+		if (matches[pair.estimateId] >= 0 || isGroundTruthUsed[pair.groundTruthId]) continue;
+
+		matches[pair.estimateId] = pair.groundTruthId;
+		isGroundTruthUsed[pair.groundTruthId] = true;
+	}
+
+	for (size_t i = 0; i < estimate.size(); i++)
+	{
+		if (matches[i] < 0) continue;
+		associatedEstimate.push_back(estimate[i]);
+		associatedGroundTruth.push_back(sortedGroundTruth[matches[i]]);
+	}
+}
+
+/// Eigenvector of the largest eigenvalue of a symmetric 4x4 matrix, by cyclic Jacobi rotations.
+static void LargestEigenvector(double A[4][4], double *v)
+{
+	double V[4][4];
+	for (int r = 0; r < 4; r++) for (int c = 0; c < 4; c++) V[r][c] = r == c ? 1.0 : 0.0;
+
+	for (int sweep = 0; sweep < 50; sweep++)
+	{
+		double offDiagonal = 0.0;
+		for (int p = 0; p < 4; p++) for (int q = p + 1; q < 4; q++) offDiagonal += A[p][q] * A[p][q];
+		if (offDiagonal < 1e-24) break;
+
+		for (int p = 0; p < 4; p++) for (int q = p + 1; q < 4; q++)
+		{
+			if (fabs(A[p][q]) < 1e-30) continue;
+
+			double theta = (A[q][q] - A[p][p]) / (2.0 * A[p][q]);
+			double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+			double c = 1.0 / sqrt(t * t + 1.0), s = t * c;
+
+			for (int k = 0; k < 4; k++)
+			{
+				double akp = A[k][p], akq = A[k][q];
+				A[k][p] = c * akp - s * akq; A[k][q] = s * akp + c * akq;
+			}
+			for (int k = 0; k < 4; k++)
+			{
+				double apk = A[p][k], aqk = A[q][k];
+				A[p][k] = c * apk - s * aqk; A[q][k] = s * apk + c * aqk;
+			}
+			for (int k = 0; k < 4; k++)
+			{
+				double vkp = V[k][p], vkq = V[k][q];
+				V[k][p] = c * vkp - s * vkq; V[k][q] = s * vkp + c * vkq;
+			}
+		}
+	}
+
+	int best = 0;
+	for (int i = 1; i < 4; i++) if (A[i][i] > A[best][best]) best = i;
+	for (int i = 0; i < 4; i++) v[i] = V[i][best];
+}
+
+/** Rigid transformation that maps the camera centres of @p estimate onto
+    those of @p groundTruth in the least squares sense (Horn, "Closed-form
+    solution of absolute orientation using unit quaternions", 1987).
+*/
+static Matrix4d AlignTrajectories(const std::vector<TrajectoryPose> &estimate, const std::vector<TrajectoryPose> &groundTruth, int noPoses)
+{
+	Vector3d meanEst(0.0), meanGT(0.0);
+	for (int i = 0; i < noPoses; i++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			meanEst[k] += estimate[i].cameraToWorld.at(3, k);
+			meanGT[k] += groundTruth[i].cameraToWorld.at(3, k);
+		}
+	}
+	meanEst /= (double)noPoses; meanGT /= (double)noPoses;
+
+	// cross covariance S[a][b] = sum of est_a * gt_b
+	double S[3][3] = { { 0 } };
+	for (int i = 0; i < noPoses; i++)
+	{
+		for (int a = 0; a < 3; a++) for (int b = 0; b < 3; b++)
+			S[a][b] += (estimate[i].cameraToWorld.at(3, a) - meanEst[a]) * (groundTruth[i].cameraToWorld.at(3, b) - meanGT[b]);
+	}
+
+	double N[4][4] = {
+		{ S[0][0] + S[1][1] + S[2][2], S[1][2] - S[2][1], S[2][0] - S[0][2], S[0][1] - S[1][0] },
+		{ S[1][2] - S[2][1], S[0][0] - S[1][1] - S[2][2], S[0][1] + S[1][0], S[2][0] + S[0][2] },
+		{ S[2][0] - S[0][2], S[0][1] + S[1][0], -S[0][0] + S[1][1] - S[2][2], S[1][2] + S[2][1] },
+		{ S[0][1] - S[1][0], S[2][0] + S[0][2], S[1][2] + S[2][1], -S[0][0] - S[1][1] + S[2][2] }
+	};
+
+	double q[4];
+	LargestEigenvector(N, q);
+
+	Matrix4d M = PoseFromQuaternion(0.0, 0.0, 0.0, q[0], q[1], q[2], q[3]);
+	for (int k = 0; k < 3; k++)
+		M.at(3, k) = meanGT[k] - (M.at(0, k) * meanEst[0] + M.at(1, k) * meanEst[1] + M.at(2, k) * meanEst[2]);
+
+	return M;
+}
+
+static Matrix4d RelativePose(const Matrix4d &from, const Matrix4d &to)
+{
+	Matrix4d invFrom;
+	from.inv(invFrom);
+	return invFrom * to;
+}
+
+TrajectoryErrors EvaluateTrajectory(const std::vector<TrajectoryPose> &estimate, const std::vector<TrajectoryPose> &groundTruth,
+	int noPoses, int rpeDelta)
+{
+	TrajectoryErrors errors;
+	memset(&errors, 0, sizeof(errors));
+
+	if ((int)estimate.size() < noPoses) noPoses = (int)estimate.size();
+	if ((int)groundTruth.size() < noPoses) noPoses = (int)groundTruth.size();
+	errors.noPoses = noPoses;
+	if (noPoses < 1) return errors;
+
+	Matrix4d alignment = AlignTrajectories(estimate, groundTruth, noPoses);
+
+	for (int i = 0; i < noPoses; i++)
+	{
+		Matrix4d aligned = alignment * estimate[i].cameraToWorld;
+
+		double error = 0.0;
+		for (int k = 0; k < 3; k++)
+		{
+			double d = aligned.at(3, k) - groundTruth[i].cameraToWorld.at(3, k);
+			error += d * d;
+		}
+
+		errors.ate_rmse += error;
+		errors.ate_mean += sqrt(error);
+		if (sqrt(error) > errors.ate_max) errors.ate_max = sqrt(error);
+	}
+	errors.ate_rmse = sqrt(errors.ate_rmse / noPoses);
+	errors.ate_mean /= noPoses;
+
+	int noPairs = 0;
+	for (int i = 0; i + rpeDelta < noPoses; i++, noPairs++)
+	{
+		Matrix4d motionGT = RelativePose(groundTruth[i].cameraToWorld, groundTruth[i + rpeDelta].cameraToWorld);
+		Matrix4d motionEst = RelativePose(estimate[i].cameraToWorld, estimate[i + rpeDelta].cameraToWorld);
+		Matrix4d error = RelativePose(motionGT, motionEst);
+
+		double translation = 0.0;
+		for (int k = 0; k < 3; k++) translation += error.at(3, k) * error.at(3, k);
+
+		double cosAngle = 0.5 * (error.at(0, 0) + error.at(1, 1) + error.at(2, 2) - 1.0);
+		if (cosAngle > 1.0) cosAngle = 1.0;
+		if (cosAngle < -1.0) cosAngle = -1.0;
+		double angle = acos(cosAngle) * RAD_TO_DEG;
+
+		errors.rpe_translation_rmse += translation;
+		errors.rpe_rotation_rmse += angle * angle;
+	}
+	if (noPairs > 0)
+	{
+		errors.rpe_translation_rmse = sqrt(errors.rpe_translation_rmse / noPairs);
+		errors.rpe_rotation_rmse = sqrt(errors.rpe_rotation_rmse / noPairs);
+	}
+
+	return errors;
+}
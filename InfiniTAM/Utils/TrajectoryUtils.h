@@ -0,0 +1,71 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <vector>
+
+#include "../ITMLib/Utils/ITMLibDefines.h"
+
+/** One camera pose of a trajectory. @p cameraToWorld maps points from
+    the camera into the world coordinate frame (the inverse of
+    ITMPose::GetM()), the translation being the camera centre.
+*/
+struct TrajectoryPose
+{
+	double timestamp;
+	ORUtils::Matrix4<double> cameraToWorld;
+};
+
+/** Errors of an estimated trajectory against the ground truth, see
+    Sturm et al., "A Benchmark for the Evaluation of RGB-D SLAM Systems",
+    IROS 2012. Translations are in the units of the trajectories,
+    rotations in degrees.
+*/
+struct TrajectoryErrors
+{
+	int noPoses;
+
+	/// Absolute trajectory error: camera centres after aligning the estimate rigidly to the ground truth
+	double ate_rmse, ate_mean, ate_max;
+
+	/// Relative pose error over a fixed number of frames
+	double rpe_translation_rmse, rpe_rotation_rmse;
+};
+
+/** Reads a trajectory in the TUM RGB-D format
+    ("timestamp tx ty tz qx qy qz qw" per line) or in the comma separated
+    ETH/EuRoC ground truth format ("timestamp,px,py,pz,qw,qx,qy,qz,...",
+    further columns are ignored). Lines starting with '#' and lines that
+    cannot be parsed are skipped. Returns false if the file cannot be read.
+*/
+bool ReadTrajectory(std::vector<TrajectoryPose> &poses, const char *fileName);
+
+/** Reads the timestamps of the images of a sequence from the first column
+    of a TUM RGB-D list ("timestamp filename", e.g. depth.txt) or of an
+    ETH/EuRoC data.csv ("timestamp,filename", in ns), one per image in the
+    order of the images. Lines starting with '#' are skipped.
+*/
+bool ReadTimestamps(std::vector<double> &timestamps, const char *fileName);
+
+/// Writes a trajectory in the TUM RGB-D format.
+bool WriteTrajectory(const std::vector<TrajectoryPose> &poses, const char *fileName);
+
+/// Converts a pose of the tracking state into a trajectory pose.
+TrajectoryPose MakeTrajectoryPose(double timestamp, const Matrix4f &worldToCamera);
+
+/** Pairs the poses of @p estimate with those of @p groundTruth of the
+    nearest timestamp, as associate.py of the TUM RGB-D tools does: pairs
+    further apart than @p maxDifference seconds are dropped, the closest
+    pairs are taken first and every pose is used at most once. The pairs
+    are returned in @p associatedEstimate and @p associatedGroundTruth in
+    the order of the estimate.
+*/
+void AssociateTrajectories(const std::vector<TrajectoryPose> &estimate, const std::vector<TrajectoryPose> &groundTruth,
+	double maxDifference, std::vector<TrajectoryPose> &associatedEstimate, std::vector<TrajectoryPose> &associatedGroundTruth);
+
+/** Compares the first @p noPoses poses of @p estimate and @p groundTruth,
+    which are associated by their index, see AssociateTrajectories(). The
+    relative pose error is taken between poses @p rpeDelta apart.
+*/
+TrajectoryErrors EvaluateTrajectory(const std::vector<TrajectoryPose> &estimate, const std::vector<TrajectoryPose> &groundTruth,
+	int noPoses, int rpeDelta = 1);
@@ -125,7 +125,7 @@ void InfiniTAMApp::StartProcessing(int useLiveCamera)
 	} else {
 		mImageSource = new InfiniTAM::Engine::OpenNIEngine(calibFile);
 	}
-	mMainEngine = new ITMMainEngine(mInternalSettings, &mImageSource->calib, mImageSource->getRGBImageSize(), mImageSource->getDepthImageSize());
+	mMainEngine = ITMMainEngine::Make(mInternalSettings, &mImageSource->calib, mImageSource->getRGBImageSize(), mImageSource->getDepthImageSize());
 
 	bool allocateGPU = false;
 	if (mInternalSettings->deviceType == ITMLibSettings::DEVICE_CUDA) allocateGPU = true;
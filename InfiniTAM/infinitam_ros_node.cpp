@@ -32,6 +32,8 @@
 #include "Engine/RosPoseSourceEngine.h"
 #include "Engine/UIEngine.h"
 
+#include "ITMLib/Utils/ITMLibSettingsIO.h"
+
 using namespace InfiniTAM::Engine;
 
 /** Create a default source of depth images from a list of command line
@@ -209,9 +211,9 @@ bool InfinitamNode::startInfinitam(std_srvs::SetBool::Request& request,
 
     SetUpSources();
 
-    main_engine_ = new ITMMainEngine(internal_settings_, &image_source_->calib,
-                                     image_source_->getRGBImageSize(),
-                                     image_source_->getDepthImageSize());
+    main_engine_ = ITMMainEngine::Make(internal_settings_, &image_source_->calib,
+                                       image_source_->getRGBImageSize(),
+                                       image_source_->getDepthImageSize());
 
     if (image_source_ == nullptr) {
       std::cout << "failed to open any image stream" << std::endl;
@@ -253,8 +255,7 @@ bool InfinitamNode::publishMap(std_srvs::Empty::Request& request,
                                std_srvs::Empty::Response& response) {
   ROS_INFO_STREAM("Service for publishing the map has started.");
   // Make the mesh ready for reading.
-  main_engine_->GetMeshingEngine()->MeshScene(main_engine_->GetMesh(),
-                                              main_engine_->GetScene());
+  main_engine_->UpdateMesh();
 
   // Get triangles from the device's memory.
   ORUtils::MemoryBlock<ITMMesh::Triangle>* cpu_triangles;
@@ -469,17 +470,31 @@ void InfinitamNode::readParameters() {
   node_handle_.param<bool>("save_cloud_to_file_system",
                            save_cloud_to_file_system_, true);
 
-  // Set InfiniTAM settings.
+  // Set InfiniTAM settings, the parameters below override the settings file.
+  std::string settings_file;
+  node_handle_.param<std::string>("settings_file", settings_file, "");
+  if (!settings_file.empty()) {
+    ROS_INFO_STREAM("Using settings file: " << settings_file);
+    ROS_ERROR_COND(!readLibSettings(settings_file.c_str(), *internal_settings_),
+                   "Failed to read the settings file %s",
+                   settings_file.c_str());
+  }
+
   node_handle_.param<float>("viewFrustum_min",
                             internal_settings_->sceneParams.viewFrustum_min,
-                            0.35f);
-  node_handle_.param<float>(
-      "viewFrustum_max", internal_settings_->sceneParams.viewFrustum_max, 3.0f);
+                            internal_settings_->sceneParams.viewFrustum_min);
+  node_handle_.param<float>("viewFrustum_max",
+                            internal_settings_->sceneParams.viewFrustum_max,
+                            internal_settings_->sceneParams.viewFrustum_max);
 
+  // Only a tracker other than the configured one resets the tracking regime.
   int tracker;
-  node_handle_.param<int>("trackerType", tracker, 1);
-  internal_settings_->trackerType =
-      static_cast<ITMLibSettings::TrackerType>(tracker);
+  node_handle_.param<int>("trackerType", tracker,
+                          internal_settings_->trackerType);
+  if (tracker != internal_settings_->trackerType) {
+    internal_settings_->SetTrackerType(
+        static_cast<ITMLibSettings::TrackerType>(tracker));
+  }
 
   node_handle_.param<std::string>("camera_frame_id", camera_frame_id_,
                                   "sr300_depth_optical_frame");